@@ -0,0 +1,253 @@
+#!/usr/bin/env python3.9
+import argparse
+import asyncio
+import json
+import logging
+import sys
+from typing import Dict, Optional
+
+from aiohttp import ClientSession, ClientResponse, web
+
+def send_reply(reply: Dict) -> None:
+    """ Print a reply to the CA, one JSON object per line.
+
+    Args:
+        reply (Dict): Reply object holding the call id and either a result or an error
+    """
+    print(json.dumps(reply), flush=True)
+
+def send_event(event: str, params: Dict) -> None:
+    """ Print an event to the CA, one JSON object per line.
+
+    Args:
+        event (str): Event name
+        params (Dict): Event parameters
+    """
+    print(json.dumps({"event": event, "params": params}), flush=True)
+
+def presentation_proof_send_request_body(connection_id: str, presentation_request: Dict) -> Dict:
+    """ Build request body for /present-proof-2.0/send-request
+
+    Args:
+        connection_id (str): Connection identifier
+        presentation_request (Dict): Presentation request object
+
+    Returns:
+        Dict: Request body for /present-proof-2.0/send-request
+    """
+    return {
+        "auto_verify": True,
+        "comment": "string",
+        "connection_id": connection_id,
+        "presentation_request": presentation_request,
+        "trace": False
+    }
+
+async def request(
+        session, method, path, data=None, text=False, params=None, headers=None
+    ) -> ClientResponse:
+        """ Send a HTTP request
+
+        Args:
+            method (str): HTTP Verb
+            path (str): URL path
+            data (Dict, optional): Request body. Defaults to None.
+            text (bool, optional): If True return response as str, otherwise return response as Dict. Defaults to False.
+            params (Dict, optional): URL parameters. Defaults to None.
+            headers (Dict, optional): Request headers. Defaults to None.
+
+        Raises:
+            Exception: HTTP request failed
+            Exception: Response can not be decoded to JSON
+
+        Returns:
+            ClientResponse: str or Dict representing the response; depends on text argument
+        """
+        params = {k: v for (k, v) in (params or {}).items() if v is not None}
+        async with session.request(
+            method, path, json=data, params=params, headers=headers
+        ) as resp:
+            resp_text = await resp.text()
+            try:
+                resp.raise_for_status()
+            except Exception as e:
+                # try to retrieve and print text on error
+                raise Exception(f"Error: {resp_text}") from e
+            if not resp_text and not text:
+                return None
+            if not text:
+                try:
+                    return json.loads(resp_text)
+                except json.JSONDecodeError as e:
+                    raise Exception(f"Error decoding JSON: {resp_text}") from e
+            return resp_text
+
+configs: Dict[str, Dict] = {}
+
+def read_config(config_file: str) -> Dict:
+    """ Read a config file once, the config files do not change while the CA runs.
+
+    Args:
+        config_file (str): Path to the VC challenge config file
+
+    Returns:
+        Dict: Config object
+    """
+    if config_file not in configs:
+        with open(config_file) as f:
+            configs[config_file] = json.load(f)
+        logging.debug(f"config: {configs[config_file]}")
+    return configs[config_file]
+
+# presentations whose verdict has not been reported yet, by presentation (thread) id
+watched: Dict[str, str] = {}
+
+# states of a presentation exchange in which the presentation has not been received yet
+PENDING_STATES = ("proposal-sent", "proposal-received", "request-sent", "request-received")
+
+async def settle(session: ClientSession, endpoint: str, record: Dict) -> Optional[bool]:
+    """ Verify a presentation exchange record if the presentation has been received.
+
+    Returns:
+        Optional[bool]: the verdict, or None if the presentation has not been received yet
+    """
+    state = record["state"]
+    if state in PENDING_STATES:
+        return None
+    if state == "abandoned":
+        return False
+    if state != "done":
+        # if server agent does not auto-verifiy received presentations, verify manually
+        record = await request(session, "post", endpoint + f"/present-proof-2.0/records/{record['pres_ex_id']}/verify-presentation")
+    return str(record.get("verified")).lower() == "true"
+
+async def report(session: ClientSession, record: Dict) -> None:
+    """ Report the verdict on a watched presentation once it is known.
+    """
+    thread_id = record.get("thread_id")
+    endpoint = watched.get(thread_id)
+    if endpoint is None:
+        return
+    verified = await settle(session, endpoint, record)
+    if verified is None or watched.pop(thread_id, None) is None:
+        return
+    logging.info(f"presentation {thread_id} verified: {verified}")
+    send_event("presentation-verified", {"presentation_id": thread_id, "verified": str(verified).lower()})
+
+async def poll(session: ClientSession, interval: float) -> None:
+    """ Watch the presentations by querying the agent, when it does not push their state.
+    """
+    while True:
+        await asyncio.sleep(interval)
+        for thread_id, endpoint in list(watched.items()):
+            try:
+                res = await request(session, "get", endpoint + "/present-proof-2.0/records", params={"thread_id": thread_id})
+                if res["results"]:
+                    await report(session, res["results"][0])
+            except Exception:
+                logging.exception(f"cannot poll presentation {thread_id}")
+
+async def serve_webhooks(session: ClientSession, port: int) -> web.AppRunner:
+    """ Watch the presentations through the webhooks of the agent (--webhook-url http://<host>:<port>).
+    """
+    async def on_present_proof(req: web.Request) -> web.Response:
+        try:
+            await report(session, await req.json())
+        except Exception:
+            logging.exception("cannot handle webhook")
+        return web.Response()
+
+    app = web.Application()
+    app.router.add_post("/topic/present_proof_v2_0/", on_present_proof)
+    runner = web.AppRunner(app)
+    await runner.setup()
+    await web.TCPSite(runner, "localhost", port).start()
+    return runner
+
+async def send_presentation_request(session: ClientSession, params: Dict) -> Dict:
+    config = read_config(params["config_file"])
+    endpoint = config["aries-admin-endpoint"]
+
+    # Retrieve connection to client agent
+    res = await request(session, "get", endpoint + "/connections", params={"their_did": params["connection_did"]})
+    connection_id = res["results"][0]["connection_id"]
+    logging.info(f"connection_id: {connection_id}")
+
+    # Send presentation request to client agent
+    ppsr_body = presentation_proof_send_request_body(connection_id, config["presentation-request"])
+    res = await request(session, "post", endpoint + "/present-proof-2.0/send-request", data=ppsr_body)
+    thread_id = res["thread_id"]
+    logging.info(f"presentation_id: {thread_id}")
+    watched[thread_id] = endpoint
+    return {"presentation_id": thread_id}
+
+async def verify_presentation(session: ClientSession, params: Dict) -> Dict:
+    config = read_config(params["config_file"])
+    endpoint = config["aries-admin-endpoint"]
+
+    # Retrieve presentation exchange record with client agent
+    res = await request(session, "get", endpoint + "/present-proof-2.0/records", params={"thread_id": params["presentation_id"]})
+    res = res["results"][0]
+    logging.info(f"pres_ex_id: {res['pres_ex_id']}")
+
+    verified = await settle(session, endpoint, res)
+    logging.info(f"verified: {verified}")
+    if verified is None:
+        return {"verified": "false", "pending": "true"}
+    watched.pop(params["presentation_id"], None)
+    return {"verified": str(verified).lower()}
+
+METHODS = {
+    "send-presentation-request": send_presentation_request,
+    "verify-presentation": verify_presentation,
+}
+
+async def handle(session: ClientSession, line: str) -> None:
+    try:
+        call = json.loads(line)
+    except json.JSONDecodeError:
+        logging.warning(f"invalid call: {line}")
+        return
+    call_id = call.get("id")
+    try:
+        method = METHODS[call["method"]]
+        result = await method(session, call.get("params", {}))
+        send_reply({"id": call_id, "result": result})
+    except Exception as e:
+        logging.exception(f"call {call_id} failed")
+        send_reply({"id": call_id, "error": str(e)})
+
+async def main():
+    # Parse arguments
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--webhook-port", type=int, help="receive the state of presentations from the agent on this port")
+    parser.add_argument("--poll-interval", type=float, default=1.0, help="otherwise, query their state this often (seconds)")
+    parser.add_argument("--log", default="WARNING", choices=["DEBUG", "INFO", "WARNING", "ERROR", "CRITICAL"])
+    args = parser.parse_args()
+    # the CA ignores the lines that are neither replies nor events
+    logging.basicConfig(level=getattr(logging, args.log), encoding="UTF-8", stream=sys.stdout)
+
+    loop = asyncio.get_running_loop()
+    reader = asyncio.StreamReader()
+    await loop.connect_read_pipe(lambda: asyncio.StreamReaderProtocol(reader), sys.stdin)
+
+    # calls are served concurrently over a single HTTP session to the agent
+    async with ClientSession() as session:
+        if args.webhook_port is not None:
+            watcher = await serve_webhooks(session, args.webhook_port)
+        else:
+            watcher = asyncio.create_task(poll(session, args.poll_interval))
+        tasks = set()
+        while line := await reader.readline():
+            task = asyncio.create_task(handle(session, line.decode()))
+            tasks.add(task)
+            task.add_done_callback(tasks.discard)
+        if tasks:
+            await asyncio.wait(tasks)
+        if args.webhook_port is not None:
+            await watcher.cleanup()
+        else:
+            watcher.cancel()
+
+
+asyncio.run(main())
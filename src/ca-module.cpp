@@ -22,36 +22,141 @@
 #include "detail/crypto-helpers.hpp"
 #include "challenge/challenge-module.hpp"
 #include "name-assignment/assignment-func.hpp"
+#include "detail/ca-synchronized-storage.hpp"
 #include "detail/challenge-encoder.hpp"
 #include "detail/error-encoder.hpp"
 #include "detail/info-encoder.hpp"
 #include "detail/request-encoder.hpp"
 #include "detail/probe-encoder.hpp"
+#include "detail/revocation-encoder.hpp"
+#include "detail/status-encoder.hpp"
 
+#include <ndn-cxx/lp/nack.hpp>
 #include <ndn-cxx/metadata-object.hpp>
 #include <ndn-cxx/security/signing-helpers.hpp>
 #include <ndn-cxx/security/verification-helpers.hpp>
 #include <ndn-cxx/util/io.hpp>
 #include <ndn-cxx/util/random.hpp>
+#include <ndn-cxx/util/sha256.hpp>
 #include <ndn-cxx/util/string-helper.hpp>
 
+#include <boost/asio/post.hpp>
+
 namespace ndncert::ca {
 
 const time::seconds DEFAULT_DATA_FRESHNESS_PERIOD = 1_s;
 const time::seconds REQUEST_VALIDITY_PERIOD_NOT_BEFORE_GRACE_PERIOD = 120_s;
+const time::seconds REVOCATION_DATASET_FRESHNESS_PERIOD = 1_h;
+const time::seconds STATUS_FRESHNESS_PERIOD = 1_min;
+const size_t MAX_QUEUED_CHALLENGE_ROUNDS = 8;
 
 NDN_LOG_INIT(ndncert.ca);
 
+/**
+ * @brief The module of a challenge whose first round may be carried by a NEW Interest, if any.
+ */
+static std::shared_ptr<ChallengeModule>
+findEmbeddableChallenge(const std::string& challengeType, const std::vector<std::string>& supportedChallenges)
+{
+  if (std::find(supportedChallenges.begin(), supportedChallenges.end(), challengeType) == supportedChallenges.end()) {
+    NDN_LOG_TRACE("Ignoring embedded challenge not supported by the CA: " << challengeType);
+    return nullptr;
+  }
+  std::shared_ptr<ChallengeModule> challenge = ChallengeModule::createChallengeModule(challengeType);
+  if (challenge == nullptr || !challenge->canEmbedInNew()) {
+    NDN_LOG_TRACE("Ignoring challenge that cannot be embedded in NEW: " << challengeType);
+    return nullptr;
+  }
+  return challenge;
+}
+
+CaSharedState::CaSharedState(ndn::KeyChain& keyChain, const CaConfig& config, const std::string& storageType,
+                             const std::string& storagePath, bool concurrent)
+  : keyChain(keyChain)
+  , storage(CaStorage::createCaStorage(storageType, config.caProfile.caPrefix, storagePath))
+  , certStore(config.caProfile.caPrefix, config.certStorePath)
+  , revocations(config.caProfile.caPrefix, config.revocationRegistryPath)
+{
+  if (storage == nullptr) {
+    NDN_THROW(std::runtime_error("Unknown CA storage type: " + storageType));
+  }
+  if (concurrent && !storage->isThreadSafe()) {
+    NDN_LOG_DEBUG("Serializing the accesses to " << storageType);
+    storage = std::make_unique<CaSynchronizedStorage>(std::move(storage));
+  }
+  if (config.stateless) {
+    stateSealer = std::make_unique<StateTokenSealer>(config.stateless->secret, config.stateless->keyLifetime,
+                                                     config.stateless->tokenLifetime);
+  }
+  if (config.admission) {
+    admission = std::make_unique<AdmissionController>(*config.admission);
+  }
+  ndn::random::generateSecureBytes(requestIdGenKey);
+}
+
+void
+CaSharedState::enableStorageThread(size_t queueCapacity)
+{
+  if (storageThread == nullptr) {
+    storageThread = std::make_shared<CaStorageThread>(queueCapacity);
+  }
+}
+
+ChallengeRound
+CaSharedState::startChallengeRound(const RequestId& requestId, std::function<void()> retry)
+{
+  std::lock_guard lock(m_challengeRounds->mutex);
+  auto [it, isStarted] = m_challengeRounds->inProgress.try_emplace(requestId);
+  if (!isStarted) {
+    if (it->second.size() < MAX_QUEUED_CHALLENGE_ROUNDS) {
+      it->second.push_back(std::move(retry));
+    }
+    else {
+      NDN_LOG_DEBUG("Dropping CHALLENGE of " << ndn::toHex(requestId) << ", too many rounds are queued");
+    }
+    return nullptr;
+  }
+
+  return ChallengeRound(new RequestId(requestId), [rounds = m_challengeRounds] (const RequestId* requestId) {
+    std::vector<std::function<void()>> retries;
+    {
+      std::lock_guard lock(rounds->mutex);
+      auto it = rounds->inProgress.find(*requestId);
+      retries = std::move(it->second);
+      rounds->inProgress.erase(it);
+    }
+    delete requestId;
+    // the first retry to run starts the next round, the others are queued again
+    for (const auto& retry : retries) {
+      retry();
+    }
+  });
+}
+
 CaModule::CaModule(ndn::Face& face, ndn::KeyChain& keyChain,
-                   const std::string& configPath, const std::string& storageType)
+                   const std::string& configPath, const std::string& storageType,
+                   const std::string& storagePath)
   : m_face(face)
-  , m_keyChain(keyChain)
 {
   // load the config and create storage
   m_config.load(configPath);
-  m_storage = CaStorage::createCaStorage(storageType, m_config.caProfile.caPrefix, "");
+  m_shared = std::make_shared<CaSharedState>(keyChain, m_config, storageType, storagePath);
+  init();
+}
+
+CaModule::CaModule(ndn::Face& face, std::shared_ptr<CaSharedState> sharedState, const std::string& configPath)
+  : m_face(face)
+  , m_shared(std::move(sharedState))
+{
+  BOOST_ASSERT(m_shared != nullptr);
+  m_config.load(configPath);
+  init();
+}
 
-  ndn::random::generateSecureBytes(m_requestIdGenKey);
+void
+CaModule::init()
+{
+  m_asyncStorage = std::make_unique<InlineAsyncCaStorage>(*m_shared->storage);
 
   if (m_config.nameAssignmentFuncs.empty()) {
     m_config.nameAssignmentFuncs.push_back(NameAssignmentFunc::createNameAssignmentFunc("random"));
@@ -62,6 +167,7 @@ CaModule::CaModule(ndn::Face& face, ndn::KeyChain& keyChain,
 
 CaModule::~CaModule()
 {
+  *m_isAlive = false;
   for (auto& handle : m_interestFilterHandles) {
     handle.cancel();
   }
@@ -105,25 +211,136 @@ CaModule::registerPrefix()
                                           [this] (auto&&, const auto& i) { onNewRenewRevoke(i, RequestType::REVOKE); });
       m_interestFilterHandles.push_back(filterId);
 
+      // register RENEW prefix
+      filterId = m_face.setInterestFilter(Name(name).append("RENEW"),
+                                          [this] (auto&&, const auto& i) { onRenew(i); });
+      m_interestFilterHandles.push_back(filterId);
+
+      // register the revocation dataset prefix
+      filterId = m_face.setInterestFilter(Name(name).append("REVOKED"),
+                                          [this] (auto&&, const auto& i) { onRevocationDataset(i); });
+      m_interestFilterHandles.push_back(filterId);
+
+      // register STATUS prefix
+      filterId = m_face.setInterestFilter(Name(name).append("STATUS"),
+                                          [this] (auto&&, const auto& i) { onStatus(i); });
+      m_interestFilterHandles.push_back(filterId);
+
+      // issued certificates; their names need not be under the CA prefix, requesters reach
+      // them through the forwarding hint of the CA
+      filterId = m_face.setInterestFilter(ndn::InterestFilter("/", "<>*<KEY><>*"),
+                                          [this] (auto&&, const auto& i) { onCertFetch(i); });
+      m_interestFilterHandles.push_back(filterId);
+
       NDN_LOG_TRACE("Prefix " << name << " got registered");
     },
     [this] (auto&&, const auto& reason) { onRegisterFailed(reason); });
   m_registeredPrefixHandles.push_back(prefixId);
 }
 
+void
+CaModule::enableStorageThread(size_t queueCapacity)
+{
+  m_shared->enableStorageThread(queueCapacity);
+  m_asyncStorage.reset();
+  m_asyncStorage = std::make_unique<ThreadedAsyncCaStorage>(*m_shared->storage, m_face.getIoService(),
+                                                            m_shared->storageThread);
+}
+
+void
+CaModule::enableSharding(uint8_t shardId, size_t nShards)
+{
+  if (nShards != 0 && shardId >= nShards) {
+    NDN_THROW(std::invalid_argument("Shard " + std::to_string(shardId) + " is not below the number of shards"));
+  }
+  m_shardId = shardId;
+  m_nShards = nShards;
+  auto prefixId = m_face.registerPrefix(getShardForwardingHint(), nullptr,
+    [this] (auto&&, const auto& reason) { onRegisterFailed(reason); });
+  m_registeredPrefixHandles.push_back(prefixId);
+}
+
+Name
+CaModule::getShardForwardingHint() const
+{
+  return Name(m_config.caProfile.caPrefix).append("CA").append("SHARD").appendNumber(*m_shardId);
+}
+
+bool
+CaModule::isOtherShard(const Name& certName) const
+{
+  if (!m_shardId || m_nShards == 0) {
+    return false;
+  }
+  // the same on all the shards, unlike the request ID, whose key is local
+  auto digest = ndn::util::Sha256::computeDigest(certName.wireEncode());
+  uint64_t hash = 0;
+  std::memcpy(&hash, digest->data(), sizeof(hash));
+  return hash % m_nShards != *m_shardId;
+}
+
 void
 CaModule::setStatusUpdateCallback(const StatusUpdateCallback& onUpdateCallback)
 {
+  std::lock_guard lock(m_statusUpdateCallbackMutex);
   m_statusUpdateCallback = onUpdateCallback;
 }
 
+void
+CaModule::notifyStatusUpdate(const RequestState& requestState)
+{
+  StatusUpdateCallback callback;
+  {
+    std::lock_guard lock(m_statusUpdateCallbackMutex);
+    callback = m_statusUpdateCallback;
+  }
+  if (callback) {
+    callback(requestState);
+  }
+  m_statusUpdateBus.publish(requestState);
+}
+
+std::optional<AdmissionController::Statistics>
+CaModule::getAdmissionStatistics() const
+{
+  if (m_shared->admission == nullptr) {
+    return std::nullopt;
+  }
+  return m_shared->admission->getStatistics();
+}
+
+bool
+CaModule::admit(const Interest& request, CaEndpoint endpoint)
+{
+  const auto& admission = m_shared->admission;
+  if (admission == nullptr) {
+    return true;
+  }
+  // the signature is not verified yet, the KeyLocator only selects a bucket
+  std::optional<Name> keyLocator;
+  auto signatureInfo = request.getSignatureInfo();
+  if (signatureInfo && signatureInfo->hasKeyLocator() &&
+      signatureInfo->getKeyLocator().getType() == ndn::tlv::Name) {
+    keyLocator = signatureInfo->getKeyLocator().getName();
+  }
+  if (admission->admit(endpoint, keyLocator, m_asyncStorage->getLoad())) {
+    return true;
+  }
+  // shedding must cost less than processing: no signed error
+  if (admission->getShedAction() == ShedAction::NACK) {
+    ndn::lp::Nack nack(request);
+    nack.setReason(ndn::lp::NackReason::CONGESTION);
+    m_face.put(nack);
+  }
+  return false;
+}
+
 Data
 CaModule::getCaProfileData()
 {
+  std::lock_guard lock(m_profileDataMutex);
   if (m_profileData == nullptr) {
-    const auto& pib = m_keyChain.getPib();
-    const auto& identity = pib.getIdentity(m_config.caProfile.caPrefix);
-    const auto& cert = identity.getDefaultKey().getDefaultCertificate();
+    auto cert = getCaCertificate();
     Block contentTLV = infotlv::encodeDataContent(m_config.caProfile, cert);
 
     Name infoPacketName(m_config.caProfile.caPrefix);
@@ -133,29 +350,37 @@ CaModule::getCaProfileData()
     m_profileData->setFinalBlock(segmentComp);
     m_profileData->setContent(contentTLV);
     m_profileData->setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
-    m_keyChain.sign(*m_profileData, signingByIdentity(m_config.caProfile.caPrefix));
+    sign(*m_profileData);
   }
   return *m_profileData;
 }
 
 void
-CaModule::onCaProfileDiscovery(const Interest&)
+CaModule::onCaProfileDiscovery(const Interest& request)
 {
   NDN_LOG_TRACE("Received CA Profile MetaData discovery Interest");
-  if (m_profileData == nullptr) {
-    m_profileData = std::make_unique<Data>(getCaProfileData());
+  if (!admit(request, CaEndpoint::INFO)) {
+    return;
   }
+  auto profileData = getCaProfileData();
   ndn::MetadataObject metadata;
-  metadata.setVersionedName(m_profileData->getName().getPrefix(-1));
-  Name discoveryInterestName(m_profileData->getName().getPrefix(-2));
+  metadata.setVersionedName(profileData.getName().getPrefix(-1));
+  Name discoveryInterestName(profileData.getName().getPrefix(-2));
   discoveryInterestName.append(ndn::MetadataObject::getKeywordComponent());
-  m_face.put(metadata.makeData(discoveryInterestName, m_keyChain, signingByIdentity(m_config.caProfile.caPrefix)));
+  std::unique_lock lock(m_shared->keyChainMutex);
+  auto metadataData = metadata.makeData(discoveryInterestName, m_shared->keyChain,
+                                        signingByIdentity(m_config.caProfile.caPrefix));
+  lock.unlock();
+  m_face.put(metadataData);
 }
 
 void
 CaModule::onProbe(const Interest& request) {
   // PROBE Naming Convention: /<CA-Prefix>/CA/PROBE/[ParametersSha256DigestComponent]
   NDN_LOG_TRACE("Received PROBE request");
+  if (!admit(request, CaEndpoint::PROBE)) {
+    return;
+  }
 
   // process PROBE requests: collect probe parameters
   std::vector<ndn::Name> redirectionNames;
@@ -198,7 +423,7 @@ CaModule::onProbe(const Interest& request) {
   result.setContent(
       probetlv::encodeDataContent(availableNames, m_config.caProfile.maxSuffixLength, redirectionNames));
   result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
-  m_keyChain.sign(result, signingByIdentity(m_config.caProfile.caPrefix));
+  sign(result);
   m_face.put(result);
   NDN_LOG_TRACE("Handle PROBE: send out the PROBE response");
 }
@@ -206,11 +431,12 @@ CaModule::onProbe(const Interest& request) {
 void
 CaModule::onNewRenewRevoke(const Interest& request, RequestType requestType)
 {
+  if (!admit(request, requestType == RequestType::REVOKE ? CaEndpoint::REVOKE : CaEndpoint::NEW)) {
+    return;
+  }
+
   //verify ca cert validity
-  const auto& caCert = m_keyChain.getPib()
-                                 .getIdentity(m_config.caProfile.caPrefix)
-                                 .getDefaultKey()
-                                 .getDefaultCertificate();
+  auto caCert = getCaCertificate();
   if (!caCert.isValid()) {
     NDN_LOG_ERROR("Server certificate invalid/expired");
     m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::BAD_VALIDITY_PERIOD,
@@ -248,6 +474,37 @@ CaModule::onNewRenewRevoke(const Interest& request, RequestType requestType)
     return;
   }
 
+  if (isOtherShard(clientCert->getName())) {
+    NDN_LOG_TRACE("Dropping " << requestType << " of " << clientCert->getName() << " for another shard");
+    return;
+  }
+
+  // recognize duplicates before any public-key operation
+  RequestId id;
+  try {
+    id = makeRequestId(clientCert->getName());
+  }
+  catch (const std::runtime_error& e) {
+    NDN_LOG_ERROR("Error computing the request ID: " << std::string(e.what()));
+    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                       "Error computing the request ID."));
+    return;
+  }
+  auto recent = m_shared->recentRequests.find(id);
+  if (recent && recent->interestName == request.getFullName()) {
+    NDN_LOG_TRACE("Retransmitted request " << ndn::toHex(id) << ", replying with the cached response");
+    m_face.put(recent->response);
+    return;
+  }
+  if (recent && !m_shared->stateSealer) {
+    // the storage would reject the request anyway, so reply as it would, without the ECDH;
+    // in stateless mode, a request may be restarted
+    NDN_LOG_ERROR("Duplicate Request ID: The same request has been seen before.");
+    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                       "Duplicate Request ID: The same request has been seen before."));
+    return;
+  }
+
   // get server's ECDH pub key
   ECDHState ecdh;
   std::vector <uint8_t> sharedSecret;
@@ -316,20 +573,6 @@ CaModule::onNewRenewRevoke(const Interest& request, RequestType requestType)
     }
   }
 
-  // create new request instance
-  uint8_t requestIdData[32];
-  Block certNameTlv = clientCert->getName().wireEncode();
-  try {
-    hmacSha256(certNameTlv.wire(), certNameTlv.size(), m_requestIdGenKey, 32, requestIdData);
-  }
-  catch (const std::runtime_error& e) {
-    NDN_LOG_ERROR("Error computing the request ID: " << std::string(e.what()));
-    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
-                                       "Error computing the request ID."));
-    return;
-  }
-  RequestId id;
-  std::memcpy(id.data(), requestIdData, id.size());
   // initialize request state
   RequestState requestState;
   requestState.caPrefix = m_config.caProfile.caPrefix;
@@ -344,43 +587,423 @@ CaModule::onNewRenewRevoke(const Interest& request, RequestType requestType)
   hkdf(sharedSecret.data(), sharedSecret.size(), salt.data(), salt.size(),
        aesKey.data(), aesKey.size(), id.data(), id.size());
   requestState.encryptionKey = aesKey;
+  auto selfPubKey = ecdh.getSelfPubKey();
+
+  // the requester may have sent the first round of a challenge along, see Request::genNewInterest()
+  std::optional<Block> paramTLV;
+  std::shared_ptr<ChallengeModule> challenge;
+  if (requestType == RequestType::NEW) {
+    try {
+      paramTLV = requesttlv::decodeEmbeddedChallenge(parameterTLV);
+      if (paramTLV) {
+        paramTLV->parse();
+        challenge = findEmbeddableChallenge(readString(paramTLV->get(tlv::SelectedChallenge)),
+                                            m_config.caProfile.supportedChallenges);
+      }
+    }
+    catch (const std::exception& e) {
+      NDN_LOG_ERROR("Unrecognized embedded challenge: " << e.what());
+      m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                         "Unrecognized embedded challenge."));
+      return;
+    }
+  }
+  if (challenge == nullptr) {
+    // the requester selects the challenge with a CHALLENGE Interest
+    onNewRenewRevokeResult(request, requestState, selfPubKey, salt);
+    return;
+  }
+
+  NDN_LOG_TRACE("CHALLENGE module embedded in NEW: " << challenge->CHALLENGE_TYPE);
+  challenge->handleChallengeRequestAsync(*paramTLV, std::move(requestState), m_face.getIoService(),
+    [this, request, challenge, selfPubKey, salt,
+     isAlive = std::weak_ptr<bool>(m_isAlive)] (auto errorInfo, RequestState requestState) {
+      if (isAlive.expired()) {
+        return;
+      }
+      if (std::get<0>(errorInfo) != ErrorCode::NO_ERROR) {
+        // the request has not been stored yet
+        m_face.put(generateErrorDataPacket(request.getName(), std::get<0>(errorInfo), std::get<1>(errorInfo)));
+        return;
+      }
+      auto challengeResponse = encodeChallengeResult(requestState);
+      onNewRenewRevokeResult(request, requestState, selfPubKey, salt, challengeResponse);
+    });
+}
+
+void
+CaModule::onNewRenewRevokeResult(const Interest& request, const RequestState& requestState,
+                                 const std::vector<uint8_t>& selfPubKey, const std::array<uint8_t, 32>& salt,
+                                 const Block& challengeResponse)
+{
+  // an embedded challenge may have completed the request already
+  bool isCompleted = requestState.status == Status::SUCCESS;
+  auto content = requesttlv::encodeDataContent(selfPubKey, salt, requestState.requestId,
+                                               m_config.caProfile.supportedChallenges, challengeResponse);
+  if ((m_shared->stateSealer || m_shardId) && !isCompleted) {
+    content.parse();
+    if (m_shared->stateSealer) {
+      // the requester holds the request state
+      content.push_back(m_shared->stateSealer->seal(requestState));
+    }
+    if (m_shardId) {
+      content.push_back(makeNestedBlock(tlv::ChallengeForwardingHint, getShardForwardingHint()));
+    }
+    content.encode();
+  }
+  auto reply = [this, name = request.getName(), fullName = request.getFullName(), requestState, content] {
+    Data result;
+    result.setName(name);
+    result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
+    result.setContent(content);
+    sign(result);
+    m_shared->recentRequests.insert(requestState.requestId, fullName, result);
+    m_face.put(result);
+    notifyStatusUpdate(requestState);
+  };
+  if (m_shared->stateSealer || isCompleted) {
+    reply();
+    return;
+  }
+  m_asyncStorage->addRequest(requestState, reply,
+    [this, name = request.getName()] (const std::string& reason) {
+      NDN_LOG_ERROR("Duplicate Request ID: The same request has been seen before (" << reason << ").");
+      m_face.put(generateErrorDataPacket(name, ErrorCode::INVALID_PARAMETER,
+                                         "Duplicate Request ID: The same request has been seen before."));
+    },
+    [this, name = request.getName()] (const std::string& reason) {
+      NDN_LOG_ERROR("Cannot save the certificate request state: " << reason);
+      if (reason == AsyncCaStorage::QUEUE_FULL) {
+        m_face.put(generateErrorDataPacket(name, ErrorCode::INVALID_PARAMETER,
+                                           "The CA is overloaded, retry later."));
+      }
+      else {
+        m_face.put(generateErrorDataPacket(name, ErrorCode::INVALID_PARAMETER,
+                                           "Cannot save the certificate request state."));
+      }
+    });
+}
+
+void
+CaModule::onRenew(const Interest& request)
+{
+  if (!admit(request, CaEndpoint::RENEW)) {
+    return;
+  }
+
+  auto caCert = getCaCertificate();
+  if (!caCert.isValid()) {
+    NDN_LOG_ERROR("Server certificate invalid/expired");
+    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::BAD_VALIDITY_PERIOD,
+                                       "Server certificate invalid/expired"));
+    return;
+  }
+
+  // RENEW Naming Convention: /<CA-prefix>/CA/RENEW/[SignedInterestParameters_Digest]
+  std::shared_ptr<Certificate> certRequest;
+  std::shared_ptr<Certificate> certToRenew;
+  RequestId id;
   try {
-    m_storage->addRequest(requestState);
+    requesttlv::decodeRenewApplicationParameters(request.getApplicationParameters(), certRequest, certToRenew);
+    id = makeRequestId(certRequest->getName());
   }
-  catch (const std::runtime_error&) {
-    NDN_LOG_ERROR("Duplicate Request ID: The same request has been seen before.");
+  catch (const std::exception& e) {
+    NDN_LOG_ERROR("Unrecognized renewal request: " << e.what());
     m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
-                                       "Duplicate Request ID: The same request has been seen before."));
+                                       "Unrecognized renewal request."));
+    return;
+  }
+  if (isOtherShard(certRequest->getName())) {
+    NDN_LOG_TRACE("Dropping renewal of " << certRequest->getName() << " for another shard");
+    return;
+  }
+  auto recent = m_shared->recentRequests.find(id);
+  if (recent && recent->interestName == request.getFullName()) {
+    NDN_LOG_TRACE("Retransmitted renewal " << ndn::toHex(id) << ", replying with the cached response");
+    m_face.put(recent->response);
+    return;
+  }
+
+  // the certificate to renew must have been issued by this CA and be still valid
+  if (!certToRenew->isValid() || !ndn::security::verifySignature(*certToRenew, caCert)) {
+    NDN_LOG_ERROR("Invalid certificate to renew " << certToRenew->getName());
+    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
+                                       "Invalid certificate to renew."));
+    return;
+  }
+  if (m_shared->revocations.isRevoked(*certToRenew)) {
+    NDN_LOG_ERROR("Revoked certificate to renew " << certToRenew->getName());
+    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                       "The certificate to renew has been revoked."));
+    return;
+  }
+  if (!ndn::security::verifySignature(request, *certToRenew)) {
+    NDN_LOG_ERROR("Invalid signature in the Interest packet.");
+    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
+                                       "Invalid signature in the Interest packet."));
+    return;
+  }
+
+  // the new certificate may be for another key, but not another identity
+  if (!Certificate::isValidName(certRequest->getName()) ||
+      certRequest->getIdentity() != certToRenew->getIdentity()) {
+    NDN_LOG_ERROR("An invalid certificate name is being requested " << certRequest->getName());
+    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::NAME_NOT_ALLOWED,
+                                       "An invalid certificate name is being requested."));
+    return;
+  }
+  auto [notBefore, notAfter] = certRequest->getValidityPeriod().getPeriod();
+  auto currentTime = time::system_clock::now();
+  if (notBefore < currentTime - REQUEST_VALIDITY_PERIOD_NOT_BEFORE_GRACE_PERIOD ||
+      notAfter > currentTime + m_config.caProfile.maxValidityPeriod ||
+      notAfter <= notBefore) {
+    NDN_LOG_ERROR("An invalid validity period is being requested.");
+    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::BAD_VALIDITY_PERIOD,
+                                       "An invalid validity period is being requested."));
+    return;
+  }
+  if (!ndn::security::verifySignature(*certRequest, *certRequest)) {
+    NDN_LOG_ERROR("Invalid signature in the self-signed certificate.");
+    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
+                                       "Invalid signature in the self-signed certificate."));
     return;
   }
 
+  // the request completes at once, it is never stored
+  RequestState requestState;
+  requestState.caPrefix = m_config.caProfile.caPrefix;
+  requestState.requestId = id;
+  requestState.requestType = RequestType::RENEW;
+  requestState.cert = *certRequest;
+  auto issuedCert = issueCertificate(requestState);
+  try {
+    m_shared->certStore.insert(issuedCert);
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_ERROR("Cannot store the issued certificate: " << e.what());
+  }
+  requestState.cert = issuedCert;
+  requestState.status = Status::SUCCESS;
+  NDN_LOG_TRACE("Renewal succeeded. Certificate has been issued: " << issuedCert.getName());
+
   Data result;
   result.setName(request.getName());
   result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
-  result.setContent(requesttlv::encodeDataContent(ecdh.getSelfPubKey(),
-                                                  salt, requestState.requestId,
-                                                  m_config.caProfile.supportedChallenges));
-  m_keyChain.sign(result, signingByIdentity(m_config.caProfile.caPrefix));
+  result.setContent(requesttlv::encodeRenewDataContent(issuedCert));
+  sign(result);
+  m_shared->recentRequests.insert(id, request.getFullName(), result);
   m_face.put(result);
-  if (m_statusUpdateCallback) {
-    m_statusUpdateCallback(requestState);
+  notifyStatusUpdate(requestState);
+}
+
+void
+CaModule::onRevocationDataset(const Interest& request)
+{
+  if (!admit(request, CaEndpoint::REVOKED)) {
+    return;
+  }
+
+  const auto& caPrefix = m_config.caProfile.caPrefix;
+  const auto& name = request.getName();
+  auto suffix = name.getSubName(caPrefix.size() + 2);
+  if (suffix.size() == 1 && suffix[0] == ndn::MetadataObject::getKeywordComponent()) {
+    // discovery of the latest version
+    ndn::MetadataObject metadata;
+    metadata.setVersionedName(revocationtlv::makeDatasetName(caPrefix, m_shared->revocations.getVersion()));
+    std::unique_lock lock(m_shared->keyChainMutex);
+    auto metadataData = metadata.makeData(name, m_shared->keyChain, signingByIdentity(caPrefix),
+                                          DEFAULT_DATA_FRESHNESS_PERIOD);
+    lock.unlock();
+    m_face.put(metadataData);
+    return;
+  }
+
+  // the segments never change once published, they are only signed once
+  auto cached = m_revocationSegments.find(request);
+  if (cached != nullptr) {
+    m_face.put(*cached);
+    return;
+  }
+
+  // /v=<version>/seg=<segment> or /v=<version>/DELTA/v=<since>/seg=<segment>
+  std::vector<CertDigest> digests;
+  uint64_t segment = 0;
+  try {
+    std::optional<uint64_t> since;
+    if (suffix.size() == 4 && suffix[1] == revocationtlv::DELTA_COMPONENT) {
+      since = suffix[2].toVersion();
+    }
+    else if (suffix.size() != 2) {
+      NDN_THROW(std::runtime_error("malformed name"));
+    }
+    segment = suffix[-1].toSegment();
+    digests = m_shared->revocations.list(suffix[0].toVersion(), since.value_or(0));
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_DEBUG("Unknown revocation dataset " << name << ": " << e.what());
+    m_face.put(generateErrorDataPacket(name, ErrorCode::INVALID_PARAMETER, "Unknown revocation dataset."));
+    return;
+  }
+  size_t lastSegment = digests.empty() ? 0 : (digests.size() - 1) / revocationtlv::DIGESTS_PER_SEGMENT;
+  if (segment > lastSegment) {
+    m_face.put(generateErrorDataPacket(name, ErrorCode::INVALID_PARAMETER, "Unknown revocation dataset."));
+    return;
   }
+
+  auto begin = digests.data() + std::min(digests.size(), segment * revocationtlv::DIGESTS_PER_SEGMENT);
+  auto end = digests.data() + std::min(digests.size(), (segment + 1) * revocationtlv::DIGESTS_PER_SEGMENT);
+  Data result(name);
+  result.setContent(revocationtlv::encodeDataContent(begin, end));
+  result.setFinalBlock(ndn::name::Component::fromSegment(lastSegment));
+  result.setFreshnessPeriod(REVOCATION_DATASET_FRESHNESS_PERIOD);
+  sign(result);
+  m_revocationSegments.insert(result);
+  m_face.put(result);
+}
+
+void
+CaModule::onStatus(const Interest& request)
+{
+  if (!admit(request, CaEndpoint::STATUS)) {
+    return;
+  }
+
+  // /<digest> or /<parameters digest> with the digests in the parameters
+  const auto& name = request.getName();
+  std::vector<CertDigest> digests;
+  try {
+    if (name.size() != m_config.caProfile.caPrefix.size() + 3) {
+      NDN_THROW(std::runtime_error("malformed name"));
+    }
+    const auto& query = name.at(-1);
+    if (query.isImplicitSha256Digest()) {
+      digests.emplace_back();
+      std::memcpy(digests.back().data(), query.value(), digests.back().size());
+    }
+    else if (query.isParametersSha256Digest() && request.isParametersDigestValid()) {
+      digests = statustlv::decodeApplicationParameters(request.getApplicationParameters());
+    }
+    else {
+      NDN_THROW(std::runtime_error("no certificate digest"));
+    }
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_DEBUG("Malformed status query " << name << ": " << e.what());
+    m_face.put(generateErrorDataPacket(name, ErrorCode::BAD_INTEREST_FORMAT, "Malformed status query."));
+    return;
+  }
+
+  // a response is valid until the next revocation or until a certificate it reports expires
+  auto version = m_shared->revocations.getVersion();
+  auto responseName = Name(name).appendVersion(version);
+  Interest cacheInterest(responseName);
+  cacheInterest.setMustBeFresh(true);
+  auto cached = m_statusResponses.find(cacheInterest);
+  if (cached != nullptr) {
+    m_face.put(*cached);
+    return;
+  }
+
+  auto now = time::system_clock::now();
+  time::milliseconds freshness = STATUS_FRESHNESS_PERIOD;
+  statustlv::CertStatusList statuses;
+  for (const auto& digest : digests) {
+    auto status = CertStatus::UNKNOWN;
+    if (m_shared->revocations.isRevoked(digest)) {
+      status = CertStatus::REVOKED;
+    }
+    else if (auto cert = m_shared->certStore.find(digest); cert) {
+      auto notAfter = cert->getValidityPeriod().getPeriod().second;
+      if (notAfter < now) {
+        status = CertStatus::EXPIRED;
+      }
+      else {
+        status = CertStatus::GOOD;
+        freshness = std::min(freshness, time::duration_cast<time::milliseconds>(notAfter - now));
+      }
+    }
+    statuses.emplace_back(digest, status);
+  }
+
+  Data result(responseName);
+  result.setContent(statustlv::encodeDataContent(version, statuses));
+  result.setFreshnessPeriod(freshness);
+  sign(result);
+  m_statusResponses.insert(result);
+  m_face.put(result);
 }
 
 void
 CaModule::onChallenge(const Interest& request)
 {
   // get certificate request state
-  auto requestState = getCertificateRequest(request);
-  if (requestState == nullptr) {
+  auto requestId = getRequestId(request);
+  if (!requestId) {
     NDN_LOG_ERROR("No certificate request state can be found.");
     m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
                                        "No certificate request state can be found."));
     return;
   }
 
+  if (m_shardId && (*requestId)[0] != *m_shardId) {
+    // another instance keeps the request and will reply
+    NDN_LOG_TRACE("Dropping CHALLENGE of shard " << static_cast<int>((*requestId)[0]));
+    return;
+  }
+
+  if (!admit(request, CaEndpoint::CHALLENGE)) {
+    return;
+  }
+  startChallengeRound(request, *requestId);
+}
+
+void
+CaModule::startChallengeRound(const Interest& request, const RequestId& requestId)
+{
+  auto round = m_shared->startChallengeRound(requestId,
+    [this, request, requestId, isAlive = std::weak_ptr<bool>(m_isAlive), &io = m_face.getIoService()] {
+      // the round may end on the thread of another CaModule, while this one is being destroyed:
+      // do not touch this until back on its own thread
+      boost::asio::post(io, [this, request, requestId, isAlive] {
+        auto alive = isAlive.lock();
+        if (alive && *alive) {
+          startChallengeRound(request, requestId);
+        }
+      });
+    });
+  if (round == nullptr) {
+    NDN_LOG_TRACE("Queuing CHALLENGE of " << ndn::toHex(requestId) << " behind the round in progress");
+    return;
+  }
+
+  if (m_shared->stateSealer) {
+    auto requestState = openStateToken(request, requestId);
+    if (!requestState) {
+      m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                         "No certificate request state can be found."));
+      return;
+    }
+    onChallengeRequestState(request, *requestState, round);
+    return;
+  }
+
+  NDN_LOG_TRACE("Request Id to query the database " << ndn::toHex(requestId));
+  m_asyncStorage->getRequest(requestId,
+    [this, request, round] (const RequestState& requestState) {
+      onChallengeRequestState(request, requestState, round);
+    },
+    [this, name = request.getName(), round] (const std::string& reason) {
+      NDN_LOG_ERROR("Cannot get certificate request record from the storage: " << reason);
+      m_face.put(generateErrorDataPacket(name, ErrorCode::INVALID_PARAMETER,
+                                         "No certificate request state can be found."));
+    });
+}
+
+void
+CaModule::onChallengeRequestState(const Interest& request, RequestState requestState, const ChallengeRound& round)
+{
   // verify signature
-  if (!ndn::security::verifySignature(request, requestState->cert)) {
+  if (!ndn::security::verifySignature(request, requestState.cert)) {
     NDN_LOG_ERROR("Invalid Signature in the Interest packet.");
     m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
                                        "Invalid Signature in the Interest packet."));
@@ -390,22 +1013,27 @@ CaModule::onChallenge(const Interest& request)
   // decrypt the parameters
   ndn::Buffer paramTLVPayload;
   try {
-    paramTLVPayload = decodeBlockWithAesGcm128(request.getApplicationParameters(), requestState->encryptionKey.data(),
-                                               requestState->requestId.data(), requestState->requestId.size(),
-                                               requestState->decryptionIv, requestState->encryptionIv);
+    paramTLVPayload = decodeBlockWithAesGcm128(request.getApplicationParameters(), requestState.encryptionKey.data(),
+                                               requestState.requestId.data(), requestState.requestId.size(),
+                                               requestState.decryptionIv, requestState.encryptionIv);
   }
   catch (const std::exception& e) {
     NDN_LOG_ERROR("Interest paramaters decryption failed: " << e.what());
-    m_storage->deleteRequest(requestState->requestId);
+    rejectRequest(request, requestState.requestId, ErrorCode::INVALID_PARAMETER,
+                  "Interest paramaters decryption failed.", round);
+    return;
+  }
+  // the request is authenticated, its state token must not be used again
+  if (m_shared->stateSealer && !m_shared->stateSealer->markUsed(getStateToken(request))) {
+    NDN_LOG_ERROR("The state token has already been used.");
     m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
-                                       "Interest paramaters decryption failed."));
+                                       "No certificate request state can be found."));
     return;
   }
   if (paramTLVPayload.empty()) {
     NDN_LOG_ERROR("No parameters are found after decryption.");
-    m_storage->deleteRequest(requestState->requestId);
-    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
-                                       "No parameters are found after decryption."));
+    rejectRequest(request, requestState.requestId, ErrorCode::INVALID_PARAMETER,
+                  "No parameters are found after decryption.", round);
     return;
   }
 
@@ -414,57 +1042,134 @@ CaModule::onChallenge(const Interest& request)
 
   // load the corresponding challenge module
   std::string challengeType = readString(paramTLV.get(tlv::SelectedChallenge));
-  auto challenge = ChallengeModule::createChallengeModule(challengeType);
+  std::shared_ptr<ChallengeModule> challenge = ChallengeModule::createChallengeModule(challengeType);
   if (challenge == nullptr) {
     NDN_LOG_TRACE("Unrecognized challenge type: " << challengeType);
-    m_storage->deleteRequest(requestState->requestId);
-    m_face.put(
-      generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER, "Unrecognized challenge type."));
+    rejectRequest(request, requestState.requestId, ErrorCode::INVALID_PARAMETER,
+                  "Unrecognized challenge type.", round);
     return;
   }
 
   NDN_LOG_TRACE("CHALLENGE module to be load: " << challengeType);
-  auto errorInfo = challenge->handleChallengeRequest(paramTLV, *requestState);
+  challenge->handleChallengeRequestAsync(paramTLV, std::move(requestState), m_face.getIoService(),
+    [this, request, challenge, round, isAlive = std::weak_ptr<bool>(m_isAlive)] (auto errorInfo, RequestState requestState) {
+      if (!isAlive.expired()) {
+        onChallengeResult(request, std::move(requestState), errorInfo, round);
+      }
+    });
+}
+
+void
+CaModule::onChallengeResult(const Interest& request, RequestState requestState,
+                            const std::tuple<ErrorCode, std::string>& errorInfo, const ChallengeRound& round)
+{
   if (std::get<0>(errorInfo) != ErrorCode::NO_ERROR) {
-    m_storage->deleteRequest(requestState->requestId);
-    m_face.put(generateErrorDataPacket(request.getName(), std::get<0>(errorInfo), std::get<1>(errorInfo)));
+    rejectRequest(request, requestState.requestId, std::get<0>(errorInfo), std::get<1>(errorInfo), round);
     return;
   }
 
-  Block payload;
-  if (requestState->status == Status::PENDING) {
-    // if challenge succeeded
-    if (requestState->requestType == RequestType::NEW || requestState->requestType == RequestType::RENEW) {
-      auto issuedCert = issueCertificate(*requestState);
-      requestState->cert = issuedCert;
-      requestState->status = Status::SUCCESS;
-      m_storage->deleteRequest(requestState->requestId);
+  auto payload = encodeChallengeResult(requestState);
+  bool isCompleted = requestState.status == Status::SUCCESS || requestState.status == Status::FAILURE;
+
+  if (m_shared->stateSealer && !isCompleted) {
+    // the requester echoes the new state in its next CHALLENGE
+    payload.parse();
+    payload.push_back(m_shared->stateSealer->seal(requestState));
+    payload.encode();
+  }
+
+  // reply only once the storage reflects the new state of the request, which ends the round
+  auto reply = [this, name = request.getName(), payload, requestState, round] {
+    Data result;
+    result.setName(name);
+    result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
+    result.setContent(payload);
+    sign(result);
+    m_face.put(result);
+    notifyStatusUpdate(requestState);
+  };
+  auto onFailure = [this, name = request.getName(), round] (const std::string& reason) {
+    NDN_LOG_ERROR("Cannot save the certificate request state: " << reason);
+    m_face.put(generateErrorDataPacket(name, ErrorCode::INVALID_PARAMETER,
+                                       "Cannot save the certificate request state."));
+  };
+  if (isCompleted) {
+    m_shared->recentRequests.erase(requestState.requestId);
+  }
+  if (m_shared->stateSealer) {
+    reply();
+  }
+  else if (isCompleted) {
+    m_asyncStorage->deleteRequest(requestState.requestId, reply, onFailure);
+  }
+  else {
+    m_asyncStorage->updateRequest(requestState, reply, onFailure);
+  }
+}
 
-      payload = challengetlv::encodeDataContent(*requestState, issuedCert.getName());
+Block
+CaModule::encodeChallengeResult(RequestState& requestState)
+{
+  if (requestState.status == Status::PENDING) {
+    // if challenge succeeded
+    if (requestState.requestType == RequestType::NEW || requestState.requestType == RequestType::RENEW) {
+      auto issuedCert = issueCertificate(requestState);
+      try {
+        m_shared->certStore.insert(issuedCert);
+      }
+      catch (const std::exception& e) {
+        NDN_LOG_ERROR("Cannot store the issued certificate: " << e.what());
+      }
+      requestState.cert = issuedCert;
+      requestState.status = Status::SUCCESS;
       NDN_LOG_TRACE("Challenge succeeded. Certificate has been issued: " << issuedCert.getName());
+      // small enough certificates are returned along, saving the requester a fetch
+      const auto& wire = issuedCert.wireEncode();
+      return challengetlv::encodeDataContent(requestState, issuedCert.getName(),
+                                             wire.size() <= m_config.inlineCertMaxSize ? wire : Block());
     }
-    else if (requestState->requestType == RequestType::REVOKE) {
-      requestState->status = Status::SUCCESS;
-      m_storage->deleteRequest(requestState->requestId);
-      // TODO: where is the code to revoke?
-      payload = challengetlv::encodeDataContent(*requestState);
-      NDN_LOG_TRACE("Challenge succeeded. Certificate has been revoked");
+    else if (requestState.requestType == RequestType::REVOKE) {
+      try {
+        m_shared->revocations.revoke(requestState.cert);
+        requestState.status = Status::SUCCESS;
+        NDN_LOG_TRACE("Challenge succeeded. Certificate has been revoked");
+      }
+      catch (const std::exception& e) {
+        NDN_LOG_ERROR("Cannot record the revocation: " << e.what());
+        requestState.status = Status::FAILURE;
+      }
+      return challengetlv::encodeDataContent(requestState);
     }
   }
-  else {
-    payload = challengetlv::encodeDataContent(*requestState);
-    m_storage->updateRequest(*requestState);
-    NDN_LOG_TRACE("No failure no success. Challenge moves on");
+  NDN_LOG_TRACE("No failure no success. Challenge moves on");
+  return challengetlv::encodeDataContent(requestState);
+}
+
+void
+CaModule::rejectRequest(const Interest& request, const RequestId& requestId,
+                        ErrorCode error, const std::string& errorInfo, const ChallengeRound& round)
+{
+  auto reply = [this, name = request.getName(), error, errorInfo, round] {
+    m_face.put(generateErrorDataPacket(name, error, errorInfo));
+  };
+  m_shared->recentRequests.erase(requestId);
+  if (m_shared->stateSealer) {
+    reply();
+    return;
   }
+  m_asyncStorage->deleteRequest(requestId, reply, [reply] (const std::string& reason) {
+    NDN_LOG_ERROR("Cannot delete the certificate request state: " << reason);
+    reply();
+  });
+}
 
-  Data result;
-  result.setName(request.getName());
-  result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
-  result.setContent(payload);
-  m_keyChain.sign(result, signingByIdentity(m_config.caProfile.caPrefix));
-  m_face.put(result);
-  if (m_statusUpdateCallback) {
-    m_statusUpdateCallback(*requestState);
+void
+CaModule::onCertFetch(const Interest& request)
+{
+  auto cert = m_shared->certStore.find(request);
+  if (cert) {
+    NDN_LOG_TRACE("Serving issued certificate " << cert->getName());
+    m_face.put(*cert);
   }
 }
 
@@ -485,26 +1190,58 @@ CaModule::issueCertificate(const RequestState& requestState)
   ndn::security::SigningInfo signingInfo(ndn::security::SigningInfo::SIGNER_TYPE_ID,
                                          m_config.caProfile.caPrefix, signatureInfo);
   // Note: we should use KeyChain::makeCertificate() in future.
-  m_keyChain.sign(newCert, signingInfo);
+  sign(newCert, signingInfo);
   NDN_LOG_TRACE("new cert got signed" << newCert);
   return newCert;
 }
 
-std::unique_ptr <RequestState>
-CaModule::getCertificateRequest(const Interest& request)
+RequestId
+CaModule::makeRequestId(const Name& certName)
+{
+  uint8_t requestIdData[32];
+  Block certNameTlv = certName.wireEncode();
+  hmacSha256(certNameTlv.wire(), certNameTlv.size(), m_shared->requestIdGenKey.data(),
+             m_shared->requestIdGenKey.size(), requestIdData);
+  RequestId id;
+  std::memcpy(id.data(), requestIdData, id.size());
+  if (m_shardId) {
+    id[0] = *m_shardId;
+  }
+  return id;
+}
+
+std::optional<RequestId>
+CaModule::getRequestId(const Interest& request)
 {
   RequestId requestId;
   try {
     auto& component = request.getName().at(m_config.caProfile.caPrefix.size() + 2);
+    if (component.value_size() != requestId.size()) {
+      NDN_THROW(std::runtime_error("Request ID component has a wrong length"));
+    }
     std::memcpy(requestId.data(), component.value(), component.value_size());
   }
   catch (const std::exception& e) {
     NDN_LOG_ERROR("Cannot read the request ID out from the request: " << e.what());
+    return std::nullopt;
+  }
+  return requestId;
+}
+
+std::unique_ptr <RequestState>
+CaModule::getCertificateRequest(const Interest& request)
+{
+  auto requestId = getRequestId(request);
+  if (!requestId) {
     return nullptr;
   }
+  if (m_shared->stateSealer) {
+    auto requestState = openStateToken(request, *requestId);
+    return requestState ? std::make_unique<RequestState>(std::move(*requestState)) : nullptr;
+  }
   try {
-    NDN_LOG_TRACE("Request Id to query the database " << ndn::toHex(requestId));
-    return std::make_unique<RequestState>(m_storage->getRequest(requestId));
+    NDN_LOG_TRACE("Request Id to query the database " << ndn::toHex(*requestId));
+    return std::make_unique<RequestState>(m_shared->storage->getRequest(*requestId));
   }
   catch (const std::exception& e) {
     NDN_LOG_ERROR("Cannot get certificate request record from the storage: " << e.what());
@@ -512,6 +1249,54 @@ CaModule::getCertificateRequest(const Interest& request)
   }
 }
 
+Block
+CaModule::getStateToken(const Interest& request)
+{
+  const auto& params = request.getApplicationParameters();
+  params.parse();
+  auto it = params.find(tlv::StateToken);
+  return it == params.elements_end() ? Block() : *it;
+}
+
+std::optional<RequestState>
+CaModule::openStateToken(const Interest& request, const RequestId& requestId)
+{
+  try {
+    auto token = getStateToken(request);
+    if (!token.isValid()) {
+      NDN_THROW(std::runtime_error("No state token in the request"));
+    }
+    return m_shared->stateSealer->open(token, requestId);
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_ERROR("Cannot open the state token: " << e.what());
+    return std::nullopt;
+  }
+}
+
+Certificate
+CaModule::getCaCertificate()
+{
+  std::lock_guard lock(m_shared->keyChainMutex);
+  return m_shared->keyChain.getPib()
+                           .getIdentity(m_config.caProfile.caPrefix)
+                           .getDefaultKey()
+                           .getDefaultCertificate();
+}
+
+void
+CaModule::sign(Data& data)
+{
+  sign(data, signingByIdentity(m_config.caProfile.caPrefix));
+}
+
+void
+CaModule::sign(Data& data, const ndn::security::SigningInfo& signingInfo)
+{
+  std::lock_guard lock(m_shared->keyChainMutex);
+  m_shared->keyChain.sign(data, signingInfo);
+}
+
 void
 CaModule::onRegisterFailed(const std::string& reason)
 {
@@ -525,7 +1310,7 @@ CaModule::generateErrorDataPacket(const Name& name, ErrorCode error, const std::
   result.setName(name);
   result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
   result.setContent(errortlv::encodeDataContent(error, errorInfo));
-  m_keyChain.sign(result, signingByIdentity(m_config.caProfile.caPrefix));
+  sign(result);
   return result;
 }
 
@@ -21,13 +21,24 @@
 #ifndef NDNCERT_CA_MODULE_HPP
 #define NDNCERT_CA_MODULE_HPP
 
+#include "detail/admission-control.hpp"
 #include "detail/ca-configuration.hpp"
 #include "detail/crypto-helpers.hpp"
+#include "detail/ca-async-storage.hpp"
 #include "detail/ca-storage.hpp"
+#include "detail/issued-cert-store.hpp"
+#include "detail/recent-request-filter.hpp"
+#include "detail/revocation-registry.hpp"
+#include "detail/state-token.hpp"
+#include "detail/status-update-bus.hpp"
 
 #include <ndn-cxx/face.hpp>
+#include <ndn-cxx/ims/in-memory-storage-lru.hpp>
 #include <ndn-cxx/security/key-chain.hpp>
 
+#include <map>
+#include <mutex>
+
 namespace ndncert::ca {
 
 /**
@@ -36,15 +47,102 @@ namespace ndncert::ca {
  * fired whenever a request instance is created, challenge status is updated, and when certificate
  * is issued.
  *
+ * The callback runs synchronously in the Interest handlers; slow consumers should subscribe to
+ * CaModule::getStatusUpdateBus() instead.
+ *
  * @param RequestState The state of the certificate request whose status is updated.
  */
 using StatusUpdateCallback = std::function<void(const RequestState&)>;
 
+/**
+ * @brief A CHALLENGE round in progress, which ends when the last copy of the handle is destroyed.
+ */
+using ChallengeRound = std::shared_ptr<const RequestId>;
+
+/**
+ * @brief The state of a CA that outlives a single CaModule.
+ *
+ * Several CaModule instances, each serving the CA on its own Face and thread, may share one
+ * CaSharedState: requests created through one instance can then be continued through any other.
+ * The KeyChain is only used while holding keyChainMutex.
+ */
+class CaSharedState : boost::noncopyable
+{
+public:
+  /**
+   * @param concurrent Whether the state is shared by several threads; a storage that is not
+   *                   thread-safe is then wrapped in a CaSynchronizedStorage.
+   * @throw std::runtime_error The storage type is unknown.
+   */
+  CaSharedState(ndn::KeyChain& keyChain, const CaConfig& config, const std::string& storageType,
+                const std::string& storagePath, bool concurrent = false);
+
+  /**
+   * @brief Start a CHALLENGE round of @p requestId, unless one is already in progress.
+   *
+   * A round reads the state of the request, runs the challenge and writes the state back, so
+   * the rounds of a request must not overlap. If one is in progress, @p retry is queued and
+   * invoked, on the thread ending that round, once it ends; it is dropped if too many are queued.
+   * Thread-safe.
+   *
+   * @return The handle of the round, or nullptr if a round is already in progress.
+   */
+  ChallengeRound
+  startChallengeRound(const RequestId& requestId, std::function<void()> retry);
+
+  /**
+   * @brief Start the thread accessing the storage for all the CaModules, unless it is running.
+   *
+   * Not thread-safe, to be called while setting up the CaModules.
+   */
+  void
+  enableStorageThread(size_t queueCapacity = 1024);
+
+public:
+  ndn::KeyChain& keyChain;
+  std::mutex keyChainMutex;
+  std::unique_ptr<CaStorage> storage;
+  // set once enableStorageThread() is called, shared by the ThreadedAsyncCaStorage of all the CaModules
+  std::shared_ptr<CaStorageThread> storageThread;
+  IssuedCertStore certStore;
+  RevocationRegistry revocations;
+  // set in stateless mode, where requests are not kept in the storage
+  std::unique_ptr<StateTokenSealer> stateSealer;
+  // set when the configuration enables admission control
+  std::unique_ptr<AdmissionController> admission;
+  // requests recently created, to answer duplicate NEW and REVOKE Interests cheaply
+  RecentRequestFilter recentRequests;
+  std::array<uint8_t, 32> requestIdGenKey;
+
+private:
+  struct ChallengeRounds
+  {
+    std::mutex mutex;
+    // the CHALLENGEs waiting for the round in progress of each request
+    std::map<RequestId, std::vector<std::function<void()>>> inProgress;
+  };
+  // outlives the CaSharedState while handles of rounds exist
+  std::shared_ptr<ChallengeRounds> m_challengeRounds = std::make_shared<ChallengeRounds>();
+};
+
 class CaModule : boost::noncopyable
 {
 public:
+  /**
+   * @param storageType The type of the request storage, e.g., "ca-storage-sqlite3" or
+   *                    "ca-storage-cached:sqlite3".
+   * @param storagePath The locator passed to the storage, see CaStorage::parseLocator.
+   * @throw std::runtime_error The storage type is unknown.
+   */
   CaModule(ndn::Face& face, ndn::KeyChain& keyChain, const std::string& configPath,
-           const std::string& storageType = "ca-storage-sqlite3");
+           const std::string& storageType = "ca-storage-sqlite3", const std::string& storagePath = "");
+
+  /**
+   * @brief Serve the CA of @p sharedState on @p face.
+   *
+   * The Interest handlers of this instance run on the thread processing the events of @p face.
+   */
+  CaModule(ndn::Face& face, std::shared_ptr<CaSharedState> sharedState, const std::string& configPath);
 
   ~CaModule();
 
@@ -57,16 +155,95 @@ public:
   const std::unique_ptr<CaStorage>&
   getCaStorage() const
   {
-    return m_storage;
+    return m_shared->storage;
+  }
+
+  IssuedCertStore&
+  getIssuedCertStore()
+  {
+    return m_shared->certStore;
+  }
+
+  RevocationRegistry&
+  getRevocationRegistry()
+  {
+    return m_shared->revocations;
+  }
+
+  const std::shared_ptr<CaSharedState>&
+  getSharedState() const
+  {
+    return m_shared;
+  }
+
+  /**
+   * @brief Access the storage from a dedicated I/O thread instead of the Face thread.
+   *
+   * By default, storage operations run synchronously in the Interest handlers. Once enabled,
+   * the handlers continue on the Face thread when the storage operation completes, and requests
+   * arriving while @p queueCapacity operations are pending are rejected.
+   * The thread is that of the CaSharedState, shared by all the CaModules enabling it; the
+   * queue capacity is set by the first of them.
+   * The storage returned by getCaStorage() must not be used directly afterwards.
+   */
+  void
+  enableStorageThread(size_t queueCapacity = 1024);
+
+  /**
+   * @brief Run as one of several CA instances serving the same CA prefix without shared storage.
+   *
+   * The request IDs allocated by this instance start with @p shardId, and NEW responses carry
+   * the forwarding hint /<CA prefix>/CA/SHARD/<shardId>, which this instance registers, so that
+   * the CHALLENGE Interests of a request reach the instance that keeps its state. CHALLENGE
+   * Interests of the other shards are dropped: with the multicast strategy on /<CA prefix>/CA,
+   * those of requesters ignoring the hint still reach the right instance.
+   *
+   * With the multicast strategy, every instance also receives each NEW, RENEW and REVOKE
+   * Interest. When @p nShards is set, the certificate name of such a request is hashed to one
+   * of the shards, and the other instances drop it, so that a request is created only once.
+   * Otherwise, a load-balancing strategy must be set on /<CA prefix>/CA/NEW, /<CA prefix>/CA/RENEW
+   * and /<CA prefix>/CA/REVOKE, the multicast strategy being set on /<CA prefix>/CA/CHALLENGE only.
+   *
+   * @param nShards The number of shards, numbered from 0, or zero to answer all requests.
+   */
+  void
+  enableSharding(uint8_t shardId, size_t nShards = 0);
+
+  std::optional<uint8_t>
+  getShardId() const
+  {
+    return m_shardId;
   }
 
   void
   setStatusUpdateCallback(const StatusUpdateCallback& onUpdateCallback);
 
+  /**
+   * @brief The bus receiving every status update, in addition to the status update callback.
+   */
+  StatusUpdateBus&
+  getStatusUpdateBus()
+  {
+    return m_statusUpdateBus;
+  }
+
   Data
   getCaProfileData();
 
+  /**
+   * @return The admission control statistics, unless admission control is disabled.
+   */
+  std::optional<AdmissionController::Statistics>
+  getAdmissionStatistics() const;
+
 NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  /**
+   * @brief Pass the Interest to admission control, shedding it if not admitted.
+   * @return Whether the Interest should be processed.
+   */
+  bool
+  admit(const Interest& request, CaEndpoint endpoint);
+
   void
   onCaProfileDiscovery(const Interest& request);
 
@@ -76,38 +253,149 @@ NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   void
   onNewRenewRevoke(const Interest& request, RequestType requestType);
 
+  /**
+   * @brief Store the new request, then reply to its NEW or REVOKE Interest.
+   * @param challengeResponse the reply to the challenge embedded in a NEW Interest, if any.
+   */
+  void
+  onNewRenewRevokeResult(const Interest& request, const RequestState& requestState,
+                         const std::vector<uint8_t>& selfPubKey, const std::array<uint8_t, 32>& salt,
+                         const Block& challengeResponse = {});
+
+  /**
+   * @brief Issue a certificate to the holder of a valid certificate of this CA, without challenge.
+   */
+  void
+  onRenew(const Interest& request);
+
+  /**
+   * @brief Serve the revocation dataset, see revocationtlv.
+   */
+  void
+  onRevocationDataset(const Interest& request);
+
+  /**
+   * @brief Report the status of one or several certificates, see statustlv.
+   */
+  void
+  onStatus(const Interest& request);
+
   void
   onChallenge(const Interest& request);
 
+  /**
+   * @brief Handle an admitted CHALLENGE once no other round of its request is in progress.
+   */
+  void
+  startChallengeRound(const Interest& request, const RequestId& requestId);
+
+  void
+  onCertFetch(const Interest& request);
+
+  void
+  onChallengeRequestState(const Interest& request, RequestState requestState, const ChallengeRound& round);
+
+  /**
+   * @brief Reply to a CHALLENGE once its challenge module has handled it.
+   */
+  void
+  onChallengeResult(const Interest& request, RequestState requestState,
+                    const std::tuple<ErrorCode, std::string>& errorInfo, const ChallengeRound& round);
+
+  /**
+   * @brief Issue the certificate if the challenge succeeded, then encode the CHALLENGE response.
+   */
+  Block
+  encodeChallengeResult(RequestState& requestState);
+
+  /**
+   * @brief Delete the request from the storage, then reply with an error and end @p round.
+   */
+  void
+  rejectRequest(const Interest& request, const RequestId& requestId,
+                ErrorCode error, const std::string& errorInfo, const ChallengeRound& round);
+
   void
   onRegisterFailed(const std::string& reason);
 
+  void
+  notifyStatusUpdate(const RequestState& requestState);
+
+  Name
+  getShardForwardingHint() const;
+
+  /**
+   * @brief Whether a request for @p certName is answered by another shard.
+   */
+  bool
+  isOtherShard(const Name& certName) const;
+
+  std::optional<RequestId>
+  getRequestId(const Interest& request);
+
+  /**
+   * @brief The ID of the request for @p certName, which is the same for all its NEW Interests.
+   */
+  RequestId
+  makeRequestId(const Name& certName);
+
   std::unique_ptr<RequestState>
   getCertificateRequest(const Interest& request);
 
+  /**
+   * @brief The state token in the parameters of a CHALLENGE, or an invalid block.
+   */
+  static Block
+  getStateToken(const Interest& request);
+
+  std::optional<RequestState>
+  openStateToken(const Interest& request, const RequestId& requestId);
+
   Certificate
   issueCertificate(const RequestState& requestState);
 
+  void
+  init();
+
   void
   registerPrefix();
 
+  Certificate
+  getCaCertificate();
+
+  void
+  sign(Data& data);
+
+  void
+  sign(Data& data, const ndn::security::SigningInfo& signingInfo);
+
   Data
   generateErrorDataPacket(const Name& name, ErrorCode error, const std::string& errorInfo);
 
 NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   ndn::Face& m_face;
   CaConfig m_config;
-  std::unique_ptr<CaStorage> m_storage;
-  ndn::KeyChain& m_keyChain;
-  uint8_t m_requestIdGenKey[32];
+  std::shared_ptr<CaSharedState> m_shared;
+  std::unique_ptr<AsyncCaStorage> m_asyncStorage;
+  std::optional<uint8_t> m_shardId;
+  size_t m_nShards = 0;
   std::unique_ptr<Data> m_profileData;
+  std::mutex m_profileDataMutex;
+  // signed segments of the revocation dataset, only accessed on the thread of m_face
+  ndn::InMemoryStorageLru m_revocationSegments{256};
+  // signed status responses, named after the registry version so that a revocation invalidates them
+  ndn::InMemoryStorageLru m_statusResponses{m_face.getIoService(), 1024};
   /**
    * StatusUpdate Callback function
    */
   StatusUpdateCallback m_statusUpdateCallback;
+  std::mutex m_statusUpdateCallbackMutex;
+  StatusUpdateBus m_statusUpdateBus;
 
   std::list<ndn::RegisteredPrefixHandle> m_registeredPrefixHandles;
   std::list<ndn::InterestFilterHandle> m_interestFilterHandles;
+  // challenges that complete after destruction must not touch the module
+  std::shared_ptr<bool> m_isAlive = std::make_shared<bool>(true);
 };
 
 } // namespace ndncert::ca
@@ -19,6 +19,9 @@
  */
 
 #include "challenge-email.hpp"
+#include "detail/smtp-mailer.hpp"
+
+#include <mutex>
 #include <regex>
 #include <boost/process.hpp>
 
@@ -32,6 +35,9 @@ const std::string ChallengeEmail::WRONG_CODE = "wrong-code";
 const std::string ChallengeEmail::PARAMETER_KEY_EMAIL = "email";
 const std::string ChallengeEmail::PARAMETER_KEY_CODE = "code";
 
+static std::mutex mailerMutex;
+static std::shared_ptr<ca::SmtpMailer> mailer;
+
 ChallengeEmail::ChallengeEmail(const std::string& scriptPath,
                                const size_t& maxAttemptTimes,
                                const time::seconds secretLifetime)
@@ -154,10 +160,27 @@ ChallengeEmail::isValidEmailAddress(const std::string& emailAddress)
   return std::regex_match(emailAddress, emailPattern);
 }
 
+void
+ChallengeEmail::setMailer(std::shared_ptr<ca::SmtpMailer> smtpMailer)
+{
+  std::lock_guard<std::mutex> lock(mailerMutex);
+  mailer = std::move(smtpMailer);
+}
+
 void
 ChallengeEmail::sendEmail(const std::string& emailAddress, const std::string& secret,
                           const ca::RequestState& request) const
 {
+  std::shared_ptr<ca::SmtpMailer> smtpMailer;
+  {
+    std::lock_guard<std::mutex> lock(mailerMutex);
+    smtpMailer = mailer;
+  }
+  if (smtpMailer != nullptr && smtpMailer->send(emailAddress, secret, request.caPrefix, request.cert.getName())) {
+    NDN_LOG_TRACE("Email to " << emailAddress << " queued for delivery");
+    return;
+  }
+
   std::string command = m_sendEmailScript;
   command += " \"" + emailAddress + "\" \"" + secret + "\" \"" +
              request.caPrefix.toUri() + "\" \"" +
@@ -25,6 +25,10 @@
 
 namespace ndncert {
 
+namespace ca {
+class SmtpMailer;
+} // namespace ca
+
 /**
  * @brief Provide Email based challenge
  *
@@ -45,6 +49,9 @@ namespace ndncert {
  * Failure info when application fails:
  *   FAILURE_MAXRETRY: When run out retry times.
  *   FAILURE_TIMEOUT: When the secret lifetime expires.
+ *
+ * The verification code is sent by the SmtpMailer set with setMailer(), if any. Otherwise, or
+ * when the queue of the mailer is full, the email sending script is run and waited for.
  */
 class ChallengeEmail : public ChallengeModule
 {
@@ -72,6 +79,13 @@ public:
   static const std::string PARAMETER_KEY_EMAIL;
   static const std::string PARAMETER_KEY_CODE;
 
+  /**
+   * @brief Sets the mailer used by all the email challenges of the process, nullptr to only use
+   *        the email sending script.
+   */
+  static void
+  setMailer(std::shared_ptr<ca::SmtpMailer> mailer);
+
 NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   static bool
   isValidEmailAddress(const std::string& emailAddress);
@@ -49,6 +49,14 @@ ChallengeModule::createChallengeModule(const std::string& challengeType)
   return i == factory.end() ? nullptr : i->second();
 }
 
+void
+ChallengeModule::handleChallengeRequestAsync(const Block& params, ca::RequestState request,
+                                             boost::asio::io_context&, const ChallengeCallback& callback)
+{
+  auto result = handleChallengeRequest(params, request);
+  callback(std::move(result), std::move(request));
+}
+
 ChallengeModule::ChallengeFactory&
 ChallengeModule::getFactory()
 {
@@ -23,6 +23,8 @@
 
 #include "detail/ca-request-state.hpp"
 
+#include <boost/asio/io_context.hpp>
+
 #include <map>
 
 namespace ndncert {
@@ -39,6 +41,32 @@ public:
   virtual std::tuple<ErrorCode, std::string>
   handleChallengeRequest(const Block& params, ca::RequestState& request) = 0;
 
+  using ChallengeCallback = std::function<void(std::tuple<ErrorCode, std::string> result,
+                                               ca::RequestState request)>;
+
+  /**
+   * @brief Handle a CHALLENGE request without blocking on external services.
+   *
+   * @p callback receives the outcome and the updated @p request on the thread running @p io,
+   * either before this function returns or later. The caller keeps the module alive until then.
+   * The default implementation calls handleChallengeRequest() and completes before returning.
+   */
+  virtual void
+  handleChallengeRequestAsync(const Block& params, ca::RequestState request, boost::asio::io_context& io,
+                              const ChallengeCallback& callback);
+
+  /**
+   * @brief Whether the first round of the challenge may be carried by the NEW Interest.
+   *
+   * The NEW Interest is signed but not encrypted, so this only holds for challenges whose
+   * parameters before the challenge starts are not confidential.
+   */
+  virtual bool
+  canEmbedInNew() const
+  {
+    return false;
+  }
+
   // For Client
   virtual std::multimap<std::string, std::string>
   getRequestedParameterList(Status status, const std::string& challengeStatus) = 0;
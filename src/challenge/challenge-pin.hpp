@@ -53,6 +53,13 @@ public:
   std::tuple<ErrorCode, std::string>
   handleChallengeRequest(const Block& params, ca::RequestState& request) override;
 
+  bool
+  canEmbedInNew() const override
+  {
+    // the selection carries no parameter
+    return true;
+  }
+
   // For Client
   std::multimap<std::string, std::string>
   getRequestedParameterList(Status status, const std::string& challengeStatus) override;
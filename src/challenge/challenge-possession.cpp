@@ -27,6 +27,8 @@
 
 #include <boost/property_tree/json_parser.hpp>
 
+#include <mutex>
+
 namespace ndncert {
 
 NDN_LOG_INIT(ndncert.challenge.possession);
@@ -37,6 +39,12 @@ const std::string ChallengePossession::PARAMETER_KEY_NONCE = "nonce";
 const std::string ChallengePossession::PARAMETER_KEY_PROOF = "proof";
 const std::string ChallengePossession::NEED_PROOF = "need-proof";
 
+/**
+ * @brief The trust anchors loaded from each configuration file, shared by the challenges of the process.
+ */
+static std::mutex trustAnchorsMutex;
+static std::map<std::string, std::shared_ptr<TrustAnchorStore>> trustAnchorsByFile;
+
 ChallengePossession::ChallengePossession(const std::string& configPath)
     : ChallengeModule("Possession", 1, time::seconds(60))
 {
@@ -64,7 +72,7 @@ ChallengePossession::parseConfigFile()
     NDN_THROW(std::runtime_error("Error processing configuration file: " + m_configFile + " no data"));
   }
 
-  m_trustAnchors.clear();
+  std::vector<Certificate> anchors;
   auto anchorList = config.get_child("anchor-list");
   auto it = anchorList.begin();
   for (; it != anchorList.end(); it++) {
@@ -74,8 +82,12 @@ ChallengePossession::parseConfigFile()
       NDN_LOG_ERROR("Cannot load the certificate from config file");
       continue;
     }
-    m_trustAnchors.push_back(*cert);
+    anchors.push_back(*cert);
   }
+  m_trustAnchors = std::make_shared<TrustAnchorStore>(std::move(anchors));
+
+  std::lock_guard<std::mutex> lock(trustAnchorsMutex);
+  trustAnchorsByFile[m_configFile] = m_trustAnchors;
 }
 
 // For CA
@@ -83,8 +95,16 @@ std::tuple<ErrorCode, std::string>
 ChallengePossession::handleChallengeRequest(const Block& params, ca::RequestState& request)
 {
   params.parse();
-  if (m_trustAnchors.empty()) {
-    parseConfigFile();
+  if (m_trustAnchors == nullptr) {
+    std::unique_lock<std::mutex> lock(trustAnchorsMutex);
+    auto it = trustAnchorsByFile.find(m_configFile);
+    if (it != trustAnchorsByFile.end()) {
+      m_trustAnchors = it->second;
+    }
+    else {
+      lock.unlock();
+      parseConfigFile();
+    }
   }
   Certificate credential;
   const uint8_t* signature = nullptr;
@@ -118,14 +138,7 @@ ChallengePossession::handleChallengeRequest(const Block& params, ca::RequestStat
     if (!credential.hasContent() || signatureLen != 0) {
       return returnWithError(request, ErrorCode::BAD_INTEREST_FORMAT, "Cannot find certificate");
     }
-    auto keyLocator = credential.getSignatureInfo().getKeyLocator().getName();
-    ndn::security::transform::PublicKey key;
-    key.loadPkcs8(credential.getPublicKey());
-    bool checkOK = std::any_of(m_trustAnchors.begin(), m_trustAnchors.end(), [&] (const auto& anchor) {
-      return (anchor.getKeyName() == keyLocator || anchor.getName() == keyLocator) &&
-             ndn::security::verifySignature(credential, anchor);
-    });
-    if (!checkOK) {
+    if (!m_trustAnchors->verify(credential)) {
       return returnWithError(request, ErrorCode::INVALID_PARAMETER, "Certificate cannot be verified");
     }
 
@@ -134,10 +147,11 @@ ChallengePossession::handleChallengeRequest(const Block& params, ca::RequestStat
     ndn::random::generateSecureBytes(secretCode);
     JsonSection secretJson;
     secretJson.add(PARAMETER_KEY_NONCE, toHex(secretCode));
-    const auto& credBlock = credential.wireEncode();
-    secretJson.add(PARAMETER_KEY_CREDENTIAL_CERT, toHex({credBlock.wire(), credBlock.size()}));
     NDN_LOG_TRACE("Secret for request " << toHex(request.requestId) << " : " << toHex(secretCode));
-    return returnWithNewChallengeStatus(request, NEED_PROOF, std::move(secretJson), m_maxAttemptTimes, m_secretLifetime);
+    auto result = returnWithNewChallengeStatus(request, NEED_PROOF, std::move(secretJson), m_maxAttemptTimes,
+                                               m_secretLifetime);
+    request.challengeState->binarySecret = credential.wireEncode();
+    return result;
   }
   else if (request.challengeState && request.challengeState->challengeStatus == NEED_PROOF) {
     NDN_LOG_TRACE("Challenge Interest (proof) arrives. Check the proof");
@@ -145,7 +159,13 @@ ChallengePossession::handleChallengeRequest(const Block& params, ca::RequestStat
     if (credential.hasContent() || signatureLen == 0) {
       return returnWithError(request, ErrorCode::BAD_INTEREST_FORMAT, "Cannot find certificate");
     }
-    credential = Certificate(Block(ndn::fromHex(request.challengeState->secrets.get(PARAMETER_KEY_CREDENTIAL_CERT, ""))));
+    if (request.challengeState->binarySecret.isValid()) {
+      credential = Certificate(request.challengeState->binarySecret);
+    }
+    else {
+      // requests stored by earlier versions keep the credential in hex
+      credential = Certificate(Block(ndn::fromHex(request.challengeState->secrets.get(PARAMETER_KEY_CREDENTIAL_CERT, ""))));
+    }
     auto secretCode = *ndn::fromHex(request.challengeState->secrets.get(PARAMETER_KEY_NONCE, ""));
 
     //check the proof
@@ -21,6 +21,7 @@
 #define NDNCERT_CHALLENGE_POSSESSION_HPP
 
 #include "challenge-module.hpp"
+#include "detail/trust-anchor-store.hpp"
 
 #include <ndn-cxx/security/key-chain.hpp>
 
@@ -43,6 +44,10 @@ namespace ndncert {
  *   3. The challenge module will Provide a 16 octet random number data.
  *   3. The Requester signs the signed Data to prove it possess the private key
  *
+ * The trust anchors of a configuration file are loaded once and shared by the challenges of the
+ * process, see TrustAnchorStore. The credential is kept in the challenge state as is until the
+ * proof arrives.
+ *
  * Failure info when application fails:
  *   INVALID_PARAMETER: When the cert issued from trust anchor or self-signed cert
  *     cannot be validated.
@@ -58,6 +63,13 @@ public:
   std::tuple<ErrorCode, std::string>
   handleChallengeRequest(const Block& params, ca::RequestState& request) override;
 
+  bool
+  canEmbedInNew() const override
+  {
+    // the credential is a public certificate
+    return true;
+  }
+
   // For Client
   std::multimap<std::string, std::string>
   getRequestedParameterList(Status status, const std::string& challengeStatus) override;
@@ -82,7 +94,7 @@ NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   parseConfigFile();
 
 NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
-  std::list<Certificate> m_trustAnchors;
+  std::shared_ptr<TrustAnchorStore> m_trustAnchors;
   std::string m_configFile;
 };
 
@@ -0,0 +1,339 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "challenge-token.hpp"
+#include "detail/crypto-helpers.hpp"
+
+#include <ndn-cxx/util/random.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+
+namespace ndncert {
+
+NDN_LOG_INIT(ndncert.challenge.token);
+NDNCERT_REGISTER_CHALLENGE(ChallengeToken, "token");
+
+const std::string ChallengeToken::PARAMETER_KEY_TOKEN = "token";
+
+// token: expiry as seconds since the epoch (8) | serial (8) | HMAC-SHA256 (32)
+const size_t EXPIRY_SIZE = 8;
+const size_t SERIAL_SIZE = 8;
+const size_t MAC_SIZE = 32;
+const size_t TOKEN_SIZE = EXPIRY_SIZE + SERIAL_SIZE + MAC_SIZE;
+const size_t MIN_KEY_SIZE = 16;
+// record of a spent token: expiry as seconds since the epoch (8) | fingerprint (8)
+const size_t SPENT_RECORD_SIZE = 16;
+
+/**
+ * @brief The authorities loaded from each configuration file, shared by the challenges of the process.
+ */
+static std::mutex authoritiesMutex;
+static std::map<std::string, std::shared_ptr<ChallengeToken::Authority>> authoritiesByFile;
+
+static void
+writeBigU64(uint8_t* dst, uint64_t value)
+{
+  for (int i = 7; i >= 0; i--) {
+    dst[i] = static_cast<uint8_t>(value & 0xFF);
+    value >>= 8;
+  }
+}
+
+static uint64_t
+readBigU64(const uint8_t* src)
+{
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++) {
+    value = (value << 8) | src[i];
+  }
+  return value;
+}
+
+static void
+computeMac(ndn::span<const uint8_t> key, const Name& identity, const uint8_t* expiryAndSerial, uint8_t* mac)
+{
+  const auto& name = identity.wireEncode();
+  std::vector<uint8_t> input(name.begin(), name.end());
+  input.insert(input.end(), expiryAndSerial, expiryAndSerial + EXPIRY_SIZE + SERIAL_SIZE);
+  hmacSha256(input.data(), input.size(), key.data(), key.size(), mac);
+}
+
+ChallengeToken::ChallengeToken(const std::string& configPath)
+  : ChallengeModule("token", 1, time::seconds(60))
+{
+  if (configPath.empty()) {
+    m_configFile = std::string(NDNCERT_SYSCONFDIR) + "/ndncert/challenge-token.conf";
+  }
+  else {
+    m_configFile = configPath;
+  }
+}
+
+std::string
+ChallengeToken::mintToken(ndn::span<const uint8_t> key, const Name& identity,
+                          const time::system_clock::time_point& expiry)
+{
+  std::array<uint8_t, TOKEN_SIZE> token{};
+  writeBigU64(token.data(), time::toUnixTimestamp(expiry).count() / 1000);
+  ndn::random::generateSecureBytes({token.data() + EXPIRY_SIZE, SERIAL_SIZE});
+  computeMac(key, identity, token.data(), token.data() + EXPIRY_SIZE + SERIAL_SIZE);
+  return ndn::toHex(token, false);
+}
+
+void
+ChallengeToken::generateKey(const std::string& configPath)
+{
+  std::array<uint8_t, 32> key{};
+  ndn::random::generateSecureBytes(key);
+  JsonSection config;
+  config.put("key", ndn::toHex(key, false));
+  boost::property_tree::write_json(configPath, config);
+}
+
+static JsonSection
+readConfig(const std::string& configPath)
+{
+  JsonSection config;
+  try {
+    boost::property_tree::read_json(configPath, config);
+  }
+  catch (const boost::property_tree::file_parser_error& error) {
+    NDN_THROW(std::runtime_error("Failed to parse configuration file " + configPath + ": " +
+                                 error.message() + " on line " + std::to_string(error.line())));
+  }
+  return config;
+}
+
+std::vector<uint8_t>
+ChallengeToken::loadKey(const std::string& configPath)
+{
+  auto config = readConfig(configPath);
+  ndn::ConstBufferPtr key;
+  try {
+    key = ndn::fromHex(config.get("key", ""));
+  }
+  catch (const std::exception&) {
+    NDN_THROW(std::runtime_error("Error processing configuration file: " + configPath + " key is not hex"));
+  }
+  if (key->size() < MIN_KEY_SIZE) {
+    NDN_THROW(std::runtime_error("Error processing configuration file: " + configPath + " key is shorter than " +
+                                 std::to_string(MIN_KEY_SIZE) + " octets"));
+  }
+  return std::vector<uint8_t>(key->begin(), key->end());
+}
+
+std::string
+ChallengeToken::loadSpentTokensPath(const std::string& configPath)
+{
+  return readConfig(configPath).get("spent-tokens", configPath + ".spent");
+}
+
+ChallengeToken::Authority::Authority(std::vector<uint8_t> key, const std::string& spentTokensPath)
+  : m_key(std::move(key))
+  , m_spentTokensPath(spentTokensPath)
+{
+  if (!m_spentTokensPath.empty()) {
+    loadSpentTokens();
+  }
+}
+
+ChallengeToken::Authority::~Authority()
+{
+  if (m_spentTokensFd >= 0) {
+    ::close(m_spentTokensFd);
+  }
+}
+
+void
+ChallengeToken::Authority::loadSpentTokens()
+{
+  auto now = time::system_clock::now();
+  std::vector<uint8_t> live;
+  std::ifstream file(m_spentTokensPath, std::ios::binary);
+  std::array<uint8_t, SPENT_RECORD_SIZE> record{};
+  // a record being appended when the process stopped is incomplete and ignored
+  while (file.read(reinterpret_cast<char*>(record.data()), record.size())) {
+    auto expiry = time::fromUnixTimestamp(time::seconds(readBigU64(record.data())));
+    auto fingerprint = readBigU64(record.data() + EXPIRY_SIZE);
+    if (expiry < now || !m_spent.insert(fingerprint).second) {
+      continue;
+    }
+    m_expiry.emplace(expiry, fingerprint);
+    live.insert(live.end(), record.begin(), record.end());
+  }
+  file.close();
+
+  // the expired tokens are dropped by rewriting the file
+  auto tmpPath = m_spentTokensPath + ".tmp";
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(live.data()), live.size());
+    if (!out.flush()) {
+      NDN_THROW(std::runtime_error("Cannot write the spent tokens to " + tmpPath));
+    }
+  }
+  boost::system::error_code ec;
+  boost::filesystem::rename(tmpPath, m_spentTokensPath, ec);
+  if (ec) {
+    NDN_THROW(std::runtime_error("Cannot write the spent tokens to " + m_spentTokensPath + ": " + ec.message()));
+  }
+
+  m_spentTokensFd = ::open(m_spentTokensPath.data(), O_WRONLY | O_APPEND | O_CLOEXEC);
+  if (m_spentTokensFd < 0) {
+    NDN_THROW(std::runtime_error("Cannot open " + m_spentTokensPath + ": " + std::strerror(errno)));
+  }
+  NDN_LOG_DEBUG("Loaded " << m_spent.size() << " spent tokens from " << m_spentTokensPath);
+}
+
+std::string
+ChallengeToken::Authority::spend(const std::string& token, const Name& identity)
+{
+  if (token.size() != 2 * TOKEN_SIZE) {
+    return "Malformed token.";
+  }
+  ndn::ConstBufferPtr bytes;
+  try {
+    bytes = ndn::fromHex(token);
+  }
+  catch (const std::exception&) {
+    return "Malformed token.";
+  }
+
+  auto now = time::system_clock::now();
+  auto expiry = time::fromUnixTimestamp(time::seconds(readBigU64(bytes->data())));
+  if (expiry < now) {
+    return "Token expired.";
+  }
+  std::array<uint8_t, MAC_SIZE> mac{};
+  computeMac(m_key, identity, bytes->data(), mac.data());
+  const uint8_t* givenMac = bytes->data() + EXPIRY_SIZE + SERIAL_SIZE;
+  uint8_t diff = 0;
+  for (size_t i = 0; i < MAC_SIZE; i++) {
+    diff |= mac[i] ^ givenMac[i];
+  }
+  if (diff != 0) {
+    return "Invalid token.";
+  }
+
+  uint64_t fingerprint = readBigU64(mac.data());
+  std::lock_guard<std::mutex> lock(m_mutex);
+  while (!m_expiry.empty() && m_expiry.begin()->first < now) {
+    m_spent.erase(m_expiry.begin()->second);
+    m_expiry.erase(m_expiry.begin());
+  }
+  if (!m_spent.insert(fingerprint).second) {
+    return "Token already spent.";
+  }
+
+  // the token is spent once it is on disk, so that a restart does not make it valid again
+  if (m_spentTokensFd >= 0) {
+    std::array<uint8_t, SPENT_RECORD_SIZE> record{};
+    std::memcpy(record.data(), bytes->data(), EXPIRY_SIZE);
+    writeBigU64(record.data() + EXPIRY_SIZE, fingerprint);
+    if (::write(m_spentTokensFd, record.data(), record.size()) != static_cast<ssize_t>(record.size()) ||
+        ::fsync(m_spentTokensFd) != 0) {
+      NDN_LOG_ERROR("Cannot record a spent token in " << m_spentTokensPath << ": " << std::strerror(errno));
+      // drop a partial record, which would shift the records appended after it
+      auto size = ::lseek(m_spentTokensFd, 0, SEEK_END);
+      if (size > 0 && ::ftruncate(m_spentTokensFd, size - size % SPENT_RECORD_SIZE) != 0) {
+        NDN_LOG_ERROR("Cannot truncate " << m_spentTokensPath << ": " << std::strerror(errno));
+      }
+      m_spent.erase(fingerprint);
+      return "Token cannot be spent now.";
+    }
+  }
+  m_expiry.emplace(expiry, fingerprint);
+  return "";
+}
+
+// For CA
+std::tuple<ErrorCode, std::string>
+ChallengeToken::handleChallengeRequest(const Block& params, ca::RequestState& request)
+{
+  params.parse();
+  if (m_authority == nullptr) {
+    std::lock_guard<std::mutex> lock(authoritiesMutex);
+    auto& authority = authoritiesByFile[m_configFile];
+    if (authority == nullptr) {
+      authority = std::make_shared<Authority>(loadKey(m_configFile), loadSpentTokensPath(m_configFile));
+    }
+    m_authority = authority;
+  }
+
+  if (request.status == Status::BEFORE_CHALLENGE) {
+    NDN_LOG_TRACE("Challenge Interest arrives. Check the token");
+    auto value = params.find(tlv::ParameterValue);
+    if (value == params.elements_end()) {
+      return returnWithError(request, ErrorCode::BAD_INTEREST_FORMAT, "Cannot find token.");
+    }
+    auto identity = request.cert.getIdentity();
+    auto reason = m_authority->spend(readString(*value), identity);
+    if (!reason.empty()) {
+      NDN_LOG_TRACE("Token for " << identity << " refused: " << reason);
+      return returnWithError(request, ErrorCode::INVALID_PARAMETER, reason);
+    }
+    NDN_LOG_TRACE("Token for " << identity << " spent. Challenge succeeded.");
+    return returnWithSuccess(request);
+  }
+  return returnWithError(request, ErrorCode::INVALID_PARAMETER, "Unexpected status or challenge status");
+}
+
+// For Client
+std::multimap<std::string, std::string>
+ChallengeToken::getRequestedParameterList(Status status, const std::string& challengeStatus)
+{
+  std::multimap<std::string, std::string> result;
+  if (status == Status::BEFORE_CHALLENGE) {
+    result.emplace(PARAMETER_KEY_TOKEN, "Please input your enrollment token");
+  }
+  else {
+    NDN_THROW(std::runtime_error("Unexpected status or challenge status."));
+  }
+  return result;
+}
+
+Block
+ChallengeToken::genChallengeRequestTLV(Status status, const std::string& challengeStatus,
+                                       const std::multimap<std::string, std::string>& params)
+{
+  Block request(tlv::EncryptedPayload);
+  if (status == Status::BEFORE_CHALLENGE) {
+    if (params.size() != 1 || params.find(PARAMETER_KEY_TOKEN) == params.end()) {
+      NDN_THROW(std::runtime_error("Wrong parameter provided."));
+    }
+    request.push_back(ndn::makeStringBlock(tlv::SelectedChallenge, CHALLENGE_TYPE));
+    request.push_back(ndn::makeStringBlock(tlv::ParameterKey, PARAMETER_KEY_TOKEN));
+    request.push_back(ndn::makeStringBlock(tlv::ParameterValue, params.find(PARAMETER_KEY_TOKEN)->second));
+  }
+  else {
+    NDN_THROW(std::runtime_error("Unexpected status or challenge status."));
+  }
+  request.encode();
+  return request;
+}
+
+} // namespace ndncert
@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_CHALLENGE_TOKEN_HPP
+#define NDNCERT_CHALLENGE_TOKEN_HPP
+
+#include "challenge-module.hpp"
+
+#include <mutex>
+#include <unordered_set>
+
+namespace ndncert {
+
+/**
+ * @brief Provide a challenge based on enrollment tokens minted in advance
+ *
+ * For fleets of devices whose identities are provisioned beforehand. The CA administrator mints
+ * a token for each identity with ndncert-mint-tokens, under a key held by the CA, and installs it
+ * on the device. The token authorizes a single enrollment of that identity before an expiry.
+ *
+ * The main process of this challenge module is:
+ *   1. Requester provides the token together with the challenge selection.
+ *   2. The challenge module checks the token with a single HMAC and succeeds.
+ *
+ * A token is the hex encoding of its expiry (8 octets, seconds since the Unix epoch), a random
+ * serial (8 octets) and an HMAC-SHA256 over the identity name, the expiry and the serial. The
+ * CA keeps no record of the minted tokens: it only remembers the spent tokens until they expire.
+ * The spent tokens are appended to a file, from which those not yet expired are loaded when the
+ * challenge is first used, so that a token stays spent across restarts. Replicas sharing a key
+ * must not share tokens.
+ *
+ * The configuration file is a JSON object whose "key" is the hex-encoded HMAC key, and whose
+ * optional "spent-tokens" is the file of the spent tokens, by default the configuration file
+ * path followed by ".spent". When "spent-tokens" is empty, the spent tokens are only kept in
+ * memory, and a token can be spent again after a restart.
+ *
+ * Failure info when application fails:
+ *   INVALID_PARAMETER: When the token is malformed, forged, expired, or already spent.
+ */
+class ChallengeToken : public ChallengeModule
+{
+public:
+  explicit
+  ChallengeToken(const std::string& configPath = "");
+
+  // For CA
+  std::tuple<ErrorCode, std::string>
+  handleChallengeRequest(const Block& params, ca::RequestState& request) override;
+
+  // For Client
+  std::multimap<std::string, std::string>
+  getRequestedParameterList(Status status, const std::string& challengeStatus) override;
+
+  Block
+  genChallengeRequestTLV(Status status, const std::string& challengeStatus,
+                         const std::multimap<std::string, std::string>& params) override;
+
+  /**
+   * @brief Mint a token authorizing @p identity to enroll once before @p expiry.
+   */
+  static std::string
+  mintToken(ndn::span<const uint8_t> key, const Name& identity, const time::system_clock::time_point& expiry);
+
+  /**
+   * @brief Generate a key and write it to the configuration file @p configPath.
+   */
+  static void
+  generateKey(const std::string& configPath);
+
+  /**
+   * @brief Read the key from the configuration file @p configPath.
+   * @throw std::runtime_error The file cannot be read or has no valid key.
+   */
+  static std::vector<uint8_t>
+  loadKey(const std::string& configPath);
+
+  /**
+   * @brief Read the file of the spent tokens from the configuration file @p configPath.
+   * @return The path of the file, or an empty string to keep the spent tokens in memory only.
+   */
+  static std::string
+  loadSpentTokensPath(const std::string& configPath);
+
+  // parameters
+  static const std::string PARAMETER_KEY_TOKEN;
+
+NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  /**
+   * @brief The key of a configuration file and the tokens spent under it, shared by the
+   *        challenges of the process.
+   */
+  class Authority : boost::noncopyable
+  {
+  public:
+    /**
+     * @param spentTokensPath The file of the spent tokens, empty to keep them in memory only.
+     * @throw std::runtime_error The file cannot be read or written.
+     */
+    explicit
+    Authority(std::vector<uint8_t> key, const std::string& spentTokensPath = "");
+
+    ~Authority();
+
+    /**
+     * @brief Check @p token for @p identity and spend it.
+     * @return An empty string if the token is valid, the reason otherwise.
+     */
+    std::string
+    spend(const std::string& token, const Name& identity);
+
+    size_t
+    getSpentCount() const
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_spent.size();
+    }
+
+  private:
+    /**
+     * @brief Load the spent tokens that have not expired, and drop the others from the file.
+     */
+    void
+    loadSpentTokens();
+
+  private:
+    const std::vector<uint8_t> m_key;
+    const std::string m_spentTokensPath;
+    int m_spentTokensFd = -1;
+    mutable std::mutex m_mutex;
+    // guarded by m_mutex, the first octets of the HMAC of each spent token, until it expires
+    std::unordered_set<uint64_t> m_spent;
+    std::multimap<time::system_clock::time_point, uint64_t> m_expiry;
+  };
+
+  std::shared_ptr<Authority> m_authority;
+  std::string m_configFile;
+};
+
+} // namespace ndncert
+
+#endif // NDNCERT_CHALLENGE_TOKEN_HPP
@@ -20,10 +20,14 @@
 
 #include "challenge-vc.hpp"
 #include <ndn-cxx/util/random.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/process.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <iostream>
+#include <list>
+#include <mutex>
 #include <regex>
 
 namespace ndncert {
@@ -63,8 +67,125 @@ ChallengeVC::parseConfigFile()
   if (config.begin() == config.end()) {
     NDN_THROW(std::runtime_error("Error processing configuration file: " + m_configFile + " no data"));
   }
+  m_ariesAdminEndpoint = config.get("aries-admin-endpoint", "");
+
+  auto helper = config.get_child_optional("helper");
+  if (helper) {
+    m_helperCommand = helper->get("command", "ndncert-vc-challenge-helper");
+    m_helperOptions.nProcesses = helper->get("processes", m_helperOptions.nProcesses);
+    m_helperOptions.callTimeout = time::seconds(helper->get("timeout", 30));
+    m_verdictWait = time::milliseconds(helper->get("verdict-wait", m_verdictWait.count()));
+  }
 }
 
+namespace {
+
+/**
+ * @brief The verdicts on presentations reported by the helpers, until a CHALLENGE claims them.
+ *
+ * The verdict of a presentation is claimed by the requester whose request holds its ID as secret.
+ * A requester may wait for a verdict that has not been reported yet.
+ */
+class PresentationVerdicts
+{
+public:
+  using Waiter = std::function<void(bool isVerified)>;
+
+  /**
+   * @brief Records the verdict on @p presentationId, or hands it to the requester waiting for it.
+   */
+  void
+  record(const std::string& presentationId, bool isVerified)
+  {
+    Waiter waiter;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto it = m_waiters.find(presentationId);
+      if (it != m_waiters.end()) {
+        waiter = std::move(it->second);
+        m_waiters.erase(it);
+      }
+      else if (m_verdicts.emplace(presentationId, isVerified).second) {
+        m_order.push_back(presentationId);
+        // the verdicts of abandoned requests are eventually forgotten
+        if (m_order.size() > MAX_VERDICTS) {
+          m_verdicts.erase(m_order.front());
+          m_order.pop_front();
+        }
+      }
+    }
+    if (waiter) {
+      waiter(isVerified);
+    }
+  }
+
+  /**
+   * @brief Claims the verdict on @p presentationId, or registers @p waiter to receive it.
+   */
+  std::optional<bool>
+  claimOrWait(const std::string& presentationId, Waiter waiter)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_verdicts.find(presentationId);
+    if (it == m_verdicts.end()) {
+      m_waiters[presentationId] = std::move(waiter);
+      return std::nullopt;
+    }
+    bool isVerified = it->second;
+    m_verdicts.erase(it);
+    m_order.erase(std::find(m_order.begin(), m_order.end(), presentationId));
+    return isVerified;
+  }
+
+  /**
+   * @return whether the waiter was still waiting, false if it has received the verdict.
+   */
+  bool
+  stopWaiting(const std::string& presentationId)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_waiters.erase(presentationId) > 0;
+  }
+
+private:
+  static constexpr size_t MAX_VERDICTS = 10000;
+
+  std::mutex m_mutex;
+  std::map<std::string, bool> m_verdicts;
+  std::list<std::string> m_order;
+  std::map<std::string, Waiter> m_waiters;
+};
+
+PresentationVerdicts&
+getVerdicts()
+{
+  static PresentationVerdicts verdicts;
+  return verdicts;
+}
+
+/**
+ * @brief The helper processes running @p command, shared by the VC challenges of the process.
+ */
+std::shared_ptr<ca::VcHelper>
+getHelper(const std::string& command, const ca::VcHelperOptions& options)
+{
+  static std::mutex mutex;
+  static std::map<std::string, std::shared_ptr<ca::VcHelper>> helpers;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& helper = helpers[command];
+  if (helper == nullptr) {
+    helper = std::make_shared<ca::VcHelper>(command, options);
+    helper->subscribe([] (const std::string& event, const JsonSection& params) {
+      if (event == "presentation-verified") {
+        getVerdicts().record(params.get("presentation_id", ""), params.get("verified", "") == "true");
+      }
+    });
+  }
+  return helper;
+}
+
+} // namespace
+
 // For CA
 std::tuple<ErrorCode, std::string>
 ChallengeVC::handleChallengeRequest(const Block& params, ca::RequestState& request)
@@ -78,11 +199,7 @@ ChallengeVC::handleChallengeRequest(const Block& params, ca::RequestState& reque
     NDN_LOG_TRACE("Challenge Interest arrives. Init the challenge");
     std::string connection_did = readString(params.get(tlv::ParameterValue)); 
     std::string presentationId = sendPresentationRequest(connection_did);
-    JsonSection secretJson;
-    secretJson.add(PARAMETER_KEY_PRESENTATION_ID, presentationId);
-    NDN_LOG_TRACE("Secret for request " << ndn::toHex(request.requestId) << " : " << presentationId);
-    return returnWithNewChallengeStatus(request, NEED_PRESENTATION_ID, std::move(secretJson), m_maxAttemptTimes,
-                                        m_secretLifetime);
+    return onPresentationRequestSent(request, presentationId);
   }
   if (request.challengeState && request.challengeState->challengeStatus == NEED_PRESENTATION_ID) {
     NDN_LOG_TRACE("Challenge Interest (Presentation ID) arrives. Check that verifiable credential has been presented");
@@ -90,17 +207,133 @@ ChallengeVC::handleChallengeRequest(const Block& params, ca::RequestState& reque
     auto secret = request.challengeState->secrets;
     if (givenPresentationId == secret.get<std::string>(PARAMETER_KEY_PRESENTATION_ID)) {
       NDN_LOG_TRACE("Correct Presentation ID. Check that presentation request has been fulfilled.");
-      bool fulfilled = verifyPresentationRequest(givenPresentationId);
-      if (fulfilled) {
-        return returnWithSuccess(request);
-      } else {
-        return returnWithError(request, ErrorCode::INVALID_PARAMETER, "Cannot verify that presentation request has been fulfilled.");
-      }
+      return onPresentationVerified(request, verifyPresentationRequest(givenPresentationId));
     }
   }
   return returnWithError(request, ErrorCode::INVALID_PARAMETER, "Unexpected status or challenge status");
 }
 
+void
+ChallengeVC::handleChallengeRequestAsync(const Block& params, ca::RequestState request, boost::asio::io_context& io,
+                                         const ChallengeCallback& callback)
+{
+  params.parse();
+  parseConfigFile();
+  if (m_helperCommand.empty()) {
+    ChallengeModule::handleChallengeRequestAsync(params, std::move(request), io, callback);
+    return;
+  }
+  auto helper = getHelper(m_helperCommand, m_helperOptions);
+
+  // the helper invokes its callbacks on its own thread, the challenge completes on the thread of io
+  auto complete = [&io, callback, request] (std::function<std::tuple<ErrorCode, std::string>(ca::RequestState&)> step) {
+    boost::asio::post(io, [callback, request, step = std::move(step)] () mutable {
+      auto result = step(request);
+      callback(std::move(result), std::move(request));
+    });
+  };
+
+  JsonSection helperParams;
+  helperParams.put("config_file", m_configFile);
+  if (request.status == Status::BEFORE_CHALLENGE) {
+    NDN_LOG_TRACE("Challenge Interest arrives. Init the challenge");
+    helperParams.put("connection_did", readString(params.get(tlv::ParameterValue)));
+    helper->call("send-presentation-request", helperParams,
+      [this, complete] (const JsonSection& result) {
+        complete([this, presentationId = result.get("presentation_id", "")] (ca::RequestState& request) {
+          return onPresentationRequestSent(request, presentationId);
+        });
+      },
+      [complete] (const std::string& reason) {
+        NDN_LOG_ERROR("Cannot send the presentation request: " << reason);
+        complete([] (ca::RequestState& request) {
+          return returnWithError(request, ErrorCode::INVALID_PARAMETER, "Cannot send the presentation request.");
+        });
+      });
+    return;
+  }
+  if (request.challengeState && request.challengeState->challengeStatus == NEED_PRESENTATION_ID) {
+    NDN_LOG_TRACE("Challenge Interest (Presentation ID) arrives. Check that verifiable credential has been presented");
+    std::string givenPresentationId = readString(params.get(tlv::ParameterValue));
+    if (givenPresentationId == request.challengeState->secrets.get<std::string>(PARAMETER_KEY_PRESENTATION_ID)) {
+      auto onVerdict = [this, complete] (bool isVerified) {
+        complete([this, isVerified] (ca::RequestState& request) {
+          return onPresentationVerified(request, isVerified);
+        });
+      };
+      auto verdict = getVerdicts().claimOrWait(givenPresentationId, onVerdict);
+      if (verdict) {
+        NDN_LOG_TRACE("Presentation " << givenPresentationId << " already verified");
+        auto result = onPresentationVerified(request, *verdict);
+        callback(std::move(result), std::move(request));
+        return;
+      }
+
+      // the presentation is asked for if its verdict is not reported in time
+      auto timer = std::make_shared<boost::asio::steady_timer>(io);
+      timer->expires_after(std::chrono::milliseconds(m_verdictWait.count()));
+      timer->async_wait([this, timer, helper, helperParams, givenPresentationId, onVerdict, complete] (const auto&) {
+        if (!getVerdicts().stopWaiting(givenPresentationId)) {
+          return;
+        }
+        NDN_LOG_TRACE("No verdict on presentation " << givenPresentationId << ", asking the helper");
+        JsonSection verifyParams = helperParams;
+        verifyParams.put("presentation_id", givenPresentationId);
+        helper->call("verify-presentation", verifyParams,
+          [this, onVerdict, complete] (const JsonSection& result) {
+            if (result.get("pending", "") != "true") {
+              onVerdict(result.get("verified", "") == "true");
+              return;
+            }
+            complete([this] (ca::RequestState& request) {
+              return onPresentationPending(request);
+            });
+          },
+          [onVerdict] (const std::string& reason) {
+            NDN_LOG_ERROR("Cannot verify the presentation: " << reason);
+            onVerdict(false);
+          });
+      });
+      return;
+    }
+  }
+  auto result = returnWithError(request, ErrorCode::INVALID_PARAMETER, "Unexpected status or challenge status");
+  callback(std::move(result), std::move(request));
+}
+
+std::tuple<ErrorCode, std::string>
+ChallengeVC::onPresentationRequestSent(ca::RequestState& request, const std::string& presentationId)
+{
+  JsonSection secretJson;
+  secretJson.add(PARAMETER_KEY_PRESENTATION_ID, presentationId);
+  NDN_LOG_TRACE("Secret for request " << ndn::toHex(request.requestId) << " : " << presentationId);
+  return returnWithNewChallengeStatus(request, NEED_PRESENTATION_ID, std::move(secretJson), m_maxAttemptTimes,
+                                      m_secretLifetime);
+}
+
+std::tuple<ErrorCode, std::string>
+ChallengeVC::onPresentationPending(ca::RequestState& request)
+{
+  // the requester may ask again, without losing a try
+  NDN_LOG_TRACE("Presentation for request " << ndn::toHex(request.requestId) << " not received yet");
+  auto secrets = request.challengeState->secrets;
+  auto remainingTime = time::duration_cast<time::seconds>(request.challengeState->timestamp +
+                                                          request.challengeState->remainingTime -
+                                                          time::system_clock::now());
+  return returnWithNewChallengeStatus(request, NEED_PRESENTATION_ID, std::move(secrets),
+                                      request.challengeState->remainingTries,
+                                      std::max(remainingTime, time::seconds(0)));
+}
+
+std::tuple<ErrorCode, std::string>
+ChallengeVC::onPresentationVerified(ca::RequestState& request, bool isVerified)
+{
+  if (isVerified) {
+    return returnWithSuccess(request);
+  }
+  return returnWithError(request, ErrorCode::INVALID_PARAMETER, "Cannot verify that presentation request has been fulfilled.");
+}
+
 // For Client
 std::multimap<std::string, std::string>
 ChallengeVC::getRequestedParameterList(Status status, const std::string& challengeStatus)
@@ -22,6 +22,7 @@
 #define NDNCERT_CHALLENGE_VC_HPP
 
 #include "challenge-module.hpp"
+#include "detail/vc-helper.hpp"
 
 namespace ndncert {
 
@@ -42,6 +43,24 @@ namespace ndncert {
  * Failure info when application fails:
  *   FAILURE_TIMEOUT: When secret is out-dated.
  *   FAILURE_MAXRETRY: When requester tries too many times.
+ *
+ * When the configuration file has a "helper" section, the CA sends the presentation requests
+ * and verifies the presentations through a pool of persistent helper processes shared by all
+ * the VC challenges of the process, see ca::VcHelper:
+ *
+ *     "helper": {"command": "ndncert-vc-challenge-helper", "processes": "1", "timeout": "<seconds>",
+ *                "verdict-wait": "<milliseconds>"}
+ *
+ * The methods are "send-presentation-request", with parameters "connection_did" and
+ * "config_file" and result "presentation_id", and "verify-presentation", with parameters
+ * "presentation_id" and "config_file" and results "verified" and "pending", the latter being
+ * "true" if nothing has been presented yet. Otherwise, each step runs a script.
+ *
+ * The helpers report the verdict on each presentation as soon as it is known, with the event
+ * "presentation-verified" and parameters "presentation_id" and "verified". A CHALLENGE carrying
+ * the presentation ID completes with the reported verdict, waiting for it up to "verdict-wait"
+ * milliseconds, after which the helper is asked. A requester whose presentation is still pending
+ * does not lose a try.
  */
 class ChallengeVC : public ChallengeModule
 {
@@ -54,6 +73,10 @@ public:
   std::tuple<ErrorCode, std::string>
   handleChallengeRequest(const Block& params, ca::RequestState& request) override;
 
+  void
+  handleChallengeRequestAsync(const Block& params, ca::RequestState request, boost::asio::io_context& io,
+                              const ChallengeCallback& callback) override;
+
   // For Client
   std::multimap<std::string, std::string>
   getRequestedParameterList(Status status, const std::string& challengeStatus) override;
@@ -82,10 +105,23 @@ NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   bool
   verifyPresentationRequest(const std::string& presentationId);
 
+  std::tuple<ErrorCode, std::string>
+  onPresentationRequestSent(ca::RequestState& request, const std::string& presentationId);
+
+  std::tuple<ErrorCode, std::string>
+  onPresentationVerified(ca::RequestState& request, bool isVerified);
+
+  std::tuple<ErrorCode, std::string>
+  onPresentationPending(ca::RequestState& request);
+
 NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   std::string m_configFile;
   std::string m_presentationRequest;
   std::string m_ariesAdminEndpoint;
+  std::string m_helperCommand;
+  ca::VcHelperOptions m_helperOptions;
+  /// the time a requester waits for the verdict on its presentation before the helper is asked
+  time::milliseconds m_verdictWait = 2_s;
 
 private:
   std::string m_sendPresentationScriptPath;
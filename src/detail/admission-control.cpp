@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/admission-control.hpp"
+
+#include <algorithm>
+
+namespace ndncert::ca {
+
+NDN_LOG_INIT(ndncert.admission);
+
+std::ostream&
+operator<<(std::ostream& os, CaEndpoint endpoint)
+{
+  switch (endpoint) {
+    case CaEndpoint::INFO:
+      return os << "INFO";
+    case CaEndpoint::PROBE:
+      return os << "PROBE";
+    case CaEndpoint::NEW:
+      return os << "NEW";
+    case CaEndpoint::CHALLENGE:
+      return os << "CHALLENGE";
+    case CaEndpoint::REVOKE:
+      return os << "REVOKE";
+    case CaEndpoint::RENEW:
+      return os << "RENEW";
+    case CaEndpoint::STATUS:
+      return os << "STATUS";
+    case CaEndpoint::REVOKED:
+      return os << "REVOKED";
+  }
+  return os << "Unrecognized endpoint";
+}
+
+TokenBucket::TokenBucket(const TokenBucketConfig& config)
+  : m_config(config)
+  , m_tokens(config.burst)
+  , m_lastRefill(time::steady_clock::now())
+{
+}
+
+bool
+TokenBucket::canConsume(double reserve)
+{
+  refill();
+  return m_tokens >= 1 + reserve;
+}
+
+void
+TokenBucket::consume()
+{
+  m_tokens -= 1;
+}
+
+double
+TokenBucket::getTokens()
+{
+  refill();
+  return m_tokens;
+}
+
+void
+TokenBucket::refill()
+{
+  auto now = time::steady_clock::now();
+  if (now <= m_lastRefill) {
+    return;
+  }
+  double elapsed = time::duration_cast<time::microseconds>(now - m_lastRefill).count() / 1e6;
+  m_tokens = std::min(m_config.burst, m_tokens + elapsed * m_config.rate);
+  m_lastRefill = now;
+}
+
+AdmissionController::AdmissionController(const AdmissionConfig& config)
+  : m_config(config)
+{
+  for (size_t i = 0; i < N_CA_ENDPOINTS; i++) {
+    if (m_config.endpointLimits[i]) {
+      m_endpointBuckets[i].emplace(*m_config.endpointLimits[i]);
+    }
+  }
+  if (m_config.totalLimit) {
+    m_totalBucket.emplace(*m_config.totalLimit);
+  }
+}
+
+bool
+AdmissionController::admit(CaEndpoint endpoint, const std::optional<Name>& keyLocator, double queueLoad)
+{
+  auto index = static_cast<size_t>(endpoint);
+  std::lock_guard lock(m_mutex);
+
+  auto shed = [&] {
+    m_statistics.nShed[index]++;
+    NDN_LOG_DEBUG("Shedding " << endpoint << " Interest");
+    return false;
+  };
+
+  if (endpoint == CaEndpoint::NEW && queueLoad >= m_config.newShedLoad) {
+    m_statistics.nShedByLoad++;
+    return shed();
+  }
+
+  TokenBucket* keyLocatorBucket = nullptr;
+  if (keyLocator && m_config.keyLocatorLimit) {
+    keyLocatorBucket = getKeyLocatorBucket(*keyLocator);
+    if (!keyLocatorBucket->canConsume()) {
+      m_statistics.nShedByKeyLocator++;
+      return shed();
+    }
+  }
+
+  auto& endpointBucket = m_endpointBuckets[index];
+  if (endpointBucket && !endpointBucket->canConsume()) {
+    return shed();
+  }
+
+  if (m_totalBucket) {
+    double reserve = endpoint == CaEndpoint::CHALLENGE ? 0 : m_config.challengeReserve * m_config.totalLimit->burst;
+    if (!m_totalBucket->canConsume(reserve)) {
+      return shed();
+    }
+    m_totalBucket->consume();
+  }
+  if (endpointBucket) {
+    endpointBucket->consume();
+  }
+  if (keyLocatorBucket != nullptr) {
+    keyLocatorBucket->consume();
+  }
+  m_statistics.nAdmitted[index]++;
+  return true;
+}
+
+AdmissionController::Statistics
+AdmissionController::getStatistics() const
+{
+  std::lock_guard lock(m_mutex);
+  auto statistics = m_statistics;
+  statistics.nKeyLocators = m_keyLocatorBuckets.size();
+  return statistics;
+}
+
+TokenBucket*
+AdmissionController::getKeyLocatorBucket(const Name& keyLocator)
+{
+  auto it = m_keyLocatorIndex.find(keyLocator);
+  if (it != m_keyLocatorIndex.end()) {
+    m_keyLocatorBuckets.splice(m_keyLocatorBuckets.begin(), m_keyLocatorBuckets, it->second);
+    return &it->second->second;
+  }
+
+  if (m_keyLocatorBuckets.size() >= std::max<size_t>(m_config.maxKeyLocators, 1)) {
+    m_keyLocatorIndex.erase(m_keyLocatorBuckets.back().first);
+    m_keyLocatorBuckets.pop_back();
+  }
+  m_keyLocatorBuckets.emplace_front(keyLocator, TokenBucket(*m_config.keyLocatorLimit));
+  m_keyLocatorIndex.emplace(keyLocator, m_keyLocatorBuckets.begin());
+  return &m_keyLocatorBuckets.front().second;
+}
+
+} // namespace ndncert::ca
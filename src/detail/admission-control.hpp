@@ -0,0 +1,202 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_ADMISSION_CONTROL_HPP
+#define NDNCERT_DETAIL_ADMISSION_CONTROL_HPP
+
+#include "detail/ndncert-common.hpp"
+
+#include <array>
+#include <list>
+#include <map>
+#include <mutex>
+
+namespace ndncert::ca {
+
+/**
+ * @brief The prefixes served by a CA that are subject to admission control.
+ */
+enum class CaEndpoint {
+  INFO,
+  PROBE,
+  NEW,
+  CHALLENGE,
+  REVOKE,
+  RENEW,
+  STATUS,
+  REVOKED,
+};
+
+constexpr size_t N_CA_ENDPOINTS = 8;
+
+std::ostream&
+operator<<(std::ostream& os, CaEndpoint endpoint);
+
+struct TokenBucketConfig
+{
+  /**
+   * @brief Tokens added per second.
+   */
+  double rate = 0;
+  /**
+   * @brief Maximum number of tokens, which is also the initial number of tokens.
+   */
+  double burst = 0;
+};
+
+class TokenBucket
+{
+public:
+  explicit
+  TokenBucket(const TokenBucketConfig& config);
+
+  /**
+   * @brief Whether a token can be taken while leaving at least @p reserve tokens.
+   */
+  bool
+  canConsume(double reserve = 0);
+
+  void
+  consume();
+
+  double
+  getTokens();
+
+private:
+  void
+  refill();
+
+private:
+  TokenBucketConfig m_config;
+  double m_tokens;
+  time::steady_clock::time_point m_lastRefill;
+};
+
+/**
+ * @brief What the CA does with the Interests it does not admit.
+ */
+enum class ShedAction {
+  /**
+   * @brief Reply with a Nack of reason Congestion.
+   */
+  NACK,
+  /**
+   * @brief Drop the Interest silently.
+   */
+  DROP,
+};
+
+/**
+ * @brief Configuration of the admission control, see AdmissionController.
+ */
+struct AdmissionConfig
+{
+  /**
+   * @brief The token bucket of each endpoint, if limited.
+   */
+  std::array<std::optional<TokenBucketConfig>, N_CA_ENDPOINTS> endpointLimits;
+  /**
+   * @brief The token bucket shared by all the endpoints, if limited.
+   */
+  std::optional<TokenBucketConfig> totalLimit;
+  /**
+   * @brief Fraction of the burst of the shared bucket that only CHALLENGE Interests may use.
+   */
+  double challengeReserve = 0.25;
+  /**
+   * @brief The token bucket of each signing key, if limited.
+   */
+  std::optional<TokenBucketConfig> keyLocatorLimit;
+  size_t maxKeyLocators = 10000;
+  /**
+   * @brief The load of the storage queue from which NEW Interests are shed.
+   */
+  double newShedLoad = 0.75;
+  ShedAction shedAction = ShedAction::NACK;
+};
+
+/**
+ * @brief Decides which Interests a CA processes, so that a burst of NEW Interests cannot delay
+ *        the completion of the requests already in progress.
+ *
+ * An Interest is admitted when a token is available in each of the buckets that apply to it:
+ * the bucket of its endpoint, the bucket shared by all the endpoints, and the bucket of the key
+ * named by its KeyLocator. CHALLENGE Interests have priority: the other endpoints leave a reserve
+ * in the shared bucket, and NEW Interests are also shed once the storage queue is loaded.
+ * The buckets of the least recently seen keys are forgotten past a configured number of keys.
+ *
+ * The controller may be shared by several threads.
+ */
+class AdmissionController : boost::noncopyable
+{
+public:
+  struct Statistics
+  {
+    std::array<uint64_t, N_CA_ENDPOINTS> nAdmitted = {};
+    std::array<uint64_t, N_CA_ENDPOINTS> nShed = {};
+    /**
+     * @brief Interests shed because the bucket of their key was empty.
+     */
+    uint64_t nShedByKeyLocator = 0;
+    /**
+     * @brief NEW Interests shed because the storage queue was loaded.
+     */
+    uint64_t nShedByLoad = 0;
+    size_t nKeyLocators = 0;
+  };
+
+  explicit
+  AdmissionController(const AdmissionConfig& config);
+
+  /**
+   * @param keyLocator The KeyLocator name of a signed Interest.
+   * @param queueLoad The fraction of the storage queue in use.
+   * @return Whether the Interest should be processed.
+   */
+  bool
+  admit(CaEndpoint endpoint, const std::optional<Name>& keyLocator = std::nullopt, double queueLoad = 0);
+
+  ShedAction
+  getShedAction() const
+  {
+    return m_config.shedAction;
+  }
+
+  Statistics
+  getStatistics() const;
+
+private:
+  TokenBucket*
+  getKeyLocatorBucket(const Name& keyLocator);
+
+private:
+  const AdmissionConfig m_config;
+  std::array<std::optional<TokenBucket>, N_CA_ENDPOINTS> m_endpointBuckets;
+  std::optional<TokenBucket> m_totalBucket;
+  // the most recently seen key is at the front
+  std::list<std::pair<Name, TokenBucket>> m_keyLocatorBuckets;
+  std::map<Name, std::list<std::pair<Name, TokenBucket>>::iterator> m_keyLocatorIndex;
+  Statistics m_statistics;
+  mutable std::mutex m_mutex;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_ADMISSION_CONTROL_HPP
@@ -0,0 +1,256 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/ca-async-storage.hpp"
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+
+namespace ndncert::ca {
+
+NDN_LOG_INIT(ndncert.storage.async);
+
+void
+AsyncCaStorage::getRequest(const RequestId& requestId, const RequestCallback& onSuccess,
+                           const FailureCallback& onFailure)
+{
+  execute([this, requestId, onSuccess, onFailure] () -> std::function<void()> {
+    try {
+      auto request = m_storage.getRequest(requestId);
+      return [onSuccess, request = std::move(request)] { onSuccess(request); };
+    }
+    catch (const std::exception& e) {
+      return [onFailure, reason = std::string(e.what())] { onFailure(reason); };
+    }
+  }, onFailure);
+}
+
+void
+AsyncCaStorage::addRequest(const RequestState& request, const SuccessCallback& onSuccess,
+                           const FailureCallback& onFailure)
+{
+  addRequest(request, onSuccess, onFailure, onFailure);
+}
+
+void
+AsyncCaStorage::addRequest(const RequestState& request, const SuccessCallback& onSuccess,
+                           const FailureCallback& onDuplicate, const FailureCallback& onFailure)
+{
+  execute([this, request, onSuccess, onDuplicate, onFailure] () -> std::function<void()> {
+    try {
+      m_storage.addRequest(request);
+      return onSuccess;
+    }
+    catch (const std::exception& e) {
+      // backends report a duplicate with their own message, so look the request up instead
+      bool isDuplicate = false;
+      try {
+        m_storage.getRequest(request.requestId);
+        isDuplicate = true;
+      }
+      catch (const std::exception&) {
+      }
+      return [onDone = isDuplicate ? onDuplicate : onFailure, reason = std::string(e.what())] {
+        onDone(reason);
+      };
+    }
+  }, onFailure);
+}
+
+void
+AsyncCaStorage::updateRequest(const RequestState& request, const SuccessCallback& onSuccess,
+                              const FailureCallback& onFailure)
+{
+  execute([this, request, onSuccess, onFailure] () -> std::function<void()> {
+    try {
+      m_storage.updateRequest(request);
+      return onSuccess;
+    }
+    catch (const std::exception& e) {
+      return [onFailure, reason = std::string(e.what())] { onFailure(reason); };
+    }
+  }, onFailure);
+}
+
+void
+AsyncCaStorage::deleteRequest(const RequestId& requestId, const SuccessCallback& onSuccess,
+                              const FailureCallback& onFailure)
+{
+  execute([this, requestId, onSuccess, onFailure] () -> std::function<void()> {
+    try {
+      m_storage.deleteRequest(requestId);
+      return onSuccess;
+    }
+    catch (const std::exception& e) {
+      return [onFailure, reason = std::string(e.what())] { onFailure(reason); };
+    }
+  }, onFailure);
+}
+
+void
+InlineAsyncCaStorage::execute(std::function<std::function<void()>()> job, const FailureCallback&)
+{
+  auto completion = job();
+  if (completion) {
+    completion();
+  }
+}
+
+CaStorageThread::CaStorageThread(size_t queueCapacity)
+  : m_queueCapacity(queueCapacity)
+{
+  m_worker = std::thread([this] { run(); });
+}
+
+CaStorageThread::~CaStorageThread()
+{
+  {
+    std::lock_guard lock(m_mutex);
+    m_isStopping = true;
+    if (!m_queue.empty()) {
+      NDN_LOG_WARN("Discarding " << m_queue.size() << " queued storage operations");
+      m_queue.clear();
+    }
+  }
+  m_cv.notify_all();
+  m_worker.join();
+}
+
+bool
+CaStorageThread::submit(const void* owner, std::function<void()> job)
+{
+  std::lock_guard lock(m_mutex);
+  if (m_queue.size() >= m_queueCapacity) {
+    return false;
+  }
+  m_queue.emplace_back(owner, std::move(job));
+  m_cv.notify_one();
+  return true;
+}
+
+void
+CaStorageThread::cancel(const void* owner)
+{
+  std::unique_lock lock(m_mutex);
+  auto it = std::remove_if(m_queue.begin(), m_queue.end(), [owner] (const auto& entry) { return entry.first == owner; });
+  if (it != m_queue.end()) {
+    NDN_LOG_WARN("Discarding " << std::distance(it, m_queue.end()) << " queued storage operations");
+    m_queue.erase(it, m_queue.end());
+  }
+  m_jobDoneCv.wait(lock, [this, owner] { return m_runningOwner != owner; });
+}
+
+size_t
+CaStorageThread::getQueueLength() const
+{
+  std::lock_guard lock(m_mutex);
+  return m_queue.size();
+}
+
+double
+CaStorageThread::getLoad() const
+{
+  return static_cast<double>(getQueueLength()) / std::max<size_t>(m_queueCapacity, 1);
+}
+
+void
+CaStorageThread::run()
+{
+  std::unique_lock lock(m_mutex);
+  while (true) {
+    m_cv.wait(lock, [this] { return m_isStopping || !m_queue.empty(); });
+    if (m_isStopping) {
+      return;
+    }
+    auto [owner, job] = std::move(m_queue.front());
+    m_queue.pop_front();
+    m_runningOwner = owner;
+    lock.unlock();
+
+    job();
+
+    lock.lock();
+    m_runningOwner = nullptr;
+    m_jobDoneCv.notify_all();
+  }
+}
+
+ThreadedAsyncCaStorage::ThreadedAsyncCaStorage(CaStorage& storage, boost::asio::io_context& io,
+                                               size_t queueCapacity)
+  : ThreadedAsyncCaStorage(storage, io, std::make_shared<CaStorageThread>(queueCapacity))
+{
+}
+
+ThreadedAsyncCaStorage::ThreadedAsyncCaStorage(CaStorage& storage, boost::asio::io_context& io,
+                                               std::shared_ptr<CaStorageThread> thread)
+  : AsyncCaStorage(storage)
+  , m_io(io)
+  , m_thread(std::move(thread))
+{
+}
+
+ThreadedAsyncCaStorage::~ThreadedAsyncCaStorage()
+{
+  *m_isAlive = false;
+  // the jobs of this adapter access its members
+  m_thread->cancel(this);
+}
+
+size_t
+ThreadedAsyncCaStorage::getQueueLength() const
+{
+  return m_thread->getQueueLength();
+}
+
+double
+ThreadedAsyncCaStorage::getLoad() const
+{
+  return m_thread->getLoad();
+}
+
+void
+ThreadedAsyncCaStorage::execute(std::function<std::function<void()>()> job, const FailureCallback& onRejected)
+{
+  auto isAlive = std::weak_ptr<bool>(m_isAlive);
+  bool isQueued = m_thread->submit(this, [job = std::move(job), &io = m_io, isAlive] {
+    auto completion = job();
+    boost::asio::post(io, [completion = std::move(completion), isAlive] {
+      auto alive = isAlive.lock();
+      if (alive && *alive && completion) {
+        completion();
+      }
+    });
+  });
+  if (isQueued) {
+    return;
+  }
+
+  NDN_LOG_WARN("Storage queue is full, rejecting the operation");
+  // the caller expects its callbacks to run asynchronously
+  boost::asio::post(m_io, [onRejected, isAlive] {
+    auto alive = isAlive.lock();
+    if (alive && *alive && onRejected) {
+      onRejected(QUEUE_FULL);
+    }
+  });
+}
+
+} // namespace ndncert::ca
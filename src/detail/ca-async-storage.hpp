@@ -0,0 +1,216 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_CA_ASYNC_STORAGE_HPP
+#define NDNCERT_DETAIL_CA_ASYNC_STORAGE_HPP
+
+#include "detail/ca-storage.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace ndncert::ca {
+
+/**
+ * @brief Asynchronous access to a CaStorage.
+ *
+ * Each operation completes by invoking either its success or its failure callback. Operations
+ * are executed in the order they are submitted, so that an update submitted after an addition
+ * of the same request always sees the added request.
+ */
+class AsyncCaStorage : boost::noncopyable
+{
+public:
+  using RequestCallback = std::function<void(const RequestState& request)>;
+  using SuccessCallback = std::function<void()>;
+  using FailureCallback = std::function<void(const std::string& reason)>;
+
+  /**
+   * @brief The failure reason of an operation rejected because the operation queue is full.
+   */
+  static constexpr const char* QUEUE_FULL = "Storage queue is full";
+
+  explicit
+  AsyncCaStorage(CaStorage& storage)
+    : m_storage(storage)
+  {
+  }
+
+  virtual
+  ~AsyncCaStorage() = default;
+
+  void
+  getRequest(const RequestId& requestId, const RequestCallback& onSuccess, const FailureCallback& onFailure);
+
+  void
+  addRequest(const RequestState& request, const SuccessCallback& onSuccess, const FailureCallback& onFailure);
+
+  /**
+   * @brief Add @p request, invoking @p onDuplicate rather than @p onFailure if the storage
+   *        already holds a request with the same ID.
+   */
+  void
+  addRequest(const RequestState& request, const SuccessCallback& onSuccess,
+             const FailureCallback& onDuplicate, const FailureCallback& onFailure);
+
+  void
+  updateRequest(const RequestState& request, const SuccessCallback& onSuccess, const FailureCallback& onFailure);
+
+  void
+  deleteRequest(const RequestId& requestId, const SuccessCallback& onSuccess, const FailureCallback& onFailure);
+
+  /**
+   * @brief The fraction of the operation queue in use, zero if operations are not queued.
+   */
+  virtual double
+  getLoad() const
+  {
+    return 0;
+  }
+
+protected:
+  /**
+   * @brief Run @p job, which accesses the storage and returns the completion to invoke.
+   *
+   * If the job cannot be run, @p onRejected must be invoked instead of the completion.
+   */
+  virtual void
+  execute(std::function<std::function<void()>()> job, const FailureCallback& onRejected) = 0;
+
+protected:
+  CaStorage& m_storage;
+};
+
+/**
+ * @brief Runs every operation immediately on the calling thread.
+ *
+ * Completion callbacks are invoked before the operation returns.
+ */
+class InlineAsyncCaStorage : public AsyncCaStorage
+{
+public:
+  using AsyncCaStorage::AsyncCaStorage;
+
+protected:
+  void
+  execute(std::function<std::function<void()>()> job, const FailureCallback& onRejected) override;
+};
+
+/**
+ * @brief A dedicated I/O thread running jobs in the order they are submitted.
+ *
+ * The thread may be shared by several ThreadedAsyncCaStorage over the same storage, e.g., one
+ * per Face serving the CA, so that the storage is only accessed by this thread.
+ */
+class CaStorageThread : boost::noncopyable
+{
+public:
+  explicit
+  CaStorageThread(size_t queueCapacity = 1024);
+
+  ~CaStorageThread();
+
+  /**
+   * @brief Queue @p job on behalf of @p owner.
+   * @return false if @p queueCapacity jobs are already waiting, in which case @p job is discarded.
+   */
+  bool
+  submit(const void* owner, std::function<void()> job);
+
+  /**
+   * @brief Discard the jobs queued by @p owner, and wait for the end of the one running, if any.
+   */
+  void
+  cancel(const void* owner);
+
+  size_t
+  getQueueLength() const;
+
+  double
+  getLoad() const;
+
+private:
+  void
+  run();
+
+private:
+  const size_t m_queueCapacity;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::condition_variable m_jobDoneCv;
+  std::deque<std::pair<const void*, std::function<void()>>> m_queue;
+  const void* m_runningOwner = nullptr;
+  bool m_isStopping = false;
+  std::thread m_worker;
+};
+
+/**
+ * @brief Runs the operations on a dedicated I/O thread.
+ *
+ * Completion callbacks are posted to @p io, normally the io_context of the Face, so that they
+ * run on the same thread as the Interest handlers. Operations submitted while the queue of the
+ * thread is full fail with a "queue full" reason instead of blocking the caller.
+ *
+ * The underlying storage must only be accessed through the thread while the adapter exists,
+ * so all the adapters over the same storage must share their thread. Operations still queued
+ * upon destruction are discarded without invoking their callbacks.
+ */
+class ThreadedAsyncCaStorage : public AsyncCaStorage
+{
+public:
+  /**
+   * @brief Run the operations on a thread of its own.
+   */
+  ThreadedAsyncCaStorage(CaStorage& storage, boost::asio::io_context& io, size_t queueCapacity = 1024);
+
+  /**
+   * @brief Run the operations on @p thread, which may be shared with other adapters of @p storage.
+   */
+  ThreadedAsyncCaStorage(CaStorage& storage, boost::asio::io_context& io, std::shared_ptr<CaStorageThread> thread);
+
+  ~ThreadedAsyncCaStorage() override;
+
+  /**
+   * @brief The number of operations waiting, including those of the adapters sharing the thread.
+   */
+  size_t
+  getQueueLength() const;
+
+  double
+  getLoad() const override;
+
+protected:
+  void
+  execute(std::function<std::function<void()>()> job, const FailureCallback& onRejected) override;
+
+private:
+  boost::asio::io_context& m_io;
+  std::shared_ptr<CaStorageThread> m_thread;
+  // completions that are still posted when the adapter is destroyed must not run
+  std::shared_ptr<bool> m_isAlive = std::make_shared<bool>(true);
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_CA_ASYNC_STORAGE_HPP
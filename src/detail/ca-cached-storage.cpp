@@ -0,0 +1,362 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/ca-cached-storage.hpp"
+
+#include <boost/lexical_cast.hpp>
+
+#include <chrono>
+
+namespace ndncert::ca {
+
+NDN_LOG_INIT(ndncert.storage.cached);
+
+const std::string CaCachedStorage::STORAGE_TYPE = "ca-storage-cached";
+NDNCERT_REGISTER_CA_STORAGE_DECORATOR(CaCachedStorage);
+
+CaCachedStorage::CaCachedStorage(std::unique_ptr<CaStorage> inner, const Name&, const std::string& path)
+  : m_inner(std::move(inner))
+{
+  BOOST_ASSERT(m_inner != nullptr);
+  auto options = parseLocator(path).second;
+  try {
+    if (options.count("cache-capacity") != 0) {
+      m_capacity = boost::lexical_cast<size_t>(options["cache-capacity"]);
+    }
+    if (options.count("flush-interval") != 0) {
+      m_flushInterval = time::milliseconds(boost::lexical_cast<uint64_t>(options["flush-interval"]));
+    }
+  }
+  catch (const boost::bad_lexical_cast&) {
+    NDN_THROW(std::runtime_error("Invalid option for " + STORAGE_TYPE + ": " + path));
+  }
+  if (m_capacity == 0) {
+    NDN_THROW(std::runtime_error("The capacity of " + STORAGE_TYPE + " must be positive"));
+  }
+
+  if (options.count("cache-eviction") != 0) {
+    if (options["cache-eviction"] == "lru") {
+      m_evictionPolicy = EvictionPolicy::LRU;
+    }
+    else if (options["cache-eviction"] == "fifo") {
+      m_evictionPolicy = EvictionPolicy::FIFO;
+    }
+    else {
+      NDN_THROW(std::runtime_error("Unknown eviction policy for " + STORAGE_TYPE + ": " +
+                                   options["cache-eviction"]));
+    }
+  }
+  if (options.count("write-mode") != 0) {
+    if (options["write-mode"] == "write-back") {
+      m_isWriteBack = true;
+    }
+    else if (options["write-mode"] == "write-through") {
+      m_isWriteBack = false;
+    }
+    else {
+      NDN_THROW(std::runtime_error("Unknown write mode for " + STORAGE_TYPE + ": " + options["write-mode"]));
+    }
+  }
+
+  if (m_isWriteBack && m_flushInterval > 0_ms) {
+    m_flusher = std::thread([this] { runFlusher(); });
+  }
+}
+
+CaCachedStorage::~CaCachedStorage()
+{
+  {
+    std::lock_guard lock(m_mutex);
+    m_isStopping = true;
+  }
+  m_flusherCv.notify_all();
+  if (m_flusher.joinable()) {
+    m_flusher.join();
+  }
+
+  std::lock_guard lock(m_mutex);
+  flushLocked();
+  if (m_nDirty + m_pendingDeletions.size() != 0) {
+    NDN_LOG_ERROR(m_nDirty + m_pendingDeletions.size() << " changes could not be written to the backing storage");
+  }
+}
+
+RequestState
+CaCachedStorage::getRequest(const RequestId& requestId)
+{
+  std::lock_guard lock(m_mutex);
+  if (m_pendingDeletions.count(requestId) != 0) {
+    NDN_THROW(std::runtime_error("Request " + ndn::toHex(requestId) + " does not exist"));
+  }
+  auto entry = findEntry(requestId);
+  if (entry != nullptr) {
+    m_metrics.nHits++;
+    return entry->request;
+  }
+
+  m_metrics.nMisses++;
+  auto request = m_inner->getRequest(requestId);
+  storeEntry(request, false);
+  return request;
+}
+
+void
+CaCachedStorage::addRequest(const RequestState& request)
+{
+  std::lock_guard lock(m_mutex);
+  if (m_index.count(request.requestId) != 0) {
+    NDN_THROW(std::runtime_error("Request " + ndn::toHex(request.requestId) + " already exists"));
+  }
+  if (m_pendingDeletions.erase(request.requestId) != 0) {
+    m_inner->deleteRequest(request.requestId);
+    m_metrics.nFlushedDeletions++;
+  }
+  m_inner->addRequest(request);
+  storeEntry(request, false);
+}
+
+void
+CaCachedStorage::updateRequest(const RequestState& request)
+{
+  std::lock_guard lock(m_mutex);
+  m_pendingDeletions.erase(request.requestId);
+  if (!m_isWriteBack) {
+    m_inner->updateRequest(request);
+  }
+  storeEntry(request, m_isWriteBack);
+}
+
+void
+CaCachedStorage::deleteRequest(const RequestId& requestId)
+{
+  std::lock_guard lock(m_mutex);
+  eraseEntry(requestId);
+  if (!m_isWriteBack) {
+    m_inner->deleteRequest(requestId);
+    return;
+  }
+  m_pendingDeletions.insert(requestId);
+  // deletions are not bounded by the cache itself
+  if (m_pendingDeletions.size() >= m_capacity) {
+    flushLocked();
+  }
+}
+
+std::list<RequestState>
+CaCachedStorage::listAllRequests()
+{
+  std::lock_guard lock(m_mutex);
+  flushLocked();
+  return m_inner->listAllRequests();
+}
+
+std::list<RequestState>
+CaCachedStorage::listAllRequests(const Name& caName)
+{
+  std::lock_guard lock(m_mutex);
+  flushLocked();
+  return m_inner->listAllRequests(caName);
+}
+
+size_t
+CaCachedStorage::forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor)
+{
+  std::lock_guard lock(m_mutex);
+  flushLocked();
+  return m_inner->forEachRequest(filter, visitor);
+}
+
+size_t
+CaCachedStorage::forEachRequestSummary(const RequestFilter& filter, const RequestSummaryVisitor& visitor)
+{
+  std::lock_guard lock(m_mutex);
+  flushLocked();
+  return m_inner->forEachRequestSummary(filter, visitor);
+}
+
+size_t
+CaCachedStorage::countRequests(const RequestFilter& filter)
+{
+  std::lock_guard lock(m_mutex);
+  flushLocked();
+  return m_inner->countRequests(filter);
+}
+
+void
+CaCachedStorage::flush()
+{
+  std::lock_guard lock(m_mutex);
+  flushLocked();
+}
+
+CaCachedStorage::Metrics
+CaCachedStorage::getMetrics() const
+{
+  std::lock_guard lock(m_mutex);
+  auto metrics = m_metrics;
+  metrics.nCached = m_entries.size();
+  metrics.nPending = m_nDirty + m_pendingDeletions.size();
+  return metrics;
+}
+
+const CaCachedStorage::Entry*
+CaCachedStorage::findEntry(const RequestId& requestId)
+{
+  auto it = m_index.find(requestId);
+  if (it == m_index.end()) {
+    return nullptr;
+  }
+  if (m_evictionPolicy == EvictionPolicy::LRU) {
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+  }
+  return &*it->second;
+}
+
+void
+CaCachedStorage::storeEntry(const RequestState& request, bool isDirty)
+{
+  auto it = m_index.find(request.requestId);
+  if (it != m_index.end()) {
+    auto& entry = *it->second;
+    if (!entry.isDirty && isDirty) {
+      m_nDirty++;
+    }
+    else if (entry.isDirty && !isDirty) {
+      m_nDirty--;
+    }
+    entry.request = request;
+    entry.isDirty = isDirty;
+    if (m_evictionPolicy == EvictionPolicy::LRU) {
+      m_entries.splice(m_entries.begin(), m_entries, it->second);
+    }
+    return;
+  }
+
+  m_entries.push_front(Entry{request, isDirty});
+  m_index.emplace(request.requestId, m_entries.begin());
+  if (isDirty) {
+    m_nDirty++;
+  }
+  evictEntries();
+}
+
+void
+CaCachedStorage::eraseEntry(const RequestId& requestId)
+{
+  auto it = m_index.find(requestId);
+  if (it == m_index.end()) {
+    return;
+  }
+  if (it->second->isDirty) {
+    m_nDirty--;
+  }
+  m_entries.erase(it->second);
+  m_index.erase(it);
+}
+
+void
+CaCachedStorage::evictEntries()
+{
+  // the least recently used entries are at the back
+  auto it = m_entries.end();
+  while (m_entries.size() > m_capacity && it != m_entries.begin()) {
+    auto& victim = *--it;
+    if (victim.isDirty) {
+      // a modified request can only leave the cache once it is written back
+      try {
+        m_inner->updateRequest(victim.request);
+      }
+      catch (const std::exception& e) {
+        // the entry stays cached and dirty, and is retried by the next flush or eviction
+        NDN_LOG_ERROR("Cannot write request " << ndn::toHex(victim.request.requestId)
+                      << " to the backing storage: " << e.what());
+        m_metrics.nFlushErrors++;
+        continue;
+      }
+      m_metrics.nFlushedUpdates++;
+      m_nDirty--;
+    }
+    m_index.erase(victim.request.requestId);
+    it = m_entries.erase(it);
+    m_metrics.nEvictions++;
+  }
+}
+
+void
+CaCachedStorage::flushLocked()
+{
+  if (m_nDirty == 0 && m_pendingDeletions.empty()) {
+    return;
+  }
+
+  size_t nWritten = 0;
+  for (auto it = m_pendingDeletions.begin(); it != m_pendingDeletions.end();) {
+    try {
+      m_inner->deleteRequest(*it);
+      it = m_pendingDeletions.erase(it);
+      m_metrics.nFlushedDeletions++;
+      nWritten++;
+    }
+    catch (const std::exception& e) {
+      NDN_LOG_ERROR("Cannot delete request " << ndn::toHex(*it) << " from the backing storage: " << e.what());
+      m_metrics.nFlushErrors++;
+      ++it;
+    }
+  }
+
+  for (auto& entry : m_entries) {
+    if (!entry.isDirty) {
+      continue;
+    }
+    try {
+      m_inner->updateRequest(entry.request);
+      entry.isDirty = false;
+      m_nDirty--;
+      m_metrics.nFlushedUpdates++;
+      nWritten++;
+    }
+    catch (const std::exception& e) {
+      // the entry stays dirty and is retried by the next flush
+      NDN_LOG_ERROR("Cannot write request " << ndn::toHex(entry.request.requestId)
+                    << " to the backing storage: " << e.what());
+      m_metrics.nFlushErrors++;
+    }
+  }
+
+  if (nWritten > 0) {
+    m_metrics.nFlushes++;
+    NDN_LOG_TRACE("Flushed " << nWritten << " changes to the backing storage");
+  }
+}
+
+void
+CaCachedStorage::runFlusher()
+{
+  std::chrono::milliseconds interval(m_flushInterval.count());
+  std::unique_lock lock(m_mutex);
+  while (!m_isStopping) {
+    m_flusherCv.wait_for(lock, interval, [this] { return m_isStopping; });
+    if (!m_isStopping) {
+      flushLocked();
+    }
+  }
+}
+
+} // namespace ndncert::ca
@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_CA_CACHED_STORAGE_HPP
+#define NDNCERT_DETAIL_CA_CACHED_STORAGE_HPP
+
+#include "detail/ca-storage.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace ndncert::ca {
+
+/**
+ * @brief Caching tier in front of another CaStorage.
+ *
+ * Recently used requests are kept in a bounded in-memory cache, so that the lookups and updates
+ * of every CHALLENGE round do not reach the backing storage. In write-back mode, updates and
+ * deletions are recorded in the cache and written to the backing storage in batches: every
+ * flush interval, when a modified request is evicted, before an enumeration, and on destruction.
+ * New requests are always written through, so that duplicates are detected by the backing storage.
+ *
+ * The storage type is "ca-storage-cached:<inner type>", e.g., "ca-storage-cached:sqlite3".
+ * Recognized locator options (see CaStorage::parseLocator):
+ *   cache-capacity: maximum number of cached requests (default 1024), exceeded only by modified
+ *                   requests that cannot be written back to the backing storage
+ *   cache-eviction: "lru" or "fifo" (default "lru")
+ *   write-mode:     "write-back" or "write-through" (default "write-back")
+ *   flush-interval: milliseconds between periodic flushes in write-back mode, zero disabling
+ *                   them (default 1000)
+ */
+class CaCachedStorage : public CaStorage
+{
+public:
+  static const std::string STORAGE_TYPE;
+
+  enum class EvictionPolicy {
+    LRU,
+    FIFO,
+  };
+
+  struct Metrics
+  {
+    uint64_t nHits = 0;
+    uint64_t nMisses = 0;
+    uint64_t nEvictions = 0;
+    /**
+     * @brief Number of flushes that wrote at least one change to the backing storage.
+     */
+    uint64_t nFlushes = 0;
+    uint64_t nFlushedUpdates = 0;
+    uint64_t nFlushedDeletions = 0;
+    uint64_t nFlushErrors = 0;
+    size_t nCached = 0;
+    /**
+     * @brief Number of changes not yet written to the backing storage.
+     */
+    size_t nPending = 0;
+  };
+
+  CaCachedStorage(std::unique_ptr<CaStorage> inner, const Name& caName = "", const std::string& path = "");
+
+  ~CaCachedStorage() override;
+
+public:
+  RequestState
+  getRequest(const RequestId& requestId) override;
+
+  void
+  addRequest(const RequestState& request) override;
+
+  void
+  updateRequest(const RequestState& request) override;
+
+  void
+  deleteRequest(const RequestId& requestId) override;
+
+  std::list<RequestState>
+  listAllRequests() override;
+
+  std::list<RequestState>
+  listAllRequests(const Name& caName) override;
+
+  /**
+   * @note @p visitor is invoked with the cache locked and must not block.
+   */
+  size_t
+  forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor) override;
+
+  size_t
+  forEachRequestSummary(const RequestFilter& filter, const RequestSummaryVisitor& visitor) override;
+
+  size_t
+  countRequests(const RequestFilter& filter) override;
+
+public:
+  /**
+   * @brief Write all pending changes to the backing storage.
+   */
+  void
+  flush();
+
+  Metrics
+  getMetrics() const;
+
+  CaStorage&
+  getInnerStorage()
+  {
+    return *m_inner;
+  }
+
+private:
+  struct Entry
+  {
+    RequestState request;
+    bool isDirty = false;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  const Entry*
+  findEntry(const RequestId& requestId);
+
+  void
+  storeEntry(const RequestState& request, bool isDirty);
+
+  void
+  eraseEntry(const RequestId& requestId);
+
+  void
+  evictEntries();
+
+  void
+  flushLocked();
+
+  void
+  runFlusher();
+
+private:
+  std::unique_ptr<CaStorage> m_inner;
+  size_t m_capacity = 1024;
+  EvictionPolicy m_evictionPolicy = EvictionPolicy::LRU;
+  bool m_isWriteBack = true;
+  time::milliseconds m_flushInterval = 1_s;
+
+  // the most recently used (or inserted, with FIFO) entry is at the front
+  EntryList m_entries;
+  std::map<RequestId, EntryList::iterator> m_index;
+  std::set<RequestId> m_pendingDeletions;
+  size_t m_nDirty = 0;
+  Metrics m_metrics;
+
+  mutable std::recursive_mutex m_mutex;
+  std::condition_variable_any m_flusherCv;
+  bool m_isStopping = false;
+  std::thread m_flusher;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_CA_CACHED_STORAGE_HPP
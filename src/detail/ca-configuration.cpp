@@ -21,12 +21,26 @@
 #include "detail/ca-configuration.hpp"
 
 #include <ndn-cxx/util/io.hpp>
+#include <ndn-cxx/util/string-helper.hpp>
 
 #include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
 namespace ndncert::ca {
 
+static TokenBucketConfig
+parseTokenBucketConfig(const JsonSection& section)
+{
+  TokenBucketConfig config;
+  config.rate = section.get(CONFIG_ADMISSION_RATE, 0.0);
+  config.burst = section.get(CONFIG_ADMISSION_BURST, config.rate);
+  if (config.rate <= 0 || config.burst < 1) {
+    NDN_THROW(std::runtime_error("Admission control rates must be positive and bursts at least 1."));
+  }
+  return config;
+}
+
 void
 CaConfig::load(const std::string& fileName)
 {
@@ -87,6 +101,93 @@ CaConfig::load(const std::string& fileName)
       nameAssignmentFuncs.push_back(std::move(func));
     }
   }
+
+  // parse stateless mode if present
+  stateless.reset();
+  auto statelessSection = configJson.get_child_optional(CONFIG_STATELESS);
+  if (statelessSection) {
+    StatelessConfig config;
+    auto secretStr = statelessSection->get(CONFIG_STATELESS_SECRET, "");
+    try {
+      auto secret = ndn::fromHex(secretStr);
+      config.secret.assign(secret->begin(), secret->end());
+    }
+    catch (const std::exception&) {
+      NDN_THROW(std::runtime_error("Stateless mode secret is not a valid hex string."));
+    }
+    config.keyLifetime = time::seconds(statelessSection->get(CONFIG_STATELESS_KEY_LIFETIME,
+                                                             config.keyLifetime.count()));
+    config.tokenLifetime = time::seconds(statelessSection->get(CONFIG_STATELESS_TOKEN_LIFETIME,
+                                                               config.tokenLifetime.count()));
+    if (config.keyLifetime <= 0_s || config.tokenLifetime <= 0_s || config.tokenLifetime > config.keyLifetime) {
+      NDN_THROW(std::runtime_error("Stateless mode token lifetime must be positive and not exceed the key lifetime."));
+    }
+    // a replica does not know the tokens used on the other replicas, so a challenge that limits
+    // the number of tries would get a fresh count from each replica an old token is replayed to
+    if (!config.secret.empty()) {
+      for (const auto& challenge : caProfile.supportedChallenges) {
+        if (challenge == "pin" || challenge == "email") {
+          NDN_THROW(std::runtime_error("Challenge " + challenge + " limits the number of tries and cannot be "
+                                       "used in stateless mode with a secret shared by replicas."));
+        }
+      }
+    }
+    stateless = std::move(config);
+  }
+
+  // parse admission control if present
+  admission.reset();
+  auto admissionSection = configJson.get_child_optional(CONFIG_ADMISSION_CONTROL);
+  if (admissionSection) {
+    AdmissionConfig config;
+    auto endpointsSection = admissionSection->get_child_optional(CONFIG_ADMISSION_ENDPOINTS);
+    if (endpointsSection) {
+      for (const auto& [key, val] : *endpointsSection) {
+        std::optional<CaEndpoint> endpoint;
+        for (size_t i = 0; i < N_CA_ENDPOINTS; i++) {
+          if (boost::lexical_cast<std::string>(static_cast<CaEndpoint>(i)) == key) {
+            endpoint = static_cast<CaEndpoint>(i);
+          }
+        }
+        if (!endpoint) {
+          NDN_THROW(std::runtime_error("Unknown admission control endpoint: " + key));
+        }
+        config.endpointLimits[static_cast<size_t>(*endpoint)] = parseTokenBucketConfig(val);
+      }
+    }
+    auto totalSection = admissionSection->get_child_optional(CONFIG_ADMISSION_TOTAL);
+    if (totalSection) {
+      config.totalLimit = parseTokenBucketConfig(*totalSection);
+    }
+    config.challengeReserve = admissionSection->get(CONFIG_ADMISSION_CHALLENGE_RESERVE, config.challengeReserve);
+    auto keyLocatorSection = admissionSection->get_child_optional(CONFIG_ADMISSION_PER_KEY_LOCATOR);
+    if (keyLocatorSection) {
+      config.keyLocatorLimit = parseTokenBucketConfig(*keyLocatorSection);
+    }
+    config.maxKeyLocators = admissionSection->get(CONFIG_ADMISSION_MAX_KEY_LOCATORS, config.maxKeyLocators);
+    config.newShedLoad = admissionSection->get(CONFIG_ADMISSION_NEW_SHED_LOAD, config.newShedLoad);
+    if (config.challengeReserve < 0 || config.challengeReserve >= 1 || config.newShedLoad <= 0) {
+      NDN_THROW(std::runtime_error("Admission control reserve must be in [0, 1) and shed load positive."));
+    }
+    auto shedAction = admissionSection->get(CONFIG_ADMISSION_SHED_ACTION, "nack");
+    if (shedAction == "nack") {
+      config.shedAction = ShedAction::NACK;
+    }
+    else if (shedAction == "drop") {
+      config.shedAction = ShedAction::DROP;
+    }
+    else {
+      NDN_THROW(std::runtime_error("Unknown admission control shed action: " + shedAction));
+    }
+    admission = std::move(config);
+  }
+
+  inlineCertMaxSize = configJson.get(CONFIG_INLINE_CERT_MAX_SIZE, DEFAULT_INLINE_CERT_MAX_SIZE);
+  if (inlineCertMaxSize >= ndn::MAX_NDN_PACKET_SIZE) {
+    NDN_THROW(std::runtime_error("Inline certificate size limit exceeds the packet size limit."));
+  }
+  certStorePath = configJson.get(CONFIG_CERT_STORE_PATH, "");
+  revocationRegistryPath = configJson.get(CONFIG_REVOCATION_REGISTRY_PATH, "");
 }
 
 } // namespace ndncert::ca
@@ -22,11 +22,14 @@
 #define NDNCERT_DETAIL_CA_CONFIGURATION_HPP
 
 #include "ca-profile.hpp"
+#include "detail/admission-control.hpp"
 #include "name-assignment/assignment-func.hpp"
 #include "redirection/redirection-policy.hpp"
 
 namespace ndncert::ca {
 
+const size_t DEFAULT_INLINE_CERT_MAX_SIZE = 4096;
+
 /**
  * @brief CA's configuration on NDNCERT.
  *
@@ -45,9 +48,48 @@ namespace ndncert::ca {
  *  [
  *    {"challenge": ""},
  *    {"challenge": ""}
- *  ]
+ *  ],
+ *  "stateless":
+ *  {
+ *    "secret": "<hex, shared by the replicas of the CA>",
+ *    "key-lifetime": "<seconds>",
+ *    "token-lifetime": "<seconds>"
+ *  },
+ *  "admission-control":
+ *  {
+ *    "endpoints":
+ *    {
+ *      "<INFO|PROBE|NEW|CHALLENGE|REVOKE|RENEW|STATUS|REVOKED>": {"rate": "<per second>", "burst": ""}
+ *    },
+ *    "total": {"rate": "<per second>", "burst": ""},
+ *    "challenge-reserve": "<fraction of the total burst>",
+ *    "per-key-locator": {"rate": "<per second>", "burst": ""},
+ *    "max-key-locators": "",
+ *    "new-shed-load": "<fraction of the storage queue>",
+ *    "shed-action": "<nack|drop>"
+ *  },
+ *  "inline-cert-max-size": "<bytes, 0 to always fetch the certificate by name>",
+ *  "cert-store-path": "<database of the issued certificates, :memory: to keep them in memory only>",
+ *  "revocation-registry-path": "<database of the revoked certificates, :memory: to keep them in memory only>"
  * }
  */
+/**
+ * @brief Configuration of the stateless mode, see StateTokenSealer.
+ *
+ * Used tokens are only remembered by the process that used them. With a secret, which lets
+ * replicas open each other's tokens, the challenges that limit the number of tries (pin and
+ * email) are therefore refused.
+ */
+struct StatelessConfig
+{
+  /**
+   * @brief The secret of the sealing keys, random if empty.
+   */
+  std::vector<uint8_t> secret;
+  time::seconds keyLifetime = 1_h;
+  time::seconds tokenLifetime = 10_min;
+};
+
 class CaConfig
 {
 public:
@@ -71,6 +113,33 @@ public:
    * @brief Name Assignment Functions
    */
   std::vector<std::unique_ptr<NameAssignmentFunc>> nameAssignmentFuncs;
+  /**
+   * @brief When set, request states are held by the requesters instead of the CA storage.
+   */
+  std::optional<StatelessConfig> stateless;
+  /**
+   * @brief When set, Interests are admitted by an AdmissionController.
+   */
+  std::optional<AdmissionConfig> admission;
+  /**
+   * @brief The largest issued certificate returned with the final CHALLENGE response.
+   *
+   * Larger certificates are fetched by name.
+   */
+  size_t inlineCertMaxSize = DEFAULT_INLINE_CERT_MAX_SIZE;
+  /**
+   * @brief The database of the issued certificates, see IssuedCertStore.
+   *
+   * Empty for the default location. Processes serving the same CA, e.g., shards, each need
+   * their own database.
+   */
+  std::string certStorePath;
+  /**
+   * @brief The database of the revoked certificates, see RevocationRegistry.
+   *
+   * Empty for the default location. Processes serving the same CA may share it.
+   */
+  std::string revocationRegistryPath;
 };
 
 } // namespace ndncert::ca
@@ -0,0 +1,460 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/ca-journaled-memory.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ndncert::ca {
+
+NDN_LOG_INIT(ndncert.storage.journaled);
+
+const std::string CaJournaledMemory::STORAGE_TYPE = "ca-storage-journaled-memory";
+NDNCERT_REGISTER_CA_STORAGE(CaJournaledMemory);
+
+// a journal record is either an encoded request (see encodeRequestState()) or this deletion marker
+const uint32_t JOURNAL_DELETION = 215;
+
+static std::runtime_error
+makeSystemError(const std::string& what, const std::string& path)
+{
+  return std::runtime_error("CaJournaledMemory " + what + " " + path + ": " + std::strerror(errno));
+}
+
+static void
+writeAll(int fd, const uint8_t* data, size_t size, const std::string& path)
+{
+  while (size > 0) {
+    auto n = ::write(fd, data, size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      NDN_THROW(makeSystemError("cannot write", path));
+    }
+    data += n;
+    size -= n;
+  }
+}
+
+/**
+ * @brief Append the content of @p from to @p to, and flush it to disk.
+ */
+static void
+appendFile(const std::string& from, const std::string& to)
+{
+  int in = ::open(from.data(), O_RDONLY | O_CLOEXEC);
+  if (in < 0) {
+    NDN_THROW(makeSystemError("cannot open", from));
+  }
+  int out = ::open(to.data(), O_WRONLY | O_APPEND | O_CLOEXEC);
+  if (out < 0) {
+    ::close(in);
+    NDN_THROW(makeSystemError("cannot open", to));
+  }
+  try {
+    std::vector<uint8_t> buffer(1 << 16);
+    while (true) {
+      auto n = ::read(in, buffer.data(), buffer.size());
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0) {
+        NDN_THROW(makeSystemError("cannot read", from));
+      }
+      if (n == 0) {
+        break;
+      }
+      writeAll(out, buffer.data(), n, to);
+    }
+    if (::fsync(out) != 0) {
+      NDN_THROW(makeSystemError("cannot write", to));
+    }
+  }
+  catch (const std::exception&) {
+    ::close(in);
+    ::close(out);
+    throw;
+  }
+  ::close(in);
+  ::close(out);
+}
+
+CaJournaledMemory::CaJournaledMemory(const Name& caName, const std::string& path)
+  : CaMemory(caName, path)
+{
+  auto [location, options] = parseLocator(path);
+  if (location.empty()) {
+    std::string fileName = caName.toUri();
+    std::replace(fileName.begin(), fileName.end(), '/', '_');
+    boost::filesystem::path dir;
+    if (getenv("HOME") != nullptr) {
+      dir = boost::filesystem::path(getenv("HOME")) / ".ndncert";
+    }
+    else {
+      dir = boost::filesystem::current_path() / ".ndncert";
+    }
+    boost::filesystem::create_directories(dir);
+    location = (dir / fileName).string();
+  }
+  m_snapshotPath = location + ".snapshot";
+  m_journalPath = location + ".journal";
+  m_prevJournalPath = location + ".journal.prev";
+
+  try {
+    if (options.count("fsync-interval") != 0) {
+      m_fsyncInterval = time::milliseconds(boost::lexical_cast<uint64_t>(options["fsync-interval"]));
+    }
+    if (options.count("snapshot-interval") != 0) {
+      m_snapshotInterval = time::seconds(boost::lexical_cast<uint64_t>(options["snapshot-interval"]));
+    }
+    if (options.count("snapshot-bytes") != 0) {
+      m_snapshotBytes = boost::lexical_cast<uint64_t>(options["snapshot-bytes"]);
+    }
+  }
+  catch (const boost::bad_lexical_cast&) {
+    NDN_THROW(std::runtime_error("Invalid option for " + STORAGE_TYPE + ": " + path));
+  }
+  if (options.count("fsync") != 0) {
+    if (options["fsync"] == "always") {
+      m_fsyncPolicy = FsyncPolicy::ALWAYS;
+    }
+    else if (options["fsync"] == "interval") {
+      m_fsyncPolicy = FsyncPolicy::INTERVAL;
+    }
+    else if (options["fsync"] == "never") {
+      m_fsyncPolicy = FsyncPolicy::NEVER;
+    }
+    else {
+      NDN_THROW(std::runtime_error("Unknown fsync policy for " + STORAGE_TYPE + ": " + options["fsync"]));
+    }
+  }
+
+  // snapshot, then the journal it was cut from (if the snapshot did not complete), then the current journal
+  auto start = time::steady_clock::now();
+  replay(m_snapshotPath, false);
+  bool hasPrevJournal = boost::filesystem::exists(m_prevJournalPath);
+  if (hasPrevJournal) {
+    replay(m_prevJournalPath, false);
+  }
+  replay(m_journalPath, true);
+  m_stats.replayDuration = time::steady_clock::now() - start;
+  NDN_LOG_INFO("Loaded " << CaMemory::listAllRequests().size() << " requests from " << m_stats.nReplayedRecords
+               << " records in " << time::duration_cast<time::milliseconds>(m_stats.replayDuration));
+
+  if (hasPrevJournal) {
+    // the previous snapshot was interrupted; the state is complete again, so write it out
+    // before the previous journal can be overwritten by the next rotation
+    writeSnapshot(CaMemory::listAllRequests());
+    boost::filesystem::remove(m_prevJournalPath);
+  }
+  openJournal();
+
+  m_worker = std::thread([this] { run(); });
+}
+
+CaJournaledMemory::~CaJournaledMemory()
+{
+  {
+    std::lock_guard lock(m_mutex);
+    m_isStopping = true;
+  }
+  m_cv.notify_all();
+  m_worker.join();
+
+  if (m_journalFd >= 0) {
+    if (m_fsyncPolicy != FsyncPolicy::NEVER) {
+      ::fsync(m_journalFd);
+    }
+    ::close(m_journalFd);
+  }
+}
+
+void
+CaJournaledMemory::addRequest(const RequestState& request)
+{
+  auto record = encodeRequestState(request);
+  std::lock_guard lock(m_mutex);
+  CaMemory::addRequest(request);
+  try {
+    append(record);
+  }
+  catch (const std::exception&) {
+    CaMemory::deleteRequest(request.requestId);
+    throw;
+  }
+}
+
+void
+CaJournaledMemory::updateRequest(const RequestState& request)
+{
+  auto record = encodeRequestState(request);
+  std::lock_guard lock(m_mutex);
+  append(record);
+  CaMemory::updateRequest(request);
+}
+
+void
+CaJournaledMemory::deleteRequest(const RequestId& requestId)
+{
+  auto record = ndn::makeBinaryBlock(JOURNAL_DELETION, requestId);
+  std::lock_guard lock(m_mutex);
+  append(record);
+  CaMemory::deleteRequest(requestId);
+}
+
+void
+CaJournaledMemory::snapshot()
+{
+  std::lock_guard snapshotLock(m_snapshotMutex);
+  auto start = time::steady_clock::now();
+
+  std::list<RequestState> requests;
+  {
+    // everything written to the current journal is part of the copied state
+    std::lock_guard lock(m_mutex);
+    requests = CaMemory::listAllRequests();
+    if (m_fsyncPolicy != FsyncPolicy::NEVER) {
+      ::fsync(m_journalFd);
+    }
+    try {
+      if (boost::filesystem::exists(m_prevJournalPath)) {
+        // an earlier snapshot failed, and the journal it rotated is still needed: move the records
+        // over instead of replacing it. Should this be interrupted, the records are replayed
+        // twice, which leads to the same state.
+        appendFile(m_journalPath, m_prevJournalPath);
+        if (::ftruncate(m_journalFd, 0) != 0) {
+          NDN_THROW(makeSystemError("cannot truncate", m_journalPath));
+        }
+      }
+      else {
+        ::close(m_journalFd);
+        m_journalFd = -1;
+        boost::filesystem::rename(m_journalPath, m_prevJournalPath);
+        openJournal();
+      }
+    }
+    catch (const std::exception&) {
+      // later mutations must still be journaled
+      if (m_journalFd < 0) {
+        try {
+          openJournal();
+        }
+        catch (const std::exception& e) {
+          NDN_LOG_ERROR("Cannot reopen the journal: " << e.what());
+        }
+      }
+      throw;
+    }
+    m_stats.journalBytes = 0;
+    m_needsFsync = false;
+  }
+
+  writeSnapshot(requests);
+  boost::filesystem::remove(m_prevJournalPath);
+
+  std::lock_guard lock(m_mutex);
+  m_stats.nSnapshots++;
+  m_stats.lastSnapshotDuration = time::steady_clock::now() - start;
+  NDN_LOG_DEBUG("Wrote a snapshot of " << requests.size() << " requests in "
+                << time::duration_cast<time::milliseconds>(m_stats.lastSnapshotDuration));
+}
+
+CaJournaledMemory::Statistics
+CaJournaledMemory::getStatistics() const
+{
+  std::lock_guard lock(m_mutex);
+  return m_stats;
+}
+
+void
+CaJournaledMemory::replay(const std::string& path, bool mayTruncate)
+{
+  if (!boost::filesystem::exists(path)) {
+    return;
+  }
+  auto size = boost::filesystem::file_size(path);
+  auto buffer = std::make_shared<ndn::Buffer>(size);
+  int fd = ::open(path.data(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    NDN_THROW(makeSystemError("cannot open", path));
+  }
+  size_t nRead = 0;
+  while (nRead < size) {
+    auto n = ::read(fd, buffer->data() + nRead, size - nRead);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      ::close(fd);
+      NDN_THROW(makeSystemError("cannot read", path));
+    }
+    nRead += n;
+  }
+  ::close(fd);
+
+  size_t offset = 0;
+  while (offset < buffer->size()) {
+    auto [isOk, record] = Block::fromBuffer(buffer, offset);
+    if (!isOk) {
+      break;
+    }
+    try {
+      if (record.type() == JOURNAL_DELETION) {
+        RequestId requestId;
+        if (record.value_size() != requestId.size()) {
+          break;
+        }
+        std::memcpy(requestId.data(), record.value(), requestId.size());
+        CaMemory::deleteRequest(requestId);
+      }
+      else {
+        CaMemory::updateRequest(decodeRequestState(record));
+      }
+    }
+    catch (const std::exception& e) {
+      NDN_LOG_ERROR("Cannot decode a record of " << path << ": " << e.what());
+      break;
+    }
+    offset += record.size();
+    m_stats.nReplayedRecords++;
+  }
+
+  if (offset < buffer->size()) {
+    if (!mayTruncate) {
+      NDN_THROW(std::runtime_error("CaJournaledMemory file is corrupted: " + path));
+    }
+    // a record was being appended when the process stopped
+    NDN_LOG_WARN("Discarding " << buffer->size() - offset << " trailing bytes of " << path);
+    boost::filesystem::resize_file(path, offset);
+  }
+}
+
+void
+CaJournaledMemory::openJournal()
+{
+  m_journalFd = ::open(m_journalPath.data(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+  if (m_journalFd < 0) {
+    NDN_THROW(makeSystemError("cannot open", m_journalPath));
+  }
+  m_stats.journalBytes = boost::filesystem::file_size(m_journalPath);
+}
+
+void
+CaJournaledMemory::append(const Block& record)
+{
+  try {
+    writeAll(m_journalFd, record.wire(), record.size(), m_journalPath);
+  }
+  catch (const std::exception&) {
+    // drop a partially written record, the replay would otherwise stop in front of it
+    if (::ftruncate(m_journalFd, m_stats.journalBytes) != 0) {
+      NDN_LOG_ERROR("Cannot truncate " << m_journalPath << ": " << std::strerror(errno));
+    }
+    throw;
+  }
+  m_stats.journalBytes += record.size();
+  if (m_fsyncPolicy == FsyncPolicy::ALWAYS) {
+    ::fsync(m_journalFd);
+  }
+  else {
+    m_needsFsync = true;
+  }
+  if (m_snapshotBytes != 0 && m_stats.journalBytes >= m_snapshotBytes && !m_isSnapshotRequested) {
+    m_isSnapshotRequested = true;
+    m_cv.notify_all();
+  }
+}
+
+void
+CaJournaledMemory::writeSnapshot(const std::list<RequestState>& requests)
+{
+  auto tmpPath = m_snapshotPath + ".tmp";
+  int fd = ::open(tmpPath.data(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    NDN_THROW(makeSystemError("cannot open", tmpPath));
+  }
+
+  // batch the records to keep the number of system calls low
+  std::vector<uint8_t> buffer;
+  try {
+    for (const auto& request : requests) {
+      auto record = encodeRequestState(request);
+      buffer.insert(buffer.end(), record.wire(), record.wire() + record.size());
+      if (buffer.size() >= (1 << 20)) {
+        writeAll(fd, buffer.data(), buffer.size(), tmpPath);
+        buffer.clear();
+      }
+    }
+    writeAll(fd, buffer.data(), buffer.size(), tmpPath);
+  }
+  catch (const std::exception&) {
+    ::close(fd);
+    throw;
+  }
+  if (::fsync(fd) != 0 || ::close(fd) != 0 || ::rename(tmpPath.data(), m_snapshotPath.data()) != 0) {
+    NDN_THROW(makeSystemError("cannot replace", m_snapshotPath));
+  }
+}
+
+void
+CaJournaledMemory::run()
+{
+  using Clock = std::chrono::steady_clock;
+  auto nextSnapshot = Clock::now() + std::chrono::seconds(m_snapshotInterval.count());
+  std::chrono::milliseconds tick(m_fsyncPolicy == FsyncPolicy::INTERVAL ?
+                                 std::max<int64_t>(m_fsyncInterval.count(), 1) : 1000);
+
+  std::unique_lock lock(m_mutex);
+  while (!m_isStopping) {
+    m_cv.wait_for(lock, tick, [this] { return m_isStopping || m_isSnapshotRequested; });
+    if (m_isStopping) {
+      break;
+    }
+    if (m_fsyncPolicy == FsyncPolicy::INTERVAL && m_needsFsync) {
+      ::fsync(m_journalFd);
+      m_needsFsync = false;
+    }
+
+    bool isDue = m_snapshotInterval > 0_s && Clock::now() >= nextSnapshot;
+    if (m_isSnapshotRequested || isDue) {
+      m_isSnapshotRequested = false;
+      lock.unlock();
+      try {
+        snapshot();
+      }
+      catch (const std::exception& e) {
+        NDN_LOG_ERROR("Cannot write a snapshot: " << e.what());
+      }
+      lock.lock();
+      nextSnapshot = Clock::now() + std::chrono::seconds(m_snapshotInterval.count());
+    }
+  }
+}
+
+} // namespace ndncert::ca
@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_CA_JOURNALED_MEMORY_HPP
+#define NDNCERT_DETAIL_CA_JOURNALED_MEMORY_HPP
+
+#include "detail/ca-memory.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace ndncert::ca {
+
+/**
+ * @brief CaMemory that survives restarts.
+ *
+ * Every mutation is appended to a journal of TLV records; a mutation that cannot be journaled
+ * fails without changing the requests. A background thread periodically
+ * writes a snapshot of all requests and starts a new journal; on startup, the snapshot and the
+ * journals written after it are replayed. Reads never touch the disk.
+ *
+ * The files are "<location>.snapshot", "<location>.journal" and, while a snapshot is being
+ * written, "<location>.journal.prev". Without a location, "$HOME/.ndncert/<CA name>" is used.
+ *
+ * Recognized locator options (see CaStorage::parseLocator):
+ *   fsync:             "always" after every record, "interval" (default) or "never"
+ *   fsync-interval:    milliseconds between two fsync() of the journal (default 1000)
+ *   snapshot-interval: seconds between two snapshots, zero disabling them (default 300)
+ *   snapshot-bytes:    journal size that triggers a snapshot, zero meaning no limit
+ *                      (default 67108864)
+ *
+ * Like CaMemory, the storage must only be used from a single thread.
+ */
+class CaJournaledMemory : public CaMemory
+{
+public:
+  static const std::string STORAGE_TYPE;
+
+  enum class FsyncPolicy {
+    ALWAYS,
+    INTERVAL,
+    NEVER,
+  };
+
+  struct Statistics
+  {
+    size_t nReplayedRecords = 0;
+    time::nanoseconds replayDuration = 0_ns;
+    uint64_t journalBytes = 0;
+    uint64_t nSnapshots = 0;
+    time::nanoseconds lastSnapshotDuration = 0_ns;
+  };
+
+  explicit
+  CaJournaledMemory(const Name& caName = "", const std::string& path = "");
+
+  ~CaJournaledMemory() override;
+
+public:
+  void
+  addRequest(const RequestState& request) override;
+
+  void
+  updateRequest(const RequestState& request) override;
+
+  void
+  deleteRequest(const RequestId& requestId) override;
+
+public:
+  /**
+   * @brief Write a snapshot now and start a new journal.
+   */
+  void
+  snapshot();
+
+  Statistics
+  getStatistics() const;
+
+NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  /**
+   * @brief Append @p record to the journal.
+   *
+   * On failure, the journal is cut back to its previous size and the exception is rethrown.
+   */
+  NDNCERT_VIRTUAL_WITH_TESTS void
+  append(const Block& record);
+
+private:
+  void
+  replay(const std::string& path, bool mayTruncate);
+
+  void
+  openJournal();
+
+  void
+  writeSnapshot(const std::list<RequestState>& requests);
+
+  void
+  run();
+
+private:
+  std::string m_snapshotPath;
+  std::string m_journalPath;
+  std::string m_prevJournalPath;
+  FsyncPolicy m_fsyncPolicy = FsyncPolicy::INTERVAL;
+  time::milliseconds m_fsyncInterval = 1_s;
+  time::seconds m_snapshotInterval = 300_s;
+  uint64_t m_snapshotBytes = 64 << 20;
+
+  int m_journalFd = -1;
+  bool m_needsFsync = false;
+  Statistics m_stats;
+
+  // guards the journal and the statistics; the map itself is only modified with it held,
+  // so that the background thread can copy it
+  mutable std::mutex m_mutex;
+  // serializes snapshots
+  std::mutex m_snapshotMutex;
+  std::condition_variable m_cv;
+  bool m_isStopping = false;
+  bool m_isSnapshotRequested = false;
+  std::thread m_worker;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_CA_JOURNALED_MEMORY_HPP
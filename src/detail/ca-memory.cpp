@@ -83,4 +83,24 @@ CaMemory::listAllRequests(const Name& caName)
   return result;
 }
 
+size_t
+CaMemory::forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor)
+{
+  auto it = filter.startAfter ? m_requests.upper_bound(*filter.startAfter) : m_requests.begin();
+  size_t nVisited = 0;
+  for (; it != m_requests.end(); ++it) {
+    if (filter.limit != 0 && nVisited >= filter.limit) {
+      break;
+    }
+    if (!filter.matches(summarizeRequest(it->second))) {
+      continue;
+    }
+    nVisited++;
+    if (!visitor(it->second)) {
+      break;
+    }
+  }
+  return nVisited;
+}
+
 } // namespace ndncert::ca
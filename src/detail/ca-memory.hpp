@@ -52,6 +52,9 @@ public:
   std::list<RequestState>
   listAllRequests(const Name& caName) override;
 
+  size_t
+  forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor) override;
+
 private:
   std::map<RequestId, RequestState> m_requests;
 };
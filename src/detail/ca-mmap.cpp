@@ -0,0 +1,473 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/ca-mmap.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ndncert::ca {
+
+NDN_LOG_INIT(ndncert.storage.mmap);
+
+const std::string CaMmap::STORAGE_TYPE = "ca-storage-mmap";
+NDNCERT_REGISTER_CA_STORAGE(CaMmap);
+
+// file layout: a fixed-size header followed by 8-byte aligned records
+const char FILE_MAGIC[8] = {'N', 'D', 'N', 'C', 'E', 'R', 'T', 'L'};
+const uint32_t FILE_VERSION = 1;
+const uint64_t FILE_HEADER_SIZE = 64;
+const uint64_t FILE_TAIL_OFFSET = 16;
+const uint64_t INITIAL_FILE_SIZE = 1 << 20;
+const uint64_t MIN_COMPACTION_BYTES = 1 << 20;
+
+// record layout: uint32 payload length, uint8 kind, 3 padding bytes, request ID, payload
+const uint64_t RECORD_HEADER_SIZE = 16;
+const uint8_t RECORD_PUT = 1;
+const uint8_t RECORD_DELETE = 2;
+
+static uint64_t
+getRecordSize(uint32_t payloadSize)
+{
+  return (RECORD_HEADER_SIZE + payloadSize + 7) & ~uint64_t(7);
+}
+
+static std::runtime_error
+makeSystemError(const std::string& what, const std::string& path)
+{
+  return std::runtime_error("CaMmap " + what + " " + path + ": " + std::strerror(errno));
+}
+
+CaMmap::CaMmap(const Name& caName, const std::string& path)
+  : CaStorage()
+{
+  auto [location, options] = parseLocator(path);
+  if (!location.empty()) {
+    m_path = location;
+  }
+  else {
+    std::string fileName = caName.toUri();
+    std::replace(fileName.begin(), fileName.end(), '/', '_');
+    fileName += ".mmap";
+    boost::filesystem::path dir;
+    if (getenv("HOME") != nullptr) {
+      dir = boost::filesystem::path(getenv("HOME")) / ".ndncert";
+    }
+    else {
+      dir = boost::filesystem::current_path() / ".ndncert";
+    }
+    boost::filesystem::create_directories(dir);
+    m_path = (dir / fileName).string();
+  }
+  m_isSync = options["sync"] == "1";
+
+  try {
+    open();
+  }
+  catch (const std::exception&) {
+    // the destructor does not run, release what was opened before the failure
+    close();
+    throw;
+  }
+}
+
+CaMmap::~CaMmap()
+{
+  close();
+}
+
+void
+CaMmap::open()
+{
+  m_fd = ::open(m_path.data(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (m_fd < 0) {
+    NDN_THROW(makeSystemError("cannot open", m_path));
+  }
+  struct stat st;
+  if (::fstat(m_fd, &st) != 0) {
+    NDN_THROW(makeSystemError("cannot stat", m_path));
+  }
+
+  bool isNew = st.st_size == 0;
+  if (isNew) {
+    if (::ftruncate(m_fd, INITIAL_FILE_SIZE) != 0) {
+      NDN_THROW(makeSystemError("cannot resize", m_path));
+    }
+    m_fileSize = INITIAL_FILE_SIZE;
+  }
+  else if (static_cast<uint64_t>(st.st_size) < FILE_HEADER_SIZE) {
+    NDN_THROW(std::runtime_error("CaMmap file is truncated: " + m_path));
+  }
+  else {
+    m_fileSize = st.st_size;
+  }
+
+  void* data = ::mmap(nullptr, m_fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (data == MAP_FAILED) {
+    NDN_THROW(makeSystemError("cannot map", m_path));
+  }
+  m_data = static_cast<uint8_t*>(data);
+
+  if (isNew) {
+    std::memcpy(m_data, FILE_MAGIC, sizeof(FILE_MAGIC));
+    std::memcpy(m_data + sizeof(FILE_MAGIC), &FILE_VERSION, sizeof(FILE_VERSION));
+    m_tail = FILE_HEADER_SIZE;
+    std::memcpy(m_data + FILE_TAIL_OFFSET, &m_tail, sizeof(m_tail));
+    return;
+  }
+
+  uint32_t version = 0;
+  std::memcpy(&version, m_data + sizeof(FILE_MAGIC), sizeof(version));
+  if (std::memcmp(m_data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || version != FILE_VERSION) {
+    NDN_THROW(std::runtime_error("CaMmap file has an unknown format: " + m_path));
+  }
+  std::memcpy(&m_tail, m_data + FILE_TAIL_OFFSET, sizeof(m_tail));
+  if (m_tail < FILE_HEADER_SIZE || m_tail > m_fileSize) {
+    NDN_THROW(std::runtime_error("CaMmap file has a corrupted header: " + m_path));
+  }
+  replay();
+}
+
+void
+CaMmap::close()
+{
+  if (m_data != nullptr) {
+    ::msync(m_data, m_fileSize, MS_SYNC);
+    ::munmap(m_data, m_fileSize);
+    m_data = nullptr;
+  }
+  if (m_fd >= 0) {
+    ::close(m_fd);
+    m_fd = -1;
+  }
+  m_index.clear();
+  m_staleBytes = 0;
+}
+
+void
+CaMmap::replay()
+{
+  uint64_t offset = FILE_HEADER_SIZE;
+  while (offset + RECORD_HEADER_SIZE <= m_tail) {
+    uint32_t payloadSize = 0;
+    std::memcpy(&payloadSize, m_data + offset, sizeof(payloadSize));
+    uint8_t kind = m_data[offset + 4];
+    RequestId requestId;
+    std::memcpy(requestId.data(), m_data + offset + 8, requestId.size());
+    uint64_t recordSize = getRecordSize(payloadSize);
+    if (offset + recordSize > m_tail || (kind != RECORD_PUT && kind != RECORD_DELETE)) {
+      break;
+    }
+
+    auto it = m_index.find(requestId);
+    if (it != m_index.end()) {
+      m_staleBytes += getRecordSize(it->second.size);
+    }
+    if (kind == RECORD_PUT) {
+      m_index[requestId] = {offset, payloadSize};
+    }
+    else {
+      if (it != m_index.end()) {
+        m_index.erase(it);
+      }
+      m_staleBytes += recordSize;
+    }
+    offset += recordSize;
+  }
+
+  if (offset != m_tail) {
+    NDN_LOG_WARN("Discarding " << m_tail - offset << " bytes of incomplete records in " << m_path);
+    m_tail = offset;
+    std::memcpy(m_data + FILE_TAIL_OFFSET, &m_tail, sizeof(m_tail));
+  }
+}
+
+RequestState
+CaMmap::getRequest(const RequestId& requestId)
+{
+  std::shared_lock lock(m_mutex);
+  auto it = m_index.find(requestId);
+  if (it == m_index.end()) {
+    NDN_THROW(std::runtime_error("Request " + ndn::toHex(requestId) + " does not exist"));
+  }
+  return readRequest(it->second);
+}
+
+void
+CaMmap::addRequest(const RequestState& request)
+{
+  auto wire = encodeRequestState(request);
+  std::unique_lock lock(m_mutex);
+  if (m_index.count(request.requestId) != 0) {
+    NDN_THROW(std::runtime_error("Request " + ndn::toHex(request.requestId) + " already exists"));
+  }
+  appendRecord(RECORD_PUT, request.requestId, &wire);
+}
+
+void
+CaMmap::updateRequest(const RequestState& request)
+{
+  auto wire = encodeRequestState(request);
+  std::unique_lock lock(m_mutex);
+  appendRecord(RECORD_PUT, request.requestId, &wire);
+}
+
+void
+CaMmap::deleteRequest(const RequestId& requestId)
+{
+  std::unique_lock lock(m_mutex);
+  if (m_index.count(requestId) == 0) {
+    return;
+  }
+  appendRecord(RECORD_DELETE, requestId, nullptr);
+}
+
+std::list<RequestState>
+CaMmap::listAllRequests()
+{
+  std::list<RequestState> result;
+  std::shared_lock lock(m_mutex);
+  for (const auto& [requestId, location] : m_index) {
+    result.push_back(readRequest(location));
+  }
+  return result;
+}
+
+std::list<RequestState>
+CaMmap::listAllRequests(const Name& caName)
+{
+  std::list<RequestState> result;
+  std::shared_lock lock(m_mutex);
+  for (const auto& [requestId, location] : m_index) {
+    auto request = readRequest(location);
+    if (request.caPrefix == caName) {
+      result.push_back(std::move(request));
+    }
+  }
+  return result;
+}
+
+size_t
+CaMmap::forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor)
+{
+  // decode in batches, so that the visitor runs without the lock and may modify the storage
+  const size_t batchSize = 64;
+  size_t nVisited = 0;
+  std::optional<RequestId> cursor = filter.startAfter;
+  bool isDone = false;
+  while (!isDone) {
+    std::vector<RequestState> batch;
+    {
+      std::shared_lock lock(m_mutex);
+      auto it = cursor ? m_index.upper_bound(*cursor) : m_index.begin();
+      for (; it != m_index.end() && batch.size() < batchSize; ++it) {
+        cursor = it->first;
+        auto request = readRequest(it->second);
+        if (filter.matches(summarizeRequest(request))) {
+          batch.push_back(std::move(request));
+        }
+      }
+      isDone = it == m_index.end();
+    }
+
+    for (const auto& request : batch) {
+      if (filter.limit != 0 && nVisited >= filter.limit) {
+        return nVisited;
+      }
+      nVisited++;
+      if (!visitor(request)) {
+        return nVisited;
+      }
+    }
+  }
+  return nVisited;
+}
+
+CaMmap::Statistics
+CaMmap::getStatistics() const
+{
+  std::shared_lock lock(m_mutex);
+  Statistics stats;
+  stats.nRequests = m_index.size();
+  stats.fileSize = m_fileSize;
+  stats.usedBytes = m_tail;
+  stats.staleBytes = m_staleBytes;
+  return stats;
+}
+
+void
+CaMmap::compact()
+{
+  std::unique_lock lock(m_mutex);
+  compactLocked();
+}
+
+RequestState
+CaMmap::readRequest(const Location& location) const
+{
+  return decodeRequestState(Block(ndn::make_span(m_data + location.offset + RECORD_HEADER_SIZE,
+                                                 location.size)));
+}
+
+void
+CaMmap::appendRecord(uint8_t kind, const RequestId& requestId, const Block* wire)
+{
+  uint32_t payloadSize = wire == nullptr ? 0 : wire->size();
+  uint64_t recordSize = getRecordSize(payloadSize);
+  reserve(m_tail + recordSize);
+
+  uint8_t* record = m_data + m_tail;
+  std::memset(record, 0, recordSize);
+  std::memcpy(record, &payloadSize, sizeof(payloadSize));
+  record[4] = kind;
+  std::memcpy(record + 8, requestId.data(), requestId.size());
+  if (wire != nullptr) {
+    std::memcpy(record + RECORD_HEADER_SIZE, wire->wire(), payloadSize);
+  }
+
+  if (m_isSync) {
+    // the record must be durable before the header points past it
+    auto pageSize = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+    auto begin = m_tail & ~(pageSize - 1);
+    ::msync(m_data + begin, m_tail + recordSize - begin, MS_SYNC);
+  }
+  auto offset = m_tail;
+  m_tail += recordSize;
+  std::memcpy(m_data + FILE_TAIL_OFFSET, &m_tail, sizeof(m_tail));
+  if (m_isSync) {
+    ::msync(m_data, FILE_HEADER_SIZE, MS_SYNC);
+  }
+
+  auto it = m_index.find(requestId);
+  if (it != m_index.end()) {
+    m_staleBytes += getRecordSize(it->second.size);
+  }
+  if (kind == RECORD_PUT) {
+    m_index[requestId] = {offset, payloadSize};
+  }
+  else {
+    m_index.erase(requestId);
+    m_staleBytes += recordSize;
+  }
+
+  if (m_staleBytes >= MIN_COMPACTION_BYTES && m_staleBytes > m_tail - m_staleBytes) {
+    // the record is already durable, a failed compaction is retried by the next append
+    try {
+      compactLocked();
+    }
+    catch (const std::exception& e) {
+      NDN_LOG_WARN("Cannot compact " << m_path << ": " << e.what());
+    }
+  }
+}
+
+void
+CaMmap::reserve(uint64_t size)
+{
+  if (size <= m_fileSize) {
+    return;
+  }
+  uint64_t newSize = m_fileSize;
+  while (newSize < size) {
+    newSize *= 2;
+  }
+  if (::ftruncate(m_fd, newSize) != 0) {
+    NDN_THROW(makeSystemError("cannot resize", m_path));
+  }
+  void* data = ::mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (data == MAP_FAILED) {
+    NDN_THROW(makeSystemError("cannot map", m_path));
+  }
+  ::munmap(m_data, m_fileSize);
+  m_data = static_cast<uint8_t*>(data);
+  m_fileSize = newSize;
+}
+
+void
+CaMmap::compactLocked()
+{
+  NDN_LOG_DEBUG("Compacting " << m_path << ": " << m_staleBytes << " of " << m_tail << " bytes are stale");
+
+  // write the live records into a new file, then atomically replace the current one
+  std::string tmpPath = m_path + ".compact";
+  std::vector<uint8_t> buffer(FILE_HEADER_SIZE, 0);
+  std::memcpy(buffer.data(), m_data, FILE_HEADER_SIZE);
+  std::map<RequestId, Location> index;
+  for (const auto& [requestId, location] : m_index) {
+    auto recordSize = getRecordSize(location.size);
+    index[requestId] = {buffer.size(), location.size};
+    buffer.insert(buffer.end(), m_data + location.offset, m_data + location.offset + recordSize);
+  }
+  uint64_t tail = buffer.size();
+  std::memcpy(buffer.data() + FILE_TAIL_OFFSET, &tail, sizeof(tail));
+  buffer.resize(std::max<uint64_t>(INITIAL_FILE_SIZE, tail), 0);
+
+  int fd = ::open(tmpPath.data(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    NDN_THROW(makeSystemError("cannot open", tmpPath));
+  }
+  void* data = MAP_FAILED;
+  auto fail = [&] (const std::string& what, const std::string& path) {
+    auto error = makeSystemError(what, path);
+    if (data != MAP_FAILED) {
+      ::munmap(data, buffer.size());
+    }
+    ::close(fd);
+    ::unlink(tmpPath.data());
+    NDN_THROW(error);
+  };
+  size_t written = 0;
+  while (written < buffer.size()) {
+    auto n = ::write(fd, buffer.data() + written, buffer.size() - written);
+    if (n < 0) {
+      fail("cannot write", tmpPath);
+    }
+    written += n;
+  }
+  if (::fsync(fd) != 0) {
+    fail("cannot write", tmpPath);
+  }
+  // the new file is mapped before the current one is replaced, so that a failure leaves it in use
+  data = ::mmap(nullptr, buffer.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    fail("cannot map", tmpPath);
+  }
+  if (::rename(tmpPath.data(), m_path.data()) != 0) {
+    fail("cannot replace", m_path);
+  }
+
+  ::munmap(m_data, m_fileSize);
+  ::close(m_fd);
+  m_fd = fd;
+  m_data = static_cast<uint8_t*>(data);
+  m_fileSize = buffer.size();
+  m_tail = tail;
+  m_index = std::move(index);
+  m_staleBytes = 0;
+}
+
+} // namespace ndncert::ca
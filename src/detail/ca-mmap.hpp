@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_CA_MMAP_HPP
+#define NDNCERT_DETAIL_CA_MMAP_HPP
+
+#include "detail/ca-storage.hpp"
+
+#include <shared_mutex>
+
+namespace ndncert::ca {
+
+/**
+ * @brief CaStorage kept in a memory-mapped, log-structured file.
+ *
+ * Every change appends a record holding the encoded request (see encodeRequestState()) or a
+ * deletion marker; an in-memory index maps each request ID to its latest record. Requests are
+ * decoded straight from the mapping, without any SQL layer or read() call. Writers are serialized,
+ * while readers proceed concurrently. The file is compacted once stale records outweigh live ones.
+ *
+ * The file uses the byte order of the host and is not meant to be moved across architectures.
+ *
+ * Recognized locator options (see CaStorage::parseLocator):
+ *   sync: "1" to msync() every change before returning (default "0")
+ */
+class CaMmap : public CaStorage
+{
+public:
+  static const std::string STORAGE_TYPE;
+
+  explicit
+  CaMmap(const Name& caName, const std::string& path = "");
+
+  ~CaMmap() override;
+
+public:
+  RequestState
+  getRequest(const RequestId& requestId) override;
+
+  void
+  addRequest(const RequestState& request) override;
+
+  void
+  updateRequest(const RequestState& request) override;
+
+  void
+  deleteRequest(const RequestId& requestId) override;
+
+  std::list<RequestState>
+  listAllRequests() override;
+
+  std::list<RequestState>
+  listAllRequests(const Name& caName) override;
+
+  size_t
+  forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor) override;
+
+  bool
+  isThreadSafe() const override
+  {
+    return true;
+  }
+
+public:
+  struct Statistics
+  {
+    size_t nRequests = 0;
+    uint64_t fileSize = 0;
+    /**
+     * @brief Bytes used by the header and all records, including stale ones.
+     */
+    uint64_t usedBytes = 0;
+    /**
+     * @brief Bytes used by records that were superseded or deleted.
+     */
+    uint64_t staleBytes = 0;
+  };
+
+  Statistics
+  getStatistics() const;
+
+  /**
+   * @brief Rewrite the file with the live records only.
+   */
+  void
+  compact();
+
+private:
+  struct Location
+  {
+    uint64_t offset;
+    uint32_t size;
+  };
+
+  void
+  open();
+
+  void
+  close();
+
+  void
+  replay();
+
+  RequestState
+  readRequest(const Location& location) const;
+
+  void
+  appendRecord(uint8_t kind, const RequestId& requestId, const Block* wire);
+
+  void
+  reserve(uint64_t size);
+
+  void
+  compactLocked();
+
+private:
+  std::string m_path;
+  bool m_isSync = false;
+  int m_fd = -1;
+  uint8_t* m_data = nullptr;
+  uint64_t m_fileSize = 0;
+  uint64_t m_tail = 0;
+  uint64_t m_staleBytes = 0;
+  std::map<RequestId, Location> m_index;
+  mutable std::shared_mutex m_mutex;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_CA_MMAP_HPP
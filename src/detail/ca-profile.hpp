@@ -39,6 +39,23 @@ const std::string CONFIG_REDIRECTION = "redirect-to";
 const std::string CONFIG_NAME_ASSIGNMENT = "name-assignment";
 const std::string CONFIG_REDIRECTION_POLICY_TYPE = "policy-type";
 const std::string CONFIG_REDIRECTION_POLICY_PARAM = "policy-param";
+const std::string CONFIG_STATELESS = "stateless";
+const std::string CONFIG_STATELESS_SECRET = "secret";
+const std::string CONFIG_STATELESS_KEY_LIFETIME = "key-lifetime";
+const std::string CONFIG_STATELESS_TOKEN_LIFETIME = "token-lifetime";
+const std::string CONFIG_ADMISSION_CONTROL = "admission-control";
+const std::string CONFIG_ADMISSION_ENDPOINTS = "endpoints";
+const std::string CONFIG_ADMISSION_TOTAL = "total";
+const std::string CONFIG_ADMISSION_CHALLENGE_RESERVE = "challenge-reserve";
+const std::string CONFIG_ADMISSION_PER_KEY_LOCATOR = "per-key-locator";
+const std::string CONFIG_ADMISSION_MAX_KEY_LOCATORS = "max-key-locators";
+const std::string CONFIG_ADMISSION_NEW_SHED_LOAD = "new-shed-load";
+const std::string CONFIG_ADMISSION_SHED_ACTION = "shed-action";
+const std::string CONFIG_ADMISSION_RATE = "rate";
+const std::string CONFIG_ADMISSION_BURST = "burst";
+const std::string CONFIG_INLINE_CERT_MAX_SIZE = "inline-cert-max-size";
+const std::string CONFIG_CERT_STORE_PATH = "cert-store-path";
+const std::string CONFIG_REVOCATION_REGISTRY_PATH = "revocation-registry-path";
 
 class CaProfile
 {
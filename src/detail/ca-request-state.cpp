@@ -55,6 +55,18 @@ statusFromBlock(const Block& block)
 
 namespace ca {
 
+// TLV types of the stored request encoding, in addition to those of the protocol
+enum : uint32_t {
+  StoredRequestState = 201,
+  StoredRequestType = 203,
+  StoredEncryptionKey = 205,
+  StoredEncryptionIv = 207,
+  StoredDecryptionIv = 209,
+  StoredChallengeTimestamp = 211,
+  StoredChallengeSecrets = 213,
+  StoredChallengeBinarySecret = 215,
+};
+
 ChallengeState::ChallengeState(const std::string& challengeStatus,
                                const time::system_clock::TimePoint& challengeTp,
                                size_t remainingTries, time::seconds remainingTime,
@@ -67,6 +79,13 @@ ChallengeState::ChallengeState(const std::string& challengeStatus,
 {
 }
 
+bool
+isCertificateIssued(const RequestState& request)
+{
+  return request.status == Status::SUCCESS &&
+         (request.requestType == RequestType::NEW || request.requestType == RequestType::RENEW);
+}
+
 std::ostream&
 operator<<(std::ostream& os, const RequestState& request)
 {
@@ -89,5 +108,95 @@ operator<<(std::ostream& os, const RequestState& request)
   return os;
 }
 
+Block
+encodeRequestState(const RequestState& request)
+{
+  Block block(StoredRequestState);
+  block.push_back(ndn::makeBinaryBlock(tlv::RequestId, request.requestId));
+  block.push_back(request.caPrefix.wireEncode());
+  block.push_back(ndn::makeNonNegativeIntegerBlock(StoredRequestType, static_cast<uint64_t>(request.requestType)));
+  block.push_back(ndn::makeNonNegativeIntegerBlock(tlv::Status, static_cast<uint64_t>(request.status)));
+  if (request.cert.hasWire()) {
+    block.push_back(request.cert.wireEncode());
+  }
+  block.push_back(ndn::makeBinaryBlock(StoredEncryptionKey, request.encryptionKey));
+  block.push_back(ndn::makeBinaryBlock(StoredEncryptionIv, request.encryptionIv));
+  block.push_back(ndn::makeBinaryBlock(StoredDecryptionIv, request.decryptionIv));
+  if (!request.challengeType.empty()) {
+    block.push_back(ndn::makeStringBlock(tlv::SelectedChallenge, request.challengeType));
+  }
+  if (request.challengeState) {
+    const auto& state = *request.challengeState;
+    block.push_back(ndn::makeStringBlock(tlv::ChallengeStatus, state.challengeStatus));
+    block.push_back(ndn::makeNonNegativeIntegerBlock(StoredChallengeTimestamp,
+                                                     time::toUnixTimestamp(state.timestamp).count()));
+    block.push_back(ndn::makeNonNegativeIntegerBlock(tlv::RemainingTries, state.remainingTries));
+    block.push_back(ndn::makeNonNegativeIntegerBlock(tlv::RemainingTime, state.remainingTime.count()));
+    std::stringstream ss;
+    boost::property_tree::write_json(ss, state.secrets, false);
+    block.push_back(ndn::makeStringBlock(StoredChallengeSecrets, ss.str()));
+    if (state.binarySecret.isValid()) {
+      block.push_back(Block(StoredChallengeBinarySecret, state.binarySecret));
+    }
+  }
+  block.encode();
+  return block;
+}
+
+RequestState
+decodeRequestState(const Block& block)
+{
+  if (block.type() != StoredRequestState) {
+    NDN_THROW(std::runtime_error("Unexpected TLV type when decoding a stored request"));
+  }
+  block.parse();
+
+  // malformed elements raise ndn::tlv::Error or ptree errors, which are runtime errors as well
+  RequestState request;
+  auto requestId = block.get(tlv::RequestId);
+  if (requestId.value_size() != request.requestId.size()) {
+    NDN_THROW(std::runtime_error("Stored request ID has a wrong length"));
+  }
+  std::memcpy(request.requestId.data(), requestId.value(), requestId.value_size());
+  request.caPrefix = Name(block.get(ndn::tlv::Name));
+  request.requestType = static_cast<RequestType>(readNonNegativeInteger(block.get(StoredRequestType)));
+  request.status = static_cast<Status>(readNonNegativeInteger(block.get(tlv::Status)));
+  auto cert = block.find(ndn::tlv::Data);
+  if (cert != block.elements_end()) {
+    request.cert = Certificate(*cert);
+  }
+  auto key = block.get(StoredEncryptionKey);
+  if (key.value_size() != request.encryptionKey.size()) {
+    NDN_THROW(std::runtime_error("Stored encryption key has a wrong length"));
+  }
+  std::memcpy(request.encryptionKey.data(), key.value(), key.value_size());
+  auto encryptionIv = block.get(StoredEncryptionIv);
+  request.encryptionIv.assign(encryptionIv.value_begin(), encryptionIv.value_end());
+  auto decryptionIv = block.get(StoredDecryptionIv);
+  request.decryptionIv.assign(decryptionIv.value_begin(), decryptionIv.value_end());
+
+  auto challengeType = block.find(tlv::SelectedChallenge);
+  if (challengeType != block.elements_end()) {
+    request.challengeType = readString(*challengeType);
+  }
+  auto challengeStatus = block.find(tlv::ChallengeStatus);
+  if (challengeStatus != block.elements_end()) {
+    std::istringstream ss(readString(block.get(StoredChallengeSecrets)));
+    JsonSection secrets;
+    boost::property_tree::read_json(ss, secrets);
+    auto timestamp = time::fromUnixTimestamp(
+      time::milliseconds(readNonNegativeInteger(block.get(StoredChallengeTimestamp))));
+    request.challengeState = ChallengeState(readString(*challengeStatus), timestamp,
+                                            readNonNegativeInteger(block.get(tlv::RemainingTries)),
+                                            time::seconds(readNonNegativeInteger(block.get(tlv::RemainingTime))),
+                                            std::move(secrets));
+    auto binarySecret = block.find(StoredChallengeBinarySecret);
+    if (binarySecret != block.elements_end()) {
+      request.challengeState->binarySecret = binarySecret->blockFromValue();
+    }
+  }
+  return request;
+}
+
 } // namespace ca
 } // namespace ndncert
@@ -79,6 +79,10 @@ struct ChallengeState
    * @brief The secret for the challenge.
    */
   JsonSection secrets;
+  /**
+   * @brief The binary secret for the challenge, such as a credential, if any.
+   */
+  Block binarySecret;
 };
 
 /**
@@ -133,6 +137,27 @@ struct RequestState
 std::ostream&
 operator<<(std::ostream& os, const RequestState& request);
 
+/**
+ * @brief Whether @p request has completed by issuing RequestState::cert, through NEW or RENEW.
+ */
+bool
+isCertificateIssued(const RequestState& request);
+
+/**
+ * @brief Encode a request into a self-contained TLV block, for storage backends that keep
+ *        requests as opaque records.
+ *
+ * The encoding is internal to the CA and not part of the NDNCERT protocol.
+ */
+Block
+encodeRequestState(const RequestState& request);
+
+/**
+ * @throw std::runtime_error The block is not a valid encoding of a request.
+ */
+RequestState
+decodeRequestState(const Block& block);
+
 } // namespace ca
 } // namespace ndncert
 
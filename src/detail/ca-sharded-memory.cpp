@@ -0,0 +1,406 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/ca-sharded-memory.hpp"
+
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace ndncert::ca {
+
+const std::string CaShardedMemory::STORAGE_TYPE = "ca-storage-sharded-memory";
+NDNCERT_REGISTER_CA_STORAGE(CaShardedMemory);
+
+const size_t DEFAULT_SHARD_COUNT = 16;
+const size_t MAX_SHARD_COUNT = 1 << 16;
+const size_t INITIAL_SHARD_SLOTS = 16;
+
+static uint64_t
+toKey(const RequestId& requestId)
+{
+  uint64_t key = 0;
+  std::memcpy(&key, requestId.data(), sizeof(key));
+  return key;
+}
+
+// the finalizer of splitmix64, so that the shard and slot bits are well distributed
+// even when request IDs are not uniformly random
+static uint64_t
+mix(uint64_t key)
+{
+  key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+  return key ^ (key >> 31);
+}
+
+static size_t
+estimateJsonSize(const JsonSection& json)
+{
+  size_t size = sizeof(JsonSection) + json.data().size();
+  for (const auto& [key, child] : json) {
+    size += key.size() + estimateJsonSize(child);
+  }
+  return size;
+}
+
+static size_t
+estimatePayloadSize(const RequestState& request)
+{
+  size_t size = request.caPrefix.size() * sizeof(ndn::name::Component) +
+                request.encryptionIv.size() + request.decryptionIv.size() +
+                request.challengeType.size();
+  if (request.cert.hasWire()) {
+    // the decoded certificate keeps its wire encoding, plus the name and signature info elements
+    size += 2 * request.cert.wireEncode().size();
+  }
+  if (request.challengeState) {
+    size += request.challengeState->challengeStatus.size() + estimateJsonSize(request.challengeState->secrets);
+    if (request.challengeState->binarySecret.isValid()) {
+      size += request.challengeState->binarySecret.size();
+    }
+  }
+  return size;
+}
+
+CaShardedMemory::CaShardedMemory(const Name&, const std::string& path)
+  : CaStorage()
+{
+  auto options = parseLocator(path).second;
+  size_t nShards = DEFAULT_SHARD_COUNT;
+  size_t capacity = 0;
+  try {
+    if (options.count("shards") != 0) {
+      nShards = boost::lexical_cast<size_t>(options["shards"]);
+    }
+    if (options.count("capacity") != 0) {
+      capacity = boost::lexical_cast<size_t>(options["capacity"]);
+    }
+  }
+  catch (const boost::bad_lexical_cast&) {
+    NDN_THROW(std::runtime_error("Invalid option for " + STORAGE_TYPE + ": " + path));
+  }
+
+  m_nShards = 1;
+  while (m_nShards < std::min(nShards, MAX_SHARD_COUNT)) {
+    m_nShards <<= 1;
+  }
+  m_shardMask = m_nShards - 1;
+  m_shards = std::make_unique<Shard[]>(m_nShards);
+  m_capacity = capacity;
+}
+
+CaShardedMemory::CaShardedMemory(size_t nShards, size_t capacity)
+  : CaShardedMemory(Name(), "?shards=" + std::to_string(nShards) + "&capacity=" + std::to_string(capacity))
+{
+}
+
+RequestState
+CaShardedMemory::getRequest(const RequestId& requestId)
+{
+  auto key = toKey(requestId);
+  auto hash = mix(key);
+  auto& shard = getShard(hash);
+  std::shared_lock lock(shard.mutex);
+  auto request = shard.find(key, hash);
+  if (request == nullptr) {
+    NDN_THROW(std::runtime_error("Request " + ndn::toHex(requestId) + " does not exist"));
+  }
+  return *request;
+}
+
+void
+CaShardedMemory::addRequest(const RequestState& request)
+{
+  if (!reserveSlot()) {
+    NDN_THROW(std::runtime_error("Request " + ndn::toHex(request.requestId) +
+                                 " cannot be added: storage capacity reached"));
+  }
+  auto key = toKey(request.requestId);
+  auto hash = mix(key);
+  auto& shard = getShard(hash);
+  bool isNew = false;
+  {
+    std::unique_lock lock(shard.mutex);
+    shard.insert(key, hash, request, false, isNew);
+  }
+  if (!isNew) {
+    releaseSlot();
+    NDN_THROW(std::runtime_error("Request " + ndn::toHex(request.requestId) + " already exists"));
+  }
+}
+
+void
+CaShardedMemory::updateRequest(const RequestState& request)
+{
+  auto key = toKey(request.requestId);
+  auto hash = mix(key);
+  auto& shard = getShard(hash);
+  std::unique_lock lock(shard.mutex);
+  if (shard.find(key, hash) == nullptr && !reserveSlot()) {
+    NDN_THROW(std::runtime_error("Request " + ndn::toHex(request.requestId) +
+                                 " cannot be added: storage capacity reached"));
+  }
+  bool isNew = false;
+  shard.insert(key, hash, request, true, isNew);
+}
+
+void
+CaShardedMemory::deleteRequest(const RequestId& requestId)
+{
+  auto key = toKey(requestId);
+  auto hash = mix(key);
+  auto& shard = getShard(hash);
+  bool isErased = false;
+  {
+    std::unique_lock lock(shard.mutex);
+    isErased = shard.erase(key, hash);
+  }
+  if (isErased) {
+    releaseSlot();
+  }
+}
+
+std::list<RequestState>
+CaShardedMemory::listAllRequests()
+{
+  std::list<RequestState> result;
+  for (size_t i = 0; i < m_nShards; i++) {
+    std::shared_lock lock(m_shards[i].mutex);
+    m_shards[i].forEach([&result] (const RequestState& request) { result.push_back(request); });
+  }
+  return result;
+}
+
+std::list<RequestState>
+CaShardedMemory::listAllRequests(const Name& caName)
+{
+  std::list<RequestState> result;
+  for (size_t i = 0; i < m_nShards; i++) {
+    std::shared_lock lock(m_shards[i].mutex);
+    m_shards[i].forEach([&] (const RequestState& request) {
+      if (request.caPrefix == caName) {
+        result.push_back(request);
+      }
+    });
+  }
+  return result;
+}
+
+size_t
+CaShardedMemory::forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor)
+{
+  // collect the matching IDs first, so that requests are visited in order and without
+  // holding any lock while the visitor runs
+  std::vector<RequestId> matches;
+  for (size_t i = 0; i < m_nShards; i++) {
+    std::shared_lock lock(m_shards[i].mutex);
+    m_shards[i].forEach([&] (const RequestState& request) {
+      if (filter.matches(summarizeRequest(request))) {
+        matches.push_back(request.requestId);
+      }
+    });
+  }
+  std::sort(matches.begin(), matches.end());
+
+  size_t nVisited = 0;
+  for (const auto& requestId : matches) {
+    if (filter.limit != 0 && nVisited >= filter.limit) {
+      break;
+    }
+    auto key = toKey(requestId);
+    auto hash = mix(key);
+    auto& shard = getShard(hash);
+    std::optional<RequestState> request;
+    {
+      std::shared_lock lock(shard.mutex);
+      auto found = shard.find(key, hash);
+      if (found != nullptr) {
+        request = *found;
+      }
+    }
+    if (!request) {
+      // deleted in the meantime
+      continue;
+    }
+    nVisited++;
+    if (!visitor(*request)) {
+      break;
+    }
+  }
+  return nVisited;
+}
+
+size_t
+CaShardedMemory::countRequests(const RequestFilter& filter)
+{
+  RequestFilter unpaginated = filter;
+  unpaginated.startAfter = std::nullopt;
+  size_t count = 0;
+  for (size_t i = 0; i < m_nShards; i++) {
+    std::shared_lock lock(m_shards[i].mutex);
+    m_shards[i].forEach([&] (const RequestState& request) {
+      if (unpaginated.matches(summarizeRequest(request))) {
+        count++;
+      }
+    });
+  }
+  return count;
+}
+
+CaShardedMemory::MemoryUsage
+CaShardedMemory::getMemoryUsage() const
+{
+  MemoryUsage usage;
+  usage.tableBytes = sizeof(Shard) * m_nShards;
+  for (size_t i = 0; i < m_nShards; i++) {
+    std::shared_lock lock(m_shards[i].mutex);
+    m_shards[i].forEach([&usage] (const RequestState&) { usage.nRequests++; });
+    usage.tableBytes += m_shards[i].getSlotCount() *
+                        (sizeof(uint64_t) + sizeof(uint8_t) + sizeof(std::optional<RequestState>));
+    usage.payloadBytes += m_shards[i].payloadBytes;
+  }
+  return usage;
+}
+
+bool
+CaShardedMemory::reserveSlot()
+{
+  auto previous = m_nRequests.fetch_add(1);
+  if (m_capacity != 0 && previous >= m_capacity) {
+    m_nRequests--;
+    return false;
+  }
+  return true;
+}
+
+void
+CaShardedMemory::releaseSlot()
+{
+  m_nRequests--;
+}
+
+const RequestState*
+CaShardedMemory::Shard::find(uint64_t key, uint64_t hash) const
+{
+  auto slot = findSlot(key, hash);
+  return slot < m_used.size() && m_used[slot] ? &*m_values[slot] : nullptr;
+}
+
+bool
+CaShardedMemory::Shard::insert(uint64_t key, uint64_t hash, const RequestState& request,
+                               bool overwrite, bool& isNew)
+{
+  if ((m_size + 1) * 10 > m_keys.size() * 7) {
+    grow();
+  }
+  auto slot = findSlot(key, hash);
+  isNew = !m_used[slot];
+  if (!isNew) {
+    if (!overwrite) {
+      return false;
+    }
+    payloadBytes -= estimatePayloadSize(*m_values[slot]);
+  }
+  else {
+    m_used[slot] = 1;
+    m_keys[slot] = key;
+    m_size++;
+  }
+  m_values[slot] = request;
+  payloadBytes += estimatePayloadSize(request);
+  return true;
+}
+
+bool
+CaShardedMemory::Shard::erase(uint64_t key, uint64_t hash)
+{
+  auto slot = findSlot(key, hash);
+  if (slot >= m_used.size() || !m_used[slot]) {
+    return false;
+  }
+  payloadBytes -= estimatePayloadSize(*m_values[slot]);
+  m_size--;
+
+  // backward-shift deletion: pull later entries of the probe sequence into the hole,
+  // so that lookups never need tombstones
+  size_t mask = m_keys.size() - 1;
+  size_t hole = slot;
+  size_t next = slot;
+  while (true) {
+    next = (next + 1) & mask;
+    if (!m_used[next]) {
+      break;
+    }
+    size_t home = mix(m_keys[next]) & mask;
+    bool isReachable = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+    if (isReachable) {
+      // the entry's home lies between the hole and its position, so it must stay
+      continue;
+    }
+    m_keys[hole] = m_keys[next];
+    m_values[hole] = std::move(m_values[next]);
+    hole = next;
+  }
+  m_used[hole] = 0;
+  m_values[hole].reset();
+  return true;
+}
+
+size_t
+CaShardedMemory::Shard::findSlot(uint64_t key, uint64_t hash) const
+{
+  if (m_keys.empty()) {
+    return 0;
+  }
+  size_t mask = m_keys.size() - 1;
+  for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+    if (!m_used[slot] || m_keys[slot] == key) {
+      return slot;
+    }
+  }
+}
+
+void
+CaShardedMemory::Shard::grow()
+{
+  std::vector<uint64_t> keys(std::max(m_keys.size() * 2, INITIAL_SHARD_SLOTS));
+  std::vector<uint8_t> used(keys.size(), 0);
+  std::vector<std::optional<RequestState>> values(keys.size());
+  size_t mask = keys.size() - 1;
+  for (size_t i = 0; i < m_keys.size(); i++) {
+    if (!m_used[i]) {
+      continue;
+    }
+    size_t slot = mix(m_keys[i]) & mask;
+    while (used[slot]) {
+      slot = (slot + 1) & mask;
+    }
+    keys[slot] = m_keys[i];
+    used[slot] = 1;
+    values[slot] = std::move(m_values[i]);
+  }
+  m_keys = std::move(keys);
+  m_used = std::move(used);
+  m_values = std::move(values);
+}
+
+} // namespace ndncert::ca
@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_CA_SHARDED_MEMORY_HPP
+#define NDNCERT_DETAIL_CA_SHARDED_MEMORY_HPP
+
+#include "detail/ca-storage.hpp"
+
+#include <atomic>
+#include <shared_mutex>
+
+namespace ndncert::ca {
+
+/**
+ * @brief In-memory CaStorage that can be shared by several threads.
+ *
+ * Requests are kept in open-addressing hash tables keyed by the 64-bit request ID. The key
+ * space is split into shards, each guarded by its own reader-writer lock, so that lookups
+ * proceed in parallel and writers only contend within a shard.
+ *
+ * Recognized locator options (see CaStorage::parseLocator):
+ *   shards:   number of shards, rounded up to a power of two (default 16)
+ *   capacity: maximum number of requests, zero meaning unlimited (default 0)
+ */
+class CaShardedMemory : public CaStorage
+{
+public:
+  static const std::string STORAGE_TYPE;
+
+  explicit
+  CaShardedMemory(const Name& caName = "", const std::string& path = "");
+
+  CaShardedMemory(size_t nShards, size_t capacity);
+
+public:
+  RequestState
+  getRequest(const RequestId& requestId) override;
+
+  /**
+   * @throw std::runtime_error There is an existing request with the same request ID,
+   *                           or the storage is full.
+   */
+  void
+  addRequest(const RequestState& request) override;
+
+  /**
+   * @throw std::runtime_error The request does not exist yet and the storage is full.
+   */
+  void
+  updateRequest(const RequestState& request) override;
+
+  void
+  deleteRequest(const RequestId& requestId) override;
+
+  std::list<RequestState>
+  listAllRequests() override;
+
+  std::list<RequestState>
+  listAllRequests(const Name& caName) override;
+
+  size_t
+  forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor) override;
+
+  size_t
+  countRequests(const RequestFilter& filter) override;
+
+  bool
+  isThreadSafe() const override
+  {
+    return true;
+  }
+
+public:
+  struct MemoryUsage
+  {
+    /**
+     * @brief Number of requests stored.
+     */
+    size_t nRequests = 0;
+    /**
+     * @brief Bytes allocated for the hash table slots.
+     */
+    size_t tableBytes = 0;
+    /**
+     * @brief Estimated bytes held by the requests outside of the slots.
+     */
+    size_t payloadBytes = 0;
+  };
+
+  MemoryUsage
+  getMemoryUsage() const;
+
+  size_t
+  size() const
+  {
+    return m_nRequests;
+  }
+
+  size_t
+  getCapacity() const
+  {
+    return m_capacity;
+  }
+
+private:
+  class Shard
+  {
+  public:
+    const RequestState*
+    find(uint64_t key, uint64_t hash) const;
+
+    /**
+     * @return false if @p key is present and @p overwrite is false.
+     */
+    bool
+    insert(uint64_t key, uint64_t hash, const RequestState& request, bool overwrite, bool& isNew);
+
+    bool
+    erase(uint64_t key, uint64_t hash);
+
+    template<typename Visitor>
+    void
+    forEach(const Visitor& visitor) const
+    {
+      for (size_t i = 0; i < m_used.size(); i++) {
+        if (m_used[i]) {
+          visitor(*m_values[i]);
+        }
+      }
+    }
+
+    size_t
+    getSlotCount() const
+    {
+      return m_keys.size();
+    }
+
+  private:
+    size_t
+    findSlot(uint64_t key, uint64_t hash) const;
+
+    void
+    grow();
+
+  public:
+    mutable std::shared_mutex mutex;
+    size_t payloadBytes = 0;
+
+  private:
+    // parallel arrays, so that probing only touches the keys and occupancy flags
+    std::vector<uint64_t> m_keys;
+    std::vector<uint8_t> m_used;
+    std::vector<std::optional<RequestState>> m_values;
+    size_t m_size = 0;
+  };
+
+  Shard&
+  getShard(uint64_t hash) const
+  {
+    // the low bits of the hash select the slot within the shard
+    return m_shards[(hash >> 48) & m_shardMask];
+  }
+
+  bool
+  reserveSlot();
+
+  void
+  releaseSlot();
+
+private:
+  std::unique_ptr<Shard[]> m_shards;
+  size_t m_nShards = 0;
+  size_t m_shardMask = 0;
+  size_t m_capacity = 0;
+  std::atomic<size_t> m_nRequests{0};
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_CA_SHARDED_MEMORY_HPP
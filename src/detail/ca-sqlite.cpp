@@ -69,19 +69,139 @@ CREATE TABLE IF NOT EXISTS
     challenge_secrets TEXT,
     encryption_key BLOB NOT NULL,
     encryption_iv BLOB,
-    decryption_iv BLOB
+    decryption_iv BLOB,
+    challenge_binary_secret BLOB
   );
 CREATE UNIQUE INDEX IF NOT EXISTS
   RequestStateIdIndex ON RequestStates(request_id);
+CREATE INDEX IF NOT EXISTS
+  RequestStateCaNameIndex ON RequestStates(ca_name, request_id);
+CREATE INDEX IF NOT EXISTS
+  RequestStateStatusIndex ON RequestStates(status, request_type);
 )SQL";
 
+// columns decoded by decodeRequestState(), in order
+const std::string REQUEST_STATE_COLUMNS = R"SQL(request_id, ca_name, status, challenge_status,
+  cert_request, challenge_type, challenge_secrets, challenge_tp, remaining_tries, remaining_time,
+  request_type, encryption_key, encryption_iv, decryption_iv, challenge_binary_secret)SQL";
+
+// columns decoded by decodeRequestSummary(), in order
+const std::string REQUEST_SUMMARY_COLUMNS = R"SQL(request_id, ca_name, status, challenge_status,
+  challenge_type, challenge_tp, request_type)SQL";
+
+static RequestState
+decodeRequestState(Sqlite3Statement& statement)
+{
+  RequestState state;
+  std::memcpy(state.requestId.data(), statement.getBlob(0), statement.getSize(0));
+  state.caPrefix = Name(statement.getBlock(1));
+  state.status = static_cast<Status>(statement.getInt(2));
+  state.cert = Certificate(statement.getBlock(4));
+  state.challengeType = statement.getString(5);
+  state.requestType = static_cast<RequestType>(statement.getInt(10));
+  std::memcpy(state.encryptionKey.data(), statement.getBlob(11), statement.getSize(11));
+  state.encryptionIv = std::vector<uint8_t>(statement.getBlob(12), statement.getBlob(12) + statement.getSize(12));
+  state.decryptionIv = std::vector<uint8_t>(statement.getBlob(13), statement.getBlob(13) + statement.getSize(13));
+  if (!state.challengeType.empty()) {
+    ChallengeState challengeState(statement.getString(3), time::fromIsoString(statement.getString(7)),
+                                  statement.getInt(8), time::seconds(statement.getInt(9)),
+                                  convertString2Json(statement.getString(6)));
+    if (statement.getSize(14) > 0) {
+      challengeState.binarySecret = statement.getBlock(14);
+    }
+    state.challengeState = challengeState;
+  }
+  return state;
+}
+
+static RequestSummary
+decodeRequestSummary(Sqlite3Statement& statement)
+{
+  RequestSummary summary;
+  std::memcpy(summary.requestId.data(), statement.getBlob(0), statement.getSize(0));
+  summary.caPrefix = Name(statement.getBlock(1));
+  summary.status = static_cast<Status>(statement.getInt(2));
+  summary.challengeType = statement.getString(4);
+  summary.requestType = static_cast<RequestType>(statement.getInt(6));
+  summary.challengeStatus = statement.getString(3);
+  auto timestamp = statement.getString(5);
+  if (!summary.challengeType.empty() && !timestamp.empty()) {
+    summary.challengeTimestamp = time::fromIsoString(timestamp);
+  }
+  return summary;
+}
+
+/**
+ * @brief Translate @p filter into a WHERE clause whose parameters are bound by bindFilter().
+ */
+static std::string
+makeFilterClause(const RequestFilter& filter, bool withPagination)
+{
+  std::string clause = " WHERE 1";
+  if (filter.caPrefix) {
+    clause += " AND ca_name = ?";
+  }
+  if (filter.status) {
+    clause += " AND status = ?";
+  }
+  if (filter.requestType) {
+    clause += " AND request_type = ?";
+  }
+  if (filter.challengeType) {
+    clause += " AND challenge_type = ?";
+  }
+  if (filter.updatedBefore) {
+    clause += " AND challenge_type <> '' AND challenge_tp < ?";
+  }
+  if (withPagination) {
+    if (filter.startAfter) {
+      clause += " AND request_id > ?";
+    }
+    clause += " ORDER BY request_id";
+    if (filter.limit != 0) {
+      clause += " LIMIT ?";
+    }
+  }
+  return clause;
+}
+
+static void
+bindFilter(Sqlite3Statement& statement, const RequestFilter& filter, bool withPagination)
+{
+  int index = 1;
+  if (filter.caPrefix) {
+    statement.bind(index++, filter.caPrefix->wireEncode(), SQLITE_TRANSIENT);
+  }
+  if (filter.status) {
+    statement.bind(index++, static_cast<int>(*filter.status));
+  }
+  if (filter.requestType) {
+    statement.bind(index++, static_cast<int>(*filter.requestType));
+  }
+  if (filter.challengeType) {
+    statement.bind(index++, *filter.challengeType, SQLITE_TRANSIENT);
+  }
+  if (filter.updatedBefore) {
+    statement.bind(index++, time::toIsoString(*filter.updatedBefore), SQLITE_TRANSIENT);
+  }
+  if (withPagination) {
+    if (filter.startAfter) {
+      statement.bind(index++, filter.startAfter->data(), filter.startAfter->size(), SQLITE_TRANSIENT);
+    }
+    if (filter.limit != 0) {
+      sqlite3_bind_int64(statement, index++, static_cast<sqlite3_int64>(filter.limit));
+    }
+  }
+}
+
 CaSqlite::CaSqlite(const Name& caName, const std::string& path)
   : CaStorage()
 {
   // Determine the path of sqlite db
   boost::filesystem::path dbDir;
-  if (!path.empty()) {
-    dbDir = boost::filesystem::path(path);
+  auto location = parseLocator(path).first;
+  if (!location.empty()) {
+    dbDir = boost::filesystem::path(location);
   }
   else {
     std::string dbName = caName.toUri();
@@ -117,6 +237,9 @@ CaSqlite::CaSqlite(const Name& caName, const std::string& path)
     sqlite3_free(errorMessage);
     NDN_THROW(std::runtime_error("CaSqlite DB cannot be initialized"));
   }
+  // databases created by earlier versions lack the binary secret, the error is that the column exists
+  sqlite3_exec(m_database, "ALTER TABLE RequestStates ADD COLUMN challenge_binary_secret BLOB",
+               nullptr, nullptr, nullptr);
 }
 
 CaSqlite::~CaSqlite()
@@ -127,33 +250,12 @@ CaSqlite::~CaSqlite()
 RequestState
 CaSqlite::getRequest(const RequestId& requestId)
 {
-  Sqlite3Statement statement(m_database,
-                             R"_SQLTEXT_(SELECT id, ca_name, status,
-                             challenge_status, cert_request,
-                             challenge_type, challenge_secrets,
-                             challenge_tp, remaining_tries, remaining_time,
-                             request_type, encryption_key, encryption_iv, decryption_iv
-                             FROM RequestStates where request_id = ?)_SQLTEXT_");
+  Sqlite3Statement statement(m_database, "SELECT " + REQUEST_STATE_COLUMNS +
+                                         " FROM RequestStates WHERE request_id = ?");
   statement.bind(1, requestId.data(), requestId.size(), SQLITE_TRANSIENT);
 
   if (statement.step() == SQLITE_ROW) {
-    RequestState state;
-    state.requestId = requestId;
-    state.caPrefix = Name(statement.getBlock(1));
-    state.status = static_cast<Status>(statement.getInt(2));
-    state.cert = Certificate(statement.getBlock(4));
-    state.challengeType = statement.getString(5);
-    state.requestType = static_cast<RequestType>(statement.getInt(10));
-    std::memcpy(state.encryptionKey.data(), statement.getBlob(11), statement.getSize(11));
-    state.encryptionIv = std::vector<uint8_t>(statement.getBlob(12), statement.getBlob(12) + statement.getSize(12));
-    state.decryptionIv = std::vector<uint8_t>(statement.getBlob(13), statement.getBlob(13) + statement.getSize(13));
-    if (!state.challengeType.empty()) {
-      ChallengeState challengeState(statement.getString(3), time::fromIsoString(statement.getString(7)),
-                                    statement.getInt(8), time::seconds(statement.getInt(9)),
-                                    convertString2Json(statement.getString(6)));
-      state.challengeState = challengeState;
-    }
-    return state;
+    return decodeRequestState(statement);
   }
   else {
     NDN_THROW(std::runtime_error("Request " + ndn::toHex(requestId) + " cannot be fetched from database"));
@@ -167,8 +269,9 @@ CaSqlite::addRequest(const RequestState& request)
       m_database,
       R"_SQLTEXT_(INSERT OR ABORT INTO RequestStates (request_id, ca_name, status, request_type,
                   cert_request, challenge_type, challenge_status, challenge_secrets,
-                  challenge_tp, remaining_tries, remaining_time, encryption_key, encryption_iv, decryption_iv)
-                  values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?))_SQLTEXT_");
+                  challenge_tp, remaining_tries, remaining_time, encryption_key, encryption_iv, decryption_iv,
+                  challenge_binary_secret)
+                  values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?))_SQLTEXT_");
   statement.bind(1, request.requestId.data(), request.requestId.size(), SQLITE_TRANSIENT);
   statement.bind(2, request.caPrefix.wireEncode(), SQLITE_TRANSIENT);
   statement.bind(3, static_cast<int>(request.status));
@@ -184,6 +287,9 @@ CaSqlite::addRequest(const RequestState& request)
     statement.bind(9, time::toIsoString(request.challengeState->timestamp), SQLITE_TRANSIENT);
     statement.bind(10, request.challengeState->remainingTries);
     statement.bind(11, request.challengeState->remainingTime.count());
+    if (request.challengeState->binarySecret.isValid()) {
+      statement.bind(15, request.challengeState->binarySecret, SQLITE_TRANSIENT);
+    }
   }
   if (statement.step() != SQLITE_DONE) {
     NDN_THROW(std::runtime_error("Request " + ndn::toHex(request.requestId) +
@@ -197,7 +303,8 @@ CaSqlite::updateRequest(const RequestState& request)
   Sqlite3Statement statement(m_database,
                              R"_SQLTEXT_(UPDATE RequestStates
                              SET status = ?, challenge_type = ?, challenge_status = ?, challenge_secrets = ?,
-                             challenge_tp = ?, remaining_tries = ?, remaining_time = ?, encryption_iv = ?, decryption_iv = ?
+                             challenge_tp = ?, remaining_tries = ?, remaining_time = ?, encryption_iv = ?, decryption_iv = ?,
+                             challenge_binary_secret = ?
                              WHERE request_id = ?)_SQLTEXT_");
   statement.bind(1, static_cast<int>(request.status));
   statement.bind(2, request.challengeType, SQLITE_TRANSIENT);
@@ -217,7 +324,13 @@ CaSqlite::updateRequest(const RequestState& request)
   }
   statement.bind(8, request.encryptionIv.data(), request.encryptionIv.size(), SQLITE_TRANSIENT);
   statement.bind(9, request.decryptionIv.data(), request.decryptionIv.size(), SQLITE_TRANSIENT);
-  statement.bind(10, request.requestId.data(), request.requestId.size(), SQLITE_TRANSIENT);
+  if (request.challengeState && request.challengeState->binarySecret.isValid()) {
+    statement.bind(10, request.challengeState->binarySecret, SQLITE_TRANSIENT);
+  }
+  else {
+    sqlite3_bind_null(statement, 10);
+  }
+  statement.bind(11, request.requestId.data(), request.requestId.size(), SQLITE_TRANSIENT);
 
   if (statement.step() != SQLITE_DONE) {
     addRequest(request);
@@ -228,30 +341,10 @@ std::list<RequestState>
 CaSqlite::listAllRequests()
 {
   std::list<RequestState> result;
-  Sqlite3Statement statement(m_database, R"_SQLTEXT_(SELECT id, request_id, ca_name, status,
-                             challenge_status, cert_request, challenge_type, challenge_secrets,
-                             challenge_tp, remaining_tries, remaining_time, request_type,
-                             encryption_key, encryption_iv, decryption_iv
-                             FROM RequestStates)_SQLTEXT_");
-  while (statement.step() == SQLITE_ROW) {
-    RequestState state;
-    std::memcpy(state.requestId.data(), statement.getBlob(1), statement.getSize(1));
-    state.caPrefix = Name(statement.getBlock(2));
-    state.status = static_cast<Status>(statement.getInt(3));
-    state.challengeType = statement.getString(6);
-    state.cert = Certificate(statement.getBlock(5));
-    state.requestType = static_cast<RequestType>(statement.getInt(11));
-    std::memcpy(state.encryptionKey.data(), statement.getBlob(12), statement.getSize(12));
-    state.encryptionIv = std::vector<uint8_t>(statement.getBlob(13), statement.getBlob(13) + statement.getSize(13));
-    state.decryptionIv = std::vector<uint8_t>(statement.getBlob(14), statement.getBlob(14) + statement.getSize(14));
-    if (state.challengeType != "") {
-      ChallengeState challengeState(statement.getString(4), time::fromIsoString(statement.getString(8)),
-                                    statement.getInt(9), time::seconds(statement.getInt(10)),
-                                    convertString2Json(statement.getString(7)));
-      state.challengeState = challengeState;
-    }
+  forEachRequest({}, [&result] (const RequestState& state) {
     result.push_back(state);
-  }
+    return true;
+  });
   return result;
 }
 
@@ -259,34 +352,57 @@ std::list<RequestState>
 CaSqlite::listAllRequests(const Name& caName)
 {
   std::list<RequestState> result;
-  Sqlite3Statement statement(m_database,
-                             R"_SQLTEXT_(SELECT id, request_id, ca_name, status,
-                             challenge_status, cert_request, challenge_type, challenge_secrets,
-                             challenge_tp, remaining_tries, remaining_time, request_type,
-                             encryption_key, encryption_iv, decryption_iv
-                             FROM RequestStates WHERE ca_name = ?)_SQLTEXT_");
-  statement.bind(1, caName.wireEncode(), SQLITE_TRANSIENT);
+  RequestFilter filter;
+  filter.caPrefix = caName;
+  forEachRequest(filter, [&result] (const RequestState& state) {
+    result.push_back(state);
+    return true;
+  });
+  return result;
+}
 
+size_t
+CaSqlite::forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor)
+{
+  Sqlite3Statement statement(m_database, "SELECT " + REQUEST_STATE_COLUMNS + " FROM RequestStates" +
+                                         makeFilterClause(filter, true));
+  bindFilter(statement, filter, true);
+  size_t nVisited = 0;
   while (statement.step() == SQLITE_ROW) {
-    RequestState state;
-    std::memcpy(state.requestId.data(), statement.getBlob(1), statement.getSize(1));
-    state.caPrefix = Name(statement.getBlock(2));
-    state.status = static_cast<Status>(statement.getInt(3));
-    state.challengeType = statement.getString(6);
-    state.cert = Certificate(statement.getBlock(5));
-    state.requestType = static_cast<RequestType>(statement.getInt(11));
-    std::memcpy(state.encryptionKey.data(), statement.getBlob(12), statement.getSize(12));
-    state.encryptionIv = std::vector<uint8_t>(statement.getBlob(13), statement.getBlob(13) + statement.getSize(13));
-    state.decryptionIv = std::vector<uint8_t>(statement.getBlob(14), statement.getBlob(14) + statement.getSize(14));
-    if (!state.challengeType.empty()) {
-      ChallengeState challengeState(statement.getString(4), time::fromIsoString(statement.getString(8)),
-                                    statement.getInt(9), time::seconds(statement.getInt(10)),
-                                    convertString2Json(statement.getString(7)));
-      state.challengeState = challengeState;
+    nVisited++;
+    if (!visitor(decodeRequestState(statement))) {
+      break;
     }
-    result.push_back(state);
   }
-  return result;
+  return nVisited;
+}
+
+size_t
+CaSqlite::forEachRequestSummary(const RequestFilter& filter, const RequestSummaryVisitor& visitor)
+{
+  Sqlite3Statement statement(m_database, "SELECT " + REQUEST_SUMMARY_COLUMNS + " FROM RequestStates" +
+                                         makeFilterClause(filter, true));
+  bindFilter(statement, filter, true);
+  size_t nVisited = 0;
+  while (statement.step() == SQLITE_ROW) {
+    nVisited++;
+    if (!visitor(decodeRequestSummary(statement))) {
+      break;
+    }
+  }
+  return nVisited;
+}
+
+size_t
+CaSqlite::countRequests(const RequestFilter& filter)
+{
+  Sqlite3Statement statement(m_database, "SELECT COUNT(*) FROM RequestStates" +
+                                         makeFilterClause(filter, false));
+  bindFilter(statement, filter, false);
+  if (statement.step() != SQLITE_ROW) {
+    NDN_THROW(std::runtime_error("Requests cannot be counted in the database"));
+  }
+  return static_cast<size_t>(sqlite3_column_int64(statement, 0));
 }
 
 void
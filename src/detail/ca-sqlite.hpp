@@ -56,6 +56,15 @@ public:
   std::list<RequestState>
   listAllRequests(const Name& caName) override;
 
+  size_t
+  forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor) override;
+
+  size_t
+  forEachRequestSummary(const RequestFilter& filter, const RequestSummaryVisitor& visitor) override;
+
+  size_t
+  countRequests(const RequestFilter& filter) override;
+
 private:
   sqlite3* m_database;
 };
@@ -22,12 +22,135 @@
 
 namespace ndncert::ca {
 
+RequestSummary
+summarizeRequest(const RequestState& request)
+{
+  RequestSummary summary;
+  summary.requestId = request.requestId;
+  summary.caPrefix = request.caPrefix;
+  summary.requestType = request.requestType;
+  summary.status = request.status;
+  summary.challengeType = request.challengeType;
+  if (request.challengeState) {
+    summary.challengeStatus = request.challengeState->challengeStatus;
+    summary.challengeTimestamp = request.challengeState->timestamp;
+  }
+  return summary;
+}
+
+bool
+RequestFilter::matches(const RequestSummary& summary) const
+{
+  if (caPrefix && summary.caPrefix != *caPrefix) {
+    return false;
+  }
+  if (status && summary.status != *status) {
+    return false;
+  }
+  if (requestType && summary.requestType != *requestType) {
+    return false;
+  }
+  if (challengeType && summary.challengeType != *challengeType) {
+    return false;
+  }
+  if (updatedBefore && (!summary.challengeTimestamp || *summary.challengeTimestamp >= *updatedBefore)) {
+    return false;
+  }
+  if (startAfter && summary.requestId <= *startAfter) {
+    return false;
+  }
+  return true;
+}
+
 std::unique_ptr<CaStorage>
 CaStorage::createCaStorage(const std::string& caStorageType, const Name& caName, const std::string& path)
 {
   auto& factory = getFactory();
   auto i = factory.find(caStorageType);
-  return i == factory.end() ? nullptr : i->second(caName, path);
+  if (i != factory.end()) {
+    return i->second(caName, path);
+  }
+
+  auto separator = caStorageType.find(':');
+  if (separator == std::string::npos) {
+    return nullptr;
+  }
+  auto& decoratorFactory = getDecoratorFactory();
+  auto decorator = decoratorFactory.find(caStorageType.substr(0, separator));
+  if (decorator == decoratorFactory.end()) {
+    return nullptr;
+  }
+  auto innerType = caStorageType.substr(separator + 1);
+  auto inner = createCaStorage(innerType, caName, path);
+  if (inner == nullptr) {
+    inner = createCaStorage("ca-storage-" + innerType, caName, path);
+  }
+  if (inner == nullptr) {
+    return nullptr;
+  }
+  return decorator->second(std::move(inner), caName, path);
+}
+
+size_t
+CaStorage::forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor)
+{
+  auto requests = filter.caPrefix ? listAllRequests(*filter.caPrefix) : listAllRequests();
+  requests.sort([] (const auto& a, const auto& b) { return a.requestId < b.requestId; });
+  size_t nVisited = 0;
+  for (const auto& request : requests) {
+    if (filter.limit != 0 && nVisited >= filter.limit) {
+      break;
+    }
+    if (!filter.matches(summarizeRequest(request))) {
+      continue;
+    }
+    nVisited++;
+    if (!visitor(request)) {
+      break;
+    }
+  }
+  return nVisited;
+}
+
+size_t
+CaStorage::forEachRequestSummary(const RequestFilter& filter, const RequestSummaryVisitor& visitor)
+{
+  return forEachRequest(filter, [&visitor] (const RequestState& request) {
+    return visitor(summarizeRequest(request));
+  });
+}
+
+size_t
+CaStorage::countRequests(const RequestFilter& filter)
+{
+  RequestFilter unpaginated = filter;
+  unpaginated.startAfter = std::nullopt;
+  unpaginated.limit = 0;
+  return forEachRequestSummary(unpaginated, [] (const auto&) { return true; });
+}
+
+std::pair<std::string, std::map<std::string, std::string>>
+CaStorage::parseLocator(const std::string& path)
+{
+  auto separator = path.find('?');
+  std::map<std::string, std::string> options;
+  if (separator == std::string::npos) {
+    return {path, options};
+  }
+
+  std::vector<std::string> items;
+  boost::algorithm::split(items, path.substr(separator + 1), boost::is_any_of("&"));
+  for (const auto& item : items) {
+    if (item.empty()) {
+      continue;
+    }
+    auto equal = item.find('=');
+    if (equal == 0 || equal == std::string::npos) {
+      NDN_THROW(std::runtime_error("Malformed storage option '" + item + "' in " + path));
+    }
+    options[item.substr(0, equal)] = item.substr(equal + 1);
+  }
+  return {path.substr(0, separator), options};
 }
 
 CaStorage::CaStorageFactory&
@@ -37,4 +160,11 @@ CaStorage::getFactory()
   return factory;
 }
 
+CaStorage::CaStorageDecoratorFactory&
+CaStorage::getDecoratorFactory()
+{
+  static CaStorageDecoratorFactory factory;
+  return factory;
+}
+
 } // namespace ndncert::ca
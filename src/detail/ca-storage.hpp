@@ -23,10 +23,74 @@
 
 #include "detail/ca-request-state.hpp"
 
+#include <functional>
 #include <map>
 
 namespace ndncert::ca {
 
+/**
+ * @brief Lightweight projection of a RequestState.
+ *
+ * Producing a summary never decodes the requested certificate nor parses the challenge secrets,
+ * which makes it suitable for enumerating a large number of requests.
+ */
+struct RequestSummary
+{
+  RequestId requestId = {};
+  Name caPrefix;
+  RequestType requestType = RequestType::NOTINITIALIZED;
+  Status status = Status::BEFORE_CHALLENGE;
+  std::string challengeType;
+  std::string challengeStatus;
+  /**
+   * @brief The last update of the challenge state, if a challenge has been started.
+   */
+  std::optional<time::system_clock::TimePoint> challengeTimestamp;
+};
+
+/**
+ * @brief Summarize a fully decoded request.
+ */
+RequestSummary
+summarizeRequest(const RequestState& request);
+
+/**
+ * @brief Criteria used to enumerate the requests kept by a CaStorage.
+ *
+ * Unset criteria match every request. Requests are always enumerated in ascending order of
+ * their request ID, so that a large result can be paginated with @p startAfter and @p limit.
+ */
+struct RequestFilter
+{
+  std::optional<Name> caPrefix;
+  std::optional<Status> status;
+  std::optional<RequestType> requestType;
+  std::optional<std::string> challengeType;
+  /**
+   * @brief Only match requests whose challenge state was last updated before this time point.
+   *
+   * Requests that have not started a challenge carry no timestamp and never match.
+   */
+  std::optional<time::system_clock::TimePoint> updatedBefore;
+  /**
+   * @brief Only match requests whose ID sorts strictly after this one.
+   */
+  std::optional<RequestId> startAfter;
+  /**
+   * @brief The maximum number of requests to visit, zero meaning no limit.
+   */
+  size_t limit = 0;
+
+  bool
+  matches(const RequestSummary& summary) const;
+};
+
+/**
+ * @brief Invoked for each enumerated request; returning false stops the enumeration.
+ */
+using RequestVisitor = std::function<bool(const RequestState&)>;
+using RequestSummaryVisitor = std::function<bool(const RequestSummary&)>;
+
 class CaStorage : boost::noncopyable
 {
 public:
@@ -57,6 +121,43 @@ public:
   virtual std::list<RequestState>
   listAllRequests(const Name& caName) = 0;
 
+  /**
+   * @brief Visit the fully decoded requests matching @p filter.
+   *
+   * The default implementation is built on listAllRequests(); backends should override it
+   * so that requests are decoded one at a time.
+   *
+   * @return The number of requests passed to @p visitor.
+   */
+  virtual size_t
+  forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor);
+
+  /**
+   * @brief Visit the summaries of the requests matching @p filter.
+   * @return The number of summaries passed to @p visitor.
+   */
+  virtual size_t
+  forEachRequestSummary(const RequestFilter& filter, const RequestSummaryVisitor& visitor);
+
+  /**
+   * @brief Count the requests matching @p filter.
+   *
+   * The pagination criteria (RequestFilter::startAfter and RequestFilter::limit) are ignored.
+   */
+  virtual size_t
+  countRequests(const RequestFilter& filter);
+
+  /**
+   * @brief Whether the storage may be used by several threads at once.
+   *
+   * Storages that are not can be shared through a CaSynchronizedStorage.
+   */
+  virtual bool
+  isThreadSafe() const
+  {
+    return false;
+  }
+
 public: // factory
   template<class CaStorageType>
   static void
@@ -69,15 +170,53 @@ public: // factory
     };
   }
 
+  /**
+   * @brief Register a storage type that wraps another storage.
+   *
+   * A decorated storage is created with the type "<decorator>:<inner type>", where the inner
+   * type may omit its "ca-storage-" prefix, e.g., "ca-storage-cached:sqlite3". The inner storage
+   * and the decorator receive the same path.
+   */
+  template<class DecoratorType>
+  static void
+  registerCaStorageDecorator(const std::string& type = DecoratorType::STORAGE_TYPE)
+  {
+    auto& factory = getDecoratorFactory();
+    BOOST_ASSERT(factory.count(type) == 0);
+    factory[type] = [] (std::unique_ptr<CaStorage> inner, const Name& caName, const std::string& path) {
+      return std::make_unique<DecoratorType>(std::move(inner), caName, path);
+    };
+  }
+
+  /**
+   * @return The created storage, or nullptr if @p caStorageType is unknown.
+   */
   static std::unique_ptr<CaStorage>
   createCaStorage(const std::string& caStorageType, const Name& caName, const std::string& path);
 
+  /**
+   * @brief Split the path given to a storage backend into a location and options.
+   *
+   * The path has the form "[location][?key=value[&key=value]...]", e.g., "/var/lib/ca.db"
+   * or "?shards=16&capacity=100000". Backends ignore the options they do not recognize.
+   *
+   * @throw std::runtime_error The options are malformed.
+   */
+  static std::pair<std::string, std::map<std::string, std::string>>
+  parseLocator(const std::string& path);
+
 private:
   using CreateFunc = std::function<std::unique_ptr<CaStorage>(const Name&, const std::string&)>;
   using CaStorageFactory = std::map<std::string, CreateFunc>;
+  using DecorateFunc = std::function<std::unique_ptr<CaStorage>(std::unique_ptr<CaStorage>,
+                                                                const Name&, const std::string&)>;
+  using CaStorageDecoratorFactory = std::map<std::string, DecorateFunc>;
 
   static CaStorageFactory&
   getFactory();
+
+  static CaStorageDecoratorFactory&
+  getDecoratorFactory();
 };
 
 } // namespace ndncert::ca
@@ -92,4 +231,14 @@ public:                                                       \
   }                                                           \
 } g_NdnCert##C##CaStorageRegistrationVariable
 
+#define NDNCERT_REGISTER_CA_STORAGE_DECORATOR(C)              \
+static class NdnCert##C##CaStorageRegistrationClass           \
+{                                                             \
+public:                                                       \
+  NdnCert##C##CaStorageRegistrationClass()                    \
+  {                                                           \
+    ::ndncert::ca::CaStorage::registerCaStorageDecorator<C>(); \
+  }                                                           \
+} g_NdnCert##C##CaStorageRegistrationVariable
+
 #endif // NDNCERT_DETAIL_CA_STORAGE_HPP
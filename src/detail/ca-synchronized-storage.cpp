@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/ca-synchronized-storage.hpp"
+
+namespace ndncert::ca {
+
+const std::string CaSynchronizedStorage::STORAGE_TYPE = "ca-storage-synchronized";
+NDNCERT_REGISTER_CA_STORAGE_DECORATOR(CaSynchronizedStorage);
+
+CaSynchronizedStorage::CaSynchronizedStorage(std::unique_ptr<CaStorage> inner, const Name&, const std::string&)
+  : m_inner(std::move(inner))
+{
+  BOOST_ASSERT(m_inner != nullptr);
+}
+
+RequestState
+CaSynchronizedStorage::getRequest(const RequestId& requestId)
+{
+  std::lock_guard lock(m_mutex);
+  return m_inner->getRequest(requestId);
+}
+
+void
+CaSynchronizedStorage::addRequest(const RequestState& request)
+{
+  std::lock_guard lock(m_mutex);
+  m_inner->addRequest(request);
+}
+
+void
+CaSynchronizedStorage::updateRequest(const RequestState& request)
+{
+  std::lock_guard lock(m_mutex);
+  m_inner->updateRequest(request);
+}
+
+void
+CaSynchronizedStorage::deleteRequest(const RequestId& requestId)
+{
+  std::lock_guard lock(m_mutex);
+  m_inner->deleteRequest(requestId);
+}
+
+std::list<RequestState>
+CaSynchronizedStorage::listAllRequests()
+{
+  std::lock_guard lock(m_mutex);
+  return m_inner->listAllRequests();
+}
+
+std::list<RequestState>
+CaSynchronizedStorage::listAllRequests(const Name& caName)
+{
+  std::lock_guard lock(m_mutex);
+  return m_inner->listAllRequests(caName);
+}
+
+size_t
+CaSynchronizedStorage::forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor)
+{
+  std::lock_guard lock(m_mutex);
+  return m_inner->forEachRequest(filter, visitor);
+}
+
+size_t
+CaSynchronizedStorage::forEachRequestSummary(const RequestFilter& filter, const RequestSummaryVisitor& visitor)
+{
+  std::lock_guard lock(m_mutex);
+  return m_inner->forEachRequestSummary(filter, visitor);
+}
+
+size_t
+CaSynchronizedStorage::countRequests(const RequestFilter& filter)
+{
+  std::lock_guard lock(m_mutex);
+  return m_inner->countRequests(filter);
+}
+
+} // namespace ndncert::ca
@@ -0,0 +1,94 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_CA_SYNCHRONIZED_STORAGE_HPP
+#define NDNCERT_DETAIL_CA_SYNCHRONIZED_STORAGE_HPP
+
+#include "detail/ca-storage.hpp"
+
+#include <mutex>
+
+namespace ndncert::ca {
+
+/**
+ * @brief Makes another CaStorage safe for concurrent use by serializing every operation.
+ *
+ * The storage type is "ca-storage-synchronized:<inner type>", e.g.,
+ * "ca-storage-synchronized:memory".
+ */
+class CaSynchronizedStorage : public CaStorage
+{
+public:
+  static const std::string STORAGE_TYPE;
+
+  CaSynchronizedStorage(std::unique_ptr<CaStorage> inner, const Name& caName = "", const std::string& path = "");
+
+public:
+  RequestState
+  getRequest(const RequestId& requestId) override;
+
+  void
+  addRequest(const RequestState& request) override;
+
+  void
+  updateRequest(const RequestState& request) override;
+
+  void
+  deleteRequest(const RequestId& requestId) override;
+
+  std::list<RequestState>
+  listAllRequests() override;
+
+  std::list<RequestState>
+  listAllRequests(const Name& caName) override;
+
+  /**
+   * @note @p visitor is invoked with the storage locked and must not use the storage.
+   */
+  size_t
+  forEachRequest(const RequestFilter& filter, const RequestVisitor& visitor) override;
+
+  size_t
+  forEachRequestSummary(const RequestFilter& filter, const RequestSummaryVisitor& visitor) override;
+
+  size_t
+  countRequests(const RequestFilter& filter) override;
+
+  bool
+  isThreadSafe() const override
+  {
+    return true;
+  }
+
+public:
+  CaStorage&
+  getInnerStorage()
+  {
+    return *m_inner;
+  }
+
+private:
+  std::unique_ptr<CaStorage> m_inner;
+  std::mutex m_mutex;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_CA_SYNCHRONIZED_STORAGE_HPP
@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/certificate-index.hpp"
+
+namespace ndncert {
+
+CertificateIndex::CertificateIndex(size_t capacity)
+  : m_capacity(capacity)
+{
+}
+
+CertificateIndex::~CertificateIndex() = default;
+
+void
+CertificateIndex::insert(const Certificate& cert)
+{
+  if (m_capacity == 0) {
+    return;
+  }
+  erase(cert.getName());
+
+  auto fullName = cert.getFullName();
+  Node* node = &m_root;
+  for (const auto& component : fullName) {
+    auto& child = node->children[component];
+    if (child == nullptr) {
+      child = std::make_unique<Node>();
+      child->parent = node;
+      child->component = component;
+    }
+    node = child.get();
+  }
+  m_entries.push_front(Entry{cert, std::move(fullName), node});
+  node->entry = m_entries.begin();
+
+  if (m_entries.size() > m_capacity) {
+    eraseEntry(std::prev(m_entries.end()));
+  }
+}
+
+std::optional<Certificate>
+CertificateIndex::find(const Interest& interest)
+{
+  const auto& name = interest.getName();
+  Node* node = findNode(name);
+  if (node == nullptr) {
+    return std::nullopt;
+  }
+  if (node->entry) {
+    // the Interest carries an implicit digest
+    return use(*node->entry);
+  }
+  if (!interest.getCanBePrefix()) {
+    // only the certificates named exactly as the Interest, whose children are their digests
+    return find(name);
+  }
+  if (node == &m_root && m_entries.empty()) {
+    return std::nullopt;
+  }
+  return use(findRightmost(node));
+}
+
+std::optional<Certificate>
+CertificateIndex::find(const Name& certName)
+{
+  // implicit digests sort before all other components
+  Node* node = findNode(certName);
+  if (node == nullptr || node->children.empty() || !node->children.begin()->second->entry) {
+    return std::nullopt;
+  }
+  return use(*node->children.begin()->second->entry);
+}
+
+bool
+CertificateIndex::erase(const Name& certName)
+{
+  Node* node = findNode(certName);
+  if (node == nullptr || node->children.empty() || !node->children.begin()->second->entry) {
+    return false;
+  }
+  eraseEntry(*node->children.begin()->second->entry);
+  return true;
+}
+
+CertificateIndex::Node*
+CertificateIndex::findNode(const Name& name) const
+{
+  const Node* node = &m_root;
+  for (const auto& component : name) {
+    auto it = node->children.find(component);
+    if (it == node->children.end()) {
+      return nullptr;
+    }
+    node = it->second.get();
+  }
+  return const_cast<Node*>(node);
+}
+
+std::list<CertificateIndex::Entry>::iterator
+CertificateIndex::findRightmost(Node* node)
+{
+  // empty nodes are pruned, so every leaf holds an entry
+  while (!node->entry) {
+    node = node->children.rbegin()->second.get();
+  }
+  return *node->entry;
+}
+
+std::optional<Certificate>
+CertificateIndex::use(std::list<Entry>::iterator entry)
+{
+  m_entries.splice(m_entries.begin(), m_entries, entry);
+  return entry->cert;
+}
+
+void
+CertificateIndex::eraseEntry(std::list<Entry>::iterator entry)
+{
+  Node* node = entry->node;
+  m_entries.erase(entry);
+  node->entry = std::nullopt;
+  while (node != &m_root && !node->entry && node->children.empty()) {
+    Node* parent = node->parent;
+    parent->children.erase(node->component);
+    node = parent;
+  }
+}
+
+} // namespace ndncert
@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_CERTIFICATE_INDEX_HPP
+#define NDNCERT_DETAIL_CERTIFICATE_INDEX_HPP
+
+#include "detail/ndncert-common.hpp"
+
+#include <list>
+#include <map>
+
+namespace ndncert {
+
+/**
+ * @brief A bounded in-memory index of certificates organized as a name tree.
+ *
+ * Each certificate is stored under its full name, which is computed once on insertion, so that
+ * an Interest is matched by walking its name components rather than by hashing every cached
+ * certificate. When the capacity is reached, the least recently used certificate is evicted.
+ */
+class CertificateIndex : boost::noncopyable
+{
+public:
+  explicit
+  CertificateIndex(size_t capacity = 256);
+
+  ~CertificateIndex();
+
+  /**
+   * @brief Add a certificate, replacing any certificate with the same name.
+   */
+  void
+  insert(const Certificate& cert);
+
+  /**
+   * @brief Find a certificate that satisfies @p interest.
+   *
+   * If several certificates satisfy the Interest, the one with the greatest name is returned.
+   */
+  std::optional<Certificate>
+  find(const Interest& interest);
+
+  /**
+   * @brief Find the certificate with exactly the given name, without implicit digest.
+   */
+  std::optional<Certificate>
+  find(const Name& certName);
+
+  /**
+   * @brief Remove the certificate with the given name, without implicit digest.
+   * @return Whether a certificate was removed.
+   */
+  bool
+  erase(const Name& certName);
+
+  size_t
+  size() const
+  {
+    return m_entries.size();
+  }
+
+  size_t
+  getCapacity() const
+  {
+    return m_capacity;
+  }
+
+private:
+  struct Node;
+
+  struct Entry
+  {
+    Certificate cert;
+    Name fullName;
+    Node* node;
+  };
+
+  struct Node
+  {
+    Node* parent = nullptr;
+    ndn::name::Component component;
+    std::map<ndn::name::Component, std::unique_ptr<Node>> children;
+    // valid only on the nodes of full names
+    std::optional<std::list<Entry>::iterator> entry;
+  };
+
+  /**
+   * @brief The node of @p name, or nullptr if there is none.
+   */
+  Node*
+  findNode(const Name& name) const;
+
+  /**
+   * @brief The entry with the greatest name under @p node.
+   */
+  static std::list<Entry>::iterator
+  findRightmost(Node* node);
+
+  std::optional<Certificate>
+  use(std::list<Entry>::iterator entry);
+
+  void
+  eraseEntry(std::list<Entry>::iterator entry);
+
+private:
+  size_t m_capacity;
+  Node m_root;
+  // the most recently used entry is at the front
+  std::list<Entry> m_entries;
+};
+
+} // namespace ndncert
+
+#endif // NDNCERT_DETAIL_CERTIFICATE_INDEX_HPP
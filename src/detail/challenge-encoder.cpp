@@ -23,7 +23,7 @@
 namespace ndncert::challengetlv {
 
 Block
-encodeDataContent(ca::RequestState& request, const Name& issuedCertName)
+encodeDataContent(ca::RequestState& request, const Name& issuedCertName, const Block& issuedCert)
 {
   Block response(tlv::EncryptedPayload);
   response.push_back(ndn::makeNonNegativeIntegerBlock(tlv::Status, static_cast<uint64_t>(request.status)));
@@ -43,6 +43,9 @@ encodeDataContent(ca::RequestState& request, const Name& issuedCertName)
     response.push_back(makeNestedBlock(tlv::IssuedCertName, issuedCertName));
     response.push_back(makeNestedBlock(ndn::tlv::ForwardingHint, Name(request.caPrefix).append("CA")));
   }
+  if (issuedCert.isValid()) {
+    response.push_back(Block(tlv::IssuedCert, issuedCert));
+  }
   response.encode();
 
   return encodeBlockWithAesGcm128(ndn::tlv::Content, request.encryptionKey.data(),
@@ -85,6 +88,15 @@ decodeDataContent(const Block& contentBlock, requester::Request& state)
         case ndn::tlv::ForwardingHint:
           state.m_forwardingHint = Name(item.blockFromValue());
           break;
+        case tlv::IssuedCert:
+          try {
+            state.m_issuedCert = std::make_shared<Certificate>(item.blockFromValue());
+          }
+          catch (const std::exception&) {
+            // the certificate is fetched by name instead
+            state.m_issuedCert = nullptr;
+          }
+          break;
         case tlv::ParameterKey:
           if (readString(item) == "nonce") {
             lookingForNonce = true;
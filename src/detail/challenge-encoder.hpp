@@ -26,8 +26,12 @@
 
 namespace ndncert::challengetlv {
 
+/**
+ * @param issuedCert the issued certificate, which saves the requester from fetching it, if any.
+ */
 Block
-encodeDataContent(ca::RequestState& request, const Name& issuedCertName = Name());
+encodeDataContent(ca::RequestState& request, const Name& issuedCertName = Name(),
+                  const Block& issuedCert = {});
 
 void
 decodeDataContent(const Block& contentBlock, requester::Request& state);
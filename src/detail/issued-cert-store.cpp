@@ -0,0 +1,313 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/issued-cert-store.hpp"
+
+#include <sqlite3.h>
+
+#include <ndn-cxx/util/sqlite3-statement.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+
+namespace ndncert::ca {
+
+using ndn::util::Sqlite3Statement;
+
+// how long a statement waits for a lock held by another connection to the database
+const int BUSY_TIMEOUT_MS = 5000;
+
+const std::string INITIALIZATION = R"SQL(
+CREATE TABLE IF NOT EXISTS
+  IssuedCertificates(
+    id INTEGER PRIMARY KEY,
+    cert_name BLOB NOT NULL,
+    cert BLOB NOT NULL,
+    issued_at INTEGER NOT NULL,
+    digest BLOB
+  );
+CREATE UNIQUE INDEX IF NOT EXISTS
+  IssuedCertificatesNameIndex ON IssuedCertificates(cert_name);
+)SQL";
+
+const std::string DIGEST_INDEX = R"SQL(
+CREATE INDEX IF NOT EXISTS
+  IssuedCertificatesDigestIndex ON IssuedCertificates(digest);
+)SQL";
+
+static std::vector<uint8_t>
+getNameKey(const Name& name)
+{
+  const auto& wire = name.wireEncode();
+  return std::vector<uint8_t>(wire.value_begin(), wire.value_end());
+}
+
+/**
+ * @brief The smallest key greater than all the keys starting with @p key.
+ * @return An empty key if there is no such key.
+ */
+static std::vector<uint8_t>
+getKeySuccessor(std::vector<uint8_t> key)
+{
+  while (!key.empty() && key.back() == 0xFF) {
+    key.pop_back();
+  }
+  if (!key.empty()) {
+    key.back()++;
+  }
+  return key;
+}
+
+/**
+ * @brief Bind the bounds of the keys starting with @p lower, as used by getRangeClause().
+ */
+static void
+bindRange(Sqlite3Statement& statement, const std::vector<uint8_t>& lower, const std::vector<uint8_t>& upper)
+{
+  // an empty vector would be bound as NULL rather than as an empty blob
+  if (lower.empty()) {
+    sqlite3_bind_zeroblob(statement, 1, 0);
+  }
+  else {
+    statement.bind(1, lower.data(), lower.size(), SQLITE_TRANSIENT);
+  }
+  if (!upper.empty()) {
+    statement.bind(2, upper.data(), upper.size(), SQLITE_TRANSIENT);
+  }
+}
+
+static std::string
+getRangeClause(const std::vector<uint8_t>& upper)
+{
+  return upper.empty() ? "cert_name >= ?" : "cert_name >= ? AND cert_name < ?";
+}
+
+IssuedCertStore::IssuedCertStore(const Name& caName, const std::string& path, size_t hotSetCapacity)
+  : m_hotSet(hotSetCapacity)
+{
+  boost::filesystem::path dbPath;
+  if (!path.empty()) {
+    // includes ":memory:", which sqlite3 opens as a private in-memory database
+    dbPath = boost::filesystem::path(path);
+  }
+  else {
+    std::string dbName = caName.toUri();
+    std::replace(dbName.begin(), dbName.end(), '/', '_');
+    dbName += ".certs.db";
+    if (getenv("HOME") != nullptr) {
+      dbPath = boost::filesystem::path(getenv("HOME")) / ".ndncert";
+    }
+    else {
+      dbPath = boost::filesystem::current_path() / ".ndncert";
+    }
+    boost::filesystem::create_directories(dbPath);
+    dbPath /= dbName;
+  }
+
+  int result = sqlite3_open_v2(dbPath.c_str(), &m_database,
+                               SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+#ifdef NDN_CXX_DISABLE_SQLITE3_FS_LOCKING
+                               "unix-dotfile"
+#else
+                               nullptr
+#endif
+  );
+  if (result != SQLITE_OK) {
+    NDN_THROW(std::runtime_error("IssuedCertStore DB cannot be opened/created: " + dbPath.string()));
+  }
+  sqlite3_busy_timeout(m_database, BUSY_TIMEOUT_MS);
+
+  char* errorMessage = nullptr;
+  result = sqlite3_exec(m_database, INITIALIZATION.data(), nullptr, nullptr, &errorMessage);
+  if (result != SQLITE_OK && errorMessage != nullptr) {
+    sqlite3_free(errorMessage);
+    NDN_THROW(std::runtime_error("IssuedCertStore DB cannot be initialized"));
+  }
+
+  // databases created before the digest index lack the digest of their certificates
+  Sqlite3Statement hasDigest(m_database,
+                             "SELECT COUNT(*) FROM pragma_table_info('IssuedCertificates') WHERE name = 'digest'");
+  if (hasDigest.step() == SQLITE_ROW && hasDigest.getInt(0) == 0) {
+    sqlite3_exec(m_database, "ALTER TABLE IssuedCertificates ADD COLUMN digest BLOB", nullptr, nullptr, nullptr);
+  }
+  std::vector<std::pair<int64_t, CertDigest>> missing;
+  Sqlite3Statement withoutDigest(m_database, "SELECT id, cert FROM IssuedCertificates WHERE digest IS NULL");
+  while (withoutDigest.step() == SQLITE_ROW) {
+    missing.emplace_back(sqlite3_column_int64(withoutDigest, 0), getCertDigest(Certificate(withoutDigest.getBlock(1))));
+  }
+  for (const auto& [id, digest] : missing) {
+    Sqlite3Statement update(m_database, "UPDATE IssuedCertificates SET digest = ? WHERE id = ?");
+    update.bind(1, digest.data(), digest.size(), SQLITE_TRANSIENT);
+    sqlite3_bind_int64(update, 2, id);
+    update.step();
+  }
+
+  result = sqlite3_exec(m_database, DIGEST_INDEX.data(), nullptr, nullptr, &errorMessage);
+  if (result != SQLITE_OK && errorMessage != nullptr) {
+    sqlite3_free(errorMessage);
+    NDN_THROW(std::runtime_error("IssuedCertStore DB cannot be initialized"));
+  }
+}
+
+IssuedCertStore::~IssuedCertStore()
+{
+  sqlite3_close(m_database);
+}
+
+void
+IssuedCertStore::insert(const Certificate& cert)
+{
+  auto key = getNameKey(cert.getName());
+  auto digest = getCertDigest(cert);
+  std::lock_guard lock(m_mutex);
+  m_hotSet.insert(cert);
+  Sqlite3Statement statement(m_database,
+                             R"SQL(INSERT OR REPLACE INTO IssuedCertificates (cert_name, cert, issued_at, digest)
+                             VALUES (?, ?, ?, ?))SQL");
+  statement.bind(1, key.data(), key.size(), SQLITE_TRANSIENT);
+  statement.bind(2, cert.wireEncode(), SQLITE_TRANSIENT);
+  sqlite3_bind_int64(statement, 3, time::toUnixTimestamp(time::system_clock::now()).count());
+  statement.bind(4, digest.data(), digest.size(), SQLITE_TRANSIENT);
+  if (statement.step() != SQLITE_DONE) {
+    NDN_THROW(std::runtime_error("Certificate " + cert.getName().toUri() + " cannot be added to the database"));
+  }
+}
+
+std::optional<Certificate>
+IssuedCertStore::find(const Interest& interest)
+{
+  std::lock_guard lock(m_mutex);
+  if (!interest.getCanBePrefix()) {
+    auto cert = m_hotSet.find(interest);
+    if (cert) {
+      return cert;
+    }
+  }
+
+  const auto& name = interest.getName();
+  if (!name.empty() && name.at(-1).isImplicitSha256Digest()) {
+    auto cert = findExact(name.getPrefix(-1));
+    if (cert && cert->getFullName() == name) {
+      return cert;
+    }
+    return std::nullopt;
+  }
+  if (interest.getCanBePrefix()) {
+    return findLatest(name);
+  }
+  return findExact(name);
+}
+
+std::optional<Certificate>
+IssuedCertStore::find(const Name& certName)
+{
+  std::lock_guard lock(m_mutex);
+  return findExact(certName);
+}
+
+std::optional<Certificate>
+IssuedCertStore::find(const CertDigest& digest)
+{
+  std::lock_guard lock(m_mutex);
+  Sqlite3Statement statement(m_database, "SELECT cert FROM IssuedCertificates WHERE digest = ?");
+  statement.bind(1, digest.data(), digest.size(), SQLITE_TRANSIENT);
+  if (statement.step() != SQLITE_ROW) {
+    return std::nullopt;
+  }
+  Certificate cert(statement.getBlock(0));
+  m_hotSet.insert(cert);
+  return cert;
+}
+
+std::vector<Certificate>
+IssuedCertStore::list(const Name& prefix, size_t limit)
+{
+  auto lower = getNameKey(prefix);
+  auto upper = getKeySuccessor(lower);
+  std::lock_guard lock(m_mutex);
+  Sqlite3Statement statement(m_database, "SELECT cert FROM IssuedCertificates WHERE " + getRangeClause(upper) +
+                                         " ORDER BY cert_name" +
+                                         (limit == 0 ? "" : " LIMIT " + std::to_string(limit)));
+  bindRange(statement, lower, upper);
+
+  std::vector<Certificate> result;
+  while (statement.step() == SQLITE_ROW) {
+    result.emplace_back(statement.getBlock(0));
+  }
+  return result;
+}
+
+void
+IssuedCertStore::erase(const Name& certName)
+{
+  std::lock_guard lock(m_mutex);
+  m_hotSet.erase(certName);
+
+  auto key = getNameKey(certName);
+  Sqlite3Statement statement(m_database, "DELETE FROM IssuedCertificates WHERE cert_name = ?");
+  statement.bind(1, key.data(), key.size(), SQLITE_TRANSIENT);
+  statement.step();
+}
+
+size_t
+IssuedCertStore::size()
+{
+  std::lock_guard lock(m_mutex);
+  Sqlite3Statement statement(m_database, "SELECT COUNT(*) FROM IssuedCertificates");
+  return statement.step() == SQLITE_ROW ? statement.getInt(0) : 0;
+}
+
+std::optional<Certificate>
+IssuedCertStore::findExact(const Name& certName)
+{
+  auto cached = m_hotSet.find(certName);
+  if (cached) {
+    return cached;
+  }
+
+  auto key = getNameKey(certName);
+  Sqlite3Statement statement(m_database, "SELECT cert FROM IssuedCertificates WHERE cert_name = ?");
+  statement.bind(1, key.data(), key.size(), SQLITE_TRANSIENT);
+  if (statement.step() != SQLITE_ROW) {
+    return std::nullopt;
+  }
+  Certificate cert(statement.getBlock(0));
+  m_hotSet.insert(cert);
+  return cert;
+}
+
+std::optional<Certificate>
+IssuedCertStore::findLatest(const Name& prefix)
+{
+  auto lower = getNameKey(prefix);
+  auto upper = getKeySuccessor(lower);
+  Sqlite3Statement statement(m_database, "SELECT cert FROM IssuedCertificates WHERE " + getRangeClause(upper) +
+                                         " ORDER BY cert_name DESC LIMIT 1");
+  bindRange(statement, lower, upper);
+  if (statement.step() != SQLITE_ROW) {
+    return std::nullopt;
+  }
+  Certificate cert(statement.getBlock(0));
+  m_hotSet.insert(cert);
+  return cert;
+}
+
+} // namespace ndncert::ca
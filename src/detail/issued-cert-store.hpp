@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_ISSUED_CERT_STORE_HPP
+#define NDNCERT_DETAIL_ISSUED_CERT_STORE_HPP
+
+#include "detail/certificate-index.hpp"
+#include "detail/revocation-encoder.hpp"
+
+#include <mutex>
+
+struct sqlite3;
+
+namespace ndncert::ca {
+
+/**
+ * @brief Persistent store of the certificates issued by a CA.
+ *
+ * Certificates are kept in an sqlite3 database indexed by name. The index holds the TLV-VALUE
+ * of each name, in which every name prefix is also a byte prefix, so that looking up all the
+ * certificates under a prefix is a range scan. Certificates are also indexed by implicit
+ * digest. The most recently used certificates are kept in an in-memory hot set. The store may
+ * be shared by several threads.
+ */
+class IssuedCertStore : boost::noncopyable
+{
+public:
+  /**
+   * @param path The database file; by default, "$HOME/.ndncert/<CA name>.certs.db". With
+   *             ":memory:", the certificates are only kept in memory and lost on restart.
+   * @param hotSetCapacity The number of certificates kept in memory.
+   */
+  explicit
+  IssuedCertStore(const Name& caName, const std::string& path = "", size_t hotSetCapacity = 256);
+
+  ~IssuedCertStore();
+
+  /**
+   * @brief Add a certificate, replacing any certificate with the same name.
+   *
+   * If the database cannot be written, the certificate is still served from the hot set
+   * until it is evicted.
+   *
+   * @throw std::runtime_error The certificate cannot be written to the database.
+   */
+  void
+  insert(const Certificate& cert);
+
+  /**
+   * @brief Find the certificate that satisfies @p interest.
+   *
+   * If the Interest can be satisfied by several certificates, the one with the greatest name,
+   * normally the latest version, is returned.
+   */
+  std::optional<Certificate>
+  find(const Interest& interest);
+
+  /**
+   * @brief Find the certificate with exactly the given name.
+   */
+  std::optional<Certificate>
+  find(const Name& certName);
+
+  /**
+   * @brief Find the certificate with the given implicit digest.
+   */
+  std::optional<Certificate>
+  find(const CertDigest& digest);
+
+  /**
+   * @brief List the certificates under @p prefix in ascending name order.
+   * @param limit The maximum number of certificates, zero meaning no limit.
+   */
+  std::vector<Certificate>
+  list(const Name& prefix, size_t limit = 0);
+
+  void
+  erase(const Name& certName);
+
+  size_t
+  size();
+
+  size_t
+  getHotSetSize() const
+  {
+    std::lock_guard lock(m_mutex);
+    return m_hotSet.size();
+  }
+
+private:
+  std::optional<Certificate>
+  findExact(const Name& certName);
+
+  std::optional<Certificate>
+  findLatest(const Name& prefix);
+
+private:
+  sqlite3* m_database = nullptr;
+  CertificateIndex m_hotSet;
+  mutable std::mutex m_mutex;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_ISSUED_CERT_STORE_HPP
@@ -54,4 +54,17 @@ operator<<(std::ostream& out, RequestType type)
   return out;
 }
 
+std::ostream&
+operator<<(std::ostream& out, CertStatus status)
+{
+  switch (status) {
+    case CertStatus::GOOD: out << "GOOD"; break;
+    case CertStatus::REVOKED: out << "REVOKED"; break;
+    case CertStatus::EXPIRED: out << "EXPIRED"; break;
+    case CertStatus::UNKNOWN: out << "UNKNOWN"; break;
+    default: out << "UNKNOWN_CERT_STATUS"; break;
+  }
+  return out;
+}
+
 } // namespace ndncert
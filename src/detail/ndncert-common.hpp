@@ -99,7 +99,21 @@ enum : uint32_t {
   ErrorInfo = 173,
   AuthenticationTag = 175,
   CertToRevoke = 177,
-  ProbeRedirect = 179
+  ProbeRedirect = 179,
+  CertToRenew = 181,
+  CertDigest = 183,
+  CertStatus = 185,
+  RevocationVersion = 187,
+  // non-critical: requesters unaware of stateless CAs ignore it
+  StateToken = 186,
+  // non-critical: requesters unaware of sharded CAs ignore it
+  ChallengeForwardingHint = 188,
+  // non-critical: CAs unaware of embedded challenges ignore it
+  EmbeddedChallenge = 190,
+  // non-critical: only sent in reply to an EmbeddedChallenge
+  EmbeddedChallengeResponse = 192,
+  // non-critical: requesters unaware of inline certificates fetch them by name
+  IssuedCert = 194
 };
 
 } // namespace tlv
@@ -136,6 +150,18 @@ enum class RequestType : uint64_t {
 std::ostream&
 operator<<(std::ostream& out, RequestType type);
 
+// Status of a certificate reported by a CA
+enum class CertStatus : uint64_t {
+  GOOD = 0,
+  REVOKED = 1,
+  EXPIRED = 2,
+  UNKNOWN = 3
+};
+
+// Convert certificate status to string
+std::ostream&
+operator<<(std::ostream& out, CertStatus status);
+
 } // namespace ndncert
 
 #endif // NDNCERT_DETAIL_NDNCERT_COMMON_HPP
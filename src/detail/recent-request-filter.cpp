@@ -0,0 +1,100 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/recent-request-filter.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ndncert::ca {
+
+size_t
+RecentRequestFilter::RequestIdHash::operator()(const RequestId& requestId) const
+{
+  // request IDs are keyed HMACs, their bytes are already uniformly distributed
+  uint64_t hash;
+  std::memcpy(&hash, requestId.data(), sizeof(hash));
+  return static_cast<size_t>(hash);
+}
+
+RecentRequestFilter::RecentRequestFilter(time::nanoseconds window, size_t capacity)
+  : m_window(window)
+  , m_capacity(std::max<size_t>(capacity, 2))
+  , m_rotation(time::steady_clock::now())
+{
+}
+
+std::optional<RecentRequestFilter::Entry>
+RecentRequestFilter::find(const RequestId& requestId)
+{
+  std::lock_guard lock(m_mutex);
+  rotate();
+  auto it = m_current.find(requestId);
+  if (it != m_current.end()) {
+    return it->second;
+  }
+  it = m_previous.find(requestId);
+  if (it != m_previous.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+void
+RecentRequestFilter::insert(const RequestId& requestId, const Name& interestName, const Data& response)
+{
+  std::lock_guard lock(m_mutex);
+  rotate();
+  m_previous.erase(requestId);
+  m_current.insert_or_assign(requestId, Entry{interestName, response});
+}
+
+void
+RecentRequestFilter::erase(const RequestId& requestId)
+{
+  std::lock_guard lock(m_mutex);
+  m_current.erase(requestId);
+  m_previous.erase(requestId);
+}
+
+size_t
+RecentRequestFilter::size() const
+{
+  std::lock_guard lock(m_mutex);
+  return m_current.size() + m_previous.size();
+}
+
+void
+RecentRequestFilter::rotate()
+{
+  auto now = time::steady_clock::now();
+  if (now - m_rotation >= m_window * 2) {
+    m_current.clear();
+    m_previous.clear();
+    m_rotation = now;
+  }
+  else if (now - m_rotation >= m_window || m_current.size() >= m_capacity / 2) {
+    m_previous = std::move(m_current);
+    m_current = Generation();
+    m_rotation = now;
+  }
+}
+
+} // namespace ndncert::ca
@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_RECENT_REQUEST_FILTER_HPP
+#define NDNCERT_DETAIL_RECENT_REQUEST_FILTER_HPP
+
+#include "detail/ca-request-state.hpp"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace ndncert::ca {
+
+/**
+ * @brief Remembers the requests recently created by a CA, with the response to their NEW or
+ *        REVOKE Interest.
+ *
+ * A request ID is derived from the requested certificate name only, so that it is known as soon
+ * as the Interest is decoded: duplicates are then recognized before any public-key operation.
+ *
+ * Entries are kept in two generations, swapped every window or once the current generation holds
+ * half the capacity, so that an entry is remembered for one to two windows. The lookups are exact.
+ * The filter may be shared by several threads.
+ */
+class RecentRequestFilter : boost::noncopyable
+{
+public:
+  struct Entry
+  {
+    /**
+     * @brief The full name of the Interest that created the request.
+     */
+    Name interestName;
+    Data response;
+  };
+
+  explicit
+  RecentRequestFilter(time::nanoseconds window = 1_min, size_t capacity = 65536);
+
+  std::optional<Entry>
+  find(const RequestId& requestId);
+
+  void
+  insert(const RequestId& requestId, const Name& interestName, const Data& response);
+
+  void
+  erase(const RequestId& requestId);
+
+  size_t
+  size() const;
+
+private:
+  void
+  rotate();
+
+private:
+  struct RequestIdHash
+  {
+    size_t
+    operator()(const RequestId& requestId) const;
+  };
+
+  using Generation = std::unordered_map<RequestId, Entry, RequestIdHash>;
+
+  const time::nanoseconds m_window;
+  const size_t m_capacity;
+  Generation m_current;
+  Generation m_previous;
+  time::steady_clock::time_point m_rotation;
+  mutable std::mutex m_mutex;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_RECENT_REQUEST_FILTER_HPP
@@ -0,0 +1,373 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/repo-publisher.hpp"
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+#include <array>
+
+namespace ndncert::ca {
+
+NDN_LOG_INIT(ndncert.repo);
+
+using boost::asio::ip::tcp;
+
+struct RepoPublisher::Connection
+{
+  explicit
+  Connection(boost::asio::io_context& io)
+    : socket(io)
+    , resolver(io)
+    , timer(io)
+  {
+  }
+
+  tcp::socket socket;
+  tcp::resolver resolver;
+  boost::asio::steady_timer timer;
+  // identifies the socket on which a completion handler was started
+  uint64_t generation = 0;
+  bool isConnected = false;
+  // connecting, writing, or waiting for the backoff to expire
+  bool isBusy = false;
+  time::milliseconds backoff = 0_ms;
+  // the Data being written, not yet counted as published
+  std::shared_ptr<std::vector<Block>> inFlight;
+  // repo-ng never writes to the connection, reads only detect its closure
+  std::array<uint8_t, 64> readBuffer;
+};
+
+RepoPublisher::RepoPublisher(boost::asio::io_context& io, const std::string& host, const std::string& port,
+                             const RepoPublisherOptions& options)
+  : m_io(io)
+  , m_host(host)
+  , m_port(port)
+  , m_options(options)
+{
+  for (size_t i = 0; i < std::max<size_t>(m_options.nConnections, 1); i++) {
+    m_connections.push_back(std::make_unique<Connection>(m_io));
+  }
+  if (!m_options.spillPath.empty()) {
+    loadSpill();
+    refillFromSpill();
+    dispatch();
+  }
+}
+
+RepoPublisher::~RepoPublisher()
+{
+  *m_isAlive = false;
+  for (auto& conn : m_connections) {
+    boost::system::error_code ec;
+    conn->resolver.cancel();
+    conn->timer.cancel();
+    conn->socket.close(ec);
+    if (conn->inFlight) {
+      // the aborted write may have been partially received, repo-ng ignores duplicates
+      m_queue.insert(m_queue.begin(), conn->inFlight->begin(), conn->inFlight->end());
+      conn->inFlight.reset();
+    }
+  }
+
+  if (!m_options.spillPath.empty()) {
+    saveSpill();
+  }
+  else if (!m_queue.empty()) {
+    NDN_LOG_WARN("Discarding " << m_queue.size() << " unpublished Data");
+  }
+}
+
+void
+RepoPublisher::publish(const Data& data)
+{
+  const auto& wire = data.wireEncode();
+  // once Data are spilled, the following ones are spilled as well to keep them in order
+  if (m_queue.size() < m_options.queueCapacity && m_spillDepth == 0) {
+    m_queue.push_back(wire);
+  }
+  else if (!m_options.spillPath.empty()) {
+    spill(wire);
+  }
+  else {
+    NDN_LOG_WARN("Publication queue is full, dropping " << data.getName());
+    m_metrics.nDropped++;
+    return;
+  }
+  dispatch();
+}
+
+RepoPublisher::Metrics
+RepoPublisher::getMetrics() const
+{
+  Metrics metrics = m_metrics;
+  metrics.queueDepth = m_queue.size();
+  metrics.spillDepth = m_spillDepth;
+  metrics.nConnected = std::count_if(m_connections.begin(), m_connections.end(),
+                                     [] (const auto& conn) { return conn->isConnected; });
+  return metrics;
+}
+
+void
+RepoPublisher::dispatch()
+{
+  for (auto& conn : m_connections) {
+    if (m_queue.empty()) {
+      return;
+    }
+    if (conn->isBusy) {
+      continue;
+    }
+    if (conn->isConnected) {
+      send(*conn);
+    }
+    else {
+      connect(*conn);
+    }
+  }
+}
+
+void
+RepoPublisher::connect(Connection& conn)
+{
+  conn.isBusy = true;
+  auto generation = ++conn.generation;
+  std::weak_ptr<bool> isAlive(m_isAlive);
+  conn.resolver.async_resolve(m_host, m_port,
+    [this, &conn, generation, isAlive] (const auto& error, const tcp::resolver::results_type& endpoints) {
+      if (isAlive.expired() || generation != conn.generation) {
+        return;
+      }
+      if (error) {
+        m_metrics.nConnectFailures++;
+        onFailure(conn, error.message());
+        return;
+      }
+      boost::asio::async_connect(conn.socket, endpoints,
+        [this, &conn, generation, isAlive] (const auto& error, const tcp::endpoint&) {
+          if (isAlive.expired() || generation != conn.generation) {
+            return;
+          }
+          if (error) {
+            m_metrics.nConnectFailures++;
+            onFailure(conn, error.message());
+            return;
+          }
+          NDN_LOG_DEBUG("Connected to repo-ng at " << m_host << ":" << m_port);
+          conn.isConnected = true;
+          conn.isBusy = false;
+          conn.backoff = 0_ms;
+          watch(conn);
+          dispatch();
+        });
+    });
+}
+
+void
+RepoPublisher::send(Connection& conn)
+{
+  auto batch = std::make_shared<std::vector<Block>>();
+  while (!m_queue.empty() && batch->size() < std::max<size_t>(m_options.maxBatchSize, 1)) {
+    batch->push_back(std::move(m_queue.front()));
+    m_queue.pop_front();
+  }
+  std::vector<boost::asio::const_buffer> buffers;
+  for (const auto& wire : *batch) {
+    buffers.emplace_back(wire.wire(), wire.size());
+  }
+
+  conn.isBusy = true;
+  conn.inFlight = batch;
+  boost::asio::async_write(conn.socket, buffers,
+    [this, &conn, batch, isAlive = std::weak_ptr<bool>(m_isAlive)] (const auto& error, size_t) {
+      if (isAlive.expired()) {
+        return;
+      }
+      conn.inFlight.reset();
+      if (error) {
+        m_metrics.nWriteFailures++;
+        // the batch may have been partially written, repo-ng ignores duplicates
+        m_queue.insert(m_queue.begin(), batch->begin(), batch->end());
+        onFailure(conn, error.message());
+        dispatch();
+        return;
+      }
+      m_metrics.nPublished += batch->size();
+      conn.isBusy = false;
+      refillFromSpill();
+      dispatch();
+    });
+}
+
+void
+RepoPublisher::watch(Connection& conn)
+{
+  conn.socket.async_read_some(boost::asio::buffer(conn.readBuffer),
+    [this, &conn, generation = conn.generation, isAlive = std::weak_ptr<bool>(m_isAlive)] (const auto& error, size_t) {
+      if (isAlive.expired() || generation != conn.generation) {
+        return;
+      }
+      if (!error) {
+        watch(conn);
+        return;
+      }
+      if (conn.isBusy) {
+        // the pending write fails as well and reestablishes the connection
+        return;
+      }
+      NDN_LOG_DEBUG("repo-ng closed the connection (" << error.message() << ")");
+      boost::system::error_code ec;
+      conn.socket.close(ec);
+      conn.isConnected = false;
+      conn.generation++;
+      dispatch();
+    });
+}
+
+void
+RepoPublisher::onFailure(Connection& conn, const std::string& reason)
+{
+  boost::system::error_code ec;
+  conn.socket.close(ec);
+  conn.isConnected = false;
+  conn.generation++;
+  conn.backoff = conn.backoff == 0_ms ? m_options.initialBackoff : std::min(conn.backoff * 2, m_options.maxBackoff);
+  NDN_LOG_WARN("Cannot publish to repo-ng at " << m_host << ":" << m_port << " (" << reason << "), retrying in "
+               << conn.backoff.count() << " ms with " << m_queue.size() + m_spillDepth << " Data pending");
+
+  conn.isBusy = true;
+  conn.timer.expires_after(std::chrono::milliseconds(conn.backoff.count()));
+  conn.timer.async_wait([this, &conn, isAlive = std::weak_ptr<bool>(m_isAlive)] (const auto& error) {
+    if (isAlive.expired() || error) {
+      return;
+    }
+    conn.isBusy = false;
+    dispatch();
+  });
+}
+
+void
+RepoPublisher::spill(const Block& wire)
+{
+  if (!m_spillWriter.is_open()) {
+    m_spillWriter.open(m_options.spillPath, std::ios::binary | std::ios::app);
+  }
+  m_spillWriter.write(reinterpret_cast<const char*>(wire.wire()), wire.size());
+  // make the Data readable by refillFromSpill()
+  m_spillWriter.flush();
+  if (!m_spillWriter) {
+    NDN_LOG_ERROR("Cannot write to the spill file " << m_options.spillPath << ", dropping Data");
+    m_spillWriter.close();
+    m_metrics.nDropped++;
+    return;
+  }
+  m_spillDepth++;
+  m_metrics.nSpilled++;
+}
+
+void
+RepoPublisher::refillFromSpill()
+{
+  if (m_spillDepth == 0 || m_queue.size() > m_options.queueCapacity / 2) {
+    return;
+  }
+
+  std::ifstream reader(m_options.spillPath, std::ios::binary);
+  reader.seekg(m_spillReadOffset);
+  try {
+    while (m_spillDepth > 0 && m_queue.size() < m_options.queueCapacity) {
+      m_queue.push_back(Block::fromStream(reader));
+      m_spillDepth--;
+      m_spillReadOffset = reader.tellg();
+    }
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_ERROR("Cannot read the spill file " << m_options.spillPath << ", dropping " << m_spillDepth
+                  << " Data (" << e.what() << ")");
+    m_metrics.nDropped += m_spillDepth;
+    m_spillDepth = 0;
+  }
+
+  if (m_spillDepth == 0) {
+    m_spillWriter.close();
+    std::ofstream(m_options.spillPath, std::ios::binary | std::ios::trunc);
+    m_spillReadOffset = 0;
+  }
+}
+
+void
+RepoPublisher::loadSpill()
+{
+  std::ifstream reader(m_options.spillPath, std::ios::binary);
+  if (!reader) {
+    return;
+  }
+
+  std::streamoff validEnd = 0;
+  try {
+    while (reader.peek() != std::char_traits<char>::eof()) {
+      static_cast<void>(Block::fromStream(reader));
+      m_spillDepth++;
+      validEnd = reader.tellg();
+    }
+  }
+  catch (const std::exception&) {
+    // the last Data was only partially spilled
+    NDN_LOG_WARN("Truncating the spill file " << m_options.spillPath << " after " << m_spillDepth << " Data");
+    reader.close();
+    boost::filesystem::resize_file(m_options.spillPath, validEnd);
+  }
+  if (m_spillDepth > 0) {
+    NDN_LOG_INFO("Republishing " << m_spillDepth << " spilled Data");
+  }
+}
+
+void
+RepoPublisher::saveSpill()
+{
+  if (m_queue.empty() && m_spillReadOffset == 0) {
+    // the spill file already holds exactly the unpublished Data
+    return;
+  }
+
+  m_spillWriter.close();
+  auto tmpPath = m_options.spillPath + ".tmp";
+  {
+    std::ofstream writer(tmpPath, std::ios::binary | std::ios::trunc);
+    // the queued Data precede the spilled ones
+    for (const auto& wire : m_queue) {
+      writer.write(reinterpret_cast<const char*>(wire.wire()), wire.size());
+    }
+    if (m_spillDepth > 0) {
+      std::ifstream reader(m_options.spillPath, std::ios::binary);
+      reader.seekg(m_spillReadOffset);
+      writer << reader.rdbuf();
+    }
+  }
+  boost::filesystem::rename(tmpPath, m_options.spillPath);
+  NDN_LOG_INFO("Saved " << m_queue.size() + m_spillDepth << " unpublished Data to " << m_options.spillPath);
+}
+
+} // namespace ndncert::ca
@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_REPO_PUBLISHER_HPP
+#define NDNCERT_DETAIL_REPO_PUBLISHER_HPP
+
+#include "detail/ndncert-common.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <deque>
+#include <fstream>
+
+namespace ndncert::ca {
+
+struct RepoPublisherOptions
+{
+  /// the number of persistent connections to repo-ng
+  size_t nConnections = 2;
+  /// the number of Data kept in memory before spilling to disk
+  size_t queueCapacity = 1024;
+  /// the maximum number of Data pipelined in a single write
+  size_t maxBatchSize = 16;
+  /// the spill file; when empty, Data published while the queue is full are dropped
+  std::string spillPath;
+  time::milliseconds initialBackoff = 100_ms;
+  time::milliseconds maxBackoff = 30_s;
+};
+
+/**
+ * @brief Publishes Data to repo-ng through its TCP bulk insertion interface.
+ *
+ * Publishing never blocks: Data are queued and written asynchronously on @p io, normally the
+ * io_context of the Face, over a pool of persistent connections. Several Data are written
+ * back to back on each connection. A connection that fails is reestablished after an
+ * exponential backoff, and the Data being written on it are queued again.
+ *
+ * When the in-memory queue is full, Data are appended to a spill file and read back once the
+ * queue has drained. The spill file, together with any Data still queued or being written upon
+ * destruction, is published again by the next publisher using the same file.
+ *
+ * repo-ng does not acknowledge insertions, so a Data is counted as published once it has been
+ * written to the socket.
+ */
+class RepoPublisher : boost::noncopyable
+{
+public:
+  struct Metrics
+  {
+    size_t queueDepth = 0;
+    size_t spillDepth = 0;
+    size_t nConnected = 0;
+    uint64_t nPublished = 0;
+    uint64_t nSpilled = 0;
+    uint64_t nDropped = 0;
+    uint64_t nConnectFailures = 0;
+    uint64_t nWriteFailures = 0;
+  };
+
+  RepoPublisher(boost::asio::io_context& io, const std::string& host, const std::string& port,
+                const RepoPublisherOptions& options = {});
+
+  ~RepoPublisher();
+
+  void
+  publish(const Data& data);
+
+  Metrics
+  getMetrics() const;
+
+private:
+  struct Connection;
+
+  void
+  dispatch();
+
+  void
+  connect(Connection& conn);
+
+  void
+  send(Connection& conn);
+
+  void
+  watch(Connection& conn);
+
+  void
+  onFailure(Connection& conn, const std::string& reason);
+
+  void
+  spill(const Block& wire);
+
+  void
+  refillFromSpill();
+
+  void
+  loadSpill();
+
+  void
+  saveSpill();
+
+private:
+  boost::asio::io_context& m_io;
+  const std::string m_host;
+  const std::string m_port;
+  const RepoPublisherOptions m_options;
+  // handlers that complete after destruction must not touch the publisher
+  std::shared_ptr<bool> m_isAlive = std::make_shared<bool>(true);
+
+  std::vector<std::unique_ptr<Connection>> m_connections;
+  std::deque<Block> m_queue;
+
+  std::ofstream m_spillWriter;
+  std::streamoff m_spillReadOffset = 0;
+  size_t m_spillDepth = 0;
+
+  Metrics m_metrics;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_REPO_PUBLISHER_HPP
@@ -29,7 +29,8 @@ namespace ndncert {
 Block
 requesttlv::encodeApplicationParameters(RequestType requestType,
                                         const std::vector<uint8_t>& ecdhPub,
-                                        const Certificate& certRequest)
+                                        const Certificate& certRequest,
+                                        const Block& embeddedChallenge)
 {
   Block request(ndn::tlv::ApplicationParameters);
   request.push_back(ndn::makeBinaryBlock(tlv::EcdhPub, ecdhPub));
@@ -39,6 +40,9 @@ requesttlv::encodeApplicationParameters(RequestType requestType,
   else if (requestType == RequestType::REVOKE) {
     request.push_back(makeNestedBlock(tlv::CertToRevoke, certRequest));
   }
+  if (embeddedChallenge.isValid()) {
+    request.push_back(Block(tlv::EmbeddedChallenge, embeddedChallenge));
+  }
   request.encode();
   return request;
 }
@@ -81,11 +85,64 @@ requesttlv::decodeApplicationParameters(const Block& payload, RequestType reques
   }
 }
 
+Block
+requesttlv::encodeRenewApplicationParameters(const Certificate& certRequest, const Certificate& certToRenew)
+{
+  Block request(ndn::tlv::ApplicationParameters);
+  request.push_back(makeNestedBlock(tlv::CertRequest, certRequest));
+  request.push_back(makeNestedBlock(tlv::CertToRenew, certToRenew));
+  request.encode();
+  return request;
+}
+
+void
+requesttlv::decodeRenewApplicationParameters(const Block& payload, std::shared_ptr<Certificate>& certRequest,
+                                             std::shared_ptr<Certificate>& certToRenew)
+{
+  payload.parse();
+
+  int certRequestCount = 0;
+  int certToRenewCount = 0;
+  for (const auto& item : payload.elements()) {
+    if (item.type() == tlv::CertRequest) {
+      item.parse();
+      certRequest = std::make_shared<Certificate>(item.get(ndn::tlv::Data));
+      certRequestCount++;
+    }
+    else if (item.type() == tlv::CertToRenew) {
+      item.parse();
+      certToRenew = std::make_shared<Certificate>(item.get(ndn::tlv::Data));
+      certToRenewCount++;
+    }
+    else if (ndn::tlv::isCriticalType(item.type())) {
+      NDN_THROW(std::runtime_error("Unrecognized TLV Type: " + std::to_string(item.type())));
+    }
+  }
+
+  if (certRequestCount != 1 || certToRenewCount != 1) {
+    NDN_THROW(std::runtime_error("Error TLV contains " + std::to_string(certRequestCount) + " certificate request(s) and " +
+                                 std::to_string(certToRenewCount) +
+                                 " certificate(s) to renew, instead of expected 1 times each."));
+  }
+}
+
+std::optional<Block>
+requesttlv::decodeEmbeddedChallenge(const Block& payload)
+{
+  payload.parse();
+  auto it = payload.find(tlv::EmbeddedChallenge);
+  if (it == payload.elements_end()) {
+    return std::nullopt;
+  }
+  return it->blockFromValue();
+}
+
 Block
 requesttlv::encodeDataContent(const std::vector<uint8_t>& ecdhKey,
                               const std::array<uint8_t, 32>& salt,
                               const RequestId& requestId,
-                              const std::vector<std::string>& challenges)
+                              const std::vector<std::string>& challenges,
+                              const Block& embeddedChallengeResponse)
 {
   Block response(ndn::tlv::Content);
   response.push_back(ndn::makeBinaryBlock(tlv::EcdhPub, ecdhKey));
@@ -94,6 +151,9 @@ requesttlv::encodeDataContent(const std::vector<uint8_t>& ecdhKey,
   for (const auto& entry: challenges) {
     response.push_back(ndn::makeStringBlock(tlv::Challenge, entry));
   }
+  if (embeddedChallengeResponse.isValid()) {
+    response.push_back(Block(tlv::EmbeddedChallengeResponse, embeddedChallengeResponse));
+  }
   response.encode();
   return response;
 }
@@ -136,4 +196,35 @@ requesttlv::decodeDataContent(const Block& content, std::vector <uint8_t>& ecdhK
   return challenges;
 }
 
+std::optional<Block>
+requesttlv::decodeEmbeddedChallengeResponse(const Block& content)
+{
+  content.parse();
+  auto it = content.find(tlv::EmbeddedChallengeResponse);
+  if (it == content.elements_end()) {
+    return std::nullopt;
+  }
+  return it->blockFromValue();
+}
+
+Block
+requesttlv::encodeRenewDataContent(const Certificate& issuedCert)
+{
+  Block response(ndn::tlv::Content);
+  response.push_back(Block(tlv::IssuedCert, issuedCert.wireEncode()));
+  response.encode();
+  return response;
+}
+
+std::shared_ptr<Certificate>
+requesttlv::decodeRenewDataContent(const Block& content)
+{
+  content.parse();
+  auto it = content.find(tlv::IssuedCert);
+  if (it == content.elements_end()) {
+    NDN_THROW(std::runtime_error("No issued certificate in the RENEW response."));
+  }
+  return std::make_shared<Certificate>(it->blockFromValue());
+}
+
 } // namespace ndncert
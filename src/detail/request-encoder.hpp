@@ -25,22 +25,64 @@
 
 namespace ndncert::requesttlv {
 
+/**
+ * @param embeddedChallenge the first round of a challenge carried by the NEW Interest,
+ *                          as returned by ChallengeModule::genChallengeRequestTLV(), if any.
+ */
 Block
 encodeApplicationParameters(RequestType requestType, const std::vector<uint8_t>& ecdhPub,
-                            const Certificate& certRequest);
+                            const Certificate& certRequest, const Block& embeddedChallenge = {});
 
 void
 decodeApplicationParameters(const Block& block, RequestType requestType, std::vector<uint8_t>& ecdhPub,
                             std::shared_ptr<Certificate>& certRequest);
 
+/**
+ * @brief Encodes the parameters of a RENEW Interest, which carry no ECDH key since no challenge follows.
+ */
+Block
+encodeRenewApplicationParameters(const Certificate& certRequest, const Certificate& certToRenew);
+
+void
+decodeRenewApplicationParameters(const Block& block, std::shared_ptr<Certificate>& certRequest,
+                                 std::shared_ptr<Certificate>& certToRenew);
+
+/**
+ * @brief The first round of a challenge carried by the NEW Interest, in the format of the
+ *        plaintext of a CHALLENGE Interest, if any.
+ */
+std::optional<Block>
+decodeEmbeddedChallenge(const Block& block);
+
+/**
+ * @param embeddedChallengeResponse the encrypted reply to the embedded challenge, as returned
+ *                                  by challengetlv::encodeDataContent(), if any.
+ */
 Block
 encodeDataContent(const std::vector<uint8_t>& ecdhKey, const std::array<uint8_t, 32>& salt,
-                  const RequestId& requestId, const std::vector<std::string>& challenges);
+                  const RequestId& requestId, const std::vector<std::string>& challenges,
+                  const Block& embeddedChallengeResponse = {});
 
 std::list<std::string>
 decodeDataContent(const Block& content, std::vector<uint8_t>& ecdhKey,
                   std::array<uint8_t, 32>& salt, RequestId& requestId);
 
+/**
+ * @brief The encrypted reply to the embedded challenge, to be decoded with
+ *        challengetlv::decodeDataContent(), if any.
+ */
+std::optional<Block>
+decodeEmbeddedChallengeResponse(const Block& content);
+
+Block
+encodeRenewDataContent(const Certificate& issuedCert);
+
+/**
+ * @throw std::runtime_error the content does not carry a certificate.
+ */
+std::shared_ptr<Certificate>
+decodeRenewDataContent(const Block& content);
+
 } // namespace ndncert::requesttlv
 
 #endif // NDNCERT_DETAIL_REQUEST_ENCODER_HPP
@@ -0,0 +1,69 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/revocation-encoder.hpp"
+
+namespace ndncert {
+
+CertDigest
+getCertDigest(const Certificate& cert)
+{
+  auto digest = cert.getFullName().at(-1);
+  CertDigest result;
+  std::memcpy(result.data(), digest.value(), result.size());
+  return result;
+}
+
+Name
+revocationtlv::makeDatasetName(const Name& caPrefix, uint64_t version, std::optional<uint64_t> since)
+{
+  Name name(caPrefix);
+  name.append("CA").append("REVOKED").appendVersion(version);
+  if (since) {
+    name.append(DELTA_COMPONENT).appendVersion(*since);
+  }
+  return name;
+}
+
+Block
+revocationtlv::encodeDataContent(const CertDigest* begin, const CertDigest* end)
+{
+  std::vector<uint8_t> digests;
+  digests.reserve((end - begin) * sizeof(CertDigest));
+  for (auto it = begin; it != end; ++it) {
+    digests.insert(digests.end(), it->begin(), it->end());
+  }
+  return ndn::makeBinaryBlock(ndn::tlv::Content, digests);
+}
+
+std::vector<CertDigest>
+revocationtlv::decodeDataContent(const Block& content)
+{
+  if (content.value_size() % sizeof(CertDigest) != 0) {
+    NDN_THROW(std::runtime_error("Revocation dataset segment is not a sequence of digests"));
+  }
+  std::vector<CertDigest> digests(content.value_size() / sizeof(CertDigest));
+  if (!digests.empty()) {
+    std::memcpy(digests.data(), content.value(), content.value_size());
+  }
+  return digests;
+}
+
+} // namespace ndncert
@@ -0,0 +1,71 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_REVOCATION_ENCODER_HPP
+#define NDNCERT_DETAIL_REVOCATION_ENCODER_HPP
+
+#include "detail/ndncert-common.hpp"
+
+namespace ndncert {
+
+/**
+ * @brief The implicit SHA-256 digest of a certificate, which is the last component of its full name.
+ */
+using CertDigest = std::array<uint8_t, 32>;
+
+CertDigest
+getCertDigest(const Certificate& cert);
+
+} // namespace ndncert
+
+/**
+ * @brief The revocation dataset published under /<CA-prefix>/CA/REVOKED.
+ *
+ * The dataset at version N lists the digests of the certificates revoked by the N first
+ * revocations, in ascending order, and is named /<CA-prefix>/CA/REVOKED/v=N. The changes from
+ * version M to version N, which list the digests revoked since version M, are named
+ * /<CA-prefix>/CA/REVOKED/v=N/DELTA/v=M. Both are segmented, each segment carrying up to
+ * DIGESTS_PER_SEGMENT digests concatenated, and the latest version is discovered with an RDR
+ * metadata Interest.
+ */
+namespace ndncert::revocationtlv {
+
+const size_t DIGESTS_PER_SEGMENT = 128;
+
+const ndn::name::Component DELTA_COMPONENT("DELTA");
+
+/**
+ * @brief The name of the dataset at @p version, or of the changes to it since @p since.
+ */
+Name
+makeDatasetName(const Name& caPrefix, uint64_t version, std::optional<uint64_t> since = std::nullopt);
+
+Block
+encodeDataContent(const CertDigest* begin, const CertDigest* end);
+
+/**
+ * @throw std::runtime_error the content is not a sequence of digests.
+ */
+std::vector<CertDigest>
+decodeDataContent(const Block& content);
+
+} // namespace ndncert::revocationtlv
+
+#endif // NDNCERT_DETAIL_REVOCATION_ENCODER_HPP
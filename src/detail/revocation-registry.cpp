@@ -0,0 +1,216 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/revocation-registry.hpp"
+
+#include <sqlite3.h>
+
+#include <ndn-cxx/util/sqlite3-statement.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+
+namespace ndncert::ca {
+
+NDN_LOG_INIT(ndncert.ca.revocation);
+
+using ndn::util::Sqlite3Statement;
+
+// how long a statement waits for a lock held by another connection to the database
+const int BUSY_TIMEOUT_MS = 5000;
+
+const std::string INITIALIZATION = R"SQL(
+CREATE TABLE IF NOT EXISTS
+  Revocations(
+    version INTEGER PRIMARY KEY,
+    digest BLOB NOT NULL,
+    cert_name BLOB NOT NULL,
+    revoked_at INTEGER NOT NULL
+  );
+CREATE UNIQUE INDEX IF NOT EXISTS
+  RevocationsDigestIndex ON Revocations(digest);
+)SQL";
+
+RevocationRegistry::RevocationRegistry(const Name& caName, const std::string& path)
+{
+  boost::filesystem::path dbPath;
+  if (!path.empty()) {
+    dbPath = boost::filesystem::path(path);
+  }
+  else {
+    std::string dbName = caName.toUri();
+    std::replace(dbName.begin(), dbName.end(), '/', '_');
+    dbName += ".revoked.db";
+    if (getenv("HOME") != nullptr) {
+      dbPath = boost::filesystem::path(getenv("HOME")) / ".ndncert";
+    }
+    else {
+      dbPath = boost::filesystem::current_path() / ".ndncert";
+    }
+    boost::filesystem::create_directories(dbPath);
+    dbPath /= dbName;
+  }
+
+  int result = sqlite3_open_v2(dbPath.c_str(), &m_database,
+                               SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+#ifdef NDN_CXX_DISABLE_SQLITE3_FS_LOCKING
+                               "unix-dotfile"
+#else
+                               nullptr
+#endif
+  );
+  if (result != SQLITE_OK) {
+    NDN_THROW(std::runtime_error("RevocationRegistry DB cannot be opened/created: " + dbPath.string()));
+  }
+  sqlite3_busy_timeout(m_database, BUSY_TIMEOUT_MS);
+
+  char* errorMessage = nullptr;
+  result = sqlite3_exec(m_database, INITIALIZATION.data(), nullptr, nullptr, &errorMessage);
+  if (result != SQLITE_OK && errorMessage != nullptr) {
+    sqlite3_free(errorMessage);
+    NDN_THROW(std::runtime_error("RevocationRegistry DB cannot be initialized"));
+  }
+
+  reloadLocked();
+  NDN_LOG_DEBUG("Loaded " << m_log.size() << " revocations from " << dbPath.string());
+}
+
+RevocationRegistry::~RevocationRegistry()
+{
+  sqlite3_close(m_database);
+}
+
+bool
+RevocationRegistry::revoke(const Certificate& cert)
+{
+  auto digest = getCertDigest(cert);
+  const auto& name = cert.getName().wireEncode();
+  std::lock_guard lock(m_mutex);
+
+  // the write lock is taken at once, so that no other process allocates the same version
+  if (sqlite3_exec(m_database, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr) != SQLITE_OK) {
+    NDN_THROW(std::runtime_error("Revocation of " + cert.getName().toUri() + " cannot start a transaction: " +
+                                 sqlite3_errmsg(m_database)));
+  }
+  try {
+    reloadLocked();
+    if (m_revoked.count(digest) != 0) {
+      sqlite3_exec(m_database, "COMMIT", nullptr, nullptr, nullptr);
+      return false;
+    }
+
+    Sqlite3Statement maxVersion(m_database, "SELECT COALESCE(MAX(version), 0) FROM Revocations");
+    if (maxVersion.step() != SQLITE_ROW) {
+      NDN_THROW(std::runtime_error("Revocation of " + cert.getName().toUri() + " cannot allocate a version"));
+    }
+    uint64_t version = sqlite3_column_int64(maxVersion, 0) + 1;
+
+    Sqlite3Statement statement(m_database,
+                               R"SQL(INSERT INTO Revocations (version, digest, cert_name, revoked_at)
+                               VALUES (?, ?, ?, ?))SQL");
+    sqlite3_bind_int64(statement, 1, version);
+    statement.bind(2, digest.data(), digest.size(), SQLITE_TRANSIENT);
+    statement.bind(3, name.value(), name.value_size(), SQLITE_TRANSIENT);
+    sqlite3_bind_int64(statement, 4, time::toUnixTimestamp(time::system_clock::now()).count());
+    if (statement.step() != SQLITE_DONE) {
+      NDN_THROW(std::runtime_error("Revocation of " + cert.getName().toUri() + " cannot be added to the database"));
+    }
+    if (sqlite3_exec(m_database, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK) {
+      NDN_THROW(std::runtime_error("Revocation of " + cert.getName().toUri() + " cannot be committed: " +
+                                   sqlite3_errmsg(m_database)));
+    }
+    m_log.push_back(digest);
+    m_revoked.insert(digest);
+    NDN_LOG_DEBUG("Revoked " << cert.getName() << " at version " << version);
+  }
+  catch (const std::exception&) {
+    sqlite3_exec(m_database, "ROLLBACK", nullptr, nullptr, nullptr);
+    throw;
+  }
+  return true;
+}
+
+bool
+RevocationRegistry::isRevoked(const Certificate& cert) const
+{
+  return isRevoked(getCertDigest(cert));
+}
+
+bool
+RevocationRegistry::isRevoked(const CertDigest& digest) const
+{
+  std::lock_guard lock(m_mutex);
+  reloadLocked();
+  return m_revoked.count(digest) != 0;
+}
+
+uint64_t
+RevocationRegistry::getVersion() const
+{
+  std::lock_guard lock(m_mutex);
+  reloadLocked();
+  return m_log.size();
+}
+
+std::vector<CertDigest>
+RevocationRegistry::list(uint64_t until, uint64_t since) const
+{
+  std::unique_lock lock(m_mutex);
+  reloadLocked();
+  if (since > until || until > m_log.size()) {
+    NDN_THROW(std::out_of_range("Revocation registry has no version " + std::to_string(until) +
+                                " since version " + std::to_string(since)));
+  }
+  std::vector<CertDigest> digests(m_log.begin() + since, m_log.begin() + until);
+  lock.unlock();
+  std::sort(digests.begin(), digests.end());
+  return digests;
+}
+
+void
+RevocationRegistry::reloadLocked() const
+{
+  // data_version only changes when another connection commits to the database
+  Sqlite3Statement dataVersion(m_database, "PRAGMA data_version");
+  if (dataVersion.step() != SQLITE_ROW) {
+    NDN_THROW(std::runtime_error("RevocationRegistry DB cannot be read"));
+  }
+  auto current = sqlite3_column_int64(dataVersion, 0);
+  if (current == m_dataVersion) {
+    return;
+  }
+  m_dataVersion = current;
+
+  Sqlite3Statement statement(m_database, "SELECT version, digest FROM Revocations WHERE version > ? ORDER BY version");
+  sqlite3_bind_int64(statement, 1, m_log.size());
+  while (statement.step() == SQLITE_ROW) {
+    CertDigest digest;
+    if (static_cast<uint64_t>(sqlite3_column_int64(statement, 0)) != m_log.size() + 1 ||
+        statement.getSize(1) != static_cast<int>(digest.size())) {
+      NDN_THROW(std::runtime_error("RevocationRegistry DB holds an invalid revocation"));
+    }
+    std::memcpy(digest.data(), statement.getBlob(1), digest.size());
+    m_log.push_back(digest);
+    m_revoked.insert(digest);
+  }
+}
+
+} // namespace ndncert::ca
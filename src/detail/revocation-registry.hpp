@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_REVOCATION_REGISTRY_HPP
+#define NDNCERT_DETAIL_REVOCATION_REGISTRY_HPP
+
+#include "detail/revocation-encoder.hpp"
+
+#include <mutex>
+#include <set>
+
+struct sqlite3;
+
+namespace ndncert::ca {
+
+/**
+ * @brief Persistent registry of the certificates revoked by a CA.
+ *
+ * Each revocation records the digest of a certificate and increments the version of the
+ * registry, so that version N is the state after the N first revocations. The revocations are
+ * kept in an sqlite3 database and mirrored in memory in revocation order, from which the
+ * revocation dataset at any version, and the changes between two versions, are listed. The
+ * registry may be shared by several threads.
+ *
+ * Several processes serving the same CA, e.g., shards, may also share the database: versions
+ * are allocated in a transaction, and the revocations committed by the other processes are
+ * loaded before the registry is read.
+ */
+class RevocationRegistry : boost::noncopyable
+{
+public:
+  /**
+   * @param path The database file; by default, "$HOME/.ndncert/<CA name>.revoked.db". With
+   *             ":memory:", the revocations are only kept in memory and lost on restart.
+   */
+  explicit
+  RevocationRegistry(const Name& caName, const std::string& path = "");
+
+  ~RevocationRegistry();
+
+  /**
+   * @brief Revoke @p cert.
+   * @return false if it was already revoked, in which case the version is unchanged.
+   */
+  bool
+  revoke(const Certificate& cert);
+
+  bool
+  isRevoked(const Certificate& cert) const;
+
+  bool
+  isRevoked(const CertDigest& digest) const;
+
+  uint64_t
+  getVersion() const;
+
+  /**
+   * @brief List, in ascending order, the digests revoked after version @p since up to version @p until.
+   * @throw std::out_of_range @p since is greater than @p until, or @p until than the current version.
+   */
+  std::vector<CertDigest>
+  list(uint64_t until, uint64_t since = 0) const;
+
+private:
+  /**
+   * @brief Load the revocations committed by other connections to the database.
+   */
+  void
+  reloadLocked() const;
+
+private:
+  sqlite3* m_database = nullptr;
+  mutable int64_t m_dataVersion = -1;
+  mutable std::vector<CertDigest> m_log;
+  mutable std::set<CertDigest> m_revoked;
+  mutable std::mutex m_mutex;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_REVOCATION_REGISTRY_HPP
@@ -0,0 +1,781 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/smtp-mailer.hpp"
+
+#include <ndn-cxx/security/transform/base64-encode.hpp>
+#include <ndn-cxx/security/transform/buffer-source.hpp>
+#include <ndn-cxx/security/transform/stream-sink.hpp>
+#include <ndn-cxx/util/random.hpp>
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/host_name.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/property_tree/ini_parser.hpp>
+#include <boost/version.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+
+namespace ndncert::ca {
+
+NDN_LOG_INIT(ndncert.smtp);
+
+using boost::asio::ip::tcp;
+using SslStream = boost::asio::ssl::stream<tcp::socket>;
+
+static std::string
+toBase64(const std::string& input, bool wantNewlines)
+{
+  namespace tr = ndn::security::transform;
+  std::ostringstream os;
+  tr::bufferSource(ndn::make_span(reinterpret_cast<const uint8_t*>(input.data()), input.size()))
+    >> tr::base64Encode(wantNewlines) >> tr::streamSink(os);
+  auto output = os.str();
+  // SMTP lines end with CRLF
+  boost::replace_all(output, "\n", "\r\n");
+  return output;
+}
+
+SmtpConfig
+SmtpConfig::load(const std::string& fileName)
+{
+  boost::property_tree::ptree ini;
+  try {
+    boost::property_tree::read_ini(fileName, ini);
+  }
+  catch (const std::exception& error) {
+    NDN_THROW(std::runtime_error("Failed to parse email configuration file " + fileName + ", " + error.what()));
+  }
+
+  SmtpConfig config;
+  config.server = ini.get("ndncert_smtp_settings.SMTP_SERVER", "");
+  config.port = ini.get("ndncert_smtp_settings.SMTP_PORT", config.port);
+  auto encryptMode = boost::algorithm::to_lower_copy(ini.get("ndncert_smtp_settings.ENCRYPT_MODE", "none"));
+  if (encryptMode == "none") {
+    config.encryption = Encryption::NONE;
+  }
+  else if (encryptMode == "ssl") {
+    config.encryption = Encryption::SSL;
+  }
+  else if (encryptMode == "tls") {
+    config.encryption = Encryption::TLS;
+  }
+  else {
+    NDN_THROW(std::runtime_error("Unknown ENCRYPT_MODE " + encryptMode + " in " + fileName));
+  }
+  config.user = ini.get("ndncert_smtp_settings.SMTP_USER", "");
+  config.password = ini.get("ndncert_smtp_settings.SMTP_PASSWORD", "");
+
+  config.mailFrom = ini.get("ndncert_email_settings.MAIL_FROM", "");
+  config.subject = ini.get("ndncert_email_settings.SUBJECT", "");
+  config.textTemplate = ini.get("ndncert_email_settings.TEXT_TEMPLATE", "");
+  config.htmlTemplate = ini.get("ndncert_email_settings.HTML_TEMPLATE", "");
+
+  if (config.server.empty() || config.mailFrom.empty()) {
+    NDN_THROW(std::runtime_error("SMTP_SERVER and MAIL_FROM must be set in " + fileName));
+  }
+  return config;
+}
+
+struct SmtpMailer::Connection
+{
+  explicit
+  Connection(boost::asio::io_context& io)
+    : resolver(io)
+    , timer(io)
+  {
+  }
+
+  template<typename Handler>
+  void
+  write(const std::shared_ptr<const std::string>& data, Handler&& handler)
+  {
+    if (isTls) {
+      boost::asio::async_write(*stream, boost::asio::buffer(*data), std::forward<Handler>(handler));
+    }
+    else {
+      boost::asio::async_write(stream->next_layer(), boost::asio::buffer(*data), std::forward<Handler>(handler));
+    }
+  }
+
+  template<typename Handler>
+  void
+  readLine(Handler&& handler)
+  {
+    if (isTls) {
+      boost::asio::async_read_until(*stream, readBuffer, "\r\n", std::forward<Handler>(handler));
+    }
+    else {
+      boost::asio::async_read_until(stream->next_layer(), readBuffer, "\r\n", std::forward<Handler>(handler));
+    }
+  }
+
+  // a TLS stream cannot be reused once closed, each connection attempt gets a new one
+  std::unique_ptr<SslStream> stream;
+  tcp::resolver resolver;
+  boost::asio::steady_timer timer;
+  boost::asio::streambuf readBuffer;
+  // identifies the stream on which a completion handler was started
+  uint64_t generation = 0;
+  bool isTls = false;
+  // greeted, secured and authenticated
+  bool isConnected = false;
+  // connecting, delivering, or waiting for the backoff to expire
+  bool isBusy = false;
+  // whether the server accepted MAIL FROM for the first email of the batch
+  bool isDelivering = false;
+  time::milliseconds backoff = 0_ms;
+  std::string extensions;
+  std::deque<Message> batch;
+};
+
+SmtpMailer::SmtpMailer(boost::asio::io_context& io, const SmtpConfig& config, const SmtpMailerOptions& options)
+  : m_io(io)
+  , m_config(config)
+  , m_options(options)
+  , m_sslContext(std::make_unique<boost::asio::ssl::context>(boost::asio::ssl::context::sslv23_client))
+  , m_dispatchTimer(io)
+{
+  // "Name <address>" or "address"
+  auto begin = m_config.mailFrom.rfind('<');
+  auto end = m_config.mailFrom.rfind('>');
+  if (begin != std::string::npos && end != std::string::npos && begin < end) {
+    m_envelopeFrom = m_config.mailFrom.substr(begin + 1, end - begin - 1);
+  }
+  else {
+    m_envelopeFrom = boost::algorithm::trim_copy(m_config.mailFrom);
+  }
+
+  m_sslContext->set_options(boost::asio::ssl::context::default_workarounds |
+                            boost::asio::ssl::context::no_sslv2 |
+                            boost::asio::ssl::context::no_sslv3 |
+                            boost::asio::ssl::context::no_tlsv1 |
+                            boost::asio::ssl::context::no_tlsv1_1);
+  m_sslContext->set_default_verify_paths();
+  m_sslContext->set_verify_mode(boost::asio::ssl::verify_peer);
+
+  for (size_t i = 0; i < std::max<size_t>(m_options.nConnections, 1); i++) {
+    m_connections.push_back(std::make_unique<Connection>(m_io));
+  }
+}
+
+SmtpMailer::~SmtpMailer()
+{
+  *m_isAlive = false;
+  m_dispatchTimer.cancel();
+  size_t nPending = m_queue.size();
+  for (auto& conn : m_connections) {
+    nPending += conn->batch.size();
+    close(*conn);
+  }
+  if (nPending > 0) {
+    NDN_LOG_WARN("Discarding " << nPending << " undelivered emails");
+  }
+}
+
+bool
+SmtpMailer::send(const std::string& emailAddress, const std::string& secret,
+                 const Name& caPrefix, const Name& certName)
+{
+  Message message;
+  message.recipient = emailAddress;
+  message.domain = boost::algorithm::to_lower_copy(emailAddress.substr(emailAddress.rfind('@') + 1));
+  message.body = formatMessage(emailAddress, secret, caPrefix, certName);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_queue.size() >= m_options.queueCapacity) {
+      NDN_LOG_WARN("Email queue is full, not sending to " << emailAddress);
+      return false;
+    }
+    m_queue.push_back(std::move(message));
+  }
+  boost::asio::post(m_io, [this, isAlive = std::weak_ptr<bool>(m_isAlive)] {
+    if (!isAlive.expired()) {
+      dispatch();
+    }
+  });
+  return true;
+}
+
+SmtpMailer::Metrics
+SmtpMailer::getMetrics() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Metrics metrics = m_metrics;
+  metrics.queueDepth = m_queue.size();
+  return metrics;
+}
+
+std::string
+SmtpMailer::formatMessage(const std::string& emailAddress, const std::string& secret,
+                          const Name& caPrefix, const Name& certName) const
+{
+  auto fill = [&] (std::string text) {
+    boost::replace_all(text, "{0}", secret);
+    boost::replace_all(text, "{1}", caPrefix.toUri());
+    boost::replace_all(text, "{2}", certName.toUri());
+    return text;
+  };
+
+  auto now = time::system_clock::to_time_t(time::system_clock::now());
+  std::tm tm{};
+  ::gmtime_r(&now, &tm);
+  char date[64];
+  std::strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S +0000", &tm);
+
+  auto boundary = "ndncert-" + std::to_string(ndn::random::generateWord64());
+  std::ostringstream os;
+  os << "From: " << m_config.mailFrom << "\r\n"
+     << "To: " << emailAddress << "\r\n"
+     << "Subject: " << m_config.subject << "\r\n"
+     << "Date: " << date << "\r\n"
+     << "Message-ID: <" << ndn::random::generateWord64() << "."
+     << m_envelopeFrom.substr(m_envelopeFrom.rfind('@') + 1) << ">\r\n"
+     << "MIME-Version: 1.0\r\n"
+     << "Content-Type: multipart/alternative; boundary=\"" << boundary << "\"\r\n"
+     << "\r\n";
+  // base64 keeps the lines short and never starts one with a dot, so nothing needs to be stuffed
+  for (const auto& [subtype, text] : {std::make_pair("plain", &m_config.textTemplate),
+                                      std::make_pair("html", &m_config.htmlTemplate)}) {
+    if (text->empty()) {
+      continue;
+    }
+    auto encoded = toBase64(fill(*text), true);
+    if (!boost::ends_with(encoded, "\r\n")) {
+      encoded += "\r\n";
+    }
+    os << "--" << boundary << "\r\n"
+       << "Content-Type: text/" << subtype << "; charset=\"utf-8\"\r\n"
+       << "Content-Transfer-Encoding: base64\r\n"
+       << "\r\n"
+       << encoded;
+  }
+  os << "--" << boundary << "--\r\n"
+     << ".";
+  return os.str();
+}
+
+void
+SmtpMailer::dispatch()
+{
+  for (auto& conn : m_connections) {
+    if (conn->isBusy) {
+      continue;
+    }
+    if (!takeBatch(*conn)) {
+      return;
+    }
+    if (conn->isConnected) {
+      conn->isBusy = true;
+      deliver(*conn);
+    }
+    else {
+      connect(*conn);
+    }
+  }
+}
+
+bool
+SmtpMailer::takeBatch(Connection& conn)
+{
+  auto now = time::steady_clock::now();
+  std::optional<time::steady_clock::time_point> nextTry;
+  auto postpone = [&] (time::steady_clock::time_point when) {
+    nextTry = nextTry ? std::min(*nextTry, when) : when;
+  };
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_queue.begin();
+    while (it != m_queue.end() && conn.batch.size() < std::max<size_t>(m_options.maxBatchSize, 1)) {
+      if (it->notBefore > now) {
+        postpone(it->notBefore);
+        ++it;
+        continue;
+      }
+      auto bucket = findDomainBucket(it->domain);
+      if (bucket != nullptr) {
+        if (!bucket->canConsume()) {
+          if (m_options.domainLimit->rate > 0) {
+            auto wait = (1 - bucket->getTokens()) / m_options.domainLimit->rate;
+            postpone(now + time::microseconds(static_cast<int64_t>(wait * 1e6) + 1000));
+          }
+          ++it;
+          continue;
+        }
+        bucket->consume();
+      }
+      conn.batch.push_back(std::move(*it));
+      it = m_queue.erase(it);
+    }
+  }
+
+  if (nextTry) {
+    scheduleDispatch(*nextTry);
+  }
+  return !conn.batch.empty();
+}
+
+void
+SmtpMailer::connect(Connection& conn)
+{
+  conn.isBusy = true;
+  auto generation = ++conn.generation;
+  conn.stream = std::make_unique<SslStream>(m_io, *m_sslContext);
+  conn.isTls = false;
+  conn.readBuffer.consume(conn.readBuffer.size());
+  arm(conn, m_options.commandTimeout);
+
+  std::weak_ptr<bool> isAlive(m_isAlive);
+  conn.resolver.async_resolve(m_config.server, m_config.port,
+    [this, &conn, generation, isAlive] (const auto& error, const tcp::resolver::results_type& endpoints) {
+      if (isAlive.expired() || generation != conn.generation) {
+        return;
+      }
+      if (error) {
+        onFailure(conn, error.message());
+        return;
+      }
+      boost::asio::async_connect(conn.stream->next_layer(), endpoints,
+        [this, &conn, generation, isAlive] (const auto& error, const tcp::endpoint&) {
+          if (isAlive.expired() || generation != conn.generation) {
+            return;
+          }
+          if (error) {
+            onFailure(conn, error.message());
+            return;
+          }
+          auto greet = [this, &conn] {
+            readReply(conn, [this, &conn] (int code, const std::string& text) {
+              if (code != 220) {
+                onFailure(conn, "unexpected greeting " + std::to_string(code) + " " + text);
+                return;
+              }
+              hello(conn);
+            });
+          };
+          if (m_config.encryption == SmtpConfig::Encryption::SSL) {
+            handshake(conn, greet);
+          }
+          else {
+            greet();
+          }
+        });
+    });
+}
+
+void
+SmtpMailer::handshake(Connection& conn, std::function<void()> next)
+{
+  // server name indication, and verification of the certificate against the server name
+  ::SSL_set_tlsext_host_name(conn.stream->native_handle(), m_config.server.data());
+#if BOOST_VERSION >= 107300
+  conn.stream->set_verify_callback(boost::asio::ssl::host_name_verification(m_config.server));
+#else
+  conn.stream->set_verify_callback(boost::asio::ssl::rfc2818_verification(m_config.server));
+#endif
+
+  arm(conn, m_options.commandTimeout);
+  conn.stream->async_handshake(boost::asio::ssl::stream_base::client,
+    [this, &conn, next, generation = conn.generation, isAlive = std::weak_ptr<bool>(m_isAlive)] (const auto& error) {
+      if (isAlive.expired() || generation != conn.generation) {
+        return;
+      }
+      if (error) {
+        onFailure(conn, "TLS handshake failed (" + error.message() + ")");
+        return;
+      }
+      conn.isTls = true;
+      next();
+    });
+}
+
+void
+SmtpMailer::hello(Connection& conn)
+{
+  command(conn, "EHLO " + boost::asio::ip::host_name(), [this, &conn] (int code, const std::string& text) {
+    if (code != 250) {
+      onFailure(conn, "EHLO refused with " + std::to_string(code) + " " + text);
+      return;
+    }
+    conn.extensions = boost::algorithm::to_upper_copy(text);
+    if (m_config.encryption == SmtpConfig::Encryption::TLS && !conn.isTls) {
+      startTls(conn);
+    }
+    else if (!m_config.user.empty() && !m_config.password.empty()) {
+      authenticate(conn);
+    }
+    else {
+      onConnected(conn);
+    }
+  });
+}
+
+void
+SmtpMailer::startTls(Connection& conn)
+{
+  if (conn.extensions.find("STARTTLS") == std::string::npos) {
+    onFailure(conn, "the server does not offer STARTTLS");
+    return;
+  }
+  command(conn, "STARTTLS", [this, &conn] (int code, const std::string& text) {
+    if (code != 220) {
+      onFailure(conn, "STARTTLS refused with " + std::to_string(code) + " " + text);
+      return;
+    }
+    // the extensions are announced again over TLS
+    handshake(conn, [this, &conn] { hello(conn); });
+  });
+}
+
+void
+SmtpMailer::authenticate(Connection& conn)
+{
+  auto credentials = toBase64(std::string(1, '\0') + m_config.user + std::string(1, '\0') + m_config.password, false);
+  command(conn, "AUTH PLAIN " + credentials, [this, &conn] (int code, const std::string& text) {
+    if (code != 235) {
+      onFailure(conn, "authentication failed with " + std::to_string(code) + " " + text);
+      return;
+    }
+    onConnected(conn);
+  });
+}
+
+void
+SmtpMailer::onConnected(Connection& conn)
+{
+  NDN_LOG_DEBUG("Connected to SMTP server " << m_config.server << ":" << m_config.port
+                << (conn.isTls ? " over TLS" : ""));
+  conn.isConnected = true;
+  conn.backoff = 0_ms;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_metrics.nConnected++;
+  }
+  deliver(conn);
+}
+
+void
+SmtpMailer::deliver(Connection& conn)
+{
+  if (conn.batch.empty()) {
+    conn.isBusy = false;
+    dispatch();
+    if (!conn.isBusy) {
+      idle(conn);
+    }
+    return;
+  }
+
+  command(conn, "MAIL FROM:<" + m_envelopeFrom + ">", [this, &conn] (int code, const std::string& text) {
+    if (code / 100 != 2) {
+      onRefused(conn, code, text);
+      return;
+    }
+    conn.isDelivering = true;
+    command(conn, "RCPT TO:<" + conn.batch.front().recipient + ">", [this, &conn] (int code, const std::string& text) {
+      if (code / 100 != 2) {
+        onRefused(conn, code, text);
+        return;
+      }
+      command(conn, "DATA", [this, &conn] (int code, const std::string& text) {
+        if (code != 354) {
+          onRefused(conn, code, text);
+          return;
+        }
+        command(conn, conn.batch.front().body, [this, &conn] (int code, const std::string& text) {
+          if (code / 100 != 2) {
+            onRefused(conn, code, text);
+            return;
+          }
+          onDelivered(conn);
+        });
+      });
+    });
+  });
+}
+
+void
+SmtpMailer::onDelivered(Connection& conn)
+{
+  NDN_LOG_TRACE("Delivered email to " << conn.batch.front().recipient);
+  conn.batch.pop_front();
+  conn.isDelivering = false;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_metrics.nSent++;
+  }
+  deliver(conn);
+}
+
+void
+SmtpMailer::onRefused(Connection& conn, int code, const std::string& text)
+{
+  auto message = std::move(conn.batch.front());
+  conn.batch.pop_front();
+  conn.isDelivering = false;
+  auto reason = std::to_string(code) + " " + text;
+  if (code / 100 == 4) {
+    retry(std::move(message), reason);
+  }
+  else {
+    NDN_LOG_WARN("SMTP server refused the email to " << message.recipient << " (" << reason << ")");
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_metrics.nRejected++;
+  }
+
+  command(conn, "RSET", [this, &conn] (int code, const std::string& text) {
+    if (code / 100 != 2) {
+      onFailure(conn, "RSET refused with " + std::to_string(code) + " " + text);
+      return;
+    }
+    deliver(conn);
+  });
+}
+
+void
+SmtpMailer::idle(Connection& conn)
+{
+  conn.timer.expires_after(std::chrono::milliseconds(m_options.idleTimeout.count()));
+  conn.timer.async_wait(
+    [this, &conn, generation = conn.generation, isAlive = std::weak_ptr<bool>(m_isAlive)] (const auto& error) {
+      if (isAlive.expired() || error || generation != conn.generation || conn.isBusy) {
+        return;
+      }
+      NDN_LOG_DEBUG("Closing idle connection to SMTP server " << m_config.server << ":" << m_config.port);
+      auto quit = std::make_shared<const std::string>("QUIT\r\n");
+      conn.write(quit, [this, &conn, quit, generation, isAlive] (const auto&, size_t) {
+        if (!isAlive.expired() && generation == conn.generation && !conn.isBusy) {
+          close(conn);
+        }
+      });
+    });
+}
+
+void
+SmtpMailer::command(Connection& conn, const std::string& line, ReplyCallback callback)
+{
+  auto data = std::make_shared<const std::string>(line + "\r\n");
+  conn.write(data,
+    [this, &conn, data, callback = std::move(callback), generation = conn.generation,
+     isAlive = std::weak_ptr<bool>(m_isAlive)] (const auto& error, size_t) {
+      if (isAlive.expired() || generation != conn.generation) {
+        return;
+      }
+      if (error) {
+        onFailure(conn, error.message());
+        return;
+      }
+      readReply(conn, std::move(callback));
+    });
+}
+
+void
+SmtpMailer::readReply(Connection& conn, ReplyCallback callback, std::string text)
+{
+  arm(conn, m_options.commandTimeout);
+  conn.readLine(
+    [this, &conn, callback = std::move(callback), text = std::move(text), generation = conn.generation,
+     isAlive = std::weak_ptr<bool>(m_isAlive)] (const auto& error, size_t) mutable {
+      if (isAlive.expired() || generation != conn.generation) {
+        return;
+      }
+      if (error) {
+        onFailure(conn, error.message());
+        return;
+      }
+      std::istream is(&conn.readBuffer);
+      std::string line;
+      std::getline(is, line);
+      if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+      }
+      if (line.size() < 3 || !std::all_of(line.begin(), line.begin() + 3, [] (unsigned char c) { return std::isdigit(c); })) {
+        onFailure(conn, "malformed reply " + line);
+        return;
+      }
+      if (line.size() > 3) {
+        text += line.substr(4) + "\n";
+      }
+      // the lines of a multiline reply but the last one have a hyphen after the code
+      if (line.size() > 3 && line[3] == '-') {
+        readReply(conn, std::move(callback), std::move(text));
+        return;
+      }
+      conn.timer.cancel();
+      if (!text.empty()) {
+        text.pop_back();
+      }
+      callback(std::stoi(line.substr(0, 3)), text);
+    });
+}
+
+void
+SmtpMailer::arm(Connection& conn, time::milliseconds timeout)
+{
+  conn.timer.expires_after(std::chrono::milliseconds(timeout.count()));
+  conn.timer.async_wait(
+    [this, &conn, generation = conn.generation, isAlive = std::weak_ptr<bool>(m_isAlive)] (const auto& error) {
+      if (isAlive.expired() || error || generation != conn.generation) {
+        return;
+      }
+      onFailure(conn, "timed out");
+    });
+}
+
+void
+SmtpMailer::onFailure(Connection& conn, const std::string& reason)
+{
+  bool wasConnected = conn.isConnected;
+  close(conn);
+  if (conn.isDelivering) {
+    // only the email being delivered is charged an attempt
+    retry(std::move(conn.batch.front()), reason);
+    conn.batch.pop_front();
+    conn.isDelivering = false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.insert(m_queue.begin(), std::make_move_iterator(conn.batch.begin()),
+                   std::make_move_iterator(conn.batch.end()));
+    if (!wasConnected) {
+      m_metrics.nConnectFailures++;
+    }
+  }
+  conn.batch.clear();
+
+  conn.backoff = conn.backoff == 0_ms ? m_options.initialBackoff : std::min(conn.backoff * 2, m_options.maxBackoff);
+  if (wasConnected) {
+    // servers close idle connections, this is only worth a warning if reconnecting fails too
+    NDN_LOG_DEBUG("Lost connection to SMTP server " << m_config.server << ":" << m_config.port << " (" << reason
+                  << "), reconnecting in " << conn.backoff.count() << " ms");
+  }
+  else {
+    NDN_LOG_WARN("Cannot connect to SMTP server " << m_config.server << ":" << m_config.port << " (" << reason
+                 << "), retrying in " << conn.backoff.count() << " ms");
+  }
+  conn.isBusy = true;
+  conn.timer.expires_after(std::chrono::milliseconds(conn.backoff.count()));
+  conn.timer.async_wait(
+    [this, &conn, generation = conn.generation, isAlive = std::weak_ptr<bool>(m_isAlive)] (const auto& error) {
+      if (isAlive.expired() || error || generation != conn.generation) {
+        return;
+      }
+      conn.isBusy = false;
+      dispatch();
+    });
+  // the other connections take over the requeued emails
+  dispatch();
+}
+
+void
+SmtpMailer::retry(Message message, const std::string& reason)
+{
+  message.nAttempts++;
+  if (message.nAttempts >= m_options.maxAttempts) {
+    NDN_LOG_WARN("Giving up on the email to " << message.recipient << " after " << message.nAttempts
+                 << " attempts (" << reason << ")");
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_metrics.nDropped++;
+    return;
+  }
+
+  auto backoff = m_options.initialBackoff;
+  for (size_t i = 1; i < message.nAttempts && backoff < m_options.maxBackoff; i++) {
+    backoff *= 2;
+  }
+  backoff = std::min(backoff, m_options.maxBackoff);
+  NDN_LOG_DEBUG("Retrying the email to " << message.recipient << " in " << backoff.count() << " ms ("
+                << reason << ")");
+  message.notBefore = time::steady_clock::now() + backoff;
+  auto notBefore = message.notBefore;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.push_back(std::move(message));
+    m_metrics.nRetried++;
+  }
+  scheduleDispatch(notBefore);
+}
+
+void
+SmtpMailer::close(Connection& conn)
+{
+  conn.resolver.cancel();
+  conn.timer.cancel();
+  if (conn.stream) {
+    boost::system::error_code ec;
+    conn.stream->next_layer().close(ec);
+  }
+  conn.generation++;
+  if (conn.isConnected) {
+    conn.isConnected = false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_metrics.nConnected--;
+  }
+}
+
+void
+SmtpMailer::scheduleDispatch(time::steady_clock::time_point when)
+{
+  if (m_isDispatchScheduled && m_dispatchTime <= when) {
+    return;
+  }
+  m_isDispatchScheduled = true;
+  m_dispatchTime = when;
+  auto delay = std::max(time::duration_cast<time::microseconds>(when - time::steady_clock::now()), 0_us);
+  m_dispatchTimer.expires_after(std::chrono::microseconds(delay.count()));
+  m_dispatchTimer.async_wait([this, isAlive = std::weak_ptr<bool>(m_isAlive)] (const auto& error) {
+    if (isAlive.expired() || error) {
+      return;
+    }
+    m_isDispatchScheduled = false;
+    dispatch();
+  });
+}
+
+TokenBucket*
+SmtpMailer::findDomainBucket(const std::string& domain)
+{
+  if (!m_options.domainLimit) {
+    return nullptr;
+  }
+  auto it = m_domainBuckets.find(domain);
+  if (it != m_domainBuckets.end()) {
+    m_domainLru.splice(m_domainLru.begin(), m_domainLru, it->second.second);
+    return &it->second.first;
+  }
+  if (m_domainBuckets.size() >= std::max<size_t>(m_options.maxDomains, 1)) {
+    m_domainBuckets.erase(m_domainLru.back());
+    m_domainLru.pop_back();
+  }
+  m_domainLru.push_front(domain);
+  it = m_domainBuckets.emplace(std::piecewise_construct, std::forward_as_tuple(domain),
+                               std::forward_as_tuple(TokenBucket(*m_options.domainLimit), m_domainLru.begin())).first;
+  return &it->second.first;
+}
+
+} // namespace ndncert::ca
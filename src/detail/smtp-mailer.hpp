@@ -0,0 +1,249 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_SMTP_MAILER_HPP
+#define NDNCERT_DETAIL_SMTP_MAILER_HPP
+
+#include "detail/admission-control.hpp"
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <deque>
+#include <unordered_map>
+
+namespace boost::asio::ssl {
+class context;
+} // namespace boost::asio::ssl
+
+namespace ndncert::ca {
+
+/**
+ * @brief The SMTP server and the email templates of the email challenge.
+ *
+ * The configuration is the INI file read by ndncert-send-email-challenge, see
+ * ndncert-mail.conf.sample. In the templates, {0} is replaced by the secret, {1} by the
+ * CA prefix, and {2} by the name of the requested certificate.
+ */
+struct SmtpConfig
+{
+  enum class Encryption {
+    /// plain SMTP
+    NONE,
+    /// implicit TLS, usually on port 465
+    SSL,
+    /// STARTTLS, usually on port 587
+    TLS,
+  };
+
+  std::string server;
+  std::string port = "25";
+  Encryption encryption = Encryption::NONE;
+  std::string user;
+  std::string password;
+
+  std::string mailFrom;
+  std::string subject;
+  std::string textTemplate;
+  std::string htmlTemplate;
+
+  /**
+   * @throw std::runtime_error the file cannot be read or lacks the SMTP server or the sender.
+   */
+  static SmtpConfig
+  load(const std::string& fileName);
+};
+
+struct SmtpMailerOptions
+{
+  /// the number of persistent connections to the SMTP server
+  size_t nConnections = 2;
+  /// the number of emails waiting for delivery, beyond which SmtpMailer::send() fails
+  size_t queueCapacity = 1024;
+  /// the maximum number of emails sent on a connection before it is handed to the next ones
+  size_t maxBatchSize = 16;
+  /// the number of times an email is tried before it is dropped
+  size_t maxAttempts = 5;
+  time::milliseconds initialBackoff = 500_ms;
+  time::milliseconds maxBackoff = 60_s;
+  /// the time allowed to the server for each reply
+  time::milliseconds commandTimeout = 30_s;
+  /// the time after which an unused connection is closed
+  time::milliseconds idleTimeout = 60_s;
+  /// the rate of emails sent to each recipient domain, if limited
+  std::optional<TokenBucketConfig> domainLimit;
+  /// the number of recipient domains whose rate is tracked
+  size_t maxDomains = 10000;
+};
+
+/**
+ * @brief Delivers the emails of the email challenge to an SMTP server.
+ *
+ * Sending never blocks: emails are queued and delivered asynchronously on @p io over a pool of
+ * persistent connections, optionally upgraded with STARTTLS and authenticated with AUTH PLAIN.
+ * Each connection delivers a batch of queued emails in a row before the next connection gets
+ * its turn, and closes once it has been idle for a while.
+ *
+ * An email refused with a permanent (5xx) reply is dropped. An email refused with a transient
+ * (4xx) reply, or interrupted by a connection failure, is tried again after an exponential
+ * backoff, up to a maximum number of attempts. A connection that fails is reestablished after
+ * an exponential backoff as well. The emails to each recipient domain may be rate limited, in
+ * which case the emails to other domains overtake them.
+ *
+ * send() and getMetrics() may be called from any thread. The mailer must be destroyed on the
+ * thread running @p io, or once @p io has stopped.
+ */
+class SmtpMailer : boost::noncopyable
+{
+public:
+  struct Metrics
+  {
+    size_t queueDepth = 0;
+    size_t nConnected = 0;
+    uint64_t nSent = 0;
+    uint64_t nRejected = 0;
+    uint64_t nRetried = 0;
+    uint64_t nDropped = 0;
+    uint64_t nConnectFailures = 0;
+  };
+
+  SmtpMailer(boost::asio::io_context& io, const SmtpConfig& config, const SmtpMailerOptions& options = {});
+
+  ~SmtpMailer();
+
+  /**
+   * @brief Queues the challenge email carrying @p secret for @p emailAddress.
+   * @return false if the queue is full, in which case the email is not sent.
+   */
+  bool
+  send(const std::string& emailAddress, const std::string& secret,
+       const Name& caPrefix, const Name& certName);
+
+  Metrics
+  getMetrics() const;
+
+NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  /**
+   * @brief Formats a MIME email, terminated by the line holding a single dot that ends the DATA command.
+   */
+  std::string
+  formatMessage(const std::string& emailAddress, const std::string& secret,
+                const Name& caPrefix, const Name& certName) const;
+
+private:
+  struct Message
+  {
+    std::string recipient;
+    std::string domain;
+    std::string body;
+    size_t nAttempts = 0;
+    time::steady_clock::time_point notBefore;
+  };
+
+  struct Connection;
+  using ReplyCallback = std::function<void(int code, const std::string& text)>;
+
+  void
+  dispatch();
+
+  bool
+  takeBatch(Connection& conn);
+
+  void
+  connect(Connection& conn);
+
+  void
+  handshake(Connection& conn, std::function<void()> next);
+
+  void
+  hello(Connection& conn);
+
+  void
+  startTls(Connection& conn);
+
+  void
+  authenticate(Connection& conn);
+
+  void
+  onConnected(Connection& conn);
+
+  void
+  deliver(Connection& conn);
+
+  void
+  onDelivered(Connection& conn);
+
+  void
+  onRefused(Connection& conn, int code, const std::string& text);
+
+  void
+  idle(Connection& conn);
+
+  void
+  command(Connection& conn, const std::string& line, ReplyCallback callback);
+
+  void
+  readReply(Connection& conn, ReplyCallback callback, std::string text = "");
+
+  void
+  arm(Connection& conn, time::milliseconds timeout);
+
+  void
+  onFailure(Connection& conn, const std::string& reason);
+
+  void
+  retry(Message message, const std::string& reason);
+
+  void
+  close(Connection& conn);
+
+  void
+  scheduleDispatch(time::steady_clock::time_point when);
+
+  TokenBucket*
+  findDomainBucket(const std::string& domain);
+
+private:
+  boost::asio::io_context& m_io;
+  const SmtpConfig m_config;
+  const SmtpMailerOptions m_options;
+  std::string m_envelopeFrom;
+  std::unique_ptr<boost::asio::ssl::context> m_sslContext;
+  // handlers that complete after destruction must not touch the mailer
+  std::shared_ptr<bool> m_isAlive = std::make_shared<bool>(true);
+
+  std::vector<std::unique_ptr<Connection>> m_connections;
+  boost::asio::steady_timer m_dispatchTimer;
+  bool m_isDispatchScheduled = false;
+  time::steady_clock::time_point m_dispatchTime;
+
+  // the domains are only accessed on the thread running io
+  std::list<std::string> m_domainLru;
+  std::unordered_map<std::string, std::pair<TokenBucket, std::list<std::string>::iterator>> m_domainBuckets;
+
+  mutable std::mutex m_mutex;
+  // guarded by m_mutex
+  std::deque<Message> m_queue;
+  Metrics m_metrics;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_SMTP_MAILER_HPP
@@ -0,0 +1,188 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/state-token.hpp"
+#include "detail/crypto-helpers.hpp"
+
+#include <ndn-cxx/util/random.hpp>
+
+namespace ndncert::ca {
+
+// token TLV-VALUE: key epoch (8) | nonce (12) | authentication tag (16) | ciphertext
+// plaintext: expiration as milliseconds since the epoch (8) | encoded request state
+const size_t EPOCH_SIZE = 8;
+const size_t NONCE_SIZE = 12;
+const size_t TAG_SIZE = 16;
+const size_t HEADER_SIZE = EPOCH_SIZE + NONCE_SIZE + TAG_SIZE;
+const std::string KEY_DERIVATION_SALT = "NDNCERT state token";
+
+static void
+writeBigU64(uint8_t* dst, uint64_t value)
+{
+  for (int i = 7; i >= 0; i--) {
+    dst[i] = static_cast<uint8_t>(value & 0xFF);
+    value >>= 8;
+  }
+}
+
+static uint64_t
+readBigU64(const uint8_t* src)
+{
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++) {
+    value = (value << 8) | src[i];
+  }
+  return value;
+}
+
+StateTokenSealer::StateTokenSealer(const std::vector<uint8_t>& secret, time::seconds keyLifetime,
+                                   time::seconds tokenLifetime)
+  : m_secret(secret)
+  , m_keyLifetime(keyLifetime)
+  , m_tokenLifetime(tokenLifetime)
+{
+  if (m_keyLifetime <= 0_s || m_tokenLifetime > m_keyLifetime) {
+    NDN_THROW(std::runtime_error("The state token lifetime must not exceed the key lifetime"));
+  }
+  if (m_secret.empty()) {
+    m_secret.resize(32);
+    ndn::random::generateSecureBytes(m_secret);
+  }
+}
+
+Block
+StateTokenSealer::seal(const RequestState& request)
+{
+  auto state = encodeRequestState(request);
+  auto expiration = time::system_clock::now() + m_tokenLifetime;
+  std::vector<uint8_t> plaintext(EPOCH_SIZE + state.size());
+  writeBigU64(plaintext.data(), time::toUnixTimestamp(expiration).count());
+  std::copy(state.begin(), state.end(), plaintext.begin() + EPOCH_SIZE);
+
+  auto epoch = getCurrentEpoch();
+  std::vector<uint8_t> value(HEADER_SIZE + plaintext.size());
+  writeBigU64(value.data(), epoch);
+  uint8_t* nonce = value.data() + EPOCH_SIZE;
+  ndn::random::generateSecureBytes({nonce, NONCE_SIZE});
+  std::array<uint8_t, 16> key;
+  {
+    std::lock_guard lock(m_mutex);
+    key = getKey(epoch);
+  }
+  aesGcm128Encrypt(plaintext.data(), plaintext.size(), request.requestId.data(), request.requestId.size(),
+                   key.data(), nonce, value.data() + HEADER_SIZE, nonce + NONCE_SIZE);
+  return ndn::makeBinaryBlock(tlv::StateToken, value);
+}
+
+RequestState
+StateTokenSealer::open(const Block& token, const RequestId& requestId)
+{
+  if (token.type() != tlv::StateToken || token.value_size() <= HEADER_SIZE + EPOCH_SIZE) {
+    NDN_THROW(std::runtime_error("Malformed state token"));
+  }
+  const uint8_t* value = token.value();
+  auto epoch = readBigU64(value);
+  auto currentEpoch = getCurrentEpoch();
+  if (epoch != currentEpoch && epoch + 1 != currentEpoch) {
+    NDN_THROW(std::runtime_error("The state token was sealed under an expired key"));
+  }
+  Nonce nonce;
+  std::copy_n(value + EPOCH_SIZE, NONCE_SIZE, nonce.begin());
+  std::array<uint8_t, 16> key;
+  {
+    std::lock_guard lock(m_mutex);
+    if (m_usedNonces.count(nonce) != 0) {
+      NDN_THROW(std::runtime_error("The state token has already been used"));
+    }
+    key = getKey(epoch);
+  }
+
+  // aesGcm128Decrypt throws if the token is forged or bound to another request ID
+  size_t ciphertextSize = token.value_size() - HEADER_SIZE;
+  std::vector<uint8_t> plaintext(ciphertextSize);
+  aesGcm128Decrypt(value + HEADER_SIZE, ciphertextSize, requestId.data(), requestId.size(),
+                   value + EPOCH_SIZE + NONCE_SIZE, key.data(), nonce.data(), plaintext.data());
+
+  time::system_clock::time_point expiration = time::fromUnixTimestamp(time::milliseconds(readBigU64(plaintext.data())));
+  if (expiration < time::system_clock::now()) {
+    NDN_THROW(std::runtime_error("The state token has expired"));
+  }
+  auto [isOk, state] = Block::fromBuffer({plaintext.data() + EPOCH_SIZE, plaintext.size() - EPOCH_SIZE});
+  if (!isOk) {
+    NDN_THROW(std::runtime_error("Malformed request state in the state token"));
+  }
+  return decodeRequestState(state);
+}
+
+bool
+StateTokenSealer::markUsed(const Block& token)
+{
+  std::lock_guard lock(m_mutex);
+  pruneNonces();
+  Nonce nonce;
+  std::copy_n(token.value() + EPOCH_SIZE, NONCE_SIZE, nonce.begin());
+  // the token was sealed earlier, so it expires within a token lifetime from now
+  auto expiration = time::system_clock::now() + m_tokenLifetime;
+  if (!m_usedNonces.emplace(nonce, expiration).second) {
+    return false;
+  }
+  m_nonceExpiry.emplace(expiration, nonce);
+  return true;
+}
+
+const std::array<uint8_t, 16>&
+StateTokenSealer::getKey(uint64_t epoch)
+{
+  auto it = m_keys.find(epoch);
+  if (it != m_keys.end()) {
+    return it->second;
+  }
+
+  // only the current and the previous keys are in use
+  while (!m_keys.empty() && m_keys.begin()->first + 1 < epoch) {
+    m_keys.erase(m_keys.begin());
+  }
+  std::array<uint8_t, 16> key;
+  uint8_t info[EPOCH_SIZE];
+  writeBigU64(info, epoch);
+  hkdf(m_secret.data(), m_secret.size(),
+       reinterpret_cast<const uint8_t*>(KEY_DERIVATION_SALT.data()), KEY_DERIVATION_SALT.size(),
+       key.data(), key.size(), info, sizeof(info));
+  return m_keys.emplace(epoch, key).first->second;
+}
+
+uint64_t
+StateTokenSealer::getCurrentEpoch() const
+{
+  return time::toUnixTimestamp(time::system_clock::now()).count() /
+         time::duration_cast<time::milliseconds>(m_keyLifetime).count();
+}
+
+void
+StateTokenSealer::pruneNonces()
+{
+  auto now = time::system_clock::now();
+  while (!m_nonceExpiry.empty() && m_nonceExpiry.begin()->first < now) {
+    m_usedNonces.erase(m_nonceExpiry.begin()->second);
+    m_nonceExpiry.erase(m_nonceExpiry.begin());
+  }
+}
+
+} // namespace ndncert::ca
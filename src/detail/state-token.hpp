@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_STATE_TOKEN_HPP
+#define NDNCERT_DETAIL_STATE_TOKEN_HPP
+
+#include "detail/ca-request-state.hpp"
+
+#include <map>
+#include <mutex>
+
+namespace ndncert::ca {
+
+/**
+ * @brief Seals request states into opaque tokens, for a CA that keeps no per-request storage.
+ *
+ * A token holds the encoding of the whole request state, encrypted with AES-GCM-128 and bound
+ * to the request ID. The sealing key changes every key lifetime and is derived from a secret,
+ * so that CA replicas configured with the same secret open each other's tokens; tokens sealed
+ * under the previous key are still accepted.
+ *
+ * Each token can be used only once: the nonces of used tokens are remembered until the tokens
+ * expire, so that an earlier state of a request cannot be replayed. The filter is local to the
+ * sealer, which may be shared by several threads: a replica configured with the same secret
+ * still accepts a token used on another replica.
+ */
+class StateTokenSealer : boost::noncopyable
+{
+public:
+  /**
+   * @param secret The secret of the sealing keys. When empty, a random secret is used.
+   * @throw std::runtime_error The token lifetime exceeds the key lifetime.
+   */
+  StateTokenSealer(const std::vector<uint8_t>& secret, time::seconds keyLifetime, time::seconds tokenLifetime);
+
+  Block
+  seal(const RequestState& request);
+
+  /**
+   * @brief Open a token without using it.
+   * @throw std::runtime_error The token is malformed, forged, bound to another request, expired
+   *                           or already used.
+   */
+  RequestState
+  open(const Block& token, const RequestId& requestId);
+
+  /**
+   * @brief Record that the token has been used, once the request it carries is authenticated.
+   * @return false if the token had already been used.
+   */
+  bool
+  markUsed(const Block& token);
+
+  size_t
+  getNonceFilterSize() const
+  {
+    std::lock_guard lock(m_mutex);
+    return m_usedNonces.size();
+  }
+
+private:
+  using Nonce = std::array<uint8_t, 12>;
+
+  const std::array<uint8_t, 16>&
+  getKey(uint64_t epoch);
+
+  uint64_t
+  getCurrentEpoch() const;
+
+  void
+  pruneNonces();
+
+private:
+  std::vector<uint8_t> m_secret;
+  const time::seconds m_keyLifetime;
+  const time::seconds m_tokenLifetime;
+  std::map<uint64_t, std::array<uint8_t, 16>> m_keys;
+  std::map<Nonce, time::system_clock::time_point> m_usedNonces;
+  std::multimap<time::system_clock::time_point, Nonce> m_nonceExpiry;
+  mutable std::mutex m_mutex;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_STATE_TOKEN_HPP
@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/status-encoder.hpp"
+
+namespace ndncert {
+
+static CertDigest
+readDigest(const Block& block)
+{
+  CertDigest digest;
+  if (block.value_size() != digest.size()) {
+    NDN_THROW(std::runtime_error("Certificate digest has an invalid size"));
+  }
+  std::memcpy(digest.data(), block.value(), digest.size());
+  return digest;
+}
+
+Name
+statustlv::makeQueryName(const Name& caPrefix, const CertDigest& digest)
+{
+  Name name(caPrefix);
+  name.append("CA").append("STATUS").appendImplicitSha256Digest(digest);
+  return name;
+}
+
+Block
+statustlv::encodeApplicationParameters(const std::vector<CertDigest>& digests)
+{
+  Block request(ndn::tlv::ApplicationParameters);
+  for (const auto& digest : digests) {
+    request.push_back(ndn::makeBinaryBlock(tlv::CertDigest, digest));
+  }
+  request.encode();
+  return request;
+}
+
+std::vector<CertDigest>
+statustlv::decodeApplicationParameters(const Block& block)
+{
+  block.parse();
+  std::vector<CertDigest> digests;
+  for (const auto& item : block.elements()) {
+    if (item.type() == tlv::CertDigest) {
+      digests.push_back(readDigest(item));
+    }
+    else if (ndn::tlv::isCriticalType(item.type())) {
+      NDN_THROW(std::runtime_error("Unrecognized TLV Type: " + std::to_string(item.type())));
+    }
+  }
+  if (digests.empty() || digests.size() > MAX_DIGESTS_PER_QUERY) {
+    NDN_THROW(std::runtime_error("Status query contains " + std::to_string(digests.size()) +
+                                 " certificate digests, instead of between 1 and " +
+                                 std::to_string(MAX_DIGESTS_PER_QUERY) + "."));
+  }
+  return digests;
+}
+
+Block
+statustlv::encodeDataContent(uint64_t revocationVersion, const CertStatusList& statuses)
+{
+  Block response(ndn::tlv::Content);
+  response.push_back(ndn::makeNonNegativeIntegerBlock(tlv::RevocationVersion, revocationVersion));
+  for (const auto& [digest, status] : statuses) {
+    response.push_back(ndn::makeBinaryBlock(tlv::CertDigest, digest));
+    response.push_back(ndn::makeNonNegativeIntegerBlock(tlv::CertStatus, static_cast<uint64_t>(status)));
+  }
+  response.encode();
+  return response;
+}
+
+std::tuple<uint64_t, statustlv::CertStatusList>
+statustlv::decodeDataContent(const Block& content)
+{
+  content.parse();
+  std::optional<uint64_t> revocationVersion;
+  CertStatusList statuses;
+  std::optional<CertDigest> digest;
+  for (const auto& item : content.elements()) {
+    if (item.type() == tlv::RevocationVersion) {
+      revocationVersion = readNonNegativeInteger(item);
+    }
+    else if (item.type() == tlv::CertDigest) {
+      if (digest) {
+        NDN_THROW(std::runtime_error("Certificate digest without status"));
+      }
+      digest = readDigest(item);
+    }
+    else if (item.type() == tlv::CertStatus) {
+      if (!digest) {
+        NDN_THROW(std::runtime_error("Certificate status without digest"));
+      }
+      statuses.emplace_back(*digest, static_cast<CertStatus>(readNonNegativeInteger(item)));
+      digest.reset();
+    }
+    else if (ndn::tlv::isCriticalType(item.type())) {
+      NDN_THROW(std::runtime_error("Unrecognized TLV Type: " + std::to_string(item.type())));
+    }
+  }
+  if (!revocationVersion || digest) {
+    NDN_THROW(std::runtime_error("Malformed status response"));
+  }
+  return {*revocationVersion, statuses};
+}
+
+} // namespace ndncert
@@ -0,0 +1,67 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_STATUS_ENCODER_HPP
+#define NDNCERT_DETAIL_STATUS_ENCODER_HPP
+
+#include "detail/revocation-encoder.hpp"
+
+/**
+ * @brief The certificate status queries served under /<CA-prefix>/CA/STATUS.
+ *
+ * A query for a single certificate is named /<CA-prefix>/CA/STATUS/<implicit digest>. A query
+ * for several certificates carries their digests in its ApplicationParameters and is named
+ * /<CA-prefix>/CA/STATUS/<parameters digest>. The reply appends the version of the revocation
+ * registry the statuses were read at, and lists each digest followed by its status, in the
+ * order of the query.
+ */
+namespace ndncert::statustlv {
+
+const size_t MAX_DIGESTS_PER_QUERY = 64;
+
+using CertStatusList = std::vector<std::pair<CertDigest, CertStatus>>;
+
+/**
+ * @brief The name of the query for a single certificate.
+ */
+Name
+makeQueryName(const Name& caPrefix, const CertDigest& digest);
+
+Block
+encodeApplicationParameters(const std::vector<CertDigest>& digests);
+
+/**
+ * @throw std::runtime_error the parameters do not list between 1 and MAX_DIGESTS_PER_QUERY digests.
+ */
+std::vector<CertDigest>
+decodeApplicationParameters(const Block& block);
+
+Block
+encodeDataContent(uint64_t revocationVersion, const CertStatusList& statuses);
+
+/**
+ * @return The version of the revocation registry and the statuses.
+ */
+std::tuple<uint64_t, CertStatusList>
+decodeDataContent(const Block& content);
+
+} // namespace ndncert::statustlv
+
+#endif // NDNCERT_DETAIL_STATUS_ENCODER_HPP
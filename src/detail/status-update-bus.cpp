@@ -0,0 +1,261 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/status-update-bus.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+
+namespace ndncert::ca {
+
+NDN_LOG_INIT(ndncert.ca.bus);
+
+/**
+ * @brief A subscriber, with a single-producer single-consumer ring buffer.
+ *
+ * The worker and the publisher only take the mutex to sleep and to wake each other up.
+ */
+class StatusUpdateBus::Subscription
+{
+public:
+  Subscription(SubscriptionId id, const Handler& handler, size_t capacity, OverflowPolicy policy)
+    : id(id)
+    , m_handler(handler)
+    , m_policy(policy)
+    , m_ring(std::max<size_t>(capacity, 1) + 1)
+  {
+    m_worker = std::thread([this] { run(); });
+  }
+
+  ~Subscription()
+  {
+    m_isStopping = true;
+    {
+      std::lock_guard lock(m_mutex);
+      m_cv.notify_all();
+    }
+    m_worker.join();
+  }
+
+  void
+  push(const Snapshot& snapshot)
+  {
+    if (tryPush(snapshot)) {
+      return;
+    }
+    if (m_policy == OverflowPolicy::DROP) {
+      m_nDropped++;
+      return;
+    }
+
+    m_isProducerWaiting = true;
+    {
+      std::unique_lock lock(m_mutex);
+      m_cv.wait(lock, [this] { return !isFull() || m_isStopping; });
+    }
+    m_isProducerWaiting = false;
+    if (!tryPush(snapshot)) {
+      m_nDropped++;
+    }
+  }
+
+  Statistics
+  getStatistics() const
+  {
+    Statistics stats;
+    stats.nDelivered = m_nDelivered;
+    stats.nDropped = m_nDropped;
+    auto head = m_head.load();
+    auto tail = m_tail.load();
+    stats.queueLength = (tail + m_ring.size() - head) % m_ring.size();
+    return stats;
+  }
+
+private:
+  // isFull() and isEmpty() are the predicates of the waits. A side that is about to sleep sets
+  // its waiting flag, then loads the index of the other side, which stores its index, then
+  // loads the flag. Only if both loads are sequentially consistent, like the stores, does one
+  // of the two sides see the store of the other, so that a wake-up cannot be missed.
+  bool
+  isFull() const
+  {
+    return (m_tail.load(std::memory_order_relaxed) + 1) % m_ring.size() == m_head.load(std::memory_order_seq_cst);
+  }
+
+  bool
+  isEmpty() const
+  {
+    return m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_seq_cst);
+  }
+
+  bool
+  tryPush(const Snapshot& snapshot)
+  {
+    auto tail = m_tail.load(std::memory_order_relaxed);
+    auto next = (tail + 1) % m_ring.size();
+    if (next == m_head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    m_ring[tail] = snapshot;
+    m_tail.store(next, std::memory_order_seq_cst);
+    if (m_isConsumerWaiting) {
+      std::lock_guard lock(m_mutex);
+      m_cv.notify_all();
+    }
+    return true;
+  }
+
+  bool
+  tryPop(Snapshot& snapshot)
+  {
+    auto head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    snapshot = std::move(m_ring[head]);
+    m_head.store((head + 1) % m_ring.size(), std::memory_order_seq_cst);
+    if (m_isProducerWaiting) {
+      std::lock_guard lock(m_mutex);
+      m_cv.notify_all();
+    }
+    return true;
+  }
+
+  void
+  run()
+  {
+    while (true) {
+      Snapshot snapshot;
+      if (tryPop(snapshot)) {
+        try {
+          m_handler(snapshot);
+        }
+        catch (const std::exception& e) {
+          NDN_LOG_ERROR("Status update subscriber " << id << " failed: " << e.what());
+        }
+        m_nDelivered++;
+        continue;
+      }
+      // pending updates are handled before stopping
+      if (m_isStopping) {
+        return;
+      }
+
+      m_isConsumerWaiting = true;
+      {
+        std::unique_lock lock(m_mutex);
+        m_cv.wait(lock, [this] { return !isEmpty() || m_isStopping; });
+      }
+      m_isConsumerWaiting = false;
+    }
+  }
+
+public:
+  const SubscriptionId id;
+
+private:
+  const Handler m_handler;
+  const OverflowPolicy m_policy;
+  std::vector<Snapshot> m_ring;
+  // written by the worker and the publisher respectively, kept on separate cache lines
+  alignas(64) std::atomic<size_t> m_head{0};
+  alignas(64) std::atomic<size_t> m_tail{0};
+
+  std::atomic<bool> m_isConsumerWaiting{false};
+  std::atomic<bool> m_isProducerWaiting{false};
+  std::atomic<bool> m_isStopping{false};
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+
+  std::atomic<uint64_t> m_nDelivered{0};
+  std::atomic<uint64_t> m_nDropped{0};
+  std::thread m_worker;
+};
+
+StatusUpdateBus::StatusUpdateBus()
+  : m_subscriptions(std::make_shared<const SubscriptionList>())
+{
+}
+
+StatusUpdateBus::~StatusUpdateBus() = default;
+
+StatusUpdateBus::SubscriptionId
+StatusUpdateBus::subscribe(const Handler& handler, size_t capacity, OverflowPolicy policy)
+{
+  std::lock_guard lock(m_mutex);
+  auto subscriptions = std::make_shared<SubscriptionList>(*m_subscriptions);
+  subscriptions->push_back(std::make_shared<Subscription>(++m_lastId, handler, capacity, policy));
+  std::atomic_store(&m_subscriptions, std::shared_ptr<const SubscriptionList>(std::move(subscriptions)));
+  return m_lastId;
+}
+
+void
+StatusUpdateBus::unsubscribe(SubscriptionId id)
+{
+  std::shared_ptr<Subscription> removed;
+  {
+    std::lock_guard lock(m_mutex);
+    auto subscriptions = std::make_shared<SubscriptionList>(*m_subscriptions);
+    auto it = std::find_if(subscriptions->begin(), subscriptions->end(),
+                           [id] (const auto& sub) { return sub->id == id; });
+    if (it == subscriptions->end()) {
+      return;
+    }
+    removed = *it;
+    subscriptions->erase(it);
+    std::atomic_store(&m_subscriptions, std::shared_ptr<const SubscriptionList>(std::move(subscriptions)));
+  }
+  // the worker is joined here, outside the lock, unless a concurrent publish() still uses it
+}
+
+bool
+StatusUpdateBus::hasSubscribers() const
+{
+  return !std::atomic_load(&m_subscriptions)->empty();
+}
+
+void
+StatusUpdateBus::publish(const RequestState& request)
+{
+  auto subscriptions = std::atomic_load(&m_subscriptions);
+  if (subscriptions->empty()) {
+    return;
+  }
+  auto snapshot = std::make_shared<const RequestState>(request);
+  for (const auto& sub : *subscriptions) {
+    sub->push(snapshot);
+  }
+}
+
+StatusUpdateBus::Statistics
+StatusUpdateBus::getStatistics(SubscriptionId id) const
+{
+  auto subscriptions = std::atomic_load(&m_subscriptions);
+  for (const auto& sub : *subscriptions) {
+    if (sub->id == id) {
+      return sub->getStatistics();
+    }
+  }
+  NDN_THROW(std::runtime_error("Unknown status update subscription " + std::to_string(id)));
+}
+
+} // namespace ndncert::ca
@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_STATUS_UPDATE_BUS_HPP
+#define NDNCERT_DETAIL_STATUS_UPDATE_BUS_HPP
+
+#include "detail/ca-request-state.hpp"
+
+#include <map>
+#include <mutex>
+
+namespace ndncert::ca {
+
+/**
+ * @brief What a subscriber does with an update that does not fit in its queue.
+ */
+enum class OverflowPolicy {
+  /// discard the update
+  DROP,
+  /// wait until the subscriber has room for the update
+  BLOCK,
+};
+
+/**
+ * @brief Delivers request status updates to any number of subscribers.
+ *
+ * Each subscriber has its own bounded lock-free queue, drained by its own worker thread, so
+ * that a slow subscriber neither delays the publisher nor the other subscribers (unless its
+ * policy is OverflowPolicy::BLOCK). Updates are delivered as shared immutable snapshots of the
+ * request state, in the order they are published.
+ *
+ * Updates must be published from a single thread at a time, normally the Face thread.
+ */
+class StatusUpdateBus : boost::noncopyable
+{
+public:
+  using Snapshot = std::shared_ptr<const RequestState>;
+  using Handler = std::function<void(const Snapshot& request)>;
+  using SubscriptionId = uint64_t;
+
+  struct Statistics
+  {
+    uint64_t nDelivered = 0;
+    uint64_t nDropped = 0;
+    size_t queueLength = 0;
+  };
+
+  StatusUpdateBus();
+
+  /**
+   * @brief Stop all the subscribers after they have handled their pending updates.
+   */
+  ~StatusUpdateBus();
+
+  /**
+   * @param handler Invoked on the worker thread of the subscriber.
+   * @param capacity The number of updates the subscriber can have pending.
+   */
+  SubscriptionId
+  subscribe(const Handler& handler, size_t capacity = 1024, OverflowPolicy policy = OverflowPolicy::DROP);
+
+  /**
+   * @brief Stop a subscriber after it has handled its pending updates.
+   */
+  void
+  unsubscribe(SubscriptionId id);
+
+  bool
+  hasSubscribers() const;
+
+  /**
+   * @brief Deliver a snapshot of @p request to all the subscribers.
+   *
+   * The snapshot is only made if there is at least one subscriber.
+   */
+  void
+  publish(const RequestState& request);
+
+  /**
+   * @throw std::runtime_error The subscription does not exist.
+   */
+  Statistics
+  getStatistics(SubscriptionId id) const;
+
+private:
+  class Subscription;
+  using SubscriptionList = std::vector<std::shared_ptr<Subscription>>;
+
+  // serializes subscribe() and unsubscribe(), publish() only loads the list
+  mutable std::mutex m_mutex;
+  std::shared_ptr<const SubscriptionList> m_subscriptions;
+  SubscriptionId m_lastId = 0;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_STATUS_UPDATE_BUS_HPP
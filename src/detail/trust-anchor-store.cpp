@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/trust-anchor-store.hpp"
+
+#include <ndn-cxx/security/verification-helpers.hpp>
+
+namespace ndncert {
+
+NDN_LOG_INIT(ndncert.trust-anchor-store);
+
+TrustAnchorStore::TrustAnchorStore(std::vector<Certificate> anchors, size_t cacheCapacity)
+  : m_anchors(std::move(anchors))
+  , m_cacheCapacity(cacheCapacity)
+{
+  for (size_t i = 0; i < m_anchors.size(); i++) {
+    m_index[m_anchors[i].getKeyName()].push_back(i);
+    m_index[m_anchors[i].getName()].push_back(i);
+  }
+}
+
+bool
+TrustAnchorStore::verify(const Certificate& credential)
+{
+  // the full name is computed outside of the lock
+  const auto& fullName = credential.getFullName();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_verdicts.find(fullName);
+    if (it != m_verdicts.end()) {
+      m_lru.splice(m_lru.begin(), m_lru, it->second.second);
+      NDN_LOG_TRACE("Cached verdict on " << credential.getName() << ": " << it->second.first);
+      return it->second.first;
+    }
+  }
+
+  bool isVerified = verifyUncached(credential);
+  if (m_cacheCapacity == 0) {
+    return isVerified;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_verdicts.count(fullName) != 0) {
+    // verified concurrently by another thread
+    return isVerified;
+  }
+  m_lru.push_front(fullName);
+  m_verdicts.emplace(fullName, std::make_pair(isVerified, m_lru.begin()));
+  if (m_verdicts.size() > m_cacheCapacity) {
+    m_verdicts.erase(m_lru.back());
+    m_lru.pop_back();
+  }
+  return isVerified;
+}
+
+size_t
+TrustAnchorStore::getCacheSize() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_verdicts.size();
+}
+
+bool
+TrustAnchorStore::verifyUncached(const Certificate& credential) const
+{
+  auto keyLocator = credential.getSignatureInfo().getKeyLocator();
+  if (keyLocator.getType() != ndn::tlv::Name) {
+    return false;
+  }
+  auto it = m_index.find(keyLocator.getName());
+  if (it == m_index.end()) {
+    return false;
+  }
+  return std::any_of(it->second.begin(), it->second.end(), [&] (size_t i) {
+    return ndn::security::verifySignature(credential, m_anchors[i]);
+  });
+}
+
+} // namespace ndncert
@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_TRUST_ANCHOR_STORE_HPP
+#define NDNCERT_DETAIL_TRUST_ANCHOR_STORE_HPP
+
+#include "detail/ndncert-common.hpp"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace ndncert {
+
+/**
+ * @brief The trust anchors of the possession challenge, indexed by key name and by certificate
+ *        name, with a bounded cache of the verdicts on the credentials checked against them.
+ *
+ * A credential is checked only against the anchors named by its KeyLocator. The verdict is
+ * remembered by the full name of the credential, which covers its implicit digest, so that a
+ * device enrolling again with the same credential costs no signature verification. When the
+ * capacity is reached, the least recently used verdict is evicted.
+ *
+ * The store may be shared by several threads.
+ */
+class TrustAnchorStore : boost::noncopyable
+{
+public:
+  explicit
+  TrustAnchorStore(std::vector<Certificate> anchors, size_t cacheCapacity = 1024);
+
+  /**
+   * @brief Whether @p credential is signed by one of the anchors named by its KeyLocator.
+   */
+  bool
+  verify(const Certificate& credential);
+
+  const std::vector<Certificate>&
+  getAnchors() const
+  {
+    return m_anchors;
+  }
+
+  size_t
+  getCacheSize() const;
+
+private:
+  bool
+  verifyUncached(const Certificate& credential) const;
+
+private:
+  const std::vector<Certificate> m_anchors;
+  // the anchors by key name and by certificate name, as indices into m_anchors
+  std::unordered_map<Name, std::vector<size_t>> m_index;
+
+  const size_t m_cacheCapacity;
+  mutable std::mutex m_mutex;
+  // guarded by m_mutex, the most recently used verdict is at the front
+  std::list<Name> m_lru;
+  std::unordered_map<Name, std::pair<bool, std::list<Name>::iterator>> m_verdicts;
+};
+
+} // namespace ndncert
+
+#endif // NDNCERT_DETAIL_TRUST_ANCHOR_STORE_HPP
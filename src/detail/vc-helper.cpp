@@ -0,0 +1,326 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/vc-helper.hpp"
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/process/async_pipe.hpp>
+#include <boost/process/child.hpp>
+#include <boost/process/io.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <algorithm>
+#include <csignal>
+#include <deque>
+
+namespace ndncert::ca {
+
+NDN_LOG_INIT(ndncert.challenge.vc.helper);
+
+namespace bp = boost::process;
+
+struct VcHelper::Process
+{
+  explicit
+  Process(boost::asio::io_context& io)
+    : restartTimer(io)
+  {
+  }
+
+  // the pipes of an exited process are not reused
+  std::unique_ptr<bp::async_pipe> input;
+  std::unique_ptr<bp::async_pipe> output;
+  bp::child child;
+  boost::asio::steady_timer restartTimer;
+  boost::asio::streambuf readBuffer;
+  std::deque<std::string> writeQueue;
+  // identifies the process for which a completion handler was started
+  uint64_t generation = 0;
+  bool isRunning = false;
+  bool isWriting = false;
+  size_t nCalls = 0;
+  time::milliseconds backoff = 0_ms;
+};
+
+VcHelper::VcHelper(const std::string& command, const VcHelperOptions& options)
+  : m_command(command)
+  , m_options(options)
+  , m_work(boost::asio::make_work_guard(m_io))
+{
+  // a helper that exits while a call is being written must not terminate the CA
+  std::signal(SIGPIPE, SIG_IGN);
+
+  for (size_t i = 0; i < std::max<size_t>(m_options.nProcesses, 1); i++) {
+    m_processes.push_back(std::make_unique<Process>(m_io));
+  }
+  boost::asio::post(m_io, [this] {
+    for (auto& process : m_processes) {
+      start(*process);
+    }
+  });
+  m_thread = std::thread([this] { m_io.run(); });
+}
+
+VcHelper::~VcHelper()
+{
+  m_work.reset();
+  m_io.stop();
+  m_thread.join();
+  for (auto& process : m_processes) {
+    std::error_code ec;
+    if (process->child.valid() && process->child.running(ec)) {
+      process->child.terminate(ec);
+    }
+  }
+}
+
+void
+VcHelper::call(const std::string& method, const JsonSection& params,
+               const ResultCallback& onResult, const ErrorCallback& onError)
+{
+  boost::asio::post(m_io, [this, method, params, onResult, onError] {
+    auto id = ++m_lastCallId;
+    auto& process = **std::min_element(m_processes.begin(), m_processes.end(), [] (const auto& a, const auto& b) {
+      return std::make_tuple(!a->isRunning, a->nCalls) < std::make_tuple(!b->isRunning, b->nCalls);
+    });
+
+    JsonSection request;
+    request.put("id", std::to_string(id));
+    request.put("method", method);
+    request.add_child("params", params);
+    std::ostringstream os;
+    boost::property_tree::write_json(os, request, false);
+    process.writeQueue.push_back(os.str());
+
+    auto timer = std::make_unique<boost::asio::steady_timer>(m_io);
+    timer->expires_after(std::chrono::milliseconds(m_options.callTimeout.count()));
+    timer->async_wait([this, id] (const auto& error) {
+      auto it = m_calls.find(id);
+      if (error || it == m_calls.end()) {
+        return;
+      }
+      auto onError = std::move(it->second.onError);
+      it->second.process->nCalls--;
+      m_calls.erase(it);
+      NDN_LOG_WARN("VC helper call " << id << " timed out");
+      onError("VC helper timed out");
+    });
+    m_calls.emplace(id, Call{&process, onResult, onError, std::move(timer)});
+    process.nCalls++;
+    NDN_LOG_TRACE("VC helper call " << id << ": " << method);
+
+    // calls to a process being restarted are written once it runs
+    if (process.isRunning) {
+      write(process);
+    }
+  });
+}
+
+void
+VcHelper::subscribe(const EventCallback& callback)
+{
+  boost::asio::post(m_io, [this, callback] {
+    m_subscribers.push_back(callback);
+  });
+}
+
+void
+VcHelper::start(Process& process)
+{
+  process.generation++;
+  process.readBuffer.consume(process.readBuffer.size());
+  process.isWriting = false;
+  try {
+    process.input = std::make_unique<bp::async_pipe>(m_io);
+    process.output = std::make_unique<bp::async_pipe>(m_io);
+    process.child = bp::child(m_command, bp::std_in < *process.input, bp::std_out > *process.output);
+  }
+  catch (const std::exception& e) {
+    onExit(process, e.what());
+    return;
+  }
+  // only the child keeps the other ends, so that its exit closes the pipes
+  boost::system::error_code ec;
+  process.input->source().close(ec);
+  process.output->sink().close(ec);
+
+  process.isRunning = true;
+  m_nStarts++;
+  NDN_LOG_DEBUG("Started VC helper " << m_command << " (pid " << process.child.id() << ")");
+  read(process);
+  write(process);
+}
+
+void
+VcHelper::read(Process& process)
+{
+  boost::asio::async_read_until(*process.output, process.readBuffer, '\n',
+    [this, &process, generation = process.generation] (const auto& error, size_t) {
+      if (generation != process.generation) {
+        return;
+      }
+      if (error) {
+        onExit(process, error.message());
+        return;
+      }
+      std::istream is(&process.readBuffer);
+      std::string line;
+      std::getline(is, line);
+      onLine(line);
+      read(process);
+    });
+}
+
+void
+VcHelper::onLine(const std::string& line)
+{
+  if (line.empty() || line.front() != '{') {
+    NDN_LOG_TRACE("<helper>: " << line);
+    return;
+  }
+
+  JsonSection reply;
+  try {
+    std::istringstream is(line);
+    boost::property_tree::read_json(is, reply);
+  }
+  catch (const std::exception&) {
+    NDN_LOG_TRACE("<helper>: " << line);
+    return;
+  }
+
+  auto event = reply.get_optional<std::string>("event");
+  if (event && reply.count("id") == 0) {
+    NDN_LOG_TRACE("VC helper event " << *event);
+    auto params = reply.get_child("params", JsonSection());
+    for (const auto& subscriber : m_subscribers) {
+      subscriber(*event, params);
+    }
+    return;
+  }
+
+  uint64_t id = 0;
+  try {
+    id = std::stoull(reply.get("id", ""));
+  }
+  catch (const std::exception&) {
+    NDN_LOG_WARN("VC helper reply without a valid id: " << line);
+    return;
+  }
+  auto it = m_calls.find(id);
+  if (it == m_calls.end()) {
+    NDN_LOG_DEBUG("VC helper replied to unknown or expired call " << id);
+    return;
+  }
+  auto call = std::move(it->second);
+  m_calls.erase(it);
+  call.timer->cancel();
+  call.process->nCalls--;
+  // a process that answers is healthy again
+  call.process->backoff = 0_ms;
+
+  auto error = reply.get_optional<std::string>("error");
+  if (error) {
+    NDN_LOG_DEBUG("VC helper call " << id << " failed: " << *error);
+    call.onError(*error);
+    return;
+  }
+  NDN_LOG_TRACE("VC helper call " << id << " succeeded");
+  call.onResult(reply.get_child("result", JsonSection()));
+}
+
+void
+VcHelper::write(Process& process)
+{
+  if (process.isWriting || process.writeQueue.empty()) {
+    return;
+  }
+  process.isWriting = true;
+  boost::asio::async_write(*process.input, boost::asio::buffer(process.writeQueue.front()),
+    [this, &process, generation = process.generation] (const auto& error, size_t) {
+      if (generation != process.generation) {
+        return;
+      }
+      process.isWriting = false;
+      if (error) {
+        onExit(process, error.message());
+        return;
+      }
+      process.writeQueue.pop_front();
+      write(process);
+    });
+}
+
+void
+VcHelper::onExit(Process& process, const std::string& reason)
+{
+  process.generation++;
+  process.isRunning = false;
+  process.isWriting = false;
+  boost::system::error_code ec;
+  if (process.input) {
+    process.input->close(ec);
+  }
+  if (process.output) {
+    process.output->close(ec);
+  }
+  if (process.child.valid()) {
+    std::error_code error;
+    if (process.child.running(error)) {
+      process.child.terminate(error);
+    }
+    process.child.wait(error);
+  }
+
+  // the calls may have been partially processed, they are not resent
+  process.writeQueue.clear();
+  std::vector<ErrorCallback> failed;
+  for (auto it = m_calls.begin(); it != m_calls.end();) {
+    if (it->second.process == &process) {
+      it->second.timer->cancel();
+      failed.push_back(std::move(it->second.onError));
+      it = m_calls.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+  process.nCalls = 0;
+
+  process.backoff = process.backoff == 0_ms ? m_options.initialBackoff :
+                                              std::min(process.backoff * 2, m_options.maxBackoff);
+  NDN_LOG_WARN("VC helper " << m_command << " exited (" << reason << ") with " << failed.size()
+               << " calls in progress, restarting in " << process.backoff.count() << " ms");
+  process.restartTimer.expires_after(std::chrono::milliseconds(process.backoff.count()));
+  process.restartTimer.async_wait([this, &process] (const auto& error) {
+    if (!error) {
+      start(process);
+    }
+  });
+
+  for (const auto& onError : failed) {
+    onError("VC helper exited");
+  }
+}
+
+} // namespace ndncert::ca
@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_VC_HELPER_HPP
+#define NDNCERT_DETAIL_VC_HELPER_HPP
+
+#include "detail/ndncert-common.hpp"
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <atomic>
+#include <map>
+#include <thread>
+
+namespace ndncert::ca {
+
+struct VcHelperOptions
+{
+  /// the number of helper processes
+  size_t nProcesses = 1;
+  /// the time allowed to a helper process for each call
+  time::milliseconds callTimeout = 30_s;
+  time::milliseconds initialBackoff = 100_ms;
+  time::milliseconds maxBackoff = 30_s;
+};
+
+/**
+ * @brief Runs the calls of the VC challenge on a pool of persistent helper processes.
+ *
+ * Each helper process reads calls from its standard input and writes replies to its standard
+ * output, one JSON object per line:
+ *
+ *     {"id": "<id>", "method": "<method>", "params": {...}}
+ *     {"id": "<id>", "result": {...}}
+ *     {"id": "<id>", "error": "<reason>"}
+ *
+ * A helper may have several calls in progress and reply in any order. It may also report events
+ * of its own accord, such as the change of state of a presentation:
+ *
+ *     {"event": "<event>", "params": {...}}
+ *
+ * Output lines that are neither replies nor events, such as logs, are ignored. All the values
+ * are strings.
+ *
+ * Calls are assigned to the process with the fewest calls in progress. A call fails if it is
+ * not answered in time, or if its process exits, in which case the process is restarted after
+ * an exponential backoff. Calls are not resent, since the methods need not be idempotent.
+ *
+ * The processes are managed by a dedicated thread, on which the callbacks are invoked.
+ */
+class VcHelper : boost::noncopyable
+{
+public:
+  using ResultCallback = std::function<void(const JsonSection& result)>;
+  using ErrorCallback = std::function<void(const std::string& reason)>;
+  using EventCallback = std::function<void(const std::string& event, const JsonSection& params)>;
+
+  VcHelper(const std::string& command, const VcHelperOptions& options = {});
+
+  /**
+   * @brief Stops the helper processes, without invoking the callbacks of the calls in progress.
+   */
+  ~VcHelper();
+
+  /**
+   * @brief Calls @p method of a helper process. Thread-safe.
+   */
+  void
+  call(const std::string& method, const JsonSection& params,
+       const ResultCallback& onResult, const ErrorCallback& onError);
+
+  /**
+   * @brief Invokes @p callback for each event reported by a helper process from now on. Thread-safe.
+   */
+  void
+  subscribe(const EventCallback& callback);
+
+  /**
+   * @brief The number of times a helper process has been started.
+   */
+  size_t
+  getStartCount() const
+  {
+    return m_nStarts;
+  }
+
+private:
+  struct Process;
+
+  struct Call
+  {
+    Process* process;
+    ResultCallback onResult;
+    ErrorCallback onError;
+    std::unique_ptr<boost::asio::steady_timer> timer;
+  };
+
+  void
+  start(Process& process);
+
+  void
+  read(Process& process);
+
+  void
+  onLine(const std::string& line);
+
+  void
+  write(Process& process);
+
+  void
+  onExit(Process& process, const std::string& reason);
+
+private:
+  const std::string m_command;
+  const VcHelperOptions m_options;
+
+  boost::asio::io_context m_io;
+  boost::asio::executor_work_guard<boost::asio::io_context::executor_type> m_work;
+  // the state below is only accessed on m_thread
+  std::vector<std::unique_ptr<Process>> m_processes;
+  std::map<uint64_t, Call> m_calls;
+  std::vector<EventCallback> m_subscribers;
+  uint64_t m_lastCallId = 0;
+  std::atomic<size_t> m_nStarts{0};
+
+  std::thread m_thread;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_VC_HELPER_HPP
@@ -27,6 +27,7 @@
 #include "detail/info-encoder.hpp"
 #include "detail/request-encoder.hpp"
 #include "detail/probe-encoder.hpp"
+#include "detail/status-encoder.hpp"
 
 #include <ndn-cxx/metadata-object.hpp>
 #include <ndn-cxx/security/signing-helpers.hpp>
@@ -43,6 +44,17 @@ namespace ndncert::requester {
 
 NDN_LOG_INIT(ndncert.client);
 
+/**
+ * @brief The state token sealed by a stateless CA in @p content, or an invalid block.
+ */
+static Block
+getStateToken(const Block& content)
+{
+  content.parse();
+  auto it = content.find(tlv::StateToken);
+  return it == content.elements_end() ? Block() : *it;
+}
+
 std::shared_ptr<Interest>
 Request::genCaProfileDiscoveryInterest(const Name& caName)
 {
@@ -109,6 +121,46 @@ Request::onProbeResponse(const Data& reply, const CaProfile& ca,
   probetlv::decodeDataContent(reply.getContent(), identityNames, otherCas);
 }
 
+std::shared_ptr<Interest>
+Request::genStatusInterest(const CaProfile& ca, const std::vector<Certificate>& certs)
+{
+  if (certs.empty() || certs.size() > statustlv::MAX_DIGESTS_PER_QUERY) {
+    NDN_THROW(std::runtime_error("A status query is for between 1 and " +
+                                 std::to_string(statustlv::MAX_DIGESTS_PER_QUERY) + " certificates."));
+  }
+  std::vector<CertDigest> digests;
+  for (const auto& cert : certs) {
+    digests.push_back(getCertDigest(cert));
+  }
+
+  std::shared_ptr<Interest> interest;
+  if (digests.size() == 1) {
+    // the response to a single certificate can be shared by all the requesters
+    interest = std::make_shared<Interest>(statustlv::makeQueryName(ca.caPrefix, digests.front()));
+  }
+  else {
+    Name interestName = ca.caPrefix;
+    interestName.append("CA").append("STATUS");
+    interest = std::make_shared<Interest>(interestName);
+    interest->setApplicationParameters(statustlv::encodeApplicationParameters(digests));
+  }
+  // the response is named after the version of the revocation registry
+  interest->setCanBePrefix(true);
+  interest->setMustBeFresh(true);
+  return interest;
+}
+
+statustlv::CertStatusList
+Request::onStatusResponse(const Data& reply, const CaProfile& ca)
+{
+  if (!ndn::security::verifySignature(reply, *ca.cert)) {
+    NDN_LOG_ERROR("Cannot verify replied Data packet signature.");
+    NDN_THROW(std::runtime_error("Cannot verify replied Data packet signature."));
+  }
+  processIfError(reply);
+  return std::get<1>(statustlv::decodeDataContent(reply.getContent()));
+}
+
 Request::Request(ndn::KeyChain& keyChain, const CaProfile& profile, RequestType requestType)
   : m_caProfile(profile)
   , m_type(requestType)
@@ -121,6 +173,29 @@ Request::genNewInterest(const Name& keyName,
                         const time::system_clock::TimePoint& notBefore,
                         const time::system_clock::TimePoint& notAfter)
 {
+  return genNewInterest(keyName, notBefore, notAfter, "", {});
+}
+
+std::shared_ptr<Interest>
+Request::genNewInterest(const Name& keyName,
+                        const time::system_clock::TimePoint& notBefore,
+                        const time::system_clock::TimePoint& notAfter,
+                        const std::string& challengeSelected,
+                        std::multimap<std::string, std::string>&& parameters)
+{
+  Block embeddedChallenge;
+  if (!challengeSelected.empty()) {
+    auto challenge = ChallengeModule::createChallengeModule(challengeSelected);
+    if (challenge == nullptr) {
+      NDN_THROW(std::runtime_error("The challenge selected is not supported by your current version of NDNCERT."));
+    }
+    if (!challenge->canEmbedInNew()) {
+      NDN_THROW(std::runtime_error("The parameters of the challenge selected cannot be sent unencrypted."));
+    }
+    embeddedChallenge = challenge->genChallengeRequestTLV(Status::BEFORE_CHALLENGE, "", parameters);
+    m_challengeType = challengeSelected;
+  }
+
   if (!m_caProfile.caPrefix.isPrefixOf(keyName)) {
     return nullptr;
   }
@@ -135,14 +210,7 @@ Request::genNewInterest(const Name& keyName,
     m_keyPair = identity.getKey(keyName);
   }
 
-  // generate certificate request
-  Certificate certRequest;
-  certRequest.setName(Name(keyName).append("cert-request").appendVersion());
-  certRequest.setContentType(ndn::tlv::ContentType_Key);
-  certRequest.setContent(m_keyPair.getPublicKey());
-  SignatureInfo signatureInfo;
-  signatureInfo.setValidityPeriod(ndn::security::ValidityPeriod(notBefore, notAfter));
-  m_keyChain.sign(certRequest, signingByKey(keyName).setSignatureInfo(signatureInfo));
+  auto certRequest = genCertRequest(notBefore, notAfter);
 
   // generate Interest packet
   Name interestName = m_caProfile.caPrefix;
@@ -150,13 +218,61 @@ Request::genNewInterest(const Name& keyName,
   auto interest = std::make_shared<Interest>(interestName);
   interest->setMustBeFresh(true);
   interest->setApplicationParameters(
-    requesttlv::encodeApplicationParameters(RequestType::NEW, m_ecdh.getSelfPubKey(), certRequest));
+    requesttlv::encodeApplicationParameters(RequestType::NEW, m_ecdh.getSelfPubKey(), certRequest,
+                                            embeddedChallenge));
 
   // sign the Interest packet
   m_keyChain.sign(*interest, signingByKey(keyName));
   return interest;
 }
 
+std::shared_ptr<Interest>
+Request::genRenewInterest(const Certificate& certificate, const Name& keyName,
+                          const time::system_clock::TimePoint& notBefore,
+                          const time::system_clock::TimePoint& notAfter)
+{
+  if (!m_caProfile.caPrefix.isPrefixOf(keyName) ||
+      ndn::security::extractIdentityFromKeyName(keyName) != certificate.getIdentity()) {
+    return nullptr;
+  }
+  m_identityName = certificate.getIdentity();
+  m_keyPair = m_keyChain.getPib().getIdentity(m_identityName).getKey(keyName);
+  auto certRequest = genCertRequest(notBefore, notAfter);
+
+  // generate Interest packet
+  Name interestName = m_caProfile.caPrefix;
+  interestName.append("CA").append("RENEW");
+  auto interest = std::make_shared<Interest>(interestName);
+  interest->setMustBeFresh(true);
+  interest->setApplicationParameters(requesttlv::encodeRenewApplicationParameters(certRequest, certificate));
+
+  // the key of the certificate to renew authorizes the renewal
+  m_keyChain.sign(*interest, signingByKey(certificate.getKeyName()));
+  return interest;
+}
+
+std::shared_ptr<Certificate>
+Request::onRenewResponse(const Data& reply)
+{
+  if (!ndn::security::verifySignature(reply, *m_caProfile.cert)) {
+    NDN_LOG_ERROR("Cannot verify replied Data packet signature.");
+    NDN_THROW(std::runtime_error("Cannot verify replied Data packet signature."));
+  }
+  processIfError(reply);
+
+  auto issuedCert = requesttlv::decodeRenewDataContent(reply.getContent());
+  if (issuedCert->getKeyName() != m_keyPair.getName() ||
+      !ndn::security::verifySignature(*issuedCert, *m_caProfile.cert)) {
+    NDN_LOG_ERROR("The renewed certificate is not for the requested key or not issued by the CA.");
+    NDN_THROW(std::runtime_error("The renewed certificate is not for the requested key or not issued by the CA."));
+  }
+  m_keyChain.addCertificate(m_keyPair, *issuedCert);
+  m_status = Status::SUCCESS;
+  m_issuedCertName = issuedCert->getName();
+  m_issuedCert = issuedCert;
+  return issuedCert;
+}
+
 std::shared_ptr<Interest>
 Request::genRevokeInterest(const Certificate& certificate)
 {
@@ -187,6 +303,11 @@ Request::onNewRenewRevokeResponse(const Data& reply)
   std::vector<uint8_t> ecdhKey;
   std::array<uint8_t, 32> salt;
   auto challenges = requesttlv::decodeDataContent(contentTLV, ecdhKey, salt, m_requestId);
+  m_stateToken = getStateToken(contentTLV);
+  auto hint = contentTLV.find(tlv::ChallengeForwardingHint);
+  if (hint != contentTLV.elements_end()) {
+    m_challengeForwardingHint = Name(hint->blockFromValue());
+  }
 
   // ECDH and HKDF
   auto sharedSecret = m_ecdh.deriveSecret(ecdhKey);
@@ -194,6 +315,12 @@ Request::onNewRenewRevokeResponse(const Data& reply)
        salt.data(), salt.size(), m_aesKey.data(), m_aesKey.size(),
        m_requestId.data(), m_requestId.size());
 
+  // the CA handled the challenge carried by the NEW interest
+  auto challengeResponse = requesttlv::decodeEmbeddedChallengeResponse(contentTLV);
+  if (challengeResponse) {
+    challengetlv::decodeDataContent(*challengeResponse, *this);
+  }
+
   // update state
   return challenges;
 }
@@ -225,12 +352,20 @@ Request::genChallengeInterest(std::multimap<std::string, std::string>&& paramete
   interestName.append("CA").append("CHALLENGE").append(Name::Component(m_requestId));
   auto interest = std::make_shared<Interest>(interestName);
   interest->setMustBeFresh(true);
+  if (!m_challengeForwardingHint.empty()) {
+    interest->setForwardingHint({m_challengeForwardingHint});
+  }
 
   // encrypt the Interest parameters
   auto paramBlock = encodeBlockWithAesGcm128(ndn::tlv::ApplicationParameters, m_aesKey.data(),
                                              challengeParams.value(), challengeParams.value_size(),
                                              m_requestId.data(), m_requestId.size(),
                                              m_encryptionIv);
+  if (m_stateToken.isValid()) {
+    paramBlock.parse();
+    paramBlock.push_back(m_stateToken);
+    paramBlock.encode();
+  }
   interest->setApplicationParameters(paramBlock);
   m_keyChain.sign(*interest, signingByKey(m_keyPair.getName()));
   return interest;
@@ -245,6 +380,18 @@ Request::onChallengeResponse(const Data& reply)
   }
   processIfError(reply);
   challengetlv::decodeDataContent(reply.getContent(), *this);
+  m_stateToken = getStateToken(reply.getContent());
+
+  if (m_issuedCert) {
+    if (m_status != Status::SUCCESS || m_issuedCert->getName() != m_issuedCertName ||
+        m_issuedCert->getKeyName() != m_keyPair.getName() ||
+        !ndn::security::verifySignature(*m_issuedCert, *m_caProfile.cert)) {
+      NDN_LOG_WARN("Ignoring the certificate returned by the CA, fetching it by name instead");
+      m_issuedCert = nullptr;
+      return;
+    }
+    m_keyChain.addCertificate(m_keyPair, *m_issuedCert);
+  }
 }
 
 std::shared_ptr<Interest>
@@ -269,6 +416,20 @@ Request::onCertFetchResponse(const Data& reply)
   }
 }
 
+Certificate
+Request::genCertRequest(const time::system_clock::TimePoint& notBefore,
+                        const time::system_clock::TimePoint& notAfter)
+{
+  Certificate certRequest;
+  certRequest.setName(Name(m_keyPair.getName()).append("cert-request").appendVersion());
+  certRequest.setContentType(ndn::tlv::ContentType_Key);
+  certRequest.setContent(m_keyPair.getPublicKey());
+  SignatureInfo signatureInfo;
+  signatureInfo.setValidityPeriod(ndn::security::ValidityPeriod(notBefore, notAfter));
+  m_keyChain.sign(certRequest, signingByKey(m_keyPair.getName()).setSignatureInfo(signatureInfo));
+  return certRequest;
+}
+
 void
 Request::processIfError(const Data& data)
 {
@@ -24,6 +24,7 @@
 #include "detail/ca-request-state.hpp"
 #include "detail/crypto-helpers.hpp"
 #include "detail/profile-storage.hpp"
+#include "detail/status-encoder.hpp"
 
 #include <ndn-cxx/security/key-chain.hpp>
 
@@ -103,6 +104,30 @@ public:
   onProbeResponse(const Data& reply, const CaProfile& ca,
                   std::vector<std::pair<Name, int>>& identityNames, std::vector<Name>& otherCas);
 
+  /**
+   * @brief Generates a STATUS Interest querying the status of @p certs.
+   *
+   * @param ca the profile of the CA that issued the certificates
+   * @param certs between 1 and statustlv::MAX_DIGESTS_PER_QUERY certificates
+   * @return A shared pointer to an Interest ready to be sent.
+   * @throw std::runtime_error if there are no or too many certificates.
+   */
+  static std::shared_ptr<Interest>
+  genStatusInterest(const CaProfile& ca, const std::vector<Certificate>& certs);
+
+  /**
+   * @brief Decodes the replied data for STATUS process from the CA.
+   *
+   * Will first verify the signature of the packet using the key provided inside the profile.
+   *
+   * @param reply The replied data packet
+   * @param ca the profile of the CA that replies the packet
+   * @return The status of each certificate, in the order of the query.
+   * @throw std::runtime_error if the decoding fails or receiving an error packet.
+   */
+  static statustlv::CertStatusList
+  onStatusResponse(const Data& reply, const CaProfile& ca);
+
   explicit
   Request(ndn::KeyChain& keyChain, const CaProfile& profile, RequestType requestType);
 
@@ -121,6 +146,54 @@ public:
                  const time::system_clock::TimePoint& notBefore,
                  const time::system_clock::TimePoint& notAfter);
 
+  /**
+   * @brief Generates a NEW interest that also carries the first round of a challenge.
+   *
+   * This saves the CHALLENGE round trip that would otherwise select the challenge. The
+   * parameters are signed with the NEW interest but not encrypted, since the key of the request
+   * is only known from the reply, so only challenges that ChallengeModule::canEmbedInNew() are
+   * accepted. A CA that does not handle the challenge replies as to a plain NEW interest, which
+   * onNewRenewRevokeResponse() leaves in the BEFORE_CHALLENGE status.
+   *
+   * @param challengeSelected The selected challenge.
+   * @param parameters The parameters of the challenge before it starts, in name, value mapping.
+   * @throw std::runtime_error if the challenge is not supported or cannot be embedded.
+   */
+  std::shared_ptr<Interest>
+  genNewInterest(const Name& keyName,
+                 const time::system_clock::TimePoint& notBefore,
+                 const time::system_clock::TimePoint& notAfter,
+                 const std::string& challengeSelected,
+                 std::multimap<std::string, std::string>&& parameters);
+
+  /**
+   * @brief Generates a RENEW interest to the CA.
+   *
+   * The interest is signed by the key of @p certificate, a still valid certificate issued by the
+   * CA, which issues the new certificate without challenge.
+   *
+   * @param certificate The certificate to renew.
+   * @param keyName The key to certify, which is the key of @p certificate or another key of its identity.
+   * @param notBefore The expected notBefore field for the certificate (starting time)
+   * @param notAfter The expected notAfter field for the certificate (expiration time)
+   * @return The shared pointer to the encoded interest, nullptr if @p keyName does not belong to
+   *         the identity of @p certificate.
+   */
+  std::shared_ptr<Interest>
+  genRenewInterest(const Certificate& certificate, const Name& keyName,
+                   const time::system_clock::TimePoint& notBefore,
+                   const time::system_clock::TimePoint& notAfter);
+
+  /**
+   * @brief Decodes the replied data of RENEW interest, and installs the issued certificate to the keychain.
+   *
+   * @param reply The replied data from the network
+   * @return The issued certificate.
+   * @throw std::runtime_error if the decoding fails or receiving an error packet.
+   */
+  std::shared_ptr<Certificate>
+  onRenewResponse(const Data& reply);
+
   /**
    * @brief Generates a REVOKE interest to the CA.
    *
@@ -135,6 +208,9 @@ public:
    * @brief Decodes the replied data of NEW, RENEW, or REVOKE interest from the CA.
    *
    * @param state The current requester state for the request. Will be updated in the function.
+   * If the CA handled the challenge carried by the NEW interest, its reply is decoded as by
+   * onChallengeResponse().
+   *
    * @param reply The replied data from the network
    * @return the list of challenge accepted by the CA, for CHALLENGE step.
    * @throw std::runtime_error if the decoding fails or receiving an error packet.
@@ -169,6 +245,10 @@ public:
   /**
    * @brief Decodes the responded data from the CHALLENGE interest.
    *
+   * If the CA returned the issued certificate along, it is checked against the CA certificate
+   * and installed to the keychain, and kept in m_issuedCert. Otherwise, it is fetched with
+   * genCertFetchInterest().
+   *
    * @param state, the corresponding requester state of the request. Will be modified.
    * @param reply, the response data.
    * @throw std::runtime_error if the decoding fails or receiving an error packet.
@@ -195,6 +275,13 @@ public:
   onCertFetchResponse(const Data& reply);
 
 private:
+  /**
+   * @brief Generates the self-signed certificate request of m_keyPair.
+   */
+  Certificate
+  genCertRequest(const time::system_clock::TimePoint& notBefore,
+                 const time::system_clock::TimePoint& notAfter);
+
   static void
   processIfError(const Data& data);
 
@@ -239,6 +326,10 @@ public:
    * @brief the name of the certificate being issued.
    */
   Name m_issuedCertName;
+  /**
+   * @brief The issued certificate, when the CA returned it with the CHALLENGE response.
+   */
+  std::shared_ptr<Certificate> m_issuedCert;
   /**
    * @brief The optional forwarding hint.
    */
@@ -263,6 +354,14 @@ public:
    * @brief Store Nonce for signature
    */
   std::array<uint8_t, 16> m_nonce = {};
+  /**
+   * @brief The request state sealed by a stateless CA, echoed in the next CHALLENGE.
+   */
+  Block m_stateToken;
+  /**
+   * @brief The forwarding hint of the CA instance keeping the request, used by CHALLENGE Interests.
+   */
+  Name m_challengeForwardingHint;
 
 private:
   /**
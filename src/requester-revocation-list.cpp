@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "requester-revocation-list.hpp"
+
+#include "detail/error-encoder.hpp"
+
+#include <ndn-cxx/metadata-object.hpp>
+#include <ndn-cxx/security/verification-helpers.hpp>
+
+namespace ndncert::requester {
+
+NDN_LOG_INIT(ndncert.client.revocation);
+
+RevocationList::RevocationList(const Name& caPrefix, std::shared_ptr<Certificate> caCert)
+  : m_caPrefix(caPrefix)
+  , m_caCert(std::move(caCert))
+{
+}
+
+std::shared_ptr<Interest>
+RevocationList::genDiscoveryInterest() const
+{
+  Name contentName = m_caPrefix;
+  contentName.append("CA").append("REVOKED");
+  return std::make_shared<Interest>(ndn::MetadataObject::makeDiscoveryInterest(contentName));
+}
+
+std::shared_ptr<Interest>
+RevocationList::onDiscoveryResponse(const Data& reply)
+{
+  verify(reply);
+  auto versionedName = ndn::MetadataObject(reply).getVersionedName();
+  auto latest = revocationtlv::makeDatasetName(m_caPrefix, versionedName.at(-1).toVersion());
+  if (latest != versionedName) {
+    NDN_THROW(std::runtime_error("Unexpected revocation dataset " + versionedName.toUri()));
+  }
+
+  m_fetchVersion = versionedName.at(-1).toVersion();
+  if (m_fetchVersion < m_version) {
+    NDN_THROW(std::runtime_error("The revocation dataset of the CA is older than the local copy"));
+  }
+  if (m_fetchVersion == m_version) {
+    NDN_LOG_TRACE("Revocation list is up to date at version " << m_version);
+    return nullptr;
+  }
+  m_fetchName = m_version == 0 ? latest : revocationtlv::makeDatasetName(m_caPrefix, m_fetchVersion, m_version);
+  m_fetched.clear();
+  return genSegmentInterest(0);
+}
+
+std::shared_ptr<Interest>
+RevocationList::onSegmentResponse(const Data& reply)
+{
+  verify(reply);
+  const auto& name = reply.getName();
+  if (m_fetchName.empty() || !reply.getFinalBlock() ||
+      name.size() != m_fetchName.size() + 1 || !m_fetchName.isPrefixOf(name) || !name.at(-1).isSegment() ||
+      name.at(-1).toSegment() * revocationtlv::DIGESTS_PER_SEGMENT != m_fetched.size()) {
+    NDN_THROW(std::runtime_error("Unexpected revocation dataset segment " + name.toUri()));
+  }
+
+  auto digests = revocationtlv::decodeDataContent(reply.getContent());
+  m_fetched.insert(m_fetched.end(), digests.begin(), digests.end());
+  auto segment = name.at(-1).toSegment();
+  if (reply.getFinalBlock()->toSegment() > segment) {
+    return genSegmentInterest(segment + 1);
+  }
+
+  m_revoked.insert(m_fetched.begin(), m_fetched.end());
+  NDN_LOG_DEBUG("Revocation list updated from version " << m_version << " to " << m_fetchVersion
+                << " with " << m_fetched.size() << " revocations");
+  m_version = m_fetchVersion;
+  m_fetchName.clear();
+  m_fetched.clear();
+  return nullptr;
+}
+
+bool
+RevocationList::isRevoked(const Certificate& cert) const
+{
+  return m_revoked.count(getCertDigest(cert)) > 0;
+}
+
+void
+RevocationList::verify(const Data& reply) const
+{
+  if (!ndn::security::verifySignature(reply, *m_caCert)) {
+    NDN_LOG_ERROR("Cannot verify replied Data packet signature.");
+    NDN_THROW(std::runtime_error("Cannot verify replied Data packet signature."));
+  }
+  // the segments of the dataset are the only replies with a final block
+  if (reply.getFinalBlock()) {
+    return;
+  }
+  auto errorInfo = errortlv::decodefromDataContent(reply.getContent());
+  if (std::get<0>(errorInfo) != ErrorCode::NO_ERROR) {
+    NDN_THROW(std::runtime_error("Error info replied from the CA: " + std::get<1>(errorInfo)));
+  }
+}
+
+std::shared_ptr<Interest>
+RevocationList::genSegmentInterest(uint64_t segment) const
+{
+  return std::make_shared<Interest>(Name(m_fetchName).appendSegment(segment));
+}
+
+} // namespace ndncert::requester
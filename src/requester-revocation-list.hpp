@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_REQUESTER_REVOCATION_LIST_HPP
+#define NDNCERT_REQUESTER_REVOCATION_LIST_HPP
+
+#include "detail/revocation-encoder.hpp"
+
+#include <set>
+
+namespace ndncert::requester {
+
+/**
+ * @brief Local copy of the revocation dataset of a CA, see revocationtlv.
+ *
+ * The first synchronization fetches the whole dataset, later ones only the changes since the
+ * local version. The local copy is only updated once all the segments of a version are fetched.
+ */
+class RevocationList : boost::noncopyable
+{
+public:
+  RevocationList(const Name& caPrefix, std::shared_ptr<Certificate> caCert);
+
+  /**
+   * @brief Generates the Interest discovering the latest version of the dataset.
+   */
+  std::shared_ptr<Interest>
+  genDiscoveryInterest() const;
+
+  /**
+   * @brief Handles the reply to the discovery Interest.
+   *
+   * @return The Interest fetching the first segment, or nullptr if the local copy is up to date.
+   * @throw std::runtime_error if the reply cannot be verified or is an error packet.
+   */
+  std::shared_ptr<Interest>
+  onDiscoveryResponse(const Data& reply);
+
+  /**
+   * @brief Handles the reply to a segment Interest.
+   *
+   * @return The Interest fetching the next segment, or nullptr once the local copy is updated.
+   * @throw std::runtime_error if the reply cannot be verified, is an error packet or is not
+   *        the expected segment.
+   */
+  std::shared_ptr<Interest>
+  onSegmentResponse(const Data& reply);
+
+  bool
+  isRevoked(const Certificate& cert) const;
+
+  uint64_t
+  getVersion() const
+  {
+    return m_version;
+  }
+
+private:
+  void
+  verify(const Data& reply) const;
+
+  std::shared_ptr<Interest>
+  genSegmentInterest(uint64_t segment) const;
+
+private:
+  const Name m_caPrefix;
+  const std::shared_ptr<Certificate> m_caCert;
+  uint64_t m_version = 0;
+  std::set<CertDigest> m_revoked;
+
+  // the version being fetched
+  Name m_fetchName;
+  uint64_t m_fetchVersion = 0;
+  std::vector<CertDigest> m_fetched;
+};
+
+} // namespace ndncert::requester
+
+#endif // NDNCERT_REQUESTER_REVOCATION_LIST_HPP
@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/admission-control.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/clock-fixture.hpp"
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+BOOST_FIXTURE_TEST_SUITE(TestAdmissionControl, ClockFixture)
+
+BOOST_AUTO_TEST_CASE(Bucket)
+{
+  TokenBucket bucket({10, 2});
+  BOOST_CHECK(bucket.canConsume());
+  bucket.consume();
+  bucket.consume();
+  BOOST_CHECK(!bucket.canConsume());
+
+  advanceClocks(50_ms);
+  BOOST_CHECK(!bucket.canConsume());
+  advanceClocks(50_ms);
+  BOOST_CHECK(bucket.canConsume());
+  BOOST_CHECK(!bucket.canConsume(1));
+
+  // never more than the burst
+  advanceClocks(10_s);
+  BOOST_CHECK_CLOSE(bucket.getTokens(), 2, 0.001);
+}
+
+BOOST_AUTO_TEST_CASE(EndpointLimits)
+{
+  AdmissionConfig config;
+  config.endpointLimits[static_cast<size_t>(CaEndpoint::NEW)] = TokenBucketConfig{1, 2};
+  AdmissionController admission(config);
+
+  BOOST_CHECK(admission.admit(CaEndpoint::NEW));
+  BOOST_CHECK(admission.admit(CaEndpoint::NEW));
+  BOOST_CHECK(!admission.admit(CaEndpoint::NEW));
+  // other endpoints are not limited
+  for (int i = 0; i < 10; i++) {
+    BOOST_CHECK(admission.admit(CaEndpoint::CHALLENGE));
+  }
+
+  advanceClocks(1_s);
+  BOOST_CHECK(admission.admit(CaEndpoint::NEW));
+
+  auto statistics = admission.getStatistics();
+  BOOST_CHECK_EQUAL(statistics.nAdmitted[static_cast<size_t>(CaEndpoint::NEW)], 3);
+  BOOST_CHECK_EQUAL(statistics.nShed[static_cast<size_t>(CaEndpoint::NEW)], 1);
+  BOOST_CHECK_EQUAL(statistics.nAdmitted[static_cast<size_t>(CaEndpoint::CHALLENGE)], 10);
+  BOOST_CHECK_EQUAL(statistics.nShed[static_cast<size_t>(CaEndpoint::CHALLENGE)], 0);
+}
+
+BOOST_AUTO_TEST_CASE(ChallengePriority)
+{
+  AdmissionConfig config;
+  config.totalLimit = TokenBucketConfig{1, 10};
+  config.challengeReserve = 0.5;
+  AdmissionController admission(config);
+
+  // NEW leaves half of the shared bucket to CHALLENGE
+  int nNew = 0;
+  while (admission.admit(CaEndpoint::NEW)) {
+    nNew++;
+  }
+  BOOST_CHECK_EQUAL(nNew, 5);
+  int nChallenge = 0;
+  while (admission.admit(CaEndpoint::CHALLENGE)) {
+    nChallenge++;
+  }
+  BOOST_CHECK_EQUAL(nChallenge, 5);
+
+  // a loaded storage queue sheds NEW only
+  advanceClocks(10_s);
+  BOOST_CHECK(!admission.admit(CaEndpoint::NEW, std::nullopt, 0.8));
+  BOOST_CHECK(admission.admit(CaEndpoint::CHALLENGE, std::nullopt, 0.8));
+  BOOST_CHECK_EQUAL(admission.getStatistics().nShedByLoad, 1);
+}
+
+BOOST_AUTO_TEST_CASE(KeyLocatorLimits)
+{
+  AdmissionConfig config;
+  config.keyLocatorLimit = TokenBucketConfig{1, 2};
+  config.maxKeyLocators = 2;
+  AdmissionController admission(config);
+
+  Name alice("/ndn/alice/KEY/1");
+  Name bob("/ndn/bob/KEY/1");
+  Name carol("/ndn/carol/KEY/1");
+  BOOST_CHECK(admission.admit(CaEndpoint::NEW, alice));
+  BOOST_CHECK(admission.admit(CaEndpoint::CHALLENGE, alice));
+  BOOST_CHECK(!admission.admit(CaEndpoint::CHALLENGE, alice));
+  BOOST_CHECK(admission.admit(CaEndpoint::NEW, bob));
+  // unsigned Interests are not limited
+  BOOST_CHECK(admission.admit(CaEndpoint::PROBE));
+
+  // carol takes the bucket of alice, the least recently seen key
+  BOOST_CHECK(admission.admit(CaEndpoint::NEW, carol));
+  auto statistics = admission.getStatistics();
+  BOOST_CHECK_EQUAL(statistics.nKeyLocators, 2);
+  BOOST_CHECK_EQUAL(statistics.nShedByKeyLocator, 1);
+  BOOST_CHECK(admission.admit(CaEndpoint::NEW, alice));
+}
+
+BOOST_AUTO_TEST_CASE(NothingConsumedWhenShed)
+{
+  AdmissionConfig config;
+  config.endpointLimits[static_cast<size_t>(CaEndpoint::NEW)] = TokenBucketConfig{1, 1};
+  config.keyLocatorLimit = TokenBucketConfig{1, 1};
+  AdmissionController admission(config);
+
+  Name alice("/ndn/alice/KEY/1");
+  Name bob("/ndn/bob/KEY/1");
+  BOOST_CHECK(admission.admit(CaEndpoint::NEW, alice));
+  // shed by the NEW bucket, the bucket of bob stays full
+  BOOST_CHECK(!admission.admit(CaEndpoint::NEW, bob));
+  BOOST_CHECK(admission.admit(CaEndpoint::CHALLENGE, bob));
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestAdmissionControl
+
+} // namespace ndncert::tests
@@ -20,6 +20,9 @@
 
 #include "ca-module.hpp"
 #include "challenge/challenge-pin.hpp"
+#include "detail/ca-journaled-memory.hpp"
+#include "detail/ca-mmap.hpp"
+#include "detail/ca-sqlite.hpp"
 #include "detail/info-encoder.hpp"
 #include "requester-request.hpp"
 
@@ -30,6 +33,10 @@
 #include <ndn-cxx/security/verification-helpers.hpp>
 #include <ndn-cxx/util/dummy-client-face.hpp>
 
+#include <boost/filesystem.hpp>
+
+#include <chrono>
+
 namespace ndncert::tests {
 
 BOOST_FIXTURE_TEST_SUITE(Benchmark, IoKeyChainFixture)
@@ -170,6 +177,107 @@ BOOST_AUTO_TEST_CASE(PacketSize1)
   BOOST_CHECK_EQUAL(count, 3);
 }
 
+static void
+measureStorageLatency(const std::string& label, ca::CaStorage& storage, const Certificate& cert)
+{
+  const int nRequests = 500;
+  using Clock = std::chrono::steady_clock;
+  auto report = [&] (const std::string& operation, Clock::time_point start) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+    BOOST_TEST_MESSAGE(label << " " << operation << ": " << elapsed.count() / nRequests << " us/op");
+  };
+
+  std::vector<ca::RequestState> requests(nRequests);
+  for (int i = 0; i < nRequests; i++) {
+    requests[i].caPrefix = Name("/ndn");
+    requests[i].requestId = {{static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i)}};
+    requests[i].requestType = RequestType::NEW;
+    requests[i].cert = cert;
+  }
+
+  auto start = Clock::now();
+  for (const auto& request : requests) {
+    storage.addRequest(request);
+  }
+  report("add", start);
+
+  start = Clock::now();
+  for (const auto& request : requests) {
+    storage.getRequest(request.requestId);
+  }
+  report("get", start);
+
+  start = Clock::now();
+  for (auto& request : requests) {
+    request.status = Status::CHALLENGE;
+    request.challengeType = "pin";
+    request.challengeState = ca::ChallengeState("need-code", time::system_clock::now(), 3,
+                                                time::seconds(300), JsonSection());
+    storage.updateRequest(request);
+  }
+  report("update", start);
+
+  start = Clock::now();
+  for (const auto& request : requests) {
+    storage.deleteRequest(request.requestId);
+  }
+  report("delete", start);
+  BOOST_CHECK(storage.listAllRequests().empty());
+}
+
+BOOST_AUTO_TEST_CASE(StorageLatency)
+{
+  auto cert = m_keyChain.createIdentity(Name("/ndn/site1")).getDefaultKey().getDefaultCertificate();
+  auto dir = boost::filesystem::path(UNIT_TESTS_TMPDIR) / "bench-storage";
+  boost::filesystem::create_directories(dir);
+  {
+    ca::CaSqlite sqliteStorage(Name(), (dir / "bench.db").string());
+    measureStorageLatency("ca-storage-sqlite3", sqliteStorage, cert);
+    ca::CaMmap mmapStorage(Name(), (dir / "bench.mmap").string());
+    measureStorageLatency("ca-storage-mmap", mmapStorage, cert);
+  }
+  boost::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(JournaledStartup)
+{
+  // NDNCERT_BENCH_ENTRIES=1000000 measures the startup of a large CA; the default keeps the suite fast
+  size_t nRequests = 20000;
+  if (getenv("NDNCERT_BENCH_ENTRIES") != nullptr) {
+    nRequests = std::stoul(getenv("NDNCERT_BENCH_ENTRIES"));
+  }
+  auto dir = boost::filesystem::path(UNIT_TESTS_TMPDIR) / "bench-journaled";
+  boost::filesystem::create_directories(dir);
+  auto location = (dir / "ca").string() + "?fsync=never&snapshot-interval=0&snapshot-bytes=0";
+
+  ca::RequestState request;
+  request.caPrefix = Name("/ndn");
+  request.requestId = {};
+  request.requestType = RequestType::NEW;
+  request.cert = m_keyChain.createIdentity(Name("/ndn/site1")).getDefaultKey().getDefaultCertificate();
+  {
+    ca::CaJournaledMemory storage(Name(), location);
+    for (size_t i = 0; i < nRequests; i++) {
+      uint32_t id = static_cast<uint32_t>(i);
+      std::memcpy(request.requestId.data(), &id, sizeof(id));
+      storage.addRequest(request);
+      if (i == nRequests / 2) {
+        // half of the requests end up in the snapshot, the other half in the journal
+        storage.snapshot();
+      }
+    }
+  }
+
+  {
+    ca::CaJournaledMemory storage(Name(), location);
+    auto stats = storage.getStatistics();
+    BOOST_CHECK_EQUAL(storage.listAllRequests().size(), nRequests);
+    BOOST_TEST_MESSAGE("ca-storage-journaled-memory startup with " << nRequests << " requests: "
+                       << time::duration_cast<time::milliseconds>(stats.replayDuration));
+  }
+  boost::filesystem::remove_all(dir);
+}
+
 BOOST_AUTO_TEST_SUITE_END() // Benchmark
 
 } // namespace ndncert::tests
@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/ca-async-storage.hpp"
+#include "detail/ca-memory.hpp"
+
+#include "tests/boost-test.hpp"
+
+#include <boost/asio/executor_work_guard.hpp>
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+static RequestState
+makeRequest(uint8_t id, Status status = Status::BEFORE_CHALLENGE)
+{
+  RequestState request;
+  request.caPrefix = Name("/ndn");
+  request.requestId = {{id}};
+  request.status = status;
+  return request;
+}
+
+BOOST_AUTO_TEST_SUITE(TestCaAsyncStorage)
+
+BOOST_AUTO_TEST_CASE(Inline)
+{
+  CaMemory storage;
+  InlineAsyncCaStorage async(storage);
+
+  std::vector<std::string> events;
+  auto onFailure = [&] (const std::string&) { events.push_back("failure"); };
+  async.addRequest(makeRequest(1), [&] { events.push_back("added"); }, onFailure);
+  async.addRequest(makeRequest(1), [&] { events.push_back("added"); }, onFailure);
+  async.updateRequest(makeRequest(1, Status::CHALLENGE), [&] { events.push_back("updated"); }, onFailure);
+  async.getRequest(makeRequest(1).requestId, [&] (const RequestState& request) {
+    BOOST_CHECK(request.status == Status::CHALLENGE);
+    events.push_back("got");
+  }, onFailure);
+  async.deleteRequest(makeRequest(1).requestId, [&] { events.push_back("deleted"); }, onFailure);
+  async.getRequest(makeRequest(1).requestId, [&] (const auto&) { events.push_back("got"); }, onFailure);
+
+  // completions run before each operation returns
+  std::vector<std::string> expected{"added", "failure", "updated", "got", "deleted", "failure"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(events.begin(), events.end(), expected.begin(), expected.end());
+}
+
+class FailingCaMemory : public CaMemory
+{
+public:
+  void
+  addRequest(const RequestState&) override
+  {
+    NDN_THROW(std::runtime_error("disk full"));
+  }
+};
+
+BOOST_AUTO_TEST_CASE(AddDuplicate)
+{
+  CaMemory storage;
+  InlineAsyncCaStorage async(storage);
+  std::vector<std::string> events;
+  auto onSuccess = [&] { events.push_back("added"); };
+  auto onDuplicate = [&] (const std::string&) { events.push_back("duplicate"); };
+  auto onFailure = [&] (const std::string&) { events.push_back("failure"); };
+  async.addRequest(makeRequest(1), onSuccess, onDuplicate, onFailure);
+  async.addRequest(makeRequest(1), onSuccess, onDuplicate, onFailure);
+
+  // a storage error is not mistaken for a duplicate
+  FailingCaMemory failingStorage;
+  InlineAsyncCaStorage failingAsync(failingStorage);
+  failingAsync.addRequest(makeRequest(1), onSuccess, onDuplicate, [&] (const std::string& reason) {
+    BOOST_CHECK_EQUAL(reason, "disk full");
+    events.push_back("failure");
+  });
+
+  std::vector<std::string> expected{"added", "duplicate", "failure"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(events.begin(), events.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(Threaded)
+{
+  CaMemory storage;
+  boost::asio::io_context io;
+  auto work = boost::asio::make_work_guard(io);
+  ThreadedAsyncCaStorage async(storage, io, 16);
+
+  const auto ioThread = std::this_thread::get_id();
+  std::vector<std::string> events;
+  auto onFailure = [&] (const std::string&) { events.push_back("failure"); };
+  auto record = [&] (const std::string& event) {
+    return [&, event] {
+      BOOST_CHECK(std::this_thread::get_id() == ioThread);
+      events.push_back(event);
+    };
+  };
+  async.addRequest(makeRequest(1), record("added"), onFailure);
+  async.updateRequest(makeRequest(1, Status::CHALLENGE), record("updated"), onFailure);
+  async.getRequest(makeRequest(1).requestId, [&] (const RequestState& request) {
+    BOOST_CHECK(request.status == Status::CHALLENGE);
+    events.push_back("got");
+  }, onFailure);
+  async.deleteRequest(makeRequest(1).requestId, [&] {
+    events.push_back("deleted");
+    work.reset();
+  }, onFailure);
+
+  // nothing completes until the io_context runs
+  BOOST_CHECK(events.empty());
+  io.run();
+
+  std::vector<std::string> expected{"added", "updated", "got", "deleted"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(events.begin(), events.end(), expected.begin(), expected.end());
+  BOOST_CHECK(storage.listAllRequests().empty());
+}
+
+BOOST_AUTO_TEST_CASE(QueueFull)
+{
+  CaMemory storage;
+  boost::asio::io_context io;
+  ThreadedAsyncCaStorage async(storage, io, 0);
+
+  std::string failure;
+  async.addRequest(makeRequest(1), [] { BOOST_ERROR("unexpected success"); },
+                   [] (const std::string&) { BOOST_ERROR("unexpected duplicate"); },
+                   [&] (const std::string& reason) { failure = reason; });
+  io.run();
+  BOOST_CHECK_EQUAL(failure, "Storage queue is full");
+  BOOST_CHECK(storage.listAllRequests().empty());
+}
+
+BOOST_AUTO_TEST_CASE(SharedThread)
+{
+  // one adapter per Face, over the same storage
+  CaMemory storage;
+  auto thread = std::make_shared<CaStorageThread>(16);
+  boost::asio::io_context io1;
+  boost::asio::io_context io2;
+  auto work1 = boost::asio::make_work_guard(io1);
+  auto work2 = boost::asio::make_work_guard(io2);
+  ThreadedAsyncCaStorage async1(storage, io1, thread);
+  auto async2 = std::make_unique<ThreadedAsyncCaStorage>(storage, io2, thread);
+
+  std::vector<std::string> events1;
+  std::vector<std::string> events2;
+  auto onFailure = [] (const std::string& reason) { BOOST_ERROR(reason); };
+  async1.addRequest(makeRequest(1), [&] { events1.push_back("added"); }, onFailure);
+  async2->addRequest(makeRequest(2), [&] {
+    events2.push_back("added");
+    work2.reset();
+  }, onFailure);
+  async1.getRequest(makeRequest(2).requestId, [&] (const auto&) {
+    events1.push_back("got");
+    work1.reset();
+  }, onFailure);
+
+  // each completion runs on the io_context of its adapter
+  io1.run();
+  BOOST_CHECK_EQUAL(events1.size(), 2);
+  BOOST_CHECK(events2.empty());
+  io2.run();
+  BOOST_CHECK_EQUAL(events2.size(), 1);
+  BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 2);
+  BOOST_CHECK_EQUAL(async1.getQueueLength(), 0);
+
+  // an adapter going away does not stop the thread of the others
+  async2.reset();
+  io1.restart();
+  auto work3 = boost::asio::make_work_guard(io1);
+  async1.deleteRequest(makeRequest(1).requestId, [&] {
+    events1.push_back("deleted");
+    work3.reset();
+  }, onFailure);
+  io1.run();
+  BOOST_CHECK_EQUAL(events1.back(), "deleted");
+  BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestCaAsyncStorage
+
+} // namespace ndncert::tests
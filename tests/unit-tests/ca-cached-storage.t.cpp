@@ -0,0 +1,236 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/ca-cached-storage.hpp"
+#include "detail/ca-memory.hpp"
+#include "detail/ca-sqlite.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+static RequestState
+makeRequest(uint8_t id, Status status = Status::BEFORE_CHALLENGE)
+{
+  RequestState request;
+  request.caPrefix = Name("/ndn");
+  request.requestId = {{id}};
+  request.requestType = RequestType::NEW;
+  request.status = status;
+  return request;
+}
+
+static std::unique_ptr<CaCachedStorage>
+makeCachedMemory(const std::string& options)
+{
+  auto storage = CaStorage::createCaStorage("ca-storage-cached:memory", Name("/ndn"), options);
+  BOOST_REQUIRE(dynamic_cast<CaCachedStorage*>(storage.get()) != nullptr);
+  return std::unique_ptr<CaCachedStorage>(static_cast<CaCachedStorage*>(storage.release()));
+}
+
+class FailingMemory : public CaMemory
+{
+public:
+  void
+  updateRequest(const RequestState& request) override
+  {
+    if (isFailing) {
+      NDN_THROW(std::runtime_error("backing storage failure"));
+    }
+    CaMemory::updateRequest(request);
+  }
+
+public:
+  bool isFailing = false;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestCaCachedStorage, KeyChainFixture)
+
+BOOST_AUTO_TEST_CASE(Factory)
+{
+  BOOST_CHECK(CaStorage::createCaStorage("ca-storage-cached:ca-storage-memory", Name("/ndn"), "") != nullptr);
+  BOOST_CHECK(CaStorage::createCaStorage("ca-storage-cached:unknown", Name("/ndn"), "") == nullptr);
+  BOOST_CHECK(CaStorage::createCaStorage("unknown:memory", Name("/ndn"), "") == nullptr);
+  BOOST_CHECK_THROW(CaStorage::createCaStorage("ca-storage-cached:memory", Name("/ndn"), "?cache-eviction=mru"),
+                    std::runtime_error);
+  BOOST_CHECK_THROW(CaStorage::createCaStorage("ca-storage-cached:memory", Name("/ndn"), "?cache-capacity=0"),
+                    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(WriteBack)
+{
+  auto storage = makeCachedMemory("?cache-capacity=4&flush-interval=0");
+  auto& inner = storage->getInnerStorage();
+
+  // new requests are written through
+  auto cert = m_keyChain.createIdentity(Name("/ndn/site1")).getDefaultKey().getDefaultCertificate();
+  auto request = makeRequest(1);
+  request.cert = cert;
+  storage->addRequest(request);
+  BOOST_CHECK_EQUAL(inner.getRequest(request.requestId).cert, cert);
+  BOOST_CHECK_THROW(storage->addRequest(request), std::runtime_error);
+
+  // updates stay in the cache until flushed
+  request.status = Status::CHALLENGE;
+  storage->updateRequest(request);
+  BOOST_CHECK(storage->getRequest(request.requestId).status == Status::CHALLENGE);
+  BOOST_CHECK(inner.getRequest(request.requestId).status == Status::BEFORE_CHALLENGE);
+  BOOST_CHECK_EQUAL(storage->getMetrics().nPending, 1);
+
+  storage->flush();
+  BOOST_CHECK(inner.getRequest(request.requestId).status == Status::CHALLENGE);
+  BOOST_CHECK_EQUAL(storage->getMetrics().nPending, 0);
+  BOOST_CHECK_EQUAL(storage->getMetrics().nFlushes, 1);
+  BOOST_CHECK_EQUAL(storage->getMetrics().nFlushedUpdates, 1);
+
+  // deletions are deferred as well, but are visible immediately
+  storage->deleteRequest(request.requestId);
+  BOOST_CHECK_THROW(storage->getRequest(request.requestId), std::runtime_error);
+  BOOST_CHECK_NO_THROW(inner.getRequest(request.requestId));
+
+  // enumerations see the pending changes
+  storage->addRequest(makeRequest(2));
+  storage->updateRequest(makeRequest(2, Status::PENDING));
+  BOOST_CHECK_EQUAL(storage->listAllRequests().size(), 1);
+  BOOST_CHECK_THROW(inner.getRequest(request.requestId), std::runtime_error);
+  RequestFilter filter;
+  filter.status = Status::PENDING;
+  BOOST_CHECK_EQUAL(storage->countRequests(filter), 1);
+  BOOST_CHECK_EQUAL(storage->getMetrics().nFlushedDeletions, 1);
+
+  // a request deleted but not yet flushed can be added again
+  storage->addRequest(makeRequest(3));
+  storage->deleteRequest(makeRequest(3).requestId);
+  BOOST_CHECK_NO_THROW(storage->addRequest(makeRequest(3)));
+  BOOST_CHECK_NO_THROW(inner.getRequest(makeRequest(3).requestId));
+}
+
+BOOST_AUTO_TEST_CASE(WriteThrough)
+{
+  auto storage = makeCachedMemory("?write-mode=write-through");
+  auto& inner = storage->getInnerStorage();
+
+  storage->addRequest(makeRequest(1));
+  storage->updateRequest(makeRequest(1, Status::CHALLENGE));
+  BOOST_CHECK(inner.getRequest(makeRequest(1).requestId).status == Status::CHALLENGE);
+  storage->deleteRequest(makeRequest(1).requestId);
+  BOOST_CHECK_THROW(inner.getRequest(makeRequest(1).requestId), std::runtime_error);
+  BOOST_CHECK_EQUAL(storage->getMetrics().nPending, 0);
+}
+
+BOOST_AUTO_TEST_CASE(Eviction)
+{
+  auto storage = makeCachedMemory("?cache-capacity=2&flush-interval=0");
+  auto& inner = storage->getInnerStorage();
+
+  storage->addRequest(makeRequest(1));
+  storage->addRequest(makeRequest(2));
+  storage->updateRequest(makeRequest(1, Status::CHALLENGE));
+
+  // request 2 is the least recently used
+  storage->addRequest(makeRequest(3));
+  auto metrics = storage->getMetrics();
+  BOOST_CHECK_EQUAL(metrics.nCached, 2);
+  BOOST_CHECK_EQUAL(metrics.nEvictions, 1);
+
+  storage->getRequest(makeRequest(1).requestId);
+  BOOST_CHECK_EQUAL(storage->getMetrics().nHits, 1);
+  storage->getRequest(makeRequest(2).requestId);
+  BOOST_CHECK_EQUAL(storage->getMetrics().nMisses, 1);
+
+  // the modified request 1 is now the least recently used, and is written back when evicted
+  BOOST_CHECK(inner.getRequest(makeRequest(1).requestId).status == Status::BEFORE_CHALLENGE);
+  storage->addRequest(makeRequest(4));
+  BOOST_CHECK(inner.getRequest(makeRequest(1).requestId).status == Status::CHALLENGE);
+  BOOST_CHECK_EQUAL(storage->getMetrics().nEvictions, 3);
+  BOOST_CHECK_EQUAL(storage->getMetrics().nPending, 0);
+}
+
+BOOST_AUTO_TEST_CASE(EvictionFailure)
+{
+  auto failingMemory = std::make_unique<FailingMemory>();
+  auto& inner = *failingMemory;
+  CaCachedStorage storage(std::move(failingMemory), Name("/ndn"), "?cache-capacity=2&flush-interval=0");
+
+  storage.addRequest(makeRequest(1));
+  storage.updateRequest(makeRequest(1, Status::CHALLENGE));
+  storage.addRequest(makeRequest(2));
+
+  // the modified request 1 cannot be written back, so the clean request 2 is evicted instead
+  inner.isFailing = true;
+  BOOST_CHECK_NO_THROW(storage.addRequest(makeRequest(3)));
+  auto metrics = storage.getMetrics();
+  BOOST_CHECK_EQUAL(metrics.nFlushErrors, 1);
+  BOOST_CHECK_EQUAL(metrics.nEvictions, 1);
+  BOOST_CHECK_EQUAL(metrics.nPending, 1);
+  BOOST_CHECK(storage.getRequest(makeRequest(1).requestId).status == Status::CHALLENGE);
+
+  // with only dirty entries left to evict, the cache temporarily exceeds its capacity
+  BOOST_CHECK_NO_THROW(storage.updateRequest(makeRequest(3, Status::CHALLENGE)));
+  BOOST_CHECK_NO_THROW(storage.addRequest(makeRequest(4)));
+  BOOST_CHECK_NO_THROW(storage.updateRequest(makeRequest(4, Status::CHALLENGE)));
+  BOOST_CHECK_EQUAL(storage.getMetrics().nPending, 3);
+  BOOST_CHECK_EQUAL(storage.getMetrics().nCached, 3);
+
+  // the modified requests are written back once the backing storage recovers
+  inner.isFailing = false;
+  storage.flush();
+  BOOST_CHECK(inner.getRequest(makeRequest(1).requestId).status == Status::CHALLENGE);
+  BOOST_CHECK_EQUAL(storage.getMetrics().nPending, 0);
+}
+
+BOOST_AUTO_TEST_CASE(FifoEviction)
+{
+  auto storage = makeCachedMemory("?cache-capacity=2&cache-eviction=fifo&flush-interval=0");
+  storage->addRequest(makeRequest(1));
+  storage->addRequest(makeRequest(2));
+  storage->getRequest(makeRequest(1).requestId);
+  storage->addRequest(makeRequest(3));
+
+  // request 1 was inserted first and is evicted despite the recent hit
+  storage->getRequest(makeRequest(1).requestId);
+  auto metrics = storage->getMetrics();
+  BOOST_CHECK_EQUAL(metrics.nHits, 1);
+  BOOST_CHECK_EQUAL(metrics.nMisses, 1);
+}
+
+BOOST_AUTO_TEST_CASE(FlushOnDestruction)
+{
+  // both storages use the default database of the CA, under the test home directory
+  Name caName("/TestCaCachedStorage/FlushOnDestruction");
+  {
+    // the periodic flusher is running, but the interval is too long to fire during the test
+    auto storage = CaStorage::createCaStorage("ca-storage-cached:sqlite3", caName, "?flush-interval=3600000");
+    BOOST_REQUIRE(storage != nullptr);
+    storage->addRequest(makeRequest(1));
+    storage->updateRequest(makeRequest(1, Status::CHALLENGE));
+  }
+
+  CaSqlite storage(caName);
+  BOOST_CHECK(storage.getRequest(makeRequest(1).requestId).status == Status::CHALLENGE);
+  storage.deleteRequest(makeRequest(1).requestId);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestCaCachedStorage
+
+} // namespace ndncert::tests
@@ -0,0 +1,274 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/ca-journaled-memory.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <chrono>
+#include <thread>
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+class JournalFixture : public KeyChainFixture
+{
+public:
+  JournalFixture()
+  {
+    dir = boost::filesystem::path(UNIT_TESTS_TMPDIR) / "test-journaled-memory";
+    boost::filesystem::create_directories(dir);
+    location = (dir / "ca").string();
+    cert = m_keyChain.createIdentity(Name("/ndn/site1")).getDefaultKey().getDefaultCertificate();
+  }
+
+  ~JournalFixture()
+  {
+    boost::filesystem::remove_all(dir);
+  }
+
+  RequestState
+  makeRequest(uint8_t id, Status status = Status::BEFORE_CHALLENGE) const
+  {
+    RequestState request;
+    request.caPrefix = Name("/ndn");
+    request.requestId = {{id}};
+    request.requestType = RequestType::NEW;
+    request.status = status;
+    request.cert = cert;
+    return request;
+  }
+
+protected:
+  boost::filesystem::path dir;
+  std::string location;
+  Certificate cert;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestCaJournaledMemory, JournalFixture)
+
+BOOST_AUTO_TEST_CASE(ReplayJournal)
+{
+  {
+    CaJournaledMemory storage(Name(), location + "?fsync=always&snapshot-interval=0");
+    storage.addRequest(makeRequest(1));
+    storage.addRequest(makeRequest(2));
+    storage.addRequest(makeRequest(3));
+    BOOST_CHECK_THROW(storage.addRequest(makeRequest(3)), std::runtime_error);
+
+    auto request = makeRequest(2, Status::CHALLENGE);
+    request.challengeType = "pin";
+    JsonSection secret;
+    secret.add("code", "1234");
+    request.challengeState = ChallengeState("need-code", time::system_clock::now(), 3,
+                                            time::seconds(300), std::move(secret));
+    storage.updateRequest(request);
+    storage.deleteRequest(makeRequest(3).requestId);
+    BOOST_CHECK_EQUAL(storage.getStatistics().nSnapshots, 0);
+    BOOST_CHECK_GT(storage.getStatistics().journalBytes, 0);
+  }
+
+  CaJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+  BOOST_CHECK_EQUAL(storage.getStatistics().nReplayedRecords, 5);
+  BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 2);
+  BOOST_CHECK_EQUAL(storage.getRequest(makeRequest(1).requestId).cert, cert);
+  auto result = storage.getRequest(makeRequest(2).requestId);
+  BOOST_CHECK(result.status == Status::CHALLENGE);
+  BOOST_REQUIRE(result.challengeState);
+  BOOST_CHECK_EQUAL(result.challengeState->secrets.get<std::string>("code"), "1234");
+  BOOST_CHECK_THROW(storage.getRequest(makeRequest(3).requestId), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(ReplaySnapshot)
+{
+  {
+    CaJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+    for (uint8_t i = 1; i <= 10; i++) {
+      storage.addRequest(makeRequest(i));
+    }
+    storage.deleteRequest(makeRequest(10).requestId);
+    storage.snapshot();
+    BOOST_CHECK_EQUAL(storage.getStatistics().journalBytes, 0);
+    BOOST_CHECK(!boost::filesystem::exists(location + ".journal.prev"));
+
+    storage.updateRequest(makeRequest(1, Status::PENDING));
+    storage.deleteRequest(makeRequest(2).requestId);
+  }
+
+  CaJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+  // nine requests from the snapshot, two records from the journal
+  BOOST_CHECK_EQUAL(storage.getStatistics().nReplayedRecords, 11);
+  BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 8);
+  BOOST_CHECK(storage.getRequest(makeRequest(1).requestId).status == Status::PENDING);
+}
+
+BOOST_AUTO_TEST_CASE(SnapshotOnJournalSize)
+{
+  CaJournaledMemory storage(Name(), location + "?snapshot-interval=0&snapshot-bytes=4096&fsync-interval=10");
+  for (uint8_t i = 1; i <= 50; i++) {
+    storage.addRequest(makeRequest(i));
+  }
+  // the background thread picks up the request
+  for (int i = 0; i < 200 && storage.getStatistics().nSnapshots == 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  BOOST_CHECK_GE(storage.getStatistics().nSnapshots, 1);
+  BOOST_CHECK(boost::filesystem::exists(location + ".snapshot"));
+}
+
+class FailingJournaledMemory : public CaJournaledMemory
+{
+public:
+  using CaJournaledMemory::CaJournaledMemory;
+
+  void
+  append(const Block& record) override
+  {
+    if (isFailing) {
+      NDN_THROW(std::runtime_error("append failed"));
+    }
+    CaJournaledMemory::append(record);
+  }
+
+public:
+  bool isFailing = false;
+};
+
+BOOST_AUTO_TEST_CASE(FailingAppend)
+{
+  {
+    FailingJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+    storage.addRequest(makeRequest(1));
+    storage.addRequest(makeRequest(2));
+
+    storage.isFailing = true;
+    BOOST_CHECK_THROW(storage.addRequest(makeRequest(3)), std::runtime_error);
+    BOOST_CHECK_THROW(storage.updateRequest(makeRequest(1, Status::PENDING)), std::runtime_error);
+    BOOST_CHECK_THROW(storage.deleteRequest(makeRequest(2).requestId), std::runtime_error);
+
+    // the requests in memory match what a restart would load
+    BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 2);
+    BOOST_CHECK_THROW(storage.getRequest(makeRequest(3).requestId), std::runtime_error);
+    BOOST_CHECK(storage.getRequest(makeRequest(1).requestId).status == Status::BEFORE_CHALLENGE);
+    BOOST_CHECK_NO_THROW(storage.getRequest(makeRequest(2).requestId));
+
+    storage.isFailing = false;
+    storage.addRequest(makeRequest(3));
+  }
+
+  CaJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+  BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 3);
+  BOOST_CHECK(storage.getRequest(makeRequest(1).requestId).status == Status::BEFORE_CHALLENGE);
+}
+
+BOOST_AUTO_TEST_CASE(TruncatedJournal)
+{
+  {
+    CaJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+    storage.addRequest(makeRequest(1));
+    storage.addRequest(makeRequest(2));
+  }
+  // simulate a crash in the middle of an append
+  auto journalSize = boost::filesystem::file_size(location + ".journal");
+  boost::filesystem::resize_file(location + ".journal", journalSize - 10);
+
+  {
+    CaJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+    BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 1);
+    storage.addRequest(makeRequest(3));
+  }
+
+  // records appended after the truncation are not lost
+  CaJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+  BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 2);
+  BOOST_CHECK_NO_THROW(storage.getRequest(makeRequest(3).requestId));
+}
+
+BOOST_AUTO_TEST_CASE(InterruptedSnapshot)
+{
+  {
+    CaJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+    storage.addRequest(makeRequest(1));
+    storage.addRequest(makeRequest(2));
+  }
+  // simulate a crash after the journal rotation, before the snapshot was written
+  boost::filesystem::rename(location + ".journal", location + ".journal.prev");
+  {
+    CaJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+    storage.deleteRequest(makeRequest(1).requestId);
+  }
+
+  CaJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+  BOOST_CHECK(!boost::filesystem::exists(location + ".journal.prev"));
+  BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 1);
+  BOOST_CHECK_NO_THROW(storage.getRequest(makeRequest(2).requestId));
+}
+
+BOOST_AUTO_TEST_CASE(FailingSnapshots)
+{
+  {
+    CaJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+    storage.addRequest(makeRequest(1));
+    storage.addRequest(makeRequest(2));
+    storage.snapshot();
+    storage.addRequest(makeRequest(3));
+
+    // the snapshot cannot be written, twice in a row
+    boost::filesystem::create_directory(location + ".snapshot.tmp");
+    BOOST_CHECK_THROW(storage.snapshot(), std::runtime_error);
+    storage.updateRequest(makeRequest(1, Status::PENDING));
+    storage.addRequest(makeRequest(4));
+    BOOST_CHECK_THROW(storage.snapshot(), std::runtime_error);
+    storage.deleteRequest(makeRequest(2).requestId);
+    BOOST_CHECK(boost::filesystem::exists(location + ".journal.prev"));
+    // the process stops before a snapshot succeeds
+  }
+  boost::filesystem::remove(location + ".snapshot.tmp");
+
+  {
+    CaJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+    BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 3);
+    BOOST_CHECK(storage.getRequest(makeRequest(1).requestId).status == Status::PENDING);
+    BOOST_CHECK_THROW(storage.getRequest(makeRequest(2).requestId), std::runtime_error);
+    BOOST_CHECK_NO_THROW(storage.getRequest(makeRequest(3).requestId));
+    BOOST_CHECK_NO_THROW(storage.getRequest(makeRequest(4).requestId));
+    BOOST_CHECK(!boost::filesystem::exists(location + ".journal.prev"));
+
+    // once the snapshot succeeds again, the rotation resumes
+    boost::filesystem::create_directory(location + ".snapshot.tmp");
+    BOOST_CHECK_THROW(storage.snapshot(), std::runtime_error);
+    boost::filesystem::remove(location + ".snapshot.tmp");
+    storage.addRequest(makeRequest(5));
+    storage.snapshot();
+    BOOST_CHECK(!boost::filesystem::exists(location + ".journal.prev"));
+  }
+
+  CaJournaledMemory storage(Name(), location + "?snapshot-interval=0");
+  BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 4);
+  BOOST_CHECK(storage.getRequest(makeRequest(1).requestId).status == Status::PENDING);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestCaJournaledMemory
+
+} // namespace ndncert::tests
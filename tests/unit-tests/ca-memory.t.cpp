@@ -92,6 +92,74 @@ BOOST_AUTO_TEST_CASE(RequestOperations)
   BOOST_CHECK_EQUAL(allRequests.size(), 1);
 }
 
+BOOST_AUTO_TEST_CASE(FilteredEnumeration)
+{
+  CaMemory storage;
+
+  auto cert = m_keyChain.createIdentity(Name("/ndn/site1")).getDefaultKey().getDefaultCertificate();
+  auto now = time::system_clock::now();
+  for (uint8_t i = 1; i <= 6; i++) {
+    RequestState request;
+    request.caPrefix = Name(i <= 4 ? "/ndn" : "/other");
+    request.requestId = {{i}};
+    request.requestType = i % 2 == 0 ? RequestType::REVOKE : RequestType::NEW;
+    request.cert = cert;
+    if (i >= 3) {
+      request.status = Status::CHALLENGE;
+      request.challengeType = "pin";
+      request.challengeState = ChallengeState("need-code", now - time::seconds(100 * i), 3,
+                                              time::seconds(3600), JsonSection());
+    }
+    storage.addRequest(request);
+  }
+
+  RequestFilter filter;
+  BOOST_CHECK_EQUAL(storage.countRequests(filter), 6);
+  filter.caPrefix = Name("/ndn");
+  BOOST_CHECK_EQUAL(storage.countRequests(filter), 4);
+  filter.requestType = RequestType::NEW;
+  BOOST_CHECK_EQUAL(storage.countRequests(filter), 2);
+  filter.status = Status::CHALLENGE;
+  BOOST_CHECK_EQUAL(storage.countRequests(filter), 1);
+
+  filter = RequestFilter();
+  filter.challengeType = "pin";
+  filter.updatedBefore = now - time::seconds(450);
+  std::vector<RequestId> visited;
+  storage.forEachRequestSummary(filter, [&] (const RequestSummary& summary) {
+    BOOST_CHECK_EQUAL(summary.challengeStatus, "need-code");
+    visited.push_back(summary.requestId);
+    return true;
+  });
+  BOOST_REQUIRE_EQUAL(visited.size(), 2);
+  BOOST_CHECK(visited[0] == RequestId{{5}});
+  BOOST_CHECK(visited[1] == RequestId{{6}});
+
+  // paginate through all requests two at a time
+  filter = RequestFilter();
+  filter.limit = 2;
+  visited.clear();
+  size_t nPages = 0;
+  while (true) {
+    size_t nVisited = storage.forEachRequest(filter, [&] (const RequestState& request) {
+      BOOST_CHECK_EQUAL(request.cert, cert);
+      visited.push_back(request.requestId);
+      filter.startAfter = request.requestId;
+      return true;
+    });
+    if (nVisited == 0) {
+      break;
+    }
+    nPages++;
+  }
+  BOOST_CHECK_EQUAL(nPages, 3);
+  BOOST_REQUIRE_EQUAL(visited.size(), 6);
+  BOOST_CHECK(std::is_sorted(visited.begin(), visited.end()));
+
+  // the visitor can stop the enumeration
+  BOOST_CHECK_EQUAL(storage.forEachRequest(RequestFilter(), [] (const auto&) { return false; }), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END() // TestCaMemory
 
 } // namespace ndncert::tests
@@ -0,0 +1,352 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/ca-mmap.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <fstream>
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+class DatabaseFixture : public KeyChainFixture
+{
+public:
+  DatabaseFixture()
+  {
+    boost::filesystem::path parentDir{UNIT_TESTS_TMPDIR};
+    dbDir = parentDir / "test-home" / ".ndncert";
+    if (!boost::filesystem::exists(dbDir)) {
+      boost::filesystem::create_directory(dbDir);
+    }
+  }
+
+  ~DatabaseFixture()
+  {
+    boost::filesystem::remove_all(dbDir);
+  }
+
+protected:
+  boost::filesystem::path dbDir;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestCaMmap, DatabaseFixture)
+
+BOOST_AUTO_TEST_CASE(RequestOperations)
+{
+  CaMmap storage(Name(), dbDir.string() + "/TestCaMmap_RequestOperations.mmap");
+
+  auto identity1 = m_keyChain.createIdentity(Name("/ndn/site1"));
+  auto key1 = identity1.getDefaultKey();
+  auto cert1 = key1.getDefaultCertificate();
+
+  // add operation
+  RequestId requestId = {{101}};
+  RequestState request1;
+  request1.caPrefix = Name("/ndn/site1");
+  request1.requestId = requestId;
+  request1.requestType = RequestType::NEW;
+  request1.cert = cert1;
+  request1.encryptionKey = {{102}};
+  request1.decryptionIv.assign({1,2,3,4,5,6,7,8,9,10,11,12});
+  request1.decryptionIv.assign({2,3,4,5,6,7,8,9,10,11,12,13});
+  storage.addRequest(request1);
+
+  // get operation
+  auto result = storage.getRequest(requestId);
+  BOOST_CHECK_EQUAL(request1.cert, result.cert);
+  BOOST_CHECK(request1.status == result.status);
+  BOOST_CHECK_EQUAL(request1.caPrefix, result.caPrefix);
+  BOOST_CHECK_EQUAL_COLLECTIONS(request1.encryptionKey.begin(), request1.encryptionKey.end(),
+                                result.encryptionKey.begin(), result.encryptionKey.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(request1.encryptionIv.begin(), request1.encryptionIv.end(),
+                                result.encryptionIv.begin(), result.encryptionIv.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(request1.decryptionIv.begin(), request1.decryptionIv.end(),
+                                result.decryptionIv.begin(), result.decryptionIv.end());
+
+  // update operation
+  RequestState request2;
+  request2.caPrefix = Name("/ndn/site1");
+  request2.requestId = requestId;
+  request2.requestType = RequestType::NEW;
+  request2.cert = cert1;
+  request2.challengeType = "email";
+  JsonSection secret;
+  secret.add("code", "1234");
+  request2.challengeState = ChallengeState("test", time::system_clock::now(), 3,
+                                           time::seconds(3600), std::move(secret));
+  request2.decryptionIv.assign({1,2,3,4,5,6,7,8,9,10,11,14});
+  request2.decryptionIv.assign({2,3,4,5,6,7,8,9,10,11,12,15});
+  storage.updateRequest(request2);
+  result = storage.getRequest(requestId);
+  BOOST_CHECK_EQUAL(request2.cert, result.cert);
+  BOOST_CHECK(request2.status == result.status);
+  BOOST_CHECK_EQUAL(request2.caPrefix, result.caPrefix);
+  BOOST_CHECK_EQUAL_COLLECTIONS(request2.encryptionIv.begin(), request2.encryptionIv.end(),
+                                result.encryptionIv.begin(), result.encryptionIv.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(request2.decryptionIv.begin(), request2.decryptionIv.end(),
+                                result.decryptionIv.begin(), result.decryptionIv.end());
+
+  // another add operation
+  auto identity2 = m_keyChain.createIdentity(Name("/ndn/site2"));
+  auto key2 = identity2.getDefaultKey();
+  auto cert2 = key2.getDefaultCertificate();
+  RequestId requestId2 = {{102}};
+  RequestState request3;
+  request3.caPrefix = Name("/ndn/site2");
+  request3.requestId = requestId2;
+  request3.requestType = RequestType::NEW;
+  request3.cert = cert2;
+  storage.addRequest(request3);
+
+  // list operation
+  auto allRequests = storage.listAllRequests();
+  BOOST_CHECK_EQUAL(allRequests.size(), 2);
+
+  storage.deleteRequest(requestId2);
+  allRequests = storage.listAllRequests();
+  BOOST_CHECK_EQUAL(allRequests.size(), 1);
+
+  storage.deleteRequest(requestId);
+  allRequests = storage.listAllRequests();
+  BOOST_CHECK_EQUAL(allRequests.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(DuplicateAdd)
+{
+  CaMmap storage(Name(), dbDir.string() + "/TestCaMmap_DuplicateAdd.mmap");
+
+  auto identity1 = m_keyChain.createIdentity(Name("/ndn/site1"));
+  auto key1 = identity1.getDefaultKey();
+  auto cert1 = key1.getDefaultCertificate();
+
+  // add operation
+  RequestId requestId = {{101}};
+  RequestState request1;
+  request1.caPrefix = Name("/ndn/site1");
+  request1.requestId = requestId;
+  request1.requestType = RequestType::NEW;
+  request1.cert = cert1;
+  BOOST_CHECK_NO_THROW(storage.addRequest(request1));
+
+  // add again
+  BOOST_CHECK_THROW(storage.addRequest(request1), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Reopen)
+{
+  auto path = dbDir.string() + "/TestCaMmap_Reopen.mmap";
+  auto cert = m_keyChain.createIdentity(Name("/ndn/site1")).getDefaultKey().getDefaultCertificate();
+  auto now = time::fromUnixTimestamp(time::toUnixTimestamp(time::system_clock::now()));
+  {
+    CaMmap storage(Name(), path);
+    for (uint8_t i = 1; i <= 3; i++) {
+      RequestState request;
+      request.caPrefix = Name("/ndn");
+      request.requestId = {{i}};
+      request.requestType = RequestType::NEW;
+      request.cert = cert;
+      storage.addRequest(request);
+    }
+    RequestState request = storage.getRequest({{2}});
+    request.status = Status::CHALLENGE;
+    request.challengeType = "pin";
+    JsonSection secret;
+    secret.add("code", "1234");
+    request.challengeState = ChallengeState("need-code", now, 3, time::seconds(300), std::move(secret));
+    request.challengeState->binarySecret = cert.wireEncode();
+    storage.updateRequest(request);
+    storage.deleteRequest({{3}});
+  }
+
+  CaMmap storage(Name(), path);
+  BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 2);
+  BOOST_CHECK_EQUAL(storage.getRequest({{1}}).cert, cert);
+  BOOST_CHECK_THROW(storage.getRequest({{3}}), std::runtime_error);
+  auto result = storage.getRequest({{2}});
+  BOOST_CHECK(result.status == Status::CHALLENGE);
+  BOOST_CHECK_EQUAL(result.challengeType, "pin");
+  BOOST_REQUIRE(result.challengeState);
+  BOOST_CHECK_EQUAL(result.challengeState->challengeStatus, "need-code");
+  BOOST_CHECK(result.challengeState->timestamp == now);
+  BOOST_CHECK_EQUAL(result.challengeState->remainingTries, 3);
+  BOOST_CHECK_EQUAL(result.challengeState->remainingTime.count(), 300);
+  BOOST_CHECK_EQUAL(result.challengeState->secrets.get<std::string>("code"), "1234");
+  BOOST_CHECK(result.challengeState->binarySecret == cert.wireEncode());
+  BOOST_CHECK_GT(storage.getStatistics().staleBytes, 0);
+}
+
+BOOST_AUTO_TEST_CASE(Compaction)
+{
+  CaMmap storage(Name(), dbDir.string() + "/TestCaMmap_Compaction.mmap");
+  auto cert = m_keyChain.createIdentity(Name("/ndn/site1")).getDefaultKey().getDefaultCertificate();
+
+  RequestState request;
+  request.caPrefix = Name("/ndn");
+  request.requestId = {{1}};
+  request.cert = cert;
+  storage.addRequest(request);
+  for (int i = 0; i < 100; i++) {
+    request.status = i % 2 == 0 ? Status::CHALLENGE : Status::BEFORE_CHALLENGE;
+    storage.updateRequest(request);
+  }
+  auto before = storage.getStatistics();
+  BOOST_CHECK_EQUAL(before.nRequests, 1);
+  BOOST_CHECK_GT(before.staleBytes, 0);
+
+  storage.compact();
+  auto after = storage.getStatistics();
+  BOOST_CHECK_EQUAL(after.nRequests, 1);
+  BOOST_CHECK_EQUAL(after.staleBytes, 0);
+  BOOST_CHECK_LT(after.usedBytes, before.usedBytes);
+  BOOST_CHECK(storage.getRequest(request.requestId).status == Status::BEFORE_CHALLENGE);
+  BOOST_CHECK_EQUAL(storage.getRequest(request.requestId).cert, cert);
+
+  // enough churn triggers the compaction automatically
+  auto recordBytes = before.staleBytes / 100;
+  const int nUpdates = 5000;
+  for (int i = 0; i < nUpdates; i++) {
+    storage.updateRequest(request);
+  }
+  BOOST_CHECK_LT(storage.getStatistics().usedBytes, nUpdates * recordBytes / 2);
+}
+
+BOOST_AUTO_TEST_CASE(CompactionFailure)
+{
+  auto path = dbDir.string() + "/TestCaMmap_CompactionFailure.mmap";
+  auto cert = m_keyChain.createIdentity(Name("/ndn/site1")).getDefaultKey().getDefaultCertificate();
+  CaMmap storage(Name(), path);
+
+  RequestState request;
+  request.caPrefix = Name("/ndn");
+  request.requestId = {{1}};
+  request.cert = cert;
+  storage.addRequest(request);
+  for (int i = 0; i < 100; i++) {
+    storage.updateRequest(request);
+  }
+
+  // the temporary file cannot be created, the current file stays in use
+  boost::filesystem::create_directory(path + ".compact");
+  BOOST_CHECK_THROW(storage.compact(), std::runtime_error);
+  BOOST_CHECK_GT(storage.getStatistics().staleBytes, 0);
+  BOOST_CHECK_EQUAL(storage.getRequest(request.requestId).cert, cert);
+
+  // an automatic compaction that fails does not fail the write
+  const int nUpdates = 5000;
+  for (int i = 0; i < nUpdates; i++) {
+    request.status = i % 2 == 0 ? Status::CHALLENGE : Status::BEFORE_CHALLENGE;
+    BOOST_REQUIRE_NO_THROW(storage.updateRequest(request));
+  }
+  BOOST_CHECK(storage.getRequest(request.requestId).status == Status::BEFORE_CHALLENGE);
+
+  boost::filesystem::remove(path + ".compact");
+  storage.compact();
+  BOOST_CHECK_EQUAL(storage.getStatistics().staleBytes, 0);
+  BOOST_CHECK(storage.getRequest(request.requestId).status == Status::BEFORE_CHALLENGE);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidFile)
+{
+  auto path = dbDir.string() + "/TestCaMmap_InvalidFile.mmap";
+  {
+    std::ofstream file(path);
+    file << std::string(64, 'x');
+  }
+  BOOST_CHECK_THROW(CaMmap(Name(), path), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(FilteredEnumeration)
+{
+  CaMmap storage(Name(), dbDir.string() + "/TestCaMmap_FilteredEnumeration.mmap");
+
+  auto cert = m_keyChain.createIdentity(Name("/ndn/site1")).getDefaultKey().getDefaultCertificate();
+  auto now = time::system_clock::now();
+  for (uint8_t i = 1; i <= 6; i++) {
+    RequestState request;
+    request.caPrefix = Name(i <= 4 ? "/ndn" : "/other");
+    request.requestId = {{i}};
+    request.requestType = i % 2 == 0 ? RequestType::REVOKE : RequestType::NEW;
+    request.cert = cert;
+    if (i >= 3) {
+      request.status = Status::CHALLENGE;
+      request.challengeType = "pin";
+      request.challengeState = ChallengeState("need-code", now - time::seconds(100 * i), 3,
+                                              time::seconds(3600), JsonSection());
+    }
+    storage.addRequest(request);
+  }
+
+  RequestFilter filter;
+  BOOST_CHECK_EQUAL(storage.countRequests(filter), 6);
+  filter.caPrefix = Name("/ndn");
+  BOOST_CHECK_EQUAL(storage.countRequests(filter), 4);
+  filter.requestType = RequestType::NEW;
+  BOOST_CHECK_EQUAL(storage.countRequests(filter), 2);
+  filter.status = Status::CHALLENGE;
+  BOOST_CHECK_EQUAL(storage.countRequests(filter), 1);
+
+  filter = RequestFilter();
+  filter.challengeType = "pin";
+  filter.updatedBefore = now - time::seconds(450);
+  std::vector<RequestId> visited;
+  storage.forEachRequestSummary(filter, [&] (const RequestSummary& summary) {
+    BOOST_CHECK_EQUAL(summary.challengeStatus, "need-code");
+    visited.push_back(summary.requestId);
+    return true;
+  });
+  BOOST_REQUIRE_EQUAL(visited.size(), 2);
+  BOOST_CHECK(visited[0] == RequestId{{5}});
+  BOOST_CHECK(visited[1] == RequestId{{6}});
+
+  // paginate through all requests two at a time
+  filter = RequestFilter();
+  filter.limit = 2;
+  visited.clear();
+  size_t nPages = 0;
+  while (true) {
+    size_t nVisited = storage.forEachRequest(filter, [&] (const RequestState& request) {
+      BOOST_CHECK_EQUAL(request.cert, cert);
+      visited.push_back(request.requestId);
+      filter.startAfter = request.requestId;
+      return true;
+    });
+    if (nVisited == 0) {
+      break;
+    }
+    nPages++;
+  }
+  BOOST_CHECK_EQUAL(nPages, 3);
+  BOOST_REQUIRE_EQUAL(visited.size(), 6);
+  BOOST_CHECK(std::is_sorted(visited.begin(), visited.end()));
+
+  // the visitor can stop the enumeration
+  BOOST_CHECK_EQUAL(storage.forEachRequest(RequestFilter(), [] (const auto&) { return false; }), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestCaMmap
+
+} // namespace ndncert::tests
@@ -22,8 +22,14 @@
 #include "challenge/challenge-module.hpp"
 #include "challenge/challenge-email.hpp"
 #include "challenge/challenge-pin.hpp"
+#include "challenge/challenge-possession.hpp"
+#include "detail/ca-synchronized-storage.hpp"
+#include "detail/error-encoder.hpp"
 #include "detail/info-encoder.hpp"
+#include "detail/revocation-encoder.hpp"
+#include "detail/status-encoder.hpp"
 #include "requester-request.hpp"
+#include "requester-revocation-list.hpp"
 
 #include "tests/boost-test.hpp"
 #include "tests/io-key-chain-fixture.hpp"
@@ -32,6 +38,8 @@
 #include <ndn-cxx/security/verification-helpers.hpp>
 #include <ndn-cxx/util/dummy-client-face.hpp>
 
+#include <thread>
+
 namespace ndncert::tests {
 
 using namespace ca;
@@ -48,7 +56,7 @@ BOOST_AUTO_TEST_CASE(Initialization)
 
   advanceClocks(time::milliseconds(20), 60);
   BOOST_CHECK_EQUAL(ca.m_registeredPrefixHandles.size(), 1); // removed local discovery registration
-  BOOST_CHECK_EQUAL(ca.m_interestFilterHandles.size(), 5);  // infoMeta, onProbe, onNew, onChallenge, onRevoke
+  BOOST_CHECK_EQUAL(ca.m_interestFilterHandles.size(), 6);  // infoMeta, onProbe, onNew, onChallenge, onRevoke, onCertFetch
 }
 
 BOOST_AUTO_TEST_CASE(HandleProfileFetching)
@@ -104,6 +112,29 @@ BOOST_AUTO_TEST_CASE(HandleProfileFetching)
   BOOST_CHECK_EQUAL(count, 2);
 }
 
+BOOST_AUTO_TEST_CASE(HandleCertFetch)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn/site1"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+  ca.getIssuedCertStore().insert(cert);
+
+  Interest interest(cert.getKeyName());
+  interest.setCanBePrefix(true);
+  interest.setForwardingHint({Name("/ndn/CA")});
+  face.receive(interest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(face.sentData.size(), 1);
+  BOOST_CHECK_EQUAL(face.sentData.front().getName(), cert.getName());
+
+  face.receive(Interest(Name("/ndn/site1/KEY/unknown")));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_EQUAL(face.sentData.size(), 1);
+}
+
 BOOST_AUTO_TEST_CASE(HandleProbe)
 {
   auto identity = m_keyChain.createIdentity(Name("/ndn"));
@@ -265,6 +296,48 @@ BOOST_AUTO_TEST_CASE(HandleNew)
   BOOST_CHECK_EQUAL(count, 1);
 }
 
+BOOST_AUTO_TEST_CASE(HandleNewDuplicate)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  auto keyName = m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName();
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  auto interest = state.genNewInterest(keyName, time::system_clock::now(), time::system_clock::now() + time::days(1));
+  // requested at the same time, hence for the same certificate name
+  requester::Request otherState(m_keyChain, item, RequestType::NEW);
+  auto otherInterest = otherState.genNewInterest(keyName, time::system_clock::now(),
+                                                 time::system_clock::now() + time::days(1));
+  face.receive(*interest);
+  advanceClocks(time::milliseconds(20), 1);
+  BOOST_REQUIRE_EQUAL(face.sentData.size(), 1);
+
+  // a retransmission gets the same response
+  face.receive(*interest);
+  advanceClocks(time::milliseconds(20), 1);
+  BOOST_REQUIRE_EQUAL(face.sentData.size(), 2);
+  BOOST_CHECK_EQUAL(face.sentData[1].wireEncode(), face.sentData[0].wireEncode());
+
+  // another NEW for the same certificate name is refused with an error
+  BOOST_REQUIRE_NE(otherInterest->getFullName(), interest->getFullName());
+  face.receive(*otherInterest);
+  advanceClocks(time::milliseconds(20), 1);
+  BOOST_REQUIRE_EQUAL(face.sentData.size(), 3);
+  BOOST_CHECK_EQUAL(face.sentNacks.size(), 0);
+  BOOST_CHECK_EQUAL(face.sentData.back().getName(), otherInterest->getName());
+  auto error = errortlv::decodefromDataContent(face.sentData.back().getContent());
+  BOOST_CHECK(std::get<0>(error) == ErrorCode::INVALID_PARAMETER);
+  BOOST_CHECK_EQUAL(std::get<1>(error), "Duplicate Request ID: The same request has been seen before.");
+  BOOST_CHECK_EQUAL(ca.getCaStorage()->listAllRequests().size(), 1);
+}
+
 BOOST_AUTO_TEST_CASE(HandleNewWithInvalidValidityPeriod1)
 {
   auto identity = m_keyChain.createIdentity(Name("/ndn"));
@@ -474,6 +547,11 @@ BOOST_AUTO_TEST_CASE(HandleChallenge)
       BOOST_CHECK(verifySignature(response, cert));
       state.onChallengeResponse(response);
       BOOST_CHECK(state.m_status == Status::SUCCESS);
+      // the certificate is returned along and installed
+      BOOST_REQUIRE(state.m_issuedCert);
+      BOOST_CHECK_EQUAL(state.m_issuedCert->getName(), state.m_issuedCertName);
+      auto key = m_keyChain.getPib().getIdentity(Name("/ndn/zhiyi")).getDefaultKey();
+      BOOST_CHECK_NO_THROW(key.getCertificate(state.m_issuedCertName));
     }
   });
   ca.setStatusUpdateCallback([](const RequestState& request) {
@@ -482,6 +560,10 @@ BOOST_AUTO_TEST_CASE(HandleChallenge)
       BOOST_CHECK(Certificate(request.cert).isValid());
     }
   });
+  std::vector<Status> busUpdates;
+  auto subscription = ca.getStatusUpdateBus().subscribe([&](const auto& request) {
+    busUpdates.push_back(request->status);
+  }, 16, OverflowPolicy::BLOCK);
 
   face.receive(*newInterest);
   advanceClocks(time::milliseconds(20), 60);
@@ -492,6 +574,364 @@ BOOST_AUTO_TEST_CASE(HandleChallenge)
   face.receive(*challengeInterest3);
   advanceClocks(time::milliseconds(20), 60);
   BOOST_CHECK_EQUAL(count, 3);
+
+  // waits for the pending updates
+  ca.getStatusUpdateBus().unsubscribe(subscription);
+  BOOST_REQUIRE_EQUAL(busUpdates.size(), 4);
+  BOOST_CHECK(busUpdates.back() == Status::SUCCESS);
+}
+
+BOOST_AUTO_TEST_CASE(HandleChallengeStateless)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-7", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  auto newInterest = state.genNewInterest(m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName(),
+                                          time::system_clock::now(),
+                                          time::system_clock::now() + time::days(1));
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  face.receive(*newInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  state.onNewRenewRevokeResponse(responses.back());
+  BOOST_CHECK(state.m_stateToken.isValid());
+  BOOST_CHECK_EQUAL(ca.getCaStorage()->listAllRequests().size(), 0);
+
+  auto challengeInterest = state.genChallengeInterest(state.selectOrContinueChallenge("pin"));
+  face.receive(*challengeInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 2);
+  state.onChallengeResponse(responses.back());
+  BOOST_CHECK_EQUAL(state.m_challengeStatus, ChallengePin::NEED_CODE);
+
+  // a used state token is rejected
+  face.receive(*challengeInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 3);
+  BOOST_CHECK_THROW(state.onChallengeResponse(responses.back()), std::runtime_error);
+
+  auto requestState = ca.m_shared->stateSealer->open(state.m_stateToken, state.m_requestId);
+  auto paramList = state.selectOrContinueChallenge("pin");
+  paramList.begin()->second = requestState.challengeState->secrets.get(ChallengePin::PARAMETER_KEY_CODE, "");
+  face.receive(*state.genChallengeInterest(std::move(paramList)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 4);
+  state.onChallengeResponse(responses.back());
+  BOOST_CHECK(state.m_status == Status::SUCCESS);
+  // inline certificates are disabled, the certificate is fetched by name
+  BOOST_CHECK(!state.m_issuedCert);
+  BOOST_CHECK(!state.m_issuedCertName.empty());
+  BOOST_CHECK(!state.m_stateToken.isValid());
+  BOOST_CHECK_EQUAL(ca.getCaStorage()->listAllRequests().size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(HandleNewWithEmbeddedChallenge)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  auto keyName = m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName();
+  auto notBefore = time::system_clock::now();
+  auto notAfter = notBefore + time::days(1);
+
+  // the email address would be sent unencrypted
+  BOOST_CHECK_THROW(state.genNewInterest(keyName, notBefore, notAfter, "email",
+                                         {{ChallengeEmail::PARAMETER_KEY_EMAIL, "zhiyi@cs.ucla.edu"}}),
+                    std::runtime_error);
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  // the PIN is selected in the NEW round trip
+  face.receive(*state.genNewInterest(keyName, notBefore, notAfter, "pin", {}));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  BOOST_CHECK(verifySignature(responses.back(), cert));
+  state.onNewRenewRevokeResponse(responses.back());
+  BOOST_CHECK(state.m_status == Status::CHALLENGE);
+  BOOST_CHECK_EQUAL(state.m_challengeStatus, ChallengePin::NEED_CODE);
+
+  auto requestState = ca.getCaStorage()->getRequest(state.m_requestId);
+  BOOST_CHECK(requestState.status == Status::CHALLENGE);
+  auto paramList = state.selectOrContinueChallenge("pin");
+  paramList.begin()->second = requestState.challengeState->secrets.get(ChallengePin::PARAMETER_KEY_CODE, "");
+  face.receive(*state.genChallengeInterest(std::move(paramList)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 2);
+  state.onChallengeResponse(responses.back());
+  BOOST_CHECK(state.m_status == Status::SUCCESS);
+}
+
+BOOST_AUTO_TEST_CASE(HandleNewWithUnsupportedEmbeddedChallenge)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  auto keyName = m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName();
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  // the CA does not offer the possession challenge, it replies as to a plain NEW
+  std::multimap<std::string, std::string> params;
+  params.emplace(ChallengePossession::PARAMETER_KEY_CREDENTIAL_CERT,
+                 std::string(reinterpret_cast<const char*>(cert.wireEncode().wire()), cert.wireEncode().size()));
+  face.receive(*state.genNewInterest(keyName, time::system_clock::now(),
+                                     time::system_clock::now() + time::days(1), "possession", std::move(params)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  auto challenges = state.onNewRenewRevokeResponse(responses.back());
+  BOOST_CHECK(state.m_status == Status::BEFORE_CHALLENGE);
+  BOOST_CHECK_EQUAL(challenges.front(), "pin");
+  BOOST_CHECK_EQUAL(ca.getCaStorage()->getRequest(state.m_requestId).challengeType, "");
+}
+
+BOOST_AUTO_TEST_CASE(HandleChallengeSharded)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  ca.enableSharding(3);
+  DummyClientFace otherFace(m_io, m_keyChain, {true, true});
+  CaModule otherCa(otherFace, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  otherCa.enableSharding(4);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_EQUAL(ca.m_registeredPrefixHandles.size(), 2);
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  auto newInterest = state.genNewInterest(m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName(),
+                                          time::system_clock::now(),
+                                          time::system_clock::now() + time::days(1));
+  face.receive(*newInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(face.sentData.size(), 1);
+  state.onNewRenewRevokeResponse(face.sentData.back());
+  BOOST_CHECK_EQUAL(state.m_requestId[0], 3);
+  BOOST_CHECK_EQUAL(state.m_challengeForwardingHint, "/ndn/CA/SHARD/%03");
+
+  auto challengeInterest = state.genChallengeInterest(state.selectOrContinueChallenge("pin"));
+  BOOST_REQUIRE_EQUAL(challengeInterest->getForwardingHint().size(), 1);
+  BOOST_CHECK_EQUAL(challengeInterest->getForwardingHint().front(), state.m_challengeForwardingHint);
+
+  // the instance of another shard stays silent
+  otherFace.receive(*challengeInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_EQUAL(otherFace.sentData.size(), 0);
+
+  face.receive(*challengeInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(face.sentData.size(), 2);
+  state.onChallengeResponse(face.sentData.back());
+  BOOST_CHECK(state.m_status == Status::CHALLENGE);
+}
+
+BOOST_AUTO_TEST_CASE(HandleNewSharded)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  // with the multicast strategy, both shards receive the NEW
+  DummyClientFace face0(m_io, m_keyChain, {true, true});
+  CaModule ca0(face0, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  ca0.enableSharding(0, 2);
+  DummyClientFace face1(m_io, m_keyChain, {true, true});
+  CaModule ca1(face1, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  ca1.enableSharding(1, 2);
+  BOOST_CHECK_THROW(ca1.enableSharding(2, 2), std::invalid_argument);
+  advanceClocks(time::milliseconds(20), 60);
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  auto newInterest = state.genNewInterest(m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName(),
+                                          time::system_clock::now(),
+                                          time::system_clock::now() + time::days(1));
+  face0.receive(*newInterest);
+  face1.receive(*newInterest);
+  advanceClocks(time::milliseconds(20), 60);
+
+  BOOST_CHECK_EQUAL(face0.sentData.size() + face1.sentData.size(), 1);
+  BOOST_CHECK_EQUAL(ca0.getCaStorage()->listAllRequests().size() + ca1.getCaStorage()->listAllRequests().size(), 1);
+  auto& ownerFace = face0.sentData.empty() ? face1 : face0;
+  BOOST_REQUIRE_EQUAL(ownerFace.sentData.size(), 1);
+  state.onNewRenewRevokeResponse(ownerFace.sentData.back());
+  BOOST_CHECK_EQUAL(state.m_requestId[0], face0.sentData.empty() ? 1 : 0);
+}
+
+BOOST_AUTO_TEST_CASE(HandleChallengeSharedState)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  CaConfig config;
+  config.load("tests/unit-tests/config-files/config-ca-1");
+  auto sharedState = std::make_shared<CaSharedState>(m_keyChain, config, "ca-storage-memory", "", true);
+  BOOST_CHECK(dynamic_cast<CaSynchronizedStorage*>(sharedState->storage.get()) != nullptr);
+
+  DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, sharedState, "tests/unit-tests/config-files/config-ca-1");
+  DummyClientFace otherFace(m_io, m_keyChain, {true, true});
+  CaModule otherCa(otherFace, sharedState, "tests/unit-tests/config-files/config-ca-1");
+  advanceClocks(time::milliseconds(20), 60);
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  auto newInterest = state.genNewInterest(m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName(),
+                                          time::system_clock::now(),
+                                          time::system_clock::now() + time::days(1));
+  face.receive(*newInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(face.sentData.size(), 1);
+  state.onNewRenewRevokeResponse(face.sentData.back());
+  BOOST_CHECK_EQUAL(otherCa.getCaStorage()->listAllRequests().size(), 1);
+
+  // the request created through one instance continues through the other
+  auto challengeInterest = state.genChallengeInterest(state.selectOrContinueChallenge("pin"));
+  otherFace.receive(*challengeInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(otherFace.sentData.size(), 1);
+  state.onChallengeResponse(otherFace.sentData.back());
+  BOOST_CHECK(state.m_status == Status::CHALLENGE);
+  BOOST_CHECK_EQUAL(ca.getCaStorage()->getRequest(state.m_requestId).challengeType, "pin");
+}
+
+BOOST_AUTO_TEST_CASE(HandleConcurrentChallenges)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  ca.enableStorageThread();
+  advanceClocks(time::milliseconds(20), 60);
+
+  // the completions of the storage thread are posted to the face as the operations complete
+  auto waitForData = [&] (size_t nData) {
+    for (int i = 0; i < 1000 && face.sentData.size() < nData; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      advanceClocks(time::milliseconds(1));
+    }
+    BOOST_REQUIRE_EQUAL(face.sentData.size(), nData);
+  };
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  face.receive(*state.genNewInterest(m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName(),
+                                     time::system_clock::now(), time::system_clock::now() + time::days(1)));
+  waitForData(1);
+  state.onNewRenewRevokeResponse(face.sentData.back());
+  face.receive(*state.genChallengeInterest(state.selectOrContinueChallenge("pin")));
+  waitForData(2);
+  state.onChallengeResponse(face.sentData.back());
+  BOOST_CHECK_EQUAL(state.m_challengeStatus, ChallengePin::NEED_CODE);
+
+  // two wrong PINs sent back to back are handled one after the other, each using up a try
+  auto paramList = state.selectOrContinueChallenge("pin");
+  paramList.begin()->second = "wrong";
+  auto guess1 = state.genChallengeInterest(std::multimap<std::string, std::string>(paramList));
+  auto guess2 = state.genChallengeInterest(std::move(paramList));
+  face.receive(*guess1);
+  face.receive(*guess2);
+  waitForData(4);
+  for (size_t i = 2; i < 4; i++) {
+    state.onChallengeResponse(face.sentData[i]);
+    BOOST_CHECK_EQUAL(state.m_challengeStatus, ChallengePin::WRONG_CODE);
+  }
+  BOOST_CHECK_EQUAL(state.m_remainingTries, 1);
+  auto requestState = ca.getCaStorage()->getRequest(state.m_requestId);
+  BOOST_CHECK_EQUAL(requestState.challengeState->remainingTries, 1);
+}
+
+BOOST_AUTO_TEST_CASE(AdmissionControl)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-8", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  auto newInterest = state.genNewInterest(m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName(),
+                                          time::system_clock::now(),
+                                          time::system_clock::now() + time::days(1));
+  requester::Request otherState(m_keyChain, item, RequestType::NEW);
+  auto otherNewInterest = otherState.genNewInterest(m_keyChain.createIdentity(Name("/ndn/a")).getDefaultKey().getName(),
+                                                    time::system_clock::now(),
+                                                    time::system_clock::now() + time::days(1));
+
+  face.receive(*newInterest);
+  face.receive(*otherNewInterest);
+  advanceClocks(time::milliseconds(20), 1);
+  BOOST_CHECK_EQUAL(face.sentData.size(), 1);
+  // the second NEW exceeds the burst and is shed without a signed reply
+  BOOST_REQUIRE_EQUAL(face.sentNacks.size(), 1);
+  BOOST_CHECK_EQUAL(face.sentNacks.back().getInterest().getName(), otherNewInterest->getName());
+  BOOST_CHECK_EQUAL(face.sentNacks.back().getReason(), ndn::lp::NackReason::CONGESTION);
+
+  // CHALLENGE has its own bucket
+  state.onNewRenewRevokeResponse(face.sentData.back());
+  auto challengeInterest = state.genChallengeInterest(state.selectOrContinueChallenge("pin"));
+  face.receive(*challengeInterest);
+  advanceClocks(time::milliseconds(20), 1);
+  BOOST_CHECK_EQUAL(face.sentData.size(), 2);
+
+  // so does the revocation dataset, apart from INFO
+  requester::RevocationList revocations(Name("/ndn"), std::make_shared<Certificate>(cert));
+  face.receive(*revocations.genDiscoveryInterest());
+  face.receive(*revocations.genDiscoveryInterest());
+  advanceClocks(time::milliseconds(20), 1);
+  BOOST_CHECK_EQUAL(face.sentData.size(), 3);
+  BOOST_CHECK_EQUAL(face.sentNacks.size(), 2);
+
+  auto statistics = ca.getAdmissionStatistics();
+  BOOST_REQUIRE(statistics);
+  BOOST_CHECK_EQUAL(statistics->nAdmitted[static_cast<size_t>(CaEndpoint::NEW)], 1);
+  BOOST_CHECK_EQUAL(statistics->nShed[static_cast<size_t>(CaEndpoint::NEW)], 1);
+  BOOST_CHECK_EQUAL(statistics->nAdmitted[static_cast<size_t>(CaEndpoint::CHALLENGE)], 1);
+  BOOST_CHECK_EQUAL(statistics->nAdmitted[static_cast<size_t>(CaEndpoint::REVOKED)], 1);
+  BOOST_CHECK_EQUAL(statistics->nShed[static_cast<size_t>(CaEndpoint::REVOKED)], 1);
+  BOOST_CHECK_EQUAL(statistics->nAdmitted[static_cast<size_t>(CaEndpoint::INFO)], 0);
 }
 
 BOOST_AUTO_TEST_CASE(HandleRevoke)
@@ -608,6 +1048,263 @@ BOOST_AUTO_TEST_CASE(HandleRevokeWithBadCert)
   BOOST_CHECK_EQUAL(receiveData, true);
 }
 
+BOOST_AUTO_TEST_CASE(HandleRenew)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  // a certificate previously issued by the CA
+  auto clientIdentity = m_keyChain.createIdentity("/ndn/qwerty");
+  auto clientKey = clientIdentity.getDefaultKey();
+  RequestState issuedRequest;
+  issuedRequest.caPrefix = Name("/ndn");
+  issuedRequest.requestType = RequestType::NEW;
+  issuedRequest.cert = clientKey.getDefaultCertificate();
+  auto issuedCert = ca.issueCertificate(issuedRequest);
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+  // what ndncert-ca-server hands to the repo-ng publisher
+  std::vector<Certificate> published;
+  ca.setStatusUpdateCallback([&] (const RequestState& request) {
+    if (isCertificateIssued(request)) {
+      published.push_back(request.cert);
+    }
+  });
+
+  // the renewal certifies a new key of the same identity in a single round trip
+  auto newKey = m_keyChain.createKey(clientIdentity);
+  requester::Request state(m_keyChain, item, RequestType::RENEW);
+  auto interest = state.genRenewInterest(issuedCert, newKey.getName(), time::system_clock::now(),
+                                         time::system_clock::now() + time::days(1));
+  BOOST_REQUIRE(interest != nullptr);
+  face.receive(*interest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  BOOST_CHECK(verifySignature(responses.back(), cert));
+  auto renewedCert = state.onRenewResponse(responses.back());
+  BOOST_CHECK_EQUAL(renewedCert->getKeyName(), newKey.getName());
+  BOOST_CHECK(verifySignature(*renewedCert, cert));
+  BOOST_CHECK(state.m_status == Status::SUCCESS);
+  BOOST_CHECK_NO_THROW(newKey.getCertificate(renewedCert->getName()));
+  BOOST_CHECK_EQUAL(ca.getCaStorage()->listAllRequests().size(), 0);
+  BOOST_REQUIRE_EQUAL(published.size(), 1);
+  BOOST_CHECK_EQUAL(published.front(), *renewedCert);
+
+  // a retransmission gets the same certificate
+  face.receive(*interest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 2);
+  BOOST_CHECK_EQUAL(responses.back().getContent(), responses.front().getContent());
+
+  // another identity cannot be renewed
+  auto otherKey = m_keyChain.createIdentity("/ndn/zhiyi").getDefaultKey();
+  requester::Request otherState(m_keyChain, item, RequestType::RENEW);
+  BOOST_CHECK(otherState.genRenewInterest(issuedCert, otherKey.getName(), time::system_clock::now(),
+                                          time::system_clock::now() + time::days(1)) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(HandleRenewWithBadCert)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  // a self-signed certificate was not issued by the CA
+  auto clientKey = m_keyChain.createIdentity("/ndn/qwerty").getDefaultKey();
+  requester::Request state(m_keyChain, item, RequestType::RENEW);
+  face.receive(*state.genRenewInterest(clientKey.getDefaultCertificate(), clientKey.getName(),
+                                       time::system_clock::now(), time::system_clock::now() + time::days(1)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  BOOST_CHECK_THROW(state.onRenewResponse(responses.back()), std::runtime_error);
+  BOOST_CHECK(state.m_status != Status::SUCCESS);
+}
+
+BOOST_AUTO_TEST_CASE(HandleRevocationDataset)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  RequestState issuedRequest;
+  issuedRequest.caPrefix = Name("/ndn");
+  issuedRequest.requestType = RequestType::NEW;
+  issuedRequest.cert = m_keyChain.createIdentity("/ndn/qwerty").getDefaultKey().getDefaultCertificate();
+  auto issuedCert1 = ca.issueCertificate(issuedRequest);
+  issuedRequest.cert = m_keyChain.createIdentity("/ndn/zhiyi").getDefaultKey().getDefaultCertificate();
+  auto issuedCert2 = ca.issueCertificate(issuedRequest);
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  requester::RevocationList revocations(Name("/ndn"), std::make_shared<Certificate>(cert));
+  std::vector<Name> fetched;
+  auto synchronize = [&] {
+    face.receive(*revocations.genDiscoveryInterest());
+    advanceClocks(time::milliseconds(20), 60);
+    auto interest = revocations.onDiscoveryResponse(responses.back());
+    while (interest != nullptr) {
+      fetched.push_back(interest->getName());
+      face.receive(*interest);
+      advanceClocks(time::milliseconds(20), 60);
+      interest = revocations.onSegmentResponse(responses.back());
+    }
+  };
+
+  // the first synchronization fetches the whole dataset
+  BOOST_CHECK(ca.getRevocationRegistry().revoke(issuedCert1));
+  auto version = ca.getRevocationRegistry().getVersion();
+  synchronize();
+  BOOST_CHECK_EQUAL(revocations.getVersion(), version);
+  BOOST_CHECK(revocations.isRevoked(issuedCert1));
+  BOOST_CHECK(!revocations.isRevoked(issuedCert2));
+  BOOST_REQUIRE(!fetched.empty());
+  BOOST_CHECK_EQUAL(fetched.front(), Name(revocationtlv::makeDatasetName(Name("/ndn"), version)).appendSegment(0));
+
+  // later ones only fetch the changes
+  fetched.clear();
+  synchronize();
+  BOOST_CHECK(fetched.empty());
+  BOOST_CHECK(ca.getRevocationRegistry().revoke(issuedCert2));
+  synchronize();
+  BOOST_CHECK_EQUAL(revocations.getVersion(), version + 1);
+  BOOST_CHECK(revocations.isRevoked(issuedCert1));
+  BOOST_CHECK(revocations.isRevoked(issuedCert2));
+  BOOST_REQUIRE_EQUAL(fetched.size(), 1);
+  BOOST_CHECK_EQUAL(fetched.front(),
+                    Name(revocationtlv::makeDatasetName(Name("/ndn"), version + 1, version)).appendSegment(0));
+
+  // the segments are only signed once
+  face.receive(Interest(fetched.front()));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_EQUAL(responses.back().getSignatureValue(), responses[responses.size() - 2].getSignatureValue());
+
+  // an unknown version is refused
+  face.receive(Interest(Name(revocationtlv::makeDatasetName(Name("/ndn"), version + 2)).appendSegment(0)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK(std::get<0>(errortlv::decodefromDataContent(responses.back().getContent())) ==
+              ErrorCode::INVALID_PARAMETER);
+
+  // a revoked certificate cannot be renewed
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::RENEW);
+  auto newKey = m_keyChain.createKey(m_keyChain.getPib().getIdentity("/ndn/qwerty"));
+  face.receive(*state.genRenewInterest(issuedCert1, newKey.getName(), time::system_clock::now(),
+                                       time::system_clock::now() + time::days(1)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_THROW(state.onRenewResponse(responses.back()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(HandleStatus)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  auto makeCertRequest = [&] (const Name& identityName) {
+    auto key = m_keyChain.createIdentity(identityName).getDefaultKey();
+    Certificate certRequest;
+    certRequest.setName(Name(key.getName()).append("cert-request").appendVersion());
+    certRequest.setContentType(ndn::tlv::ContentType_Key);
+    certRequest.setContent(key.getPublicKey());
+    SignatureInfo signatureInfo;
+    signatureInfo.setValidityPeriod(ndn::security::ValidityPeriod(time::system_clock::now(),
+                                                                  time::system_clock::now() + time::hours(10)));
+    m_keyChain.sign(certRequest, signingByKey(key.getName()).setSignatureInfo(signatureInfo));
+    return certRequest;
+  };
+  RequestState issuedRequest;
+  issuedRequest.caPrefix = Name("/ndn");
+  issuedRequest.requestType = RequestType::NEW;
+  issuedRequest.cert = makeCertRequest("/ndn/qwerty");
+  auto issuedCert1 = ca.issueCertificate(issuedRequest);
+  issuedRequest.cert = makeCertRequest("/ndn/zhiyi");
+  auto issuedCert2 = ca.issueCertificate(issuedRequest);
+  auto unknownCert = m_keyChain.createIdentity("/ndn/unknown").getDefaultKey().getDefaultCertificate();
+  ca.getRevocationRegistry().revoke(issuedCert2);
+  auto version = ca.getRevocationRegistry().getVersion();
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+  auto query = [&] (const std::vector<Certificate>& certs) {
+    face.receive(*requester::Request::genStatusInterest(item, certs));
+    advanceClocks(time::milliseconds(20), 60);
+    BOOST_REQUIRE(!responses.empty());
+    return requester::Request::onStatusResponse(responses.back(), item);
+  };
+
+  // a single certificate is queried by name
+  auto statuses = query({issuedCert1});
+  BOOST_REQUIRE_EQUAL(statuses.size(), 1);
+  BOOST_CHECK(statuses[0].first == getCertDigest(issuedCert1));
+  BOOST_CHECK_EQUAL(statuses[0].second, CertStatus::GOOD);
+  BOOST_CHECK_EQUAL(responses.back().getName(),
+                    Name(statustlv::makeQueryName(Name("/ndn"), getCertDigest(issuedCert1))).appendVersion(version));
+
+  // a repeated query costs no signature
+  query({issuedCert1});
+  BOOST_REQUIRE_EQUAL(responses.size(), 2);
+  BOOST_CHECK_EQUAL(responses[1].getSignatureValue(), responses[0].getSignatureValue());
+
+  // several certificates are queried at once
+  statuses = query({issuedCert1, issuedCert2, unknownCert});
+  BOOST_REQUIRE_EQUAL(statuses.size(), 3);
+  BOOST_CHECK_EQUAL(statuses[0].second, CertStatus::GOOD);
+  BOOST_CHECK_EQUAL(statuses[1].second, CertStatus::REVOKED);
+  BOOST_CHECK(statuses[2].first == getCertDigest(unknownCert));
+  BOOST_CHECK_EQUAL(statuses[2].second, CertStatus::UNKNOWN);
+
+  // a revocation invalidates the cached responses
+  ca.getRevocationRegistry().revoke(issuedCert1);
+  statuses = query({issuedCert1});
+  BOOST_CHECK_EQUAL(statuses[0].second, CertStatus::REVOKED);
+  BOOST_CHECK_EQUAL(responses.back().getName().at(-1).toVersion(), version + 1);
+
+  // an expired certificate is reported as such
+  issuedRequest.cert = makeCertRequest("/ndn/expired");
+  auto issuedCert3 = ca.issueCertificate(issuedRequest);
+  BOOST_CHECK_EQUAL(query({issuedCert3})[0].second, CertStatus::GOOD);
+  advanceClocks(time::hours(1), 11);
+  BOOST_CHECK_EQUAL(query({issuedCert3})[0].second, CertStatus::EXPIRED);
+
+  // a query without digest is refused
+  face.receive(Interest(Name("/ndn/CA/STATUS")));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_THROW(requester::Request::onStatusResponse(responses.back(), item), std::runtime_error);
+  BOOST_CHECK_THROW(requester::Request::genStatusInterest(item, {}), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END() // TestCaModule
 
 } // namespace ndncert::tests
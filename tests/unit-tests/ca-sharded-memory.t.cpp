@@ -0,0 +1,220 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/ca-sharded-memory.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+
+#include <thread>
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+static RequestId
+makeRequestId(uint32_t i)
+{
+  RequestId requestId = {};
+  for (size_t j = 0; j < 4; j++) {
+    requestId[3 - j] = static_cast<uint8_t>(i >> (8 * j));
+  }
+  return requestId;
+}
+
+BOOST_FIXTURE_TEST_SUITE(TestCaShardedMemory, KeyChainFixture)
+
+BOOST_AUTO_TEST_CASE(RequestOperations)
+{
+  CaShardedMemory storage;
+
+  auto cert1 = m_keyChain.createIdentity(Name("/ndn/site1")).getDefaultKey().getDefaultCertificate();
+
+  RequestId requestId = {{101}};
+  RequestState request1;
+  request1.caPrefix = Name("/ndn/site1");
+  request1.requestId = requestId;
+  request1.requestType = RequestType::NEW;
+  request1.cert = cert1;
+  BOOST_CHECK_NO_THROW(storage.addRequest(request1));
+  BOOST_CHECK_THROW(storage.addRequest(request1), std::runtime_error);
+  BOOST_CHECK_EQUAL(storage.size(), 1);
+
+  auto result = storage.getRequest(requestId);
+  BOOST_CHECK_EQUAL(request1.cert, result.cert);
+  BOOST_CHECK(request1.status == result.status);
+  BOOST_CHECK_EQUAL(request1.caPrefix, result.caPrefix);
+
+  RequestState request2 = request1;
+  request2.challengeType = "email";
+  JsonSection secret;
+  secret.add("code", "1234");
+  request2.challengeState = ChallengeState("test", time::system_clock::now(), 3,
+                                           time::seconds(3600), std::move(secret));
+  storage.updateRequest(request2);
+  result = storage.getRequest(requestId);
+  BOOST_CHECK_EQUAL(result.challengeType, "email");
+  BOOST_REQUIRE(result.challengeState);
+  BOOST_CHECK_EQUAL(result.challengeState->secrets.get<std::string>("code"), "1234");
+  BOOST_CHECK_EQUAL(storage.size(), 1);
+
+  auto cert2 = m_keyChain.createIdentity(Name("/ndn/site2")).getDefaultKey().getDefaultCertificate();
+  RequestId requestId2 = {{102}};
+  RequestState request3;
+  request3.caPrefix = Name("/ndn/site2");
+  request3.requestId = requestId2;
+  request3.requestType = RequestType::NEW;
+  request3.cert = cert2;
+  storage.addRequest(request3);
+
+  BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 2);
+  BOOST_CHECK_EQUAL(storage.listAllRequests(Name("/ndn/site2")).size(), 1);
+
+  storage.deleteRequest(requestId2);
+  BOOST_CHECK_EQUAL(storage.listAllRequests().size(), 1);
+  BOOST_CHECK_THROW(storage.getRequest(requestId2), std::runtime_error);
+  BOOST_CHECK_EQUAL(storage.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GrowAndDelete)
+{
+  // a single shard makes every insertion and deletion go through the same table
+  CaShardedMemory storage(1, 0);
+  const uint32_t nRequests = 1000;
+  for (uint32_t i = 0; i < nRequests; i++) {
+    RequestState request;
+    request.caPrefix = Name("/ndn");
+    request.requestId = makeRequestId(i);
+    storage.addRequest(request);
+  }
+  BOOST_CHECK_EQUAL(storage.size(), nRequests);
+
+  for (uint32_t i = 0; i < nRequests; i += 2) {
+    storage.deleteRequest(makeRequestId(i));
+  }
+  BOOST_CHECK_EQUAL(storage.size(), nRequests / 2);
+  for (uint32_t i = 0; i < nRequests; i++) {
+    if (i % 2 == 0) {
+      BOOST_CHECK_THROW(storage.getRequest(makeRequestId(i)), std::runtime_error);
+    }
+    else {
+      BOOST_CHECK(storage.getRequest(makeRequestId(i)).requestId == makeRequestId(i));
+    }
+  }
+
+  RequestFilter filter;
+  filter.limit = 10;
+  std::vector<RequestId> visited;
+  storage.forEachRequest(filter, [&] (const RequestState& request) {
+    visited.push_back(request.requestId);
+    return true;
+  });
+  BOOST_REQUIRE_EQUAL(visited.size(), 10);
+  BOOST_CHECK(visited.front() == makeRequestId(1));
+  BOOST_CHECK(std::is_sorted(visited.begin(), visited.end()));
+  BOOST_CHECK_EQUAL(storage.countRequests(filter), nRequests / 2);
+}
+
+BOOST_AUTO_TEST_CASE(Capacity)
+{
+  auto storage = CaStorage::createCaStorage(CaShardedMemory::STORAGE_TYPE, Name("/ndn"),
+                                            "?shards=4&capacity=3");
+  BOOST_REQUIRE(storage != nullptr);
+  for (uint32_t i = 0; i < 3; i++) {
+    RequestState request;
+    request.requestId = makeRequestId(i);
+    storage->addRequest(request);
+  }
+
+  RequestState request;
+  request.requestId = makeRequestId(3);
+  BOOST_CHECK_THROW(storage->addRequest(request), std::runtime_error);
+  BOOST_CHECK_THROW(storage->updateRequest(request), std::runtime_error);
+
+  // updating an existing request does not consume capacity
+  request.requestId = makeRequestId(2);
+  BOOST_CHECK_NO_THROW(storage->updateRequest(request));
+
+  storage->deleteRequest(makeRequestId(0));
+  request.requestId = makeRequestId(3);
+  BOOST_CHECK_NO_THROW(storage->addRequest(request));
+
+  BOOST_CHECK_THROW(CaStorage::createCaStorage(CaShardedMemory::STORAGE_TYPE, Name("/ndn"), "?shards=x"),
+                    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentAccess)
+{
+  CaShardedMemory storage(8, 0);
+  const uint32_t nThreads = 4;
+  const uint32_t nPerThread = 500;
+
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < nThreads; t++) {
+    threads.emplace_back([&storage, t] {
+      for (uint32_t i = 0; i < nPerThread; i++) {
+        RequestState request;
+        request.requestId = makeRequestId(t * nPerThread + i);
+        request.status = Status::BEFORE_CHALLENGE;
+        storage.addRequest(request);
+        request.status = Status::CHALLENGE;
+        storage.updateRequest(request);
+        storage.getRequest(request.requestId);
+        if (i % 4 == 0) {
+          storage.deleteRequest(request.requestId);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  BOOST_CHECK_EQUAL(storage.size(), nThreads * nPerThread * 3 / 4);
+  RequestFilter filter;
+  filter.status = Status::CHALLENGE;
+  BOOST_CHECK_EQUAL(storage.countRequests(filter), storage.size());
+}
+
+BOOST_AUTO_TEST_CASE(MemoryUsage)
+{
+  CaShardedMemory storage(2, 0);
+  BOOST_CHECK_EQUAL(storage.getMemoryUsage().nRequests, 0);
+  BOOST_CHECK_EQUAL(storage.getMemoryUsage().payloadBytes, 0);
+
+  auto cert = m_keyChain.createIdentity(Name("/ndn/site1")).getDefaultKey().getDefaultCertificate();
+  RequestState request;
+  request.caPrefix = Name("/ndn/site1");
+  request.requestId = {{1}};
+  request.cert = cert;
+  storage.addRequest(request);
+
+  auto usage = storage.getMemoryUsage();
+  BOOST_CHECK_EQUAL(usage.nRequests, 1);
+  BOOST_CHECK_GT(usage.tableBytes, 0);
+  BOOST_CHECK_GE(usage.payloadBytes, cert.wireEncode().size());
+
+  storage.deleteRequest(request.requestId);
+  BOOST_CHECK_EQUAL(storage.getMemoryUsage().payloadBytes, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestCaShardedMemory
+
+} // namespace ndncert::tests
@@ -0,0 +1,83 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/ca-memory.hpp"
+#include "detail/ca-synchronized-storage.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+
+#include <thread>
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+BOOST_FIXTURE_TEST_SUITE(TestCaSynchronizedStorage, KeyChainFixture)
+
+BOOST_AUTO_TEST_CASE(Factory)
+{
+  auto storage = CaStorage::createCaStorage("ca-storage-synchronized:memory", Name("/ndn"), "");
+  BOOST_REQUIRE(storage != nullptr);
+  BOOST_CHECK(storage->isThreadSafe());
+  auto synchronized = dynamic_cast<CaSynchronizedStorage*>(storage.get());
+  BOOST_REQUIRE(synchronized != nullptr);
+  BOOST_CHECK(!synchronized->getInnerStorage().isThreadSafe());
+  BOOST_CHECK(dynamic_cast<CaMemory*>(&synchronized->getInnerStorage()) != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentAccess)
+{
+  CaSynchronizedStorage storage(std::make_unique<CaMemory>());
+  auto cert = m_keyChain.createIdentity(Name("/ndn/site1")).getDefaultKey().getDefaultCertificate();
+
+  const size_t nThreads = 4;
+  const size_t nPerThread = 200;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < nThreads; t++) {
+    threads.emplace_back([&, t] {
+      for (size_t i = 0; i < nPerThread; i++) {
+        RequestState request;
+        request.caPrefix = Name("/ndn/site1");
+        request.requestId = {{static_cast<uint8_t>(t), static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i)}};
+        request.requestType = RequestType::NEW;
+        request.cert = cert;
+        storage.addRequest(request);
+        request.status = Status::CHALLENGE;
+        storage.updateRequest(request);
+        if (i % 2 == 0) {
+          storage.deleteRequest(request.requestId);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  BOOST_CHECK_EQUAL(storage.listAllRequests().size(), nThreads * nPerThread / 2);
+  RequestFilter filter;
+  filter.status = Status::CHALLENGE;
+  BOOST_CHECK_EQUAL(storage.countRequests(filter), nThreads * nPerThread / 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestCaSynchronizedStorage
+
+} // namespace ndncert::tests
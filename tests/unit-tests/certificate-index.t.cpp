@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/certificate-index.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+
+namespace ndncert::tests {
+
+class CertificateIndexFixture : public KeyChainFixture
+{
+public:
+  Certificate
+  makeCert(const Name& identityName, uint64_t version)
+  {
+    auto identity = m_keyChain.createIdentity(identityName);
+    auto cert = identity.getDefaultKey().getDefaultCertificate();
+    cert.setName(Name(identity.getDefaultKey().getName()).append("NDNCERT").appendVersion(version));
+    m_keyChain.sign(cert, ndn::signingByIdentity(identity));
+    return cert;
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestCertificateIndex, CertificateIndexFixture)
+
+BOOST_AUTO_TEST_CASE(Lookup)
+{
+  CertificateIndex index;
+  auto cert1 = makeCert("/ndn/site1", 1);
+  auto cert2 = makeCert("/ndn/site1", 2);
+  auto cert3 = makeCert("/ndn/site2", 1);
+  index.insert(cert1);
+  index.insert(cert2);
+  index.insert(cert3);
+  BOOST_CHECK_EQUAL(index.size(), 3);
+
+  BOOST_CHECK_EQUAL(index.find(cert1.getName())->getName(), cert1.getName());
+  BOOST_CHECK(!index.find(cert1.getKeyName()));
+
+  BOOST_CHECK_EQUAL(index.find(Interest(cert1.getName()))->getName(), cert1.getName());
+  BOOST_CHECK_EQUAL(index.find(Interest(cert3.getFullName()))->getName(), cert3.getName());
+  BOOST_CHECK(!index.find(Interest(cert1.getKeyName())));
+  BOOST_CHECK(!index.find(Interest(Name(cert3.getName()).append(cert1.getFullName().at(-1)))));
+
+  Interest prefixInterest(cert1.getKeyName());
+  prefixInterest.setCanBePrefix(true);
+  BOOST_CHECK_EQUAL(index.find(prefixInterest)->getName(), cert2.getName());
+  prefixInterest.setName("/ndn/site3");
+  BOOST_CHECK(!index.find(prefixInterest));
+
+  BOOST_CHECK(index.erase(cert2.getName()));
+  BOOST_CHECK(!index.erase(cert2.getName()));
+  prefixInterest.setName(cert1.getKeyName());
+  BOOST_CHECK_EQUAL(index.find(prefixInterest)->getName(), cert1.getName());
+
+  // removing the last certificate under a prefix prunes the tree
+  BOOST_CHECK(index.erase(cert3.getName()));
+  prefixInterest.setName("/ndn/site2");
+  BOOST_CHECK(!index.find(prefixInterest));
+  BOOST_CHECK_EQUAL(index.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Replace)
+{
+  CertificateIndex index;
+  auto cert = makeCert("/ndn/site1", 1);
+  index.insert(cert);
+  auto resigned = cert;
+  m_keyChain.sign(resigned, ndn::signingWithSha256());
+  index.insert(resigned);
+
+  BOOST_CHECK_EQUAL(index.size(), 1);
+  BOOST_CHECK(!index.find(Interest(cert.getFullName())));
+  BOOST_CHECK_EQUAL(index.find(cert.getName())->wireEncode(), resigned.wireEncode());
+}
+
+BOOST_AUTO_TEST_CASE(LruEviction)
+{
+  CertificateIndex index(2);
+  auto cert1 = makeCert("/ndn/site1", 1);
+  auto cert2 = makeCert("/ndn/site2", 1);
+  auto cert3 = makeCert("/ndn/site3", 1);
+  index.insert(cert1);
+  index.insert(cert2);
+  BOOST_CHECK(index.find(cert1.getName()));
+  index.insert(cert3);
+
+  BOOST_CHECK_EQUAL(index.size(), 2);
+  BOOST_CHECK(index.find(cert1.getName()));
+  BOOST_CHECK(!index.find(cert2.getName()));
+  BOOST_CHECK(index.find(cert3.getName()));
+
+  CertificateIndex disabled(0);
+  disabled.insert(cert1);
+  BOOST_CHECK_EQUAL(disabled.size(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestCertificateIndex
+
+} // namespace ndncert::tests
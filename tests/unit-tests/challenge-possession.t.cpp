@@ -33,8 +33,7 @@ public:
   createTrustAnchor()
   {
     trustAnchor = m_keyChain.createIdentity("/trust").getDefaultKey().getDefaultCertificate();
-    challenge.parseConfigFile();
-    challenge.m_trustAnchors.front() = trustAnchor;
+    challenge.m_trustAnchors = std::make_shared<TrustAnchorStore>(std::vector<Certificate>{trustAnchor});
   }
 
   void
@@ -92,8 +91,8 @@ BOOST_AUTO_TEST_CASE(LoadConfig)
   BOOST_CHECK_EQUAL(challenge.CHALLENGE_TYPE, "Possession");
 
   challenge.parseConfigFile();
-  BOOST_CHECK_EQUAL(challenge.m_trustAnchors.size(), 1);
-  auto cert = challenge.m_trustAnchors.front();
+  BOOST_CHECK_EQUAL(challenge.m_trustAnchors->getAnchors().size(), 1);
+  auto cert = challenge.m_trustAnchors->getAnchors().front();
   BOOST_CHECK_EQUAL(cert.getName(),
                     "/ndn/site1/KEY/%11%BC%22%F4c%15%FF%17/self/%FD%00%00%01Y%C8%14%D9%A5");
 }
@@ -105,6 +104,10 @@ BOOST_AUTO_TEST_CASE(HandleChallengeRequest)
   createRequesterCredential();
   signCertRequest();
 
+  BOOST_CHECK(state.challengeState->binarySecret == credential.wireEncode());
+  BOOST_CHECK(!state.challengeState->secrets.get_optional<std::string>(ChallengePossession::PARAMETER_KEY_CREDENTIAL_CERT));
+  BOOST_CHECK_EQUAL(challenge.m_trustAnchors->getCacheSize(), 1);
+
   auto nonceBuf = ndn::fromHex(state.challengeState->secrets.get("nonce", ""));
   std::array<uint8_t, 16> nonce{};
   memcpy(nonce.data(), nonceBuf->data(), 16);
@@ -112,6 +115,20 @@ BOOST_AUTO_TEST_CASE(HandleChallengeRequest)
   BOOST_CHECK_EQUAL(statusToString(state.status), statusToString(Status::PENDING));
 }
 
+BOOST_AUTO_TEST_CASE(HandleChallengeRequestUntrusted)
+{
+  createTrustAnchor();
+  createCertificateRequest();
+  createRequesterCredential();
+  challenge.m_trustAnchors = std::make_shared<TrustAnchorStore>(
+    std::vector<Certificate>{m_keyChain.createIdentity("/other").getDefaultKey().getDefaultCertificate()});
+
+  auto params = challenge.getRequestedParameterList(state.status, "");
+  ChallengePossession::fulfillParameters(params, m_keyChain, credential.getName(), std::array<uint8_t, 16>{});
+  challenge.handleChallengeRequest(challenge.genChallengeRequestTLV(state.status, "", params), state);
+  BOOST_CHECK_EQUAL(statusToString(state.status), statusToString(Status::FAILURE));
+}
+
 BOOST_AUTO_TEST_CASE(HandleChallengeRequestProofFail)
 {
   createTrustAnchor();
@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "challenge/challenge-token.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+
+#include <boost/filesystem/operations.hpp>
+
+#include <fstream>
+
+namespace ndncert::tests {
+
+const std::string CONFIG_FILE = "tests/unit-tests/config-files/config-challenge-token";
+
+class ChallengeTokenFixture : public KeyChainFixture
+{
+public:
+  ChallengeTokenFixture()
+  {
+    request.caPrefix = Name("/ndn/site1");
+    request.requestId = RequestId{{101}};
+    request.requestType = RequestType::NEW;
+    request.cert = m_keyChain.createIdentity("/ndn/site1/device1").getDefaultKey().getDefaultCertificate();
+  }
+
+  void
+  handle(const std::string& token)
+  {
+    auto params = challenge.getRequestedParameterList(Status::BEFORE_CHALLENGE, "");
+    BOOST_REQUIRE_EQUAL(params.count(ChallengeToken::PARAMETER_KEY_TOKEN), 1);
+    params.find(ChallengeToken::PARAMETER_KEY_TOKEN)->second = token;
+    request.status = Status::BEFORE_CHALLENGE;
+    challenge.handleChallengeRequest(challenge.genChallengeRequestTLV(Status::BEFORE_CHALLENGE, "", params), request);
+  }
+
+public:
+  ChallengeToken challenge{CONFIG_FILE};
+  std::vector<uint8_t> key = ChallengeToken::loadKey(CONFIG_FILE);
+  ca::RequestState request;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestChallengeToken, ChallengeTokenFixture)
+
+BOOST_AUTO_TEST_CASE(ChallengeType)
+{
+  BOOST_CHECK_EQUAL(challenge.CHALLENGE_TYPE, "token");
+  BOOST_CHECK_EQUAL(key.size(), 32);
+}
+
+BOOST_AUTO_TEST_CASE(SpendOnce)
+{
+  auto token = ChallengeToken::mintToken(key, "/ndn/site1/device1", time::system_clock::now() + 1_h);
+  handle(token);
+  BOOST_CHECK(request.status == Status::PENDING);
+  BOOST_CHECK(!request.challengeState);
+
+  // another challenge of the process knows that the token is spent
+  ChallengeToken otherChallenge(CONFIG_FILE);
+  auto params = otherChallenge.getRequestedParameterList(Status::BEFORE_CHALLENGE, "");
+  params.find(ChallengeToken::PARAMETER_KEY_TOKEN)->second = token;
+  request.status = Status::BEFORE_CHALLENGE;
+  otherChallenge.handleChallengeRequest(otherChallenge.genChallengeRequestTLV(Status::BEFORE_CHALLENGE, "", params),
+                                        request);
+  BOOST_CHECK(request.status == Status::FAILURE);
+  BOOST_CHECK_EQUAL(otherChallenge.m_authority->getSpentCount(), challenge.m_authority->getSpentCount());
+}
+
+BOOST_AUTO_TEST_CASE(WrongIdentity)
+{
+  handle(ChallengeToken::mintToken(key, "/ndn/site1/device2", time::system_clock::now() + 1_h));
+  BOOST_CHECK(request.status == Status::FAILURE);
+}
+
+BOOST_AUTO_TEST_CASE(WrongKey)
+{
+  std::vector<uint8_t> otherKey(32, 0x42);
+  handle(ChallengeToken::mintToken(otherKey, "/ndn/site1/device1", time::system_clock::now() + 1_h));
+  BOOST_CHECK(request.status == Status::FAILURE);
+}
+
+BOOST_AUTO_TEST_CASE(Expired)
+{
+  handle(ChallengeToken::mintToken(key, "/ndn/site1/device1", time::system_clock::now() - 1_h));
+  BOOST_CHECK(request.status == Status::FAILURE);
+}
+
+BOOST_AUTO_TEST_CASE(Malformed)
+{
+  handle("not a token");
+  BOOST_CHECK(request.status == Status::FAILURE);
+
+  auto token = ChallengeToken::mintToken(key, "/ndn/site1/device1", time::system_clock::now() + 1_h);
+  token.back() = token.back() == '0' ? '1' : '0';
+  handle(token);
+  BOOST_CHECK(request.status == Status::FAILURE);
+}
+
+BOOST_AUTO_TEST_CASE(SpentTokensFile)
+{
+  boost::filesystem::create_directories(UNIT_TESTS_TMPDIR);
+  auto path = std::string(UNIT_TESTS_TMPDIR) + "/challenge-token-spent";
+  boost::filesystem::remove(path);
+  auto spent = ChallengeToken::mintToken(key, "/ndn/site1/device1", time::system_clock::now() + 1_h);
+  {
+    ChallengeToken::Authority authority(key, path);
+    BOOST_CHECK_EQUAL(authority.spend(spent, "/ndn/site1/device1"), "");
+    BOOST_CHECK_EQUAL(boost::filesystem::file_size(path), 16);
+  }
+  {
+    // a token that expired since it was spent, followed by an incomplete record
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file << std::string(16, '\0') << std::string(5, '\x42');
+  }
+
+  // after a restart, the token is still spent
+  ChallengeToken::Authority authority(key, path);
+  BOOST_CHECK_EQUAL(authority.getSpentCount(), 1);
+  BOOST_CHECK_EQUAL(authority.spend(spent, "/ndn/site1/device1"), "Token already spent.");
+  // the file is trimmed when it is loaded
+  BOOST_CHECK_EQUAL(boost::filesystem::file_size(path), 16);
+  auto other = ChallengeToken::mintToken(key, "/ndn/site1/device2", time::system_clock::now() + 1_h);
+  BOOST_CHECK_EQUAL(authority.spend(other, "/ndn/site1/device2"), "");
+  BOOST_CHECK_EQUAL(boost::filesystem::file_size(path), 32);
+  boost::filesystem::remove(path);
+
+  // without a file, only the process remembers the spent tokens
+  BOOST_CHECK_EQUAL(ChallengeToken::loadSpentTokensPath(CONFIG_FILE), "");
+}
+
+BOOST_AUTO_TEST_CASE(GenerateKey)
+{
+  boost::filesystem::create_directories(UNIT_TESTS_TMPDIR);
+  auto path = std::string(UNIT_TESTS_TMPDIR) + "/challenge-token.conf";
+  ChallengeToken::generateKey(path);
+  auto newKey = ChallengeToken::loadKey(path);
+  BOOST_CHECK_EQUAL(newKey.size(), 32);
+  BOOST_CHECK(newKey != key);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestChallengeToken
+
+} // namespace ndncert::tests
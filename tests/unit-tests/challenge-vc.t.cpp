@@ -23,6 +23,8 @@
 #include "tests/boost-test.hpp"
 #include "tests/key-chain-fixture.hpp"
 
+#include <boost/asio/executor_work_guard.hpp>
+
 #include <fstream>
 
 namespace ndncert::tests {
@@ -146,6 +148,64 @@ BOOST_AUTO_TEST_CASE(OnChallengeRequestWithPresentationId)
     std::remove("tmp.txt");
 }
 
+BOOST_AUTO_TEST_CASE(OnChallengeRequestWithHelper)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn/site1"));
+  auto key = identity.getDefaultKey();
+  auto cert = key.getDefaultCertificate();
+  ca::RequestState request;
+  request.caPrefix = Name("/ndn/site1");
+  request.requestId = {{102}};
+  request.requestType = RequestType::NEW;
+  request.cert = cert;
+
+  ChallengeVC challenge("./tests/unit-tests/config-files/config-challenge-vc-helper");
+  boost::asio::io_context io;
+  auto work = boost::asio::make_work_guard(io);
+  int nCallbacks = 0;
+  auto handle = [&] (const std::string& key, const std::string& value) {
+    Block paramTLV = ndn::makeEmptyBlock(tlv::EncryptedPayload);
+    paramTLV.push_back(ndn::makeStringBlock(tlv::ParameterKey, key));
+    paramTLV.push_back(ndn::makeStringBlock(tlv::ParameterValue, value));
+    challenge.handleChallengeRequestAsync(paramTLV, request, io,
+      [&] (std::tuple<ErrorCode, std::string> result, ca::RequestState state) {
+        nCallbacks++;
+        BOOST_CHECK(std::get<0>(result) == ErrorCode::NO_ERROR);
+        request = std::move(state);
+        io.stop();
+      });
+    io.restart();
+    io.run_for(std::chrono::seconds(10));
+  };
+
+  handle(ChallengeVC::PARAMETER_KEY_DID, "did");
+  BOOST_CHECK_EQUAL(nCallbacks, 1);
+  BOOST_CHECK(request.status == Status::CHALLENGE);
+  BOOST_REQUIRE(request.challengeState);
+  BOOST_CHECK_EQUAL(request.challengeState->challengeStatus, ChallengeVC::NEED_PRESENTATION_ID);
+  BOOST_CHECK_EQUAL(request.challengeState->secrets.get<std::string>(ChallengeVC::PARAMETER_KEY_PRESENTATION_ID),
+                    "pres-did");
+
+  // the helper has reported the verdict, which the requester claims
+  handle(ChallengeVC::PARAMETER_KEY_PRESENTATION_ID, "pres-did");
+  BOOST_CHECK_EQUAL(nCallbacks, 2);
+  BOOST_CHECK(request.status == Status::PENDING);
+  BOOST_CHECK(!request.challengeState);
+
+  // a requester whose presentation is pending may ask again
+  request.status = Status::BEFORE_CHALLENGE;
+  handle(ChallengeVC::PARAMETER_KEY_DID, "late");
+  BOOST_CHECK_EQUAL(nCallbacks, 3);
+  BOOST_REQUIRE(request.challengeState);
+  auto remainingTries = request.challengeState->remainingTries;
+  handle(ChallengeVC::PARAMETER_KEY_PRESENTATION_ID, "pres-late");
+  BOOST_CHECK_EQUAL(nCallbacks, 4);
+  BOOST_CHECK(request.status == Status::CHALLENGE);
+  BOOST_REQUIRE(request.challengeState);
+  BOOST_CHECK_EQUAL(request.challengeState->challengeStatus, ChallengeVC::NEED_PRESENTATION_ID);
+  BOOST_CHECK_EQUAL(request.challengeState->remainingTries, remainingTries);
+}
+
 BOOST_AUTO_TEST_SUITE_END() // TestChallengeVC
 
 } // namespace ndncert::tests
\ No newline at end of file
@@ -40,6 +40,7 @@ BOOST_AUTO_TEST_CASE(CaConfigFile)
   BOOST_CHECK_EQUAL(config.caProfile.probeParameterKeys.front(), "full name");
   BOOST_CHECK_EQUAL(config.caProfile.supportedChallenges.size(), 1);
   BOOST_CHECK_EQUAL(config.caProfile.supportedChallenges.front(), "pin");
+  BOOST_CHECK_EQUAL(config.inlineCertMaxSize, ca::DEFAULT_INLINE_CERT_MAX_SIZE);
 
   config.load("tests/unit-tests/config-files/config-ca-2");
   BOOST_CHECK_EQUAL(config.caProfile.caPrefix, "/ndn");
@@ -70,6 +71,36 @@ BOOST_AUTO_TEST_CASE(CaConfigFile)
   BOOST_CHECK_EQUAL(names[0], Name("/irl/1@1.edu"));
   BOOST_CHECK_EQUAL(names[1], Name("/irl/ndncert"));
   BOOST_CHECK_EQUAL(names[2].size(), 1);
+  BOOST_CHECK(!config.stateless);
+
+  config.load("tests/unit-tests/config-files/config-ca-7");
+  BOOST_REQUIRE(config.stateless);
+  BOOST_CHECK(config.stateless->secret.empty());
+  BOOST_CHECK_EQUAL(config.stateless->keyLifetime, time::seconds(3600));
+  BOOST_CHECK_EQUAL(config.stateless->tokenLifetime, time::seconds(600));
+  BOOST_CHECK(!config.admission);
+  BOOST_CHECK_EQUAL(config.inlineCertMaxSize, 0);
+  BOOST_CHECK_EQUAL(config.certStorePath, ":memory:");
+  BOOST_CHECK_EQUAL(config.revocationRegistryPath, ":memory:");
+
+  config.load("tests/unit-tests/config-files/config-ca-8");
+  BOOST_REQUIRE(config.admission);
+  const auto& newLimit = config.admission->endpointLimits[static_cast<size_t>(ca::CaEndpoint::NEW)];
+  BOOST_REQUIRE(newLimit);
+  BOOST_CHECK_EQUAL(newLimit->rate, 1);
+  BOOST_CHECK_EQUAL(newLimit->burst, 1);
+  const auto& challengeLimit = config.admission->endpointLimits[static_cast<size_t>(ca::CaEndpoint::CHALLENGE)];
+  BOOST_REQUIRE(challengeLimit);
+  BOOST_CHECK_EQUAL(challengeLimit->burst, 100);
+  BOOST_CHECK(!config.admission->endpointLimits[static_cast<size_t>(ca::CaEndpoint::PROBE)]);
+  BOOST_REQUIRE(config.admission->endpointLimits[static_cast<size_t>(ca::CaEndpoint::REVOKED)]);
+  BOOST_REQUIRE(config.admission->totalLimit);
+  BOOST_CHECK_EQUAL(config.admission->totalLimit->burst, 100);
+  BOOST_CHECK_EQUAL(config.admission->challengeReserve, 0.2);
+  BOOST_REQUIRE(config.admission->keyLocatorLimit);
+  BOOST_CHECK_EQUAL(config.admission->keyLocatorLimit->rate, 2);
+  BOOST_CHECK_EQUAL(config.admission->maxKeyLocators, 1000);
+  BOOST_CHECK(config.admission->shedAction == ca::ShedAction::NACK);
 }
 
 BOOST_AUTO_TEST_CASE(CaConfigFileWithErrors)
@@ -83,6 +114,8 @@ BOOST_AUTO_TEST_CASE(CaConfigFileWithErrors)
   BOOST_CHECK_THROW(config.load("tests/unit-tests/config-files/config-ca-4"), std::runtime_error);
   // unsupported name assignment
   BOOST_CHECK_THROW(config.load("tests/unit-tests/config-files/config-ca-6"), std::runtime_error);
+  // a secret shared by replicas with a challenge that limits the number of tries
+  BOOST_CHECK_THROW(config.load("tests/unit-tests/config-files/config-ca-9"), std::runtime_error);
 }
 
 BOOST_AUTO_TEST_CASE(ProfileStorageConfigFile)
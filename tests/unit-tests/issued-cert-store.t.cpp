@@ -0,0 +1,155 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/issued-cert-store.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+class IssuedCertStoreFixture : public KeyChainFixture
+{
+public:
+  IssuedCertStoreFixture()
+  {
+    boost::filesystem::path parentDir{UNIT_TESTS_TMPDIR};
+    dbDir = parentDir / "test-home" / ".ndncert";
+    boost::filesystem::create_directories(dbDir);
+    dbPath = (dbDir / "TestIssuedCertStore.db").string();
+    boost::filesystem::remove(dbPath);
+  }
+
+  ~IssuedCertStoreFixture()
+  {
+    boost::filesystem::remove_all(dbDir);
+  }
+
+  Certificate
+  makeCert(const Name& identityName, uint64_t version)
+  {
+    auto identity = m_keyChain.createIdentity(identityName);
+    auto cert = identity.getDefaultKey().getDefaultCertificate();
+    cert.setName(Name(identity.getDefaultKey().getName()).append("NDNCERT").appendVersion(version));
+    m_keyChain.sign(cert, ndn::signingByIdentity(identity));
+    return cert;
+  }
+
+protected:
+  boost::filesystem::path dbDir;
+  std::string dbPath;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestIssuedCertStore, IssuedCertStoreFixture)
+
+BOOST_AUTO_TEST_CASE(ExactAndPrefixLookup)
+{
+  IssuedCertStore store(Name("/ndn"), dbPath);
+  auto cert1 = makeCert("/ndn/site1", 1);
+  auto cert2 = makeCert("/ndn/site1", 2);
+  auto cert3 = makeCert("/ndn/site2", 1);
+  store.insert(cert1);
+  store.insert(cert2);
+  store.insert(cert3);
+  BOOST_CHECK_EQUAL(store.size(), 3);
+
+  BOOST_CHECK_EQUAL(store.find(cert1.getName())->getName(), cert1.getName());
+  BOOST_CHECK(!store.find(Name("/ndn/site3")));
+
+  // an exact Interest only matches a full certificate name
+  BOOST_CHECK(!store.find(Interest(cert1.getKeyName())));
+  BOOST_CHECK_EQUAL(store.find(Interest(cert1.getName()))->getName(), cert1.getName());
+
+  // a CanBePrefix Interest returns the latest version
+  Interest prefixInterest(cert1.getKeyName());
+  prefixInterest.setCanBePrefix(true);
+  BOOST_CHECK_EQUAL(store.find(prefixInterest)->getName(), cert2.getName());
+
+  // the implicit digest must match
+  BOOST_CHECK_EQUAL(store.find(Interest(cert3.getFullName()))->getName(), cert3.getName());
+  BOOST_CHECK(!store.find(Interest(Name(cert3.getName()).append(cert1.getFullName().at(-1)))));
+
+  auto site1 = store.list(Name("/ndn/site1"));
+  BOOST_REQUIRE_EQUAL(site1.size(), 2);
+  BOOST_CHECK_EQUAL(site1[0].getName(), cert1.getName());
+  BOOST_CHECK_EQUAL(site1[1].getName(), cert2.getName());
+  BOOST_CHECK_EQUAL(store.list(Name()).size(), 3);
+  BOOST_CHECK_EQUAL(store.list(Name(), 1).size(), 1);
+
+  // lookup by implicit digest alone
+  BOOST_CHECK_EQUAL(store.find(getCertDigest(cert3))->getName(), cert3.getName());
+  BOOST_CHECK(!store.find(CertDigest{}));
+
+  store.erase(cert2.getName());
+  BOOST_CHECK_EQUAL(store.find(prefixInterest)->getName(), cert1.getName());
+  BOOST_CHECK_EQUAL(store.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(HotSet)
+{
+  IssuedCertStore store(Name("/ndn"), dbPath, 2);
+  auto cert1 = makeCert("/ndn/site1", 1);
+  auto cert2 = makeCert("/ndn/site2", 1);
+  auto cert3 = makeCert("/ndn/site3", 1);
+  store.insert(cert1);
+  store.insert(cert2);
+  store.insert(cert3);
+  BOOST_CHECK_EQUAL(store.getHotSetSize(), 2);
+
+  // evicted certificates are still found in the database
+  BOOST_CHECK_EQUAL(store.find(cert1.getName())->getName(), cert1.getName());
+  BOOST_CHECK_EQUAL(store.getHotSetSize(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(Persistence)
+{
+  auto cert = makeCert("/ndn/site1", 1);
+  {
+    IssuedCertStore store(Name("/ndn"), dbPath);
+    store.insert(cert);
+  }
+  IssuedCertStore store(Name("/ndn"), dbPath);
+  BOOST_CHECK_EQUAL(store.size(), 1);
+  BOOST_CHECK_EQUAL(store.getHotSetSize(), 0);
+  BOOST_CHECK_EQUAL(store.find(cert.getName())->wireEncode(), cert.wireEncode());
+}
+
+BOOST_AUTO_TEST_CASE(InMemory)
+{
+  auto cert = makeCert("/ndn/site1", 1);
+  {
+    IssuedCertStore store(Name("/ndn"), ":memory:", 0);
+    store.insert(cert);
+    BOOST_CHECK_EQUAL(store.size(), 1);
+    BOOST_CHECK_EQUAL(store.find(cert.getName())->wireEncode(), cert.wireEncode());
+  }
+  BOOST_CHECK(!boost::filesystem::exists(":memory:"));
+  IssuedCertStore store(Name("/ndn"), ":memory:");
+  BOOST_CHECK_EQUAL(store.size(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestIssuedCertStore
+
+} // namespace ndncert::tests
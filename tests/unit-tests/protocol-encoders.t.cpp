@@ -23,6 +23,7 @@
 #include "detail/info-encoder.hpp"
 #include "detail/probe-encoder.hpp"
 #include "detail/request-encoder.hpp"
+#include "detail/status-encoder.hpp"
 #include "detail/ca-configuration.hpp"
 
 #include "tests/boost-test.hpp"
@@ -117,6 +118,91 @@ BOOST_AUTO_TEST_CASE(NewRevokeEncodingParam)
   BOOST_CHECK_EQUAL(*returnedCert, *certRequest);
 }
 
+BOOST_AUTO_TEST_CASE(RenewEncoding)
+{
+  requester::ProfileStorage caCache;
+  caCache.load("tests/unit-tests/config-files/config-client-1");
+  auto& cert = caCache.getKnownProfiles().front().cert;
+  auto b = requesttlv::encodeRenewApplicationParameters(*cert, *cert);
+  std::shared_ptr<Certificate> returnedRequest;
+  std::shared_ptr<Certificate> returnedCert;
+  requesttlv::decodeRenewApplicationParameters(b, returnedRequest, returnedCert);
+  BOOST_CHECK_EQUAL(*returnedRequest, *cert);
+  BOOST_CHECK_EQUAL(*returnedCert, *cert);
+
+  auto content = requesttlv::encodeRenewDataContent(*cert);
+  BOOST_CHECK_EQUAL(*requesttlv::decodeRenewDataContent(content), *cert);
+
+  // the ECDH key of a NEW Interest is not expected
+  auto newParams = requesttlv::encodeApplicationParameters(RequestType::NEW, ECDHState().getSelfPubKey(), *cert);
+  BOOST_CHECK_THROW(requesttlv::decodeRenewApplicationParameters(newParams, returnedRequest, returnedCert),
+                    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(StatusEncoding)
+{
+  requester::ProfileStorage caCache;
+  caCache.load("tests/unit-tests/config-files/config-client-1");
+  auto& cert = caCache.getKnownProfiles().front().cert;
+  auto digest = getCertDigest(*cert);
+  CertDigest otherDigest{};
+
+  auto b = statustlv::encodeApplicationParameters({digest, otherDigest});
+  auto digests = statustlv::decodeApplicationParameters(b);
+  BOOST_REQUIRE_EQUAL(digests.size(), 2);
+  BOOST_CHECK(digests[0] == digest);
+  BOOST_CHECK(digests[1] == otherDigest);
+  BOOST_CHECK_THROW(statustlv::decodeApplicationParameters(statustlv::encodeApplicationParameters({})),
+                    std::runtime_error);
+  std::vector<CertDigest> tooMany(statustlv::MAX_DIGESTS_PER_QUERY + 1);
+  BOOST_CHECK_THROW(statustlv::decodeApplicationParameters(statustlv::encodeApplicationParameters(tooMany)),
+                    std::runtime_error);
+
+  auto content = statustlv::encodeDataContent(5, {{digest, CertStatus::GOOD}, {otherDigest, CertStatus::UNKNOWN}});
+  auto [version, statuses] = statustlv::decodeDataContent(content);
+  BOOST_CHECK_EQUAL(version, 5);
+  BOOST_REQUIRE_EQUAL(statuses.size(), 2);
+  BOOST_CHECK(statuses[0].first == digest);
+  BOOST_CHECK_EQUAL(statuses[0].second, CertStatus::GOOD);
+  BOOST_CHECK(statuses[1].first == otherDigest);
+  BOOST_CHECK_EQUAL(statuses[1].second, CertStatus::UNKNOWN);
+
+  BOOST_CHECK_EQUAL(statustlv::makeQueryName(Name("/ndn"), digest),
+                    Name("/ndn/CA/STATUS").append(cert->getFullName().at(-1)));
+}
+
+BOOST_AUTO_TEST_CASE(NewEncodingEmbeddedChallenge)
+{
+  requester::ProfileStorage caCache;
+  caCache.load("tests/unit-tests/config-files/config-client-1");
+  auto& certRequest = caCache.getKnownProfiles().front().cert;
+  std::vector<uint8_t> pub = ECDHState().getSelfPubKey();
+  auto b = requesttlv::encodeApplicationParameters(RequestType::NEW, pub, *certRequest);
+  BOOST_CHECK(!requesttlv::decodeEmbeddedChallenge(b));
+
+  Block challenge(tlv::EncryptedPayload);
+  challenge.push_back(ndn::makeStringBlock(tlv::SelectedChallenge, "pin"));
+  challenge.encode();
+  b = requesttlv::encodeApplicationParameters(RequestType::NEW, pub, *certRequest, challenge);
+  std::vector<uint8_t> returnedPub;
+  std::shared_ptr<Certificate> returnedCert;
+  requesttlv::decodeApplicationParameters(b, RequestType::NEW, returnedPub, returnedCert);
+  BOOST_CHECK_EQUAL(*returnedCert, *certRequest);
+  auto returnedChallenge = requesttlv::decodeEmbeddedChallenge(b);
+  BOOST_REQUIRE(returnedChallenge);
+  BOOST_CHECK_EQUAL(*returnedChallenge, challenge);
+
+  std::array<uint8_t, 32> salt = {{101}};
+  RequestId id = {{102}};
+  auto content = requesttlv::encodeDataContent(pub, salt, id, {"pin"});
+  BOOST_CHECK(!requesttlv::decodeEmbeddedChallengeResponse(content));
+  Block response(ndn::tlv::Content, ndn::makeStringBlock(tlv::ChallengeStatus, "need-code"));
+  content = requesttlv::encodeDataContent(pub, salt, id, {"pin"}, response);
+  auto returnedResponse = requesttlv::decodeEmbeddedChallengeResponse(content);
+  BOOST_REQUIRE(returnedResponse);
+  BOOST_CHECK_EQUAL(*returnedResponse, response);
+}
+
 BOOST_AUTO_TEST_CASE(NewRevokeEncodingData)
 {
   std::vector<uint8_t> pub = ECDHState().getSelfPubKey();
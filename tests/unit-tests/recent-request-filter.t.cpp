@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/recent-request-filter.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/clock-fixture.hpp"
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+class RecentRequestFilterFixture : public ClockFixture
+{
+public:
+  Data
+  makeResponse(const Name& name)
+  {
+    Data data(name);
+    data.setContent(ndn::makeStringBlock(ndn::tlv::Content, name.toUri()));
+    return data;
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestRecentRequestFilter, RecentRequestFilterFixture)
+
+BOOST_AUTO_TEST_CASE(FindAndErase)
+{
+  RecentRequestFilter filter;
+  RequestId id1 = {1, 2, 3, 4, 5, 6, 7, 8};
+  RequestId id2 = {1, 2, 3, 4, 5, 6, 7, 9};
+  BOOST_CHECK(!filter.find(id1));
+
+  filter.insert(id1, "/ndn/CA/NEW/params1", makeResponse("/ndn/CA/NEW/params1"));
+  auto entry = filter.find(id1);
+  BOOST_REQUIRE(entry);
+  BOOST_CHECK_EQUAL(entry->interestName, "/ndn/CA/NEW/params1");
+  BOOST_CHECK_EQUAL(entry->response.getName(), "/ndn/CA/NEW/params1");
+  // lookups are exact
+  BOOST_CHECK(!filter.find(id2));
+
+  filter.erase(id1);
+  BOOST_CHECK(!filter.find(id1));
+  BOOST_CHECK_EQUAL(filter.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Expiration)
+{
+  RecentRequestFilter filter(10_s);
+  RequestId id1 = {1};
+  RequestId id2 = {2};
+  filter.insert(id1, "/a", makeResponse("/a"));
+
+  advanceClocks(6_s);
+  filter.insert(id2, "/b", makeResponse("/b"));
+  advanceClocks(6_s);
+  // id1 is in the previous generation, still remembered
+  BOOST_CHECK(filter.find(id1));
+  BOOST_CHECK(filter.find(id2));
+
+  advanceClocks(10_s);
+  BOOST_CHECK(!filter.find(id1));
+  advanceClocks(10_s);
+  BOOST_CHECK(!filter.find(id2));
+  BOOST_CHECK_EQUAL(filter.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Capacity)
+{
+  RecentRequestFilter filter(1_h, 4);
+  for (uint8_t i = 0; i < 10; i++) {
+    filter.insert({i}, "/a", makeResponse("/a"));
+    BOOST_CHECK_LE(filter.size(), 4);
+  }
+  BOOST_CHECK(filter.find({9}));
+  BOOST_CHECK(!filter.find({0}));
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestRecentRequestFilter
+
+} // namespace ndncert::tests
@@ -0,0 +1,291 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/repo-publisher.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <array>
+#include <set>
+
+namespace ndncert::tests {
+
+using namespace ca;
+using boost::asio::ip::tcp;
+
+/**
+ * @brief Stands in for the TCP bulk insertion interface of repo-ng.
+ */
+class RepoSink
+{
+public:
+  RepoSink(boost::asio::io_context& io, uint16_t port = 0)
+    : m_io(io)
+    , m_acceptor(io, tcp::endpoint(boost::asio::ip::address_v4::loopback(), port))
+  {
+    accept();
+  }
+
+  uint16_t
+  getPort() const
+  {
+    return m_acceptor.local_endpoint().port();
+  }
+
+  void
+  close()
+  {
+    m_acceptor.close();
+    for (auto& socket : m_sockets) {
+      boost::system::error_code ec;
+      socket->close(ec);
+    }
+  }
+
+private:
+  void
+  accept()
+  {
+    auto socket = std::make_shared<tcp::socket>(m_io);
+    m_acceptor.async_accept(*socket, [this, socket] (const auto& error) {
+      if (error) {
+        return;
+      }
+      m_sockets.push_back(socket);
+      read(socket, std::make_shared<std::vector<uint8_t>>());
+      accept();
+    });
+  }
+
+  void
+  read(std::shared_ptr<tcp::socket> socket, std::shared_ptr<std::vector<uint8_t>> pending)
+  {
+    auto chunk = std::make_shared<std::array<uint8_t, 4096>>();
+    socket->async_read_some(boost::asio::buffer(*chunk), [=] (const auto& error, size_t nBytes) {
+      if (error) {
+        return;
+      }
+      pending->insert(pending->end(), chunk->begin(), chunk->begin() + nBytes);
+      auto buffer = std::make_shared<const ndn::Buffer>(pending->data(), pending->size());
+      size_t offset = 0;
+      while (offset < buffer->size()) {
+        auto [isOk, block] = Block::fromBuffer(buffer, offset);
+        if (!isOk) {
+          break;
+        }
+        received.emplace_back(block);
+        offset += block.size();
+      }
+      pending->erase(pending->begin(), pending->begin() + offset);
+      read(socket, pending);
+    });
+  }
+
+public:
+  std::vector<Data> received;
+
+private:
+  boost::asio::io_context& m_io;
+  tcp::acceptor m_acceptor;
+  std::vector<std::shared_ptr<tcp::socket>> m_sockets;
+};
+
+class RepoPublisherFixture : public KeyChainFixture
+{
+public:
+  RepoPublisherFixture()
+  {
+    spillPath = std::string(UNIT_TESTS_TMPDIR) + "/repo-publisher.spill";
+    boost::filesystem::remove(spillPath);
+  }
+
+  ~RepoPublisherFixture()
+  {
+    boost::filesystem::remove(spillPath);
+  }
+
+  Data
+  makeData(int i, size_t contentSize = 0)
+  {
+    Data data(Name("/ndn/repo-publisher").appendNumber(i));
+    if (contentSize > 0) {
+      data.setContent(std::vector<uint8_t>(contentSize));
+    }
+    m_keyChain.sign(data, ndn::signingWithSha256());
+    return data;
+  }
+
+  template<typename Predicate>
+  bool
+  runUntil(Predicate pred, std::chrono::milliseconds timeout = std::chrono::seconds(5))
+  {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!pred() && std::chrono::steady_clock::now() < deadline) {
+      io.restart();
+      io.run_for(std::chrono::milliseconds(10));
+    }
+    return pred();
+  }
+
+protected:
+  boost::asio::io_context io;
+  std::string spillPath;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestRepoPublisher, RepoPublisherFixture)
+
+BOOST_AUTO_TEST_CASE(Publish)
+{
+  RepoSink sink(io);
+  RepoPublisherOptions options;
+  options.maxBatchSize = 4;
+  RepoPublisher publisher(io, "127.0.0.1", std::to_string(sink.getPort()), options);
+  for (int i = 0; i < 50; i++) {
+    publisher.publish(makeData(i));
+  }
+
+  BOOST_REQUIRE(runUntil([&] { return sink.received.size() == 50; }));
+  std::set<Name> names;
+  for (const auto& data : sink.received) {
+    names.insert(data.getName());
+  }
+  BOOST_CHECK_EQUAL(names.size(), 50);
+
+  auto metrics = publisher.getMetrics();
+  BOOST_CHECK_EQUAL(metrics.nPublished, 50);
+  BOOST_CHECK_EQUAL(metrics.queueDepth, 0);
+  BOOST_CHECK_EQUAL(metrics.nConnected, 2);
+  BOOST_CHECK_EQUAL(metrics.nConnectFailures, 0);
+}
+
+BOOST_AUTO_TEST_CASE(Reconnect)
+{
+  auto sink = std::make_unique<RepoSink>(io);
+  auto port = sink->getPort();
+  sink->close();
+  sink.reset();
+
+  RepoPublisherOptions options;
+  options.nConnections = 1;
+  options.initialBackoff = 10_ms;
+  options.maxBackoff = 20_ms;
+  RepoPublisher publisher(io, "127.0.0.1", std::to_string(port), options);
+  for (int i = 0; i < 5; i++) {
+    publisher.publish(makeData(i));
+  }
+  BOOST_REQUIRE(runUntil([&] { return publisher.getMetrics().nConnectFailures >= 2; }));
+  BOOST_CHECK_EQUAL(publisher.getMetrics().queueDepth, 5);
+
+  sink = std::make_unique<RepoSink>(io, port);
+  BOOST_REQUIRE(runUntil([&] { return sink->received.size() == 5; }));
+  for (int i = 0; i < 5; i++) {
+    BOOST_CHECK_EQUAL(sink->received[i].getName(), makeData(i).getName());
+  }
+
+  // the connection is reestablished when repo-ng closes it
+  sink->close();
+  BOOST_REQUIRE(runUntil([&] { return publisher.getMetrics().nConnected == 0; }));
+  sink = std::make_unique<RepoSink>(io, port);
+  publisher.publish(makeData(5));
+  BOOST_REQUIRE(runUntil([&] { return sink->received.size() == 1; }));
+  BOOST_CHECK_EQUAL(publisher.getMetrics().nPublished, 6);
+}
+
+BOOST_AUTO_TEST_CASE(Drop)
+{
+  auto port = RepoSink(io).getPort();
+  RepoPublisherOptions options;
+  options.queueCapacity = 2;
+  options.initialBackoff = 1_s;
+  RepoPublisher publisher(io, "127.0.0.1", std::to_string(port), options);
+  for (int i = 0; i < 3; i++) {
+    publisher.publish(makeData(i));
+  }
+  auto metrics = publisher.getMetrics();
+  BOOST_CHECK_EQUAL(metrics.queueDepth, 2);
+  BOOST_CHECK_EQUAL(metrics.nDropped, 1);
+}
+
+BOOST_AUTO_TEST_CASE(Spill)
+{
+  auto port = RepoSink(io).getPort();
+  RepoPublisherOptions options;
+  options.nConnections = 1;
+  options.queueCapacity = 2;
+  options.initialBackoff = 1_s;
+  options.spillPath = spillPath;
+  {
+    RepoPublisher publisher(io, "127.0.0.1", std::to_string(port), options);
+    for (int i = 0; i < 5; i++) {
+      publisher.publish(makeData(i));
+    }
+    auto metrics = publisher.getMetrics();
+    BOOST_CHECK_EQUAL(metrics.queueDepth, 2);
+    BOOST_CHECK_EQUAL(metrics.spillDepth, 3);
+    BOOST_CHECK_EQUAL(metrics.nSpilled, 3);
+    BOOST_CHECK_EQUAL(metrics.nDropped, 0);
+  }
+
+  // the next publisher picks up both the queued and the spilled Data, in order
+  RepoSink sink(io, port);
+  RepoPublisher publisher(io, "127.0.0.1", std::to_string(port), options);
+  BOOST_CHECK_EQUAL(publisher.getMetrics().queueDepth + publisher.getMetrics().spillDepth, 5);
+  BOOST_REQUIRE(runUntil([&] { return sink.received.size() == 5; }));
+  for (int i = 0; i < 5; i++) {
+    BOOST_CHECK_EQUAL(sink.received[i].getName(), makeData(i).getName());
+  }
+  BOOST_CHECK_EQUAL(publisher.getMetrics().spillDepth, 0);
+  BOOST_CHECK_EQUAL(boost::filesystem::file_size(spillPath), 0);
+}
+
+BOOST_AUTO_TEST_CASE(SaveInFlight)
+{
+  // accepts connections but never reads from them, so that a large enough write never completes
+  tcp::acceptor stalledRepo(io, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+  auto port = std::to_string(stalledRepo.local_endpoint().port());
+  RepoPublisherOptions options;
+  options.nConnections = 1;
+  options.queueCapacity = 4096;
+  options.maxBatchSize = 4096;
+  options.spillPath = spillPath;
+  const int nData = 4000;
+  {
+    RepoPublisher publisher(io, "127.0.0.1", port, options);
+    for (int i = 0; i < nData; i++) {
+      publisher.publish(makeData(i, 8000));
+    }
+    BOOST_REQUIRE(runUntil([&] { return publisher.getMetrics().queueDepth == 0; }));
+    io.restart();
+    io.run_for(std::chrono::milliseconds(100));
+    BOOST_CHECK_EQUAL(publisher.getMetrics().nPublished, 0);
+  }
+
+  // the batch being written is saved along with the queue
+  RepoPublisher publisher(io, "127.0.0.1", port, options);
+  BOOST_CHECK_EQUAL(publisher.getMetrics().queueDepth + publisher.getMetrics().spillDepth, nData);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestRepoPublisher
+
+} // namespace ndncert::tests
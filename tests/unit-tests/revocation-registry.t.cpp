@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/revocation-registry.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+class RevocationRegistryFixture : public KeyChainFixture
+{
+public:
+  RevocationRegistryFixture()
+  {
+    boost::filesystem::path parentDir{UNIT_TESTS_TMPDIR};
+    dbDir = parentDir / "test-home" / ".ndncert";
+    boost::filesystem::create_directories(dbDir);
+    dbPath = (dbDir / "TestRevocationRegistry.db").string();
+    boost::filesystem::remove(dbPath);
+  }
+
+  ~RevocationRegistryFixture()
+  {
+    boost::filesystem::remove_all(dbDir);
+  }
+
+  Certificate
+  makeCert(const Name& identityName)
+  {
+    return m_keyChain.createIdentity(identityName).getDefaultKey().getDefaultCertificate();
+  }
+
+protected:
+  boost::filesystem::path dbDir;
+  std::string dbPath;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestRevocationRegistry, RevocationRegistryFixture)
+
+BOOST_AUTO_TEST_CASE(RevokeAndList)
+{
+  RevocationRegistry registry(Name("/ndn"), dbPath);
+  auto cert1 = makeCert("/ndn/site1");
+  auto cert2 = makeCert("/ndn/site2");
+  auto cert3 = makeCert("/ndn/site3");
+  BOOST_CHECK_EQUAL(registry.getVersion(), 0);
+  BOOST_CHECK(registry.list(0).empty());
+
+  BOOST_CHECK(registry.revoke(cert1));
+  BOOST_CHECK(registry.revoke(cert2));
+  BOOST_CHECK(!registry.revoke(cert1));
+  BOOST_CHECK_EQUAL(registry.getVersion(), 2);
+  BOOST_CHECK(registry.isRevoked(cert1));
+  BOOST_CHECK(registry.isRevoked(cert2));
+  BOOST_CHECK(!registry.isRevoked(cert3));
+  BOOST_CHECK(registry.revoke(cert3));
+
+  auto all = registry.list(3);
+  BOOST_REQUIRE_EQUAL(all.size(), 3);
+  BOOST_CHECK(std::is_sorted(all.begin(), all.end()));
+  BOOST_CHECK_EQUAL(registry.list(1).size(), 1);
+  BOOST_CHECK(registry.list(1)[0] == getCertDigest(cert1));
+
+  auto delta = registry.list(3, 1);
+  BOOST_REQUIRE_EQUAL(delta.size(), 2);
+  BOOST_CHECK(std::is_sorted(delta.begin(), delta.end()));
+  BOOST_CHECK(std::find(delta.begin(), delta.end(), getCertDigest(cert1)) == delta.end());
+  BOOST_CHECK(registry.list(3, 3).empty());
+
+  BOOST_CHECK_THROW(registry.list(4), std::out_of_range);
+  BOOST_CHECK_THROW(registry.list(1, 2), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(Persistence)
+{
+  auto cert1 = makeCert("/ndn/site1");
+  auto cert2 = makeCert("/ndn/site2");
+  {
+    RevocationRegistry registry(Name("/ndn"), dbPath);
+    registry.revoke(cert1);
+    registry.revoke(cert2);
+  }
+  RevocationRegistry registry(Name("/ndn"), dbPath);
+  BOOST_CHECK_EQUAL(registry.getVersion(), 2);
+  BOOST_CHECK(registry.isRevoked(cert1));
+  BOOST_REQUIRE_EQUAL(registry.list(1).size(), 1);
+  BOOST_CHECK(registry.list(1)[0] == getCertDigest(cert1));
+  BOOST_CHECK(!registry.revoke(cert2));
+}
+
+BOOST_AUTO_TEST_CASE(SharedDatabase)
+{
+  // two shards of a CA revoking through their own connection to the same database
+  RevocationRegistry shard1(Name("/ndn"), dbPath);
+  RevocationRegistry shard2(Name("/ndn"), dbPath);
+  auto cert1 = makeCert("/ndn/site1");
+  auto cert2 = makeCert("/ndn/site2");
+  auto cert3 = makeCert("/ndn/site3");
+
+  BOOST_CHECK(shard1.revoke(cert1));
+  BOOST_CHECK(shard2.revoke(cert2));
+  BOOST_CHECK(!shard2.revoke(cert1));
+  BOOST_CHECK(shard1.revoke(cert3));
+
+  BOOST_CHECK_EQUAL(shard1.getVersion(), 3);
+  BOOST_CHECK_EQUAL(shard2.getVersion(), 3);
+  BOOST_CHECK(shard1.isRevoked(cert2));
+  BOOST_CHECK(shard2.isRevoked(cert3));
+  BOOST_REQUIRE_EQUAL(shard2.list(1).size(), 1);
+  BOOST_CHECK(shard2.list(1)[0] == getCertDigest(cert1));
+  BOOST_CHECK(shard1.list(3, 1) == shard2.list(3, 1));
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestRevocationRegistry
+
+} // namespace ndncert::tests
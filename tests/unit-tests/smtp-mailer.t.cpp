@@ -0,0 +1,466 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/smtp-mailer.hpp"
+
+#include "tests/boost-test.hpp"
+
+#include <ndn-cxx/security/transform/base64-decode.hpp>
+#include <ndn-cxx/security/transform/buffer-source.hpp>
+#include <ndn-cxx/security/transform/stream-sink.hpp>
+
+#include <boost/asio/ip/host_name.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+namespace ndncert::tests {
+
+using namespace ca;
+using boost::asio::ip::tcp;
+
+/**
+ * @brief Stands in for an SMTP server without TLS.
+ */
+class SmtpSink
+{
+public:
+  struct Email
+  {
+    std::string from;
+    std::string to;
+    std::string data;
+  };
+
+  SmtpSink(boost::asio::io_context& io, uint16_t port = 0)
+    : m_io(io)
+    , m_acceptor(io, tcp::endpoint(boost::asio::ip::address_v4::loopback(), port))
+  {
+    accept();
+  }
+
+  uint16_t
+  getPort() const
+  {
+    return m_acceptor.local_endpoint().port();
+  }
+
+  void
+  close()
+  {
+    m_acceptor.close();
+    for (auto& session : m_sessions) {
+      boost::system::error_code ec;
+      session->socket.close(ec);
+    }
+  }
+
+private:
+  struct Session
+  {
+    explicit
+    Session(boost::asio::io_context& io)
+      : socket(io)
+    {
+    }
+
+    tcp::socket socket;
+    boost::asio::streambuf buffer;
+    bool isInData = false;
+    Email email;
+  };
+
+  void
+  accept()
+  {
+    auto session = std::make_shared<Session>(m_io);
+    m_acceptor.async_accept(session->socket, [this, session] (const auto& error) {
+      if (error) {
+        return;
+      }
+      nConnections++;
+      m_sessions.push_back(session);
+      reply(session, "220 sink ESMTP");
+      read(session);
+      accept();
+    });
+  }
+
+  void
+  read(std::shared_ptr<Session> session)
+  {
+    boost::asio::async_read_until(session->socket, session->buffer, "\r\n",
+      [this, session] (const auto& error, size_t) {
+        if (error) {
+          return;
+        }
+        std::istream is(&session->buffer);
+        std::string line;
+        std::getline(is, line);
+        line.pop_back();
+        if (onLine(session, line)) {
+          read(session);
+        }
+      });
+  }
+
+  bool
+  onLine(std::shared_ptr<Session> session, const std::string& line)
+  {
+    if (session->isInData) {
+      if (line == ".") {
+        session->isInData = false;
+        received.push_back(session->email);
+        reply(session, "250 queued");
+      }
+      else {
+        session->email.data += line + "\r\n";
+      }
+      return true;
+    }
+
+    commands.push_back(line);
+    if (boost::starts_with(line, "EHLO")) {
+      reply(session, "250-sink\r\n250-AUTH PLAIN\r\n250 8BITMIME");
+    }
+    else if (boost::starts_with(line, "AUTH PLAIN ")) {
+      reply(session, "235 authenticated");
+    }
+    else if (boost::starts_with(line, "MAIL FROM:")) {
+      session->email = Email{line.substr(10), "", ""};
+      reply(session, "250 sender ok");
+    }
+    else if (boost::starts_with(line, "RCPT TO:")) {
+      session->email.to = line.substr(8);
+      auto it = deferred.find(session->email.to);
+      if (rejected.count(session->email.to) > 0) {
+        reply(session, "550 no such user");
+      }
+      else if (it != deferred.end() && it->second > 0) {
+        it->second--;
+        reply(session, "451 try again later");
+      }
+      else {
+        reply(session, "250 recipient ok");
+      }
+    }
+    else if (line == "DATA") {
+      session->isInData = true;
+      reply(session, "354 go ahead");
+    }
+    else if (line == "RSET") {
+      reply(session, "250 reset");
+    }
+    else if (line == "QUIT") {
+      nQuits++;
+      reply(session, "221 bye");
+      return false;
+    }
+    else {
+      reply(session, "502 unknown command");
+    }
+    return true;
+  }
+
+  void
+  reply(std::shared_ptr<Session> session, const std::string& text)
+  {
+    auto data = std::make_shared<std::string>(text + "\r\n");
+    boost::asio::async_write(session->socket, boost::asio::buffer(*data), [session, data] (const auto&, size_t) {});
+  }
+
+public:
+  std::vector<Email> received;
+  std::vector<std::string> commands;
+  std::set<std::string> rejected;
+  std::map<std::string, int> deferred;
+  size_t nConnections = 0;
+  size_t nQuits = 0;
+
+private:
+  boost::asio::io_context& m_io;
+  tcp::acceptor m_acceptor;
+  std::vector<std::shared_ptr<Session>> m_sessions;
+};
+
+class SmtpMailerFixture
+{
+public:
+  SmtpMailerFixture()
+  {
+    config.server = "127.0.0.1";
+    config.mailFrom = "NDNCERT Robot <noreply@example.net>";
+    config.subject = "Email Challenge Triggered by NDNCERT";
+    config.textTemplate = "Your PIN code: {0} from NDNCERT CA {1}. Certificate Name: {2}.";
+    config.htmlTemplate = "<p>Your PIN code: {0}</p>";
+    options.initialBackoff = 10_ms;
+    options.maxBackoff = 20_ms;
+  }
+
+  bool
+  send(SmtpMailer& mailer, const std::string& emailAddress)
+  {
+    return mailer.send(emailAddress, "123456", Name("/ndn"), Name("/ndn/alice/KEY/1/NA/1"));
+  }
+
+  template<typename Predicate>
+  bool
+  runUntil(Predicate pred, std::chrono::milliseconds timeout = std::chrono::seconds(5))
+  {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!pred() && std::chrono::steady_clock::now() < deadline) {
+      io.restart();
+      io.run_for(std::chrono::milliseconds(10));
+    }
+    return pred();
+  }
+
+  static std::string
+  decodeBase64(const std::string& input)
+  {
+    namespace tr = ndn::security::transform;
+    std::ostringstream os;
+    tr::bufferSource(ndn::make_span(reinterpret_cast<const uint8_t*>(input.data()), input.size()))
+      >> tr::base64Decode(false) >> tr::streamSink(os);
+    return os.str();
+  }
+
+protected:
+  boost::asio::io_context io;
+  SmtpConfig config;
+  SmtpMailerOptions options;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestSmtpMailer, SmtpMailerFixture)
+
+BOOST_AUTO_TEST_CASE(LoadConfig)
+{
+  auto loaded = SmtpConfig::load("tests/unit-tests/config-files/config-mail-1");
+  BOOST_CHECK_EQUAL(loaded.server, "smtp.example.net");
+  BOOST_CHECK_EQUAL(loaded.port, "587");
+  BOOST_CHECK(loaded.encryption == SmtpConfig::Encryption::TLS);
+  BOOST_CHECK_EQUAL(loaded.user, "ndncert");
+  BOOST_CHECK_EQUAL(loaded.password, "secret");
+  BOOST_CHECK_EQUAL(loaded.mailFrom, "NDNCERT Robot <noreply-ndncert@example.net>");
+  BOOST_CHECK_EQUAL(loaded.subject, "Email Challenge Triggered by NDNCERT");
+  BOOST_CHECK_EQUAL(loaded.textTemplate, "Your PIN code: {0} from NDNCERT CA {1}. Certificate Name: {2}.");
+
+  BOOST_CHECK_THROW(SmtpConfig::load("tests/unit-tests/config-files/config-mail-2"), std::runtime_error);
+  BOOST_CHECK_THROW(SmtpConfig::load("tests/unit-tests/config-files/Non-Existing"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(FormatMessage)
+{
+  SmtpMailer mailer(io, config, options);
+  auto message = mailer.formatMessage("alice@example.org", "123456", Name("/ndn"), Name("/ndn/alice/KEY/1/NA/1"));
+  BOOST_CHECK(boost::starts_with(message, "From: NDNCERT Robot <noreply@example.net>\r\n"
+                                          "To: alice@example.org\r\n"
+                                          "Subject: Email Challenge Triggered by NDNCERT\r\n"));
+  BOOST_CHECK(boost::ends_with(message, "--\r\n."));
+
+  std::vector<std::string> lines;
+  std::istringstream is(message);
+  for (std::string line; std::getline(is, line);) {
+    lines.push_back(boost::trim_right_copy_if(line, boost::is_any_of("\r")));
+  }
+  std::string plainText;
+  bool isInPlainText = false;
+  for (size_t i = 0; i + 1 < lines.size(); i++) {
+    BOOST_CHECK_LE(lines[i].size(), 998);
+    BOOST_CHECK(!boost::starts_with(lines[i], "."));
+    if (boost::starts_with(lines[i], "Content-Type: text/plain")) {
+      isInPlainText = true;
+      i += 2;
+      continue;
+    }
+    if (isInPlainText && boost::starts_with(lines[i], "--")) {
+      isInPlainText = false;
+    }
+    if (isInPlainText) {
+      plainText += lines[i];
+    }
+  }
+  BOOST_CHECK_EQUAL(lines.back(), ".");
+  BOOST_CHECK_EQUAL(decodeBase64(plainText),
+                    "Your PIN code: 123456 from NDNCERT CA /ndn. Certificate Name: /ndn/alice/KEY/1/NA/1.");
+}
+
+BOOST_AUTO_TEST_CASE(Deliver)
+{
+  SmtpSink sink(io);
+  config.port = std::to_string(sink.getPort());
+  options.maxBatchSize = 4;
+  SmtpMailer mailer(io, config, options);
+  for (int i = 0; i < 20; i++) {
+    BOOST_CHECK(send(mailer, "user" + std::to_string(i) + "@example.org"));
+  }
+
+  BOOST_REQUIRE(runUntil([&] { return sink.received.size() == 20; }));
+  std::set<std::string> recipients;
+  for (const auto& email : sink.received) {
+    BOOST_CHECK_EQUAL(email.from, "<noreply@example.net>");
+    recipients.insert(email.to);
+  }
+  BOOST_CHECK_EQUAL(recipients.size(), 20);
+  BOOST_CHECK_EQUAL(recipients.count("<user7@example.org>"), 1);
+  // the connections are reused across batches
+  BOOST_CHECK_EQUAL(sink.nConnections, 2);
+  BOOST_CHECK_EQUAL(std::count(sink.commands.begin(), sink.commands.end(), "EHLO " + boost::asio::ip::host_name()), 2);
+
+  auto metrics = mailer.getMetrics();
+  BOOST_CHECK_EQUAL(metrics.nSent, 20);
+  BOOST_CHECK_EQUAL(metrics.queueDepth, 0);
+  BOOST_CHECK_EQUAL(metrics.nConnected, 2);
+  BOOST_CHECK_EQUAL(metrics.nConnectFailures, 0);
+}
+
+BOOST_AUTO_TEST_CASE(Authenticate)
+{
+  SmtpSink sink(io);
+  config.port = std::to_string(sink.getPort());
+  config.user = "ndncert";
+  config.password = "secret";
+  SmtpMailer mailer(io, config, options);
+  send(mailer, "alice@example.org");
+
+  BOOST_REQUIRE(runUntil([&] { return sink.received.size() == 1; }));
+  auto auth = std::find_if(sink.commands.begin(), sink.commands.end(),
+                           [] (const auto& command) { return boost::starts_with(command, "AUTH PLAIN "); });
+  BOOST_REQUIRE(auth != sink.commands.end());
+  BOOST_CHECK_EQUAL(decodeBase64(auth->substr(11)), std::string("\0ndncert\0secret", 15));
+}
+
+BOOST_AUTO_TEST_CASE(Refused)
+{
+  SmtpSink sink(io);
+  sink.rejected.insert("<nobody@example.org>");
+  sink.deferred["<busy@example.org>"] = 1;
+  sink.deferred["<gone@example.org>"] = 100;
+  config.port = std::to_string(sink.getPort());
+  options.nConnections = 1;
+  options.maxAttempts = 3;
+  SmtpMailer mailer(io, config, options);
+  send(mailer, "nobody@example.org");
+  send(mailer, "busy@example.org");
+  send(mailer, "gone@example.org");
+  send(mailer, "alice@example.org");
+
+  BOOST_REQUIRE(runUntil([&] {
+    auto metrics = mailer.getMetrics();
+    return metrics.nSent == 2 && metrics.nDropped == 1;
+  }));
+  BOOST_REQUIRE_EQUAL(sink.received.size(), 2);
+  // the deferred email is overtaken by the next one
+  BOOST_CHECK_EQUAL(sink.received[0].to, "<alice@example.org>");
+  BOOST_CHECK_EQUAL(sink.received[1].to, "<busy@example.org>");
+  // the transaction is reset after each refusal
+  BOOST_CHECK_EQUAL(std::count(sink.commands.begin(), sink.commands.end(), "RSET"), 1 + 1 + 3);
+
+  auto metrics = mailer.getMetrics();
+  BOOST_CHECK_EQUAL(metrics.nRejected, 1);
+  BOOST_CHECK_EQUAL(metrics.nRetried, 1 + 2);
+  BOOST_CHECK_EQUAL(metrics.queueDepth, 0);
+  BOOST_CHECK_EQUAL(sink.nConnections, 1);
+}
+
+BOOST_AUTO_TEST_CASE(Reconnect)
+{
+  auto sink = std::make_unique<SmtpSink>(io);
+  auto port = sink->getPort();
+  sink->close();
+  sink.reset();
+
+  config.port = std::to_string(port);
+  options.nConnections = 1;
+  SmtpMailer mailer(io, config, options);
+  for (int i = 0; i < 5; i++) {
+    send(mailer, "user" + std::to_string(i) + "@example.org");
+  }
+  BOOST_REQUIRE(runUntil([&] { return mailer.getMetrics().nConnectFailures >= 2; }));
+  BOOST_CHECK_EQUAL(mailer.getMetrics().queueDepth, 5);
+
+  sink = std::make_unique<SmtpSink>(io, port);
+  BOOST_REQUIRE(runUntil([&] { return sink->received.size() == 5; }));
+  for (int i = 0; i < 5; i++) {
+    BOOST_CHECK_EQUAL(sink->received[i].to, "<user" + std::to_string(i) + "@example.org>");
+  }
+
+  // connection failures are not charged to the emails
+  BOOST_CHECK_EQUAL(mailer.getMetrics().nRetried, 0);
+  sink->close();
+}
+
+BOOST_AUTO_TEST_CASE(QueueFull)
+{
+  options.queueCapacity = 2;
+  SmtpMailer mailer(io, config, options);
+  BOOST_CHECK(send(mailer, "alice@example.org"));
+  BOOST_CHECK(send(mailer, "bob@example.org"));
+  BOOST_CHECK(!send(mailer, "carol@example.org"));
+  BOOST_CHECK_EQUAL(mailer.getMetrics().queueDepth, 2);
+}
+
+BOOST_AUTO_TEST_CASE(DomainLimit)
+{
+  SmtpSink sink(io);
+  config.port = std::to_string(sink.getPort());
+  options.domainLimit = TokenBucketConfig{0, 2};
+  SmtpMailer mailer(io, config, options);
+  send(mailer, "alice@example.org");
+  send(mailer, "bob@example.org");
+  send(mailer, "carol@EXAMPLE.org");
+  send(mailer, "dave@example.net");
+
+  BOOST_REQUIRE(runUntil([&] { return sink.received.size() == 3; }));
+  std::set<std::string> recipients;
+  for (const auto& email : sink.received) {
+    recipients.insert(email.to);
+  }
+  BOOST_CHECK_EQUAL(recipients.count("<dave@example.net>"), 1);
+  BOOST_CHECK_EQUAL(recipients.count("<carol@EXAMPLE.org>"), 0);
+  BOOST_CHECK_EQUAL(mailer.getMetrics().queueDepth, 1);
+}
+
+BOOST_AUTO_TEST_CASE(IdleClose)
+{
+  SmtpSink sink(io);
+  config.port = std::to_string(sink.getPort());
+  options.nConnections = 1;
+  options.idleTimeout = 50_ms;
+  SmtpMailer mailer(io, config, options);
+  send(mailer, "alice@example.org");
+
+  BOOST_REQUIRE(runUntil([&] { return sink.nQuits == 1 && mailer.getMetrics().nConnected == 0; }));
+  BOOST_CHECK_EQUAL(sink.received.size(), 1);
+
+  // the next email opens a new connection
+  send(mailer, "bob@example.org");
+  BOOST_REQUIRE(runUntil([&] { return sink.received.size() == 2; }));
+  BOOST_CHECK_EQUAL(sink.nConnections, 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestSmtpMailer
+
+} // namespace ndncert::tests
@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/state-token.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/clock-fixture.hpp"
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+class StateTokenFixture : public ClockFixture
+{
+public:
+  StateTokenFixture()
+  {
+    request.caPrefix = Name("/ndn");
+    request.requestId = {1, 2, 3, 4, 5, 6, 7, 8};
+    request.requestType = RequestType::NEW;
+    request.status = Status::CHALLENGE;
+    request.encryptionKey = {9, 9, 9};
+    request.challengeType = "pin";
+    JsonSection secrets;
+    secrets.add("code", "123456");
+    request.challengeState = ChallengeState("need-code", time::system_clock::now(), 3, 3600_s,
+                                            std::move(secrets));
+  }
+
+protected:
+  const std::vector<uint8_t> secret = std::vector<uint8_t>(32, 0x42);
+  RequestState request;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestStateToken, StateTokenFixture)
+
+BOOST_AUTO_TEST_CASE(SealAndOpen)
+{
+  StateTokenSealer sealer(secret, 3600_s, 600_s);
+  auto token = sealer.seal(request);
+  BOOST_CHECK_EQUAL(token.type(), tlv::StateToken);
+
+  auto opened = sealer.open(token, request.requestId);
+  BOOST_CHECK_EQUAL(opened.caPrefix, request.caPrefix);
+  BOOST_CHECK(opened.status == Status::CHALLENGE);
+  BOOST_CHECK(opened.encryptionKey == request.encryptionKey);
+  BOOST_CHECK_EQUAL(opened.challengeState->secrets.get<std::string>("code"), "123456");
+
+  // a token is bound to its request ID
+  RequestId otherId = {8, 7, 6, 5, 4, 3, 2, 1};
+  BOOST_CHECK_THROW(sealer.open(token, otherId), std::runtime_error);
+
+  // a tampered token is rejected
+  auto value = std::vector<uint8_t>(token.value_begin(), token.value_end());
+  value.back() ^= 0x01;
+  BOOST_CHECK_THROW(sealer.open(ndn::makeBinaryBlock(tlv::StateToken, value), request.requestId),
+                    std::runtime_error);
+
+  // replicas sharing the secret accept each other's tokens
+  StateTokenSealer replica(secret, 3600_s, 600_s);
+  BOOST_CHECK_NO_THROW(replica.open(token, request.requestId));
+  StateTokenSealer stranger({}, 3600_s, 600_s);
+  BOOST_CHECK_THROW(stranger.open(token, request.requestId), std::runtime_error);
+
+  BOOST_CHECK_THROW(StateTokenSealer(secret, 60_s, 600_s), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Replay)
+{
+  StateTokenSealer sealer(secret, 3600_s, 600_s);
+  auto token = sealer.seal(request);
+  BOOST_CHECK(sealer.markUsed(token));
+  BOOST_CHECK(!sealer.markUsed(token));
+  BOOST_CHECK_THROW(sealer.open(token, request.requestId), std::runtime_error);
+  BOOST_CHECK_EQUAL(sealer.getNonceFilterSize(), 1);
+
+  // the filter is local: a replica sharing the secret accepts the used token, which is why
+  // the challenges that limit the number of tries are refused in that configuration
+  StateTokenSealer replica(secret, 3600_s, 600_s);
+  BOOST_CHECK_NO_THROW(replica.open(token, request.requestId));
+  BOOST_CHECK(replica.markUsed(token));
+  BOOST_CHECK(!replica.markUsed(token));
+
+  // used nonces are forgotten once the token could not be opened anyway
+  advanceClocks(1_s, 601_s);
+  auto token2 = sealer.seal(request);
+  sealer.markUsed(token2);
+  BOOST_CHECK_EQUAL(sealer.getNonceFilterSize(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Expiration)
+{
+  StateTokenSealer sealer(secret, 60_s, 60_s);
+  auto token = sealer.seal(request);
+
+  // tokens sealed under the previous key remain valid until they expire
+  advanceClocks(1_s, 30_s);
+  BOOST_CHECK_NO_THROW(sealer.open(token, request.requestId));
+  advanceClocks(1_s, 31_s);
+  BOOST_CHECK_THROW(sealer.open(token, request.requestId), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestStateToken
+
+} // namespace ndncert::tests
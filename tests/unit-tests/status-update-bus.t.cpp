@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/status-update-bus.hpp"
+
+#include "tests/boost-test.hpp"
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+static RequestState
+makeRequest(uint8_t i)
+{
+  RequestState request;
+  request.requestId = {i};
+  request.status = Status::CHALLENGE;
+  return request;
+}
+
+template<typename Predicate>
+static bool
+waitUntil(Predicate pred)
+{
+  for (int i = 0; i < 500 && !pred(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return pred();
+}
+
+BOOST_AUTO_TEST_SUITE(TestStatusUpdateBus)
+
+BOOST_AUTO_TEST_CASE(MultipleSubscribers)
+{
+  StatusUpdateBus bus;
+  BOOST_CHECK(!bus.hasSubscribers());
+  // publishing without subscribers does nothing
+  bus.publish(makeRequest(0));
+
+  std::vector<StatusUpdateBus::Snapshot> received1, received2;
+  auto id1 = bus.subscribe([&] (const auto& request) { received1.push_back(request); });
+  auto id2 = bus.subscribe([&] (const auto& request) { received2.push_back(request); });
+  BOOST_CHECK(bus.hasSubscribers());
+
+  for (uint8_t i = 0; i < 10; i++) {
+    bus.publish(makeRequest(i));
+  }
+  BOOST_REQUIRE(waitUntil([&] { return bus.getStatistics(id1).nDelivered == 10 &&
+                                       bus.getStatistics(id2).nDelivered == 10; }));
+  for (uint8_t i = 0; i < 10; i++) {
+    BOOST_CHECK_EQUAL(received1[i]->requestId[0], i);
+    // the subscribers share the same snapshot
+    BOOST_CHECK_EQUAL(received1[i], received2[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(DropPolicy)
+{
+  StatusUpdateBus bus;
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  std::atomic<bool> isHandling{false};
+  auto id = bus.subscribe([&] (const auto&) {
+    isHandling = true;
+    released.wait();
+  }, 2, OverflowPolicy::DROP);
+
+  bus.publish(makeRequest(0));
+  BOOST_REQUIRE(waitUntil([&] { return isHandling.load(); }));
+  for (uint8_t i = 1; i < 5; i++) {
+    bus.publish(makeRequest(i));
+  }
+  auto stats = bus.getStatistics(id);
+  BOOST_CHECK_EQUAL(stats.queueLength, 2);
+  BOOST_CHECK_EQUAL(stats.nDropped, 2);
+
+  release.set_value();
+  BOOST_REQUIRE(waitUntil([&] { return bus.getStatistics(id).nDelivered == 3; }));
+}
+
+BOOST_AUTO_TEST_CASE(BlockPolicy)
+{
+  StatusUpdateBus bus;
+  std::vector<uint8_t> received;
+  auto id = bus.subscribe([&] (const auto& request) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    received.push_back(request->requestId[0]);
+  }, 1, OverflowPolicy::BLOCK);
+
+  for (uint8_t i = 0; i < 20; i++) {
+    bus.publish(makeRequest(i));
+  }
+  BOOST_REQUIRE(waitUntil([&] { return bus.getStatistics(id).nDelivered == 20; }));
+  BOOST_CHECK_EQUAL(bus.getStatistics(id).nDropped, 0);
+  for (uint8_t i = 0; i < 20; i++) {
+    BOOST_CHECK_EQUAL(received[i], i);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Unsubscribe)
+{
+  StatusUpdateBus bus;
+  std::atomic<int> nReceived{0};
+  auto id = bus.subscribe([&] (const auto& request) {
+    if (request->requestId[0] == 0) {
+      NDN_THROW(std::runtime_error("failing subscriber"));
+    }
+    nReceived++;
+  });
+  for (uint8_t i = 0; i < 5; i++) {
+    bus.publish(makeRequest(i));
+  }
+
+  // pending updates are handled before the subscriber stops, despite the failure
+  bus.unsubscribe(id);
+  BOOST_CHECK_EQUAL(nReceived, 4);
+  BOOST_CHECK(!bus.hasSubscribers());
+  BOOST_CHECK_THROW(bus.getStatistics(id), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestStatusUpdateBus
+
+} // namespace ndncert::tests
@@ -0,0 +1,34 @@
+#!/usr/bin/env python3
+import json
+import sys
+
+print("test VC helper started", flush=True)
+
+for line in sys.stdin:
+    call = json.loads(line)
+    method = call["method"]
+    params = call["params"]
+    if method == "send-presentation-request":
+        presentation_id = "pres-" + params["connection_did"]
+        print(json.dumps({"id": call["id"], "result": {"presentation_id": presentation_id}}), flush=True)
+        # the presentations of late requesters are still pending
+        if params["connection_did"] != "late":
+            print(json.dumps({"event": "presentation-verified",
+                              "params": {"presentation_id": presentation_id, "verified": "true"}}), flush=True)
+        continue
+    elif method == "verify-presentation":
+        if params["presentation_id"] == "pres-late":
+            reply = {"id": call["id"], "result": {"verified": "false", "pending": "true"}}
+        else:
+            verified = params["presentation_id"].startswith("pres-")
+            reply = {"id": call["id"], "result": {"verified": "true" if verified else "false"}}
+    elif method == "emit":
+        print(json.dumps({"event": "test", "params": params}), flush=True)
+        reply = {"id": call["id"], "result": {}}
+    elif method == "hang":
+        continue
+    elif method == "crash":
+        sys.exit(1)
+    else:
+        reply = {"id": call["id"], "error": "unknown method " + method}
+    print(json.dumps(reply), flush=True)
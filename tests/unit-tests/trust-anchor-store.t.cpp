@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/trust-anchor-store.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+
+namespace ndncert::tests {
+
+class TrustAnchorStoreFixture : public KeyChainFixture
+{
+public:
+  Certificate
+  makeCredential(const Name& identity, const Certificate& issuer)
+  {
+    auto key = m_keyChain.createIdentity(identity).getDefaultKey();
+    ndn::security::MakeCertificateOptions opts;
+    opts.issuerId = ndn::name::Component("Credential");
+    return m_keyChain.makeCertificate(key, signingByCertificate(issuer), opts);
+  }
+
+public:
+  Certificate anchor1 = m_keyChain.createIdentity("/anchor1").getDefaultKey().getDefaultCertificate();
+  Certificate anchor2 = m_keyChain.createIdentity("/anchor2").getDefaultKey().getDefaultCertificate();
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestTrustAnchorStore, TrustAnchorStoreFixture)
+
+BOOST_AUTO_TEST_CASE(Verify)
+{
+  TrustAnchorStore store({anchor1, anchor2});
+  BOOST_CHECK_EQUAL(store.getAnchors().size(), 2);
+
+  // signed by an anchor, named by its certificate name
+  BOOST_CHECK(store.verify(makeCredential("/device1", anchor2)));
+
+  // signed by a key that is not an anchor
+  auto other = m_keyChain.createIdentity("/other").getDefaultKey().getDefaultCertificate();
+  BOOST_CHECK(!store.verify(makeCredential("/device2", other)));
+
+  // named after an anchor, but not signed by it
+  auto forged = makeCredential("/device3", other);
+  auto info = forged.getSignatureInfo();
+  info.setKeyLocator(anchor1.getKeyName());
+  forged.setSignatureInfo(info);
+  BOOST_CHECK(!store.verify(forged));
+}
+
+BOOST_AUTO_TEST_CASE(VerdictCache)
+{
+  TrustAnchorStore store({anchor1}, 2);
+  auto credential1 = makeCredential("/device1", anchor1);
+  auto credential2 = makeCredential("/device2", anchor1);
+  auto credential3 = makeCredential("/device3", anchor2);
+
+  BOOST_CHECK(store.verify(credential1));
+  BOOST_CHECK(store.verify(credential1));
+  BOOST_CHECK_EQUAL(store.getCacheSize(), 1);
+  BOOST_CHECK(store.verify(credential2));
+  BOOST_CHECK(!store.verify(credential3));
+  BOOST_CHECK(!store.verify(credential3));
+  BOOST_CHECK_EQUAL(store.getCacheSize(), 2);
+
+  // the verdicts are bound to the exact credential
+  auto modified = credential1;
+  modified.setContent(ndn::make_span(reinterpret_cast<const uint8_t*>("x"), 1));
+  BOOST_CHECK(!store.verify(modified));
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestTrustAnchorStore
+
+} // namespace ndncert::tests
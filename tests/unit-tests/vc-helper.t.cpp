@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/vc-helper.hpp"
+
+#include "tests/boost-test.hpp"
+
+#include <future>
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+const std::string HELPER = "./tests/unit-tests/test-vc-helper.py";
+
+/**
+ * @brief Waits for the outcome of a call, which is "result:<value of @p key>" or "error:<reason>".
+ */
+static std::string
+callHelper(VcHelper& helper, const std::string& method, const JsonSection& params, const std::string& key = "")
+{
+  auto promise = std::make_shared<std::promise<std::string>>();
+  auto future = promise->get_future();
+  helper.call(method, params,
+              [=] (const JsonSection& result) { promise->set_value("result:" + result.get(key, "")); },
+              [=] (const std::string& reason) { promise->set_value("error:" + reason); });
+  if (future.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+    return "no outcome";
+  }
+  return future.get();
+}
+
+BOOST_AUTO_TEST_SUITE(TestVcHelper)
+
+BOOST_AUTO_TEST_CASE(Call)
+{
+  VcHelper helper(HELPER);
+
+  JsonSection params;
+  params.put("connection_did", "did");
+  BOOST_CHECK_EQUAL(callHelper(helper, "send-presentation-request", params, "presentation_id"),
+                    "result:pres-did");
+
+  JsonSection verifyParams;
+  verifyParams.put("presentation_id", "pres-did");
+  BOOST_CHECK_EQUAL(callHelper(helper, "verify-presentation", verifyParams, "verified"), "result:true");
+  verifyParams.put("presentation_id", "other");
+  BOOST_CHECK_EQUAL(callHelper(helper, "verify-presentation", verifyParams, "verified"), "result:false");
+
+  BOOST_CHECK_EQUAL(callHelper(helper, "unknown", {}), "error:unknown method unknown");
+  BOOST_CHECK_EQUAL(helper.getStartCount(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Event)
+{
+  VcHelper helper(HELPER);
+  std::promise<std::string> event;
+  helper.subscribe([&] (const std::string& name, const JsonSection& params) {
+    event.set_value(name + ":" + params.get("key", ""));
+  });
+
+  JsonSection params;
+  params.put("key", "value");
+  BOOST_CHECK_EQUAL(callHelper(helper, "emit", params), "result:");
+  auto future = event.get_future();
+  BOOST_REQUIRE(future.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+  BOOST_CHECK_EQUAL(future.get(), "test:value");
+}
+
+BOOST_AUTO_TEST_CASE(Timeout)
+{
+  VcHelperOptions options;
+  options.callTimeout = 200_ms;
+  VcHelper helper(HELPER, options);
+
+  // a call that is never answered does not hold up the calls made after it
+  auto hanging = std::async(std::launch::async, [&] { return callHelper(helper, "hang", {}); });
+  JsonSection params;
+  params.put("connection_did", "did");
+  BOOST_CHECK_EQUAL(callHelper(helper, "send-presentation-request", params, "presentation_id"),
+                    "result:pres-did");
+  BOOST_CHECK_EQUAL(hanging.get(), "error:VC helper timed out");
+  BOOST_CHECK_EQUAL(helper.getStartCount(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Restart)
+{
+  VcHelperOptions options;
+  options.initialBackoff = 10_ms;
+  VcHelper helper(HELPER, options);
+
+  BOOST_CHECK_EQUAL(callHelper(helper, "crash", {}), "error:VC helper exited");
+
+  // calls made while the helper restarts are written once it runs
+  JsonSection params;
+  params.put("connection_did", "did");
+  BOOST_CHECK_EQUAL(callHelper(helper, "send-presentation-request", params, "presentation_id"),
+                    "result:pres-did");
+  BOOST_CHECK_EQUAL(helper.getStartCount(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(MissingCommand)
+{
+  VcHelperOptions options;
+  options.initialBackoff = 10_ms;
+  VcHelper helper("./tests/unit-tests/no-such-helper", options);
+
+  BOOST_CHECK_EQUAL(callHelper(helper, "verify-presentation", {}), "error:VC helper exited");
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestVcHelper
+
+} // namespace ndncert::tests
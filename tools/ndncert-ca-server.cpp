@@ -19,16 +19,19 @@
  */
 
 #include "ca-module.hpp"
+#include "challenge/challenge-email.hpp"
+#include "detail/repo-publisher.hpp"
+#include "detail/smtp-mailer.hpp"
 
 #include <boost/asio.hpp>
-#include <boost/asio/ip/tcp.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/parsers.hpp>
 #include <boost/program_options/variables_map.hpp>
 
-#include <chrono>
-#include <deque>
+#include <atomic>
 #include <iostream>
+#include <thread>
 
 #include <ndn-cxx/face.hpp>
 #include <ndn-cxx/security/key-chain.hpp>
@@ -39,27 +42,7 @@ static ndn::Face face;
 static ndn::KeyChain keyChain;
 static std::string repoHost = "localhost";
 static std::string repoPort = "7376";
-const size_t MAX_CACHED_CERT_NUM = 100;
-
-static bool
-writeDataToRepo(const Data& data)
-{
-  boost::asio::ip::tcp::iostream requestStream;
-#if BOOST_VERSION >= 106600
-    requestStream.expires_after(std::chrono::seconds(3));
-#else
-    requestStream.expires_from_now(boost::posix_time::seconds(3));
-#endif //BOOST_VERSION >= 106600
-  requestStream.connect(repoHost, repoPort);
-  if (!requestStream) {
-    std::cerr << "ERROR: Cannot publish the certificate to repo-ng"
-              << " (" << requestStream.error().message() << ")" << std::endl;
-    return false;
-  }
-  requestStream.write(reinterpret_cast<const char*>(data.wireEncode().wire()),
-                      data.wireEncode().size());
-  return true;
-}
+static std::atomic<int> exitCode{0};
 
 static void
 handleSignal(const boost::system::error_code& error, int signalNum)
@@ -76,8 +59,9 @@ handleSignal(const boost::system::error_code& error, int signalNum)
     std::cerr << signalName;
   }
   std::cerr << std::endl;
+  // return from main() so that the repo publisher can save its pending certificates
+  exitCode = 1;
   face.getIoService().stop();
-  exit(1);
 }
 
 static int
@@ -89,16 +73,61 @@ main(int argc, char* argv[])
   terminateSignals.async_wait(handleSignal);
 
   std::string configFilePath(NDNCERT_SYSCONFDIR "/ndncert/ca.conf");
+  std::string storageType("ca-storage-sqlite3");
+  std::string storagePath;
+  size_t storageQueue = 0;
+  std::string certStorePath;
+  std::string revocationRegistryPath;
+  size_t nThreads = 1;
+  int shardId = -1;
+  size_t nShards = 0;
   bool wantRepoOut = false;
+  RepoPublisherOptions repoOptions;
+  std::string mailConfigPath(NDNCERT_SYSCONFDIR "/ndncert/ndncert-mail.conf");
+  SmtpMailerOptions mailOptions;
 
   namespace po = boost::program_options;
   po::options_description optsDesc("Options");
   optsDesc.add_options()
   ("help,h", "print this help message and exit")
   ("config-file,c", po::value<std::string>(&configFilePath)->default_value(configFilePath), "path to configuration file")
+  ("storage-type,t", po::value<std::string>(&storageType)->default_value(storageType),
+   "request storage type, e.g., ca-storage-sqlite3, ca-storage-memory, ca-storage-cached:sqlite3")
+  ("storage-path,s", po::value<std::string>(&storagePath),
+   "request storage location and options, e.g., /var/lib/ndncert/ca.db?cache-capacity=4096&flush-interval=500")
+  ("storage-queue,q", po::value<size_t>(&storageQueue),
+   "when set, access the request storage from a dedicated thread with a queue of this size")
+  ("cert-store-path", po::value<std::string>(&certStorePath),
+   "database of the issued certificates, overriding the configuration file; "
+   ":memory: keeps them in memory only")
+  ("revocation-registry-path", po::value<std::string>(&revocationRegistryPath),
+   "database of the revoked certificates, overriding the configuration file; "
+   "the shards of a CA may share it")
+  ("threads,j", po::value<size_t>(&nThreads)->default_value(nThreads),
+   "number of threads serving the CA, each with its own connection to NFD; "
+   "set a load-balancing strategy, e.g., random, on /<CA prefix>/CA to spread the requests")
+  ("shard", po::value<int>(&shardId),
+   "when set (0-255), run as one shard of a CA served by several processes, each with its own storage")
+  ("shards", po::value<size_t>(&nShards),
+   "number of shards; when set, each NEW, RENEW and REVOKE is answered by one shard only, "
+   "so that the multicast strategy may be set on /<CA prefix>/CA; otherwise, "
+   "set it on /<CA prefix>/CA/CHALLENGE only")
   ("repo-output,r", po::bool_switch(&wantRepoOut), "when enabled, all issued certificates will be published to repo-ng")
   ("repo-host,H", po::value<std::string>(&repoHost)->default_value(repoHost), "repo-ng host")
-  ("repo-port,P", po::value<std::string>(&repoPort)->default_value(repoPort), "repo-ng port");
+  ("repo-port,P", po::value<std::string>(&repoPort)->default_value(repoPort), "repo-ng port")
+  ("repo-connections", po::value<size_t>(&repoOptions.nConnections)->default_value(repoOptions.nConnections),
+   "number of persistent connections to repo-ng")
+  ("repo-queue", po::value<size_t>(&repoOptions.queueCapacity)->default_value(repoOptions.queueCapacity),
+   "number of certificates queued in memory for repo-ng")
+  ("repo-spill", po::value<std::string>(&repoOptions.spillPath),
+   "file receiving the certificates that do not fit in the repo-ng queue")
+  ("mail-config", po::value<std::string>(&mailConfigPath)->default_value(mailConfigPath),
+   "SMTP settings of the email challenge; when the file does not exist, "
+   "the emails are sent by ndncert-send-email-challenge")
+  ("mail-connections", po::value<size_t>(&mailOptions.nConnections)->default_value(mailOptions.nConnections),
+   "number of persistent connections to the SMTP server")
+  ("mail-queue", po::value<size_t>(&mailOptions.queueCapacity)->default_value(mailOptions.queueCapacity),
+   "number of emails waiting for the SMTP server");
 
   po::variables_map vm;
   try {
@@ -121,46 +150,139 @@ main(int argc, char* argv[])
     return 0;
   }
 
-  CaModule ca(face, keyChain, configFilePath);
-  std::deque<Data> cachedCertificates;
-  auto profileData = ca.getCaProfileData();
+  if (shardId > 255) {
+    std::cerr << "ERROR: the shard must be between 0 and 255" << std::endl;
+    return 2;
+  }
+  if (nShards != 0 && (shardId < 0 || static_cast<size_t>(shardId) >= nShards)) {
+    std::cerr << "ERROR: --shards requires a --shard below the number of shards" << std::endl;
+    return 2;
+  }
+  if (nThreads == 0) {
+    std::cerr << "ERROR: at least one thread is needed" << std::endl;
+    return 2;
+  }
+
+  // the storage, signing key and issued certificates are shared by the CA modules of all threads,
+  // each serving the CA on its own face
+  CaConfig config;
+  config.load(configFilePath);
+  if (vm.count("cert-store-path") != 0) {
+    config.certStorePath = certStorePath;
+  }
+  if (vm.count("revocation-registry-path") != 0) {
+    config.revocationRegistryPath = revocationRegistryPath;
+  }
+  auto sharedState = std::make_shared<CaSharedState>(keyChain, config, storageType, storagePath, nThreads > 1);
+  std::vector<std::unique_ptr<ndn::Face>> workerFaces;
+  for (size_t i = 1; i < nThreads; i++) {
+    workerFaces.push_back(std::make_unique<ndn::Face>());
+  }
+  std::vector<std::unique_ptr<CaModule>> cas;
+  cas.push_back(std::make_unique<CaModule>(face, sharedState, configFilePath));
+  for (const auto& workerFace : workerFaces) {
+    cas.push_back(std::make_unique<CaModule>(*workerFace, sharedState, configFilePath));
+  }
+  for (const auto& ca : cas) {
+    if (storageQueue > 0) {
+      ca->enableStorageThread(storageQueue);
+    }
+    if (shardId >= 0) {
+      ca->enableSharding(static_cast<uint8_t>(shardId), nShards);
+    }
+  }
+  auto profileData = cas.front()->getCaProfileData();
 
+  // issued certificates are served by the CA modules from their certificate store
+  std::unique_ptr<RepoPublisher> repoPublisher;
   if (wantRepoOut) {
-    writeDataToRepo(profileData);
-    ca.setStatusUpdateCallback([&](const RequestState& request) {
-      if (request.status == Status::SUCCESS && request.requestType == RequestType::NEW) {
-        writeDataToRepo(request.cert);
-      }
-    });
+    repoPublisher = std::make_unique<RepoPublisher>(face.getIoService(), repoHost, repoPort, repoOptions);
+    repoPublisher->publish(profileData);
+    for (const auto& ca : cas) {
+      // the publisher runs on the main face
+      ca->setStatusUpdateCallback([&](const RequestState& request) {
+        if (isCertificateIssued(request)) {
+          boost::asio::post(face.getIoService(), [&, cert = request.cert] { repoPublisher->publish(cert); });
+        }
+      });
+    }
   }
   else {
-    ca.setStatusUpdateCallback([&](const RequestState& request) {
-      if (request.status == Status::SUCCESS && request.requestType == RequestType::NEW) {
-        cachedCertificates.push_front(request.cert);
-        if (cachedCertificates.size() > MAX_CACHED_CERT_NUM) {
-          cachedCertificates.pop_back();
-        }
+    auto serveProfile = [&] (ndn::Face& f) {
+      f.setInterestFilter(
+          ndn::InterestFilter(config.caProfile.caPrefix),
+          [&](const auto&, const auto& interest) {
+            if (interest.getName().isPrefixOf(profileData.getName())) {
+              f.put(profileData);
+            }
+          });
+    };
+    serveProfile(face);
+    for (const auto& workerFace : workerFaces) {
+      serveProfile(*workerFace);
+    }
+  }
+
+  // the mailer runs on the main face, the email challenges of all threads queue their emails to it
+  std::shared_ptr<SmtpMailer> mailer;
+  if (boost::filesystem::exists(mailConfigPath)) {
+    try {
+      mailer = std::make_shared<SmtpMailer>(face.getIoService(), SmtpConfig::load(mailConfigPath), mailOptions);
+      ChallengeEmail::setMailer(mailer);
+    }
+    catch (const std::exception& e) {
+      std::cerr << "WARNING: " << e.what() << ", emails will be sent by ndncert-send-email-challenge" << std::endl;
+    }
+  }
+
+  std::vector<std::thread> workers;
+  for (const auto& workerFace : workerFaces) {
+    workers.emplace_back([&f = *workerFace] {
+      try {
+        f.processEvents();
+      }
+      catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        exitCode = 1;
+        face.getIoService().stop();
       }
     });
-    face.setInterestFilter(
-        ndn::InterestFilter(ca.getCaConf().caProfile.caPrefix),
-        [&](const auto&, const auto& interest) {
-          const auto& interestName = interest.getName();
-          if (interestName.isPrefixOf(profileData.getName())) {
-            face.put(profileData);
-            return;
-          }
-          for (const auto& item : cachedCertificates) {
-            if (interestName.isPrefixOf(item.getFullName())) {
-              face.put(item);
-              return;
-            }
-          }
-        });
   }
 
   face.processEvents();
-  return 0;
+  for (const auto& workerFace : workerFaces) {
+    workerFace->getIoService().stop();
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  auto admissionStatistics = cas.front()->getAdmissionStatistics();
+  if (admissionStatistics) {
+    std::cerr << "Admission control:";
+    for (size_t i = 0; i < N_CA_ENDPOINTS; i++) {
+      std::cerr << " " << static_cast<CaEndpoint>(i) << " " << admissionStatistics->nAdmitted[i]
+                << " admitted/" << admissionStatistics->nShed[i] << " shed;";
+    }
+    std::cerr << " shed by key " << admissionStatistics->nShedByKeyLocator
+              << ", by storage load " << admissionStatistics->nShedByLoad << std::endl;
+  }
+  if (mailer) {
+    ChallengeEmail::setMailer(nullptr);
+    auto mailMetrics = mailer->getMetrics();
+    std::cerr << "Emails: " << mailMetrics.nSent << " sent, " << mailMetrics.nRejected << " rejected, "
+              << mailMetrics.nDropped << " dropped, " << mailMetrics.queueDepth << " undelivered" << std::endl;
+    mailer.reset();
+  }
+  if (repoPublisher) {
+    auto repoMetrics = repoPublisher->getMetrics();
+    std::cerr << "repo-ng: " << repoMetrics.nPublished << " published, " << repoMetrics.nDropped << " dropped, "
+              << repoMetrics.queueDepth << " queued, " << repoMetrics.spillDepth << " spilled; "
+              << repoMetrics.nConnectFailures << " connect failures, " << repoMetrics.nWriteFailures
+              << " write failures" << std::endl;
+  }
+  cas.clear();
+  return exitCode;
 }
 
 } // namespace ndncert::ca
@@ -21,6 +21,8 @@
 #include "ca-module.hpp"
 #include "detail/ca-sqlite.hpp"
 
+#include <ndn-cxx/util/string-helper.hpp>
+
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/variables_map.hpp>
 #include <boost/program_options/parsers.hpp>
@@ -29,18 +31,67 @@
 
 namespace ndncert::ca {
 
+static std::optional<Status>
+parseStatus(const std::string& str)
+{
+  static const std::map<std::string, Status> statuses = {
+    {"before-challenge", Status::BEFORE_CHALLENGE},
+    {"challenge", Status::CHALLENGE},
+    {"pending", Status::PENDING},
+    {"success", Status::SUCCESS},
+    {"failure", Status::FAILURE},
+  };
+  auto it = statuses.find(boost::algorithm::to_lower_copy(str));
+  return it == statuses.end() ? std::nullopt : std::make_optional(it->second);
+}
+
+static std::optional<RequestType>
+parseRequestType(const std::string& str)
+{
+  static const std::map<std::string, RequestType> types = {
+    {"new", RequestType::NEW},
+    {"renew", RequestType::RENEW},
+    {"revoke", RequestType::REVOKE},
+  };
+  auto it = types.find(boost::algorithm::to_lower_copy(str));
+  return it == types.end() ? std::nullopt : std::make_optional(it->second);
+}
+
 static int
 main(int argc, char* argv[])
 {
   namespace po = boost::program_options;
   std::string caNameString = "";
+  std::string databasePath = "";
+  std::string statusString;
+  std::string typeString;
+  std::string challengeType;
+  std::string startAfterHex;
+  int64_t olderThan = 0;
+  size_t limit = 0;
+  bool wantCount = false;
+  bool wantSummary = false;
   po::options_description description(
-    "Usage: ndncert-ca-status [-h] caName\n"
+    "Usage: ndncert-ca-status [-h] [-c|-s] [options] caName\n"
+    "\n"
+    "Lists the requests kept by the CA. With --count or --summary, certificates are not decoded.\n"
     "\n"
     "Options");
   description.add_options()
     ("help,h", "produce help message")
-    ("caName", po::value<std::string>(&caNameString), "CA Identity Name, e.g., /example");
+    ("caName", po::value<std::string>(&caNameString), "CA Identity Name, e.g., /example")
+    ("database,d", po::value<std::string>(&databasePath), "path to the CA database, "
+                                                          "by default ~/.ndncert/<caName>.db")
+    ("count,c", po::bool_switch(&wantCount), "only print the number of matching requests")
+    ("summary,s", po::bool_switch(&wantSummary), "print one line per matching request and totals by status")
+    ("status", po::value<std::string>(&statusString),
+     "only match requests in this status: before-challenge, challenge, pending, success, failure")
+    ("type", po::value<std::string>(&typeString), "only match requests of this type: new, renew, revoke")
+    ("challenge", po::value<std::string>(&challengeType), "only match requests using this challenge")
+    ("older-than", po::value<int64_t>(&olderThan),
+     "only match requests whose challenge was last updated more than this many seconds ago")
+    ("after", po::value<std::string>(&startAfterHex), "only list requests whose ID (hex) sorts after this one")
+    ("limit,n", po::value<size_t>(&limit), "list at most this many requests");
   po::positional_options_description p;
   p.add("caName", 1);
   po::variables_map vm;
@@ -61,15 +112,80 @@ main(int argc, char* argv[])
     return 2;
   }
 
-  CaSqlite storage(Name(caNameString), "");
-  std::list<RequestState> requestList;
-  requestList = storage.listAllRequests();
+  RequestFilter filter;
+  filter.caPrefix = Name(caNameString);
+  filter.limit = limit;
+  if (!statusString.empty()) {
+    filter.status = parseStatus(statusString);
+    if (!filter.status) {
+      std::cerr << "ERROR: unrecognized status " << statusString << std::endl;
+      return 2;
+    }
+  }
+  if (!typeString.empty()) {
+    filter.requestType = parseRequestType(typeString);
+    if (!filter.requestType) {
+      std::cerr << "ERROR: unrecognized request type " << typeString << std::endl;
+      return 2;
+    }
+  }
+  if (!challengeType.empty()) {
+    filter.challengeType = challengeType;
+  }
+  if (olderThan > 0) {
+    filter.updatedBefore = time::system_clock::now() - time::seconds(olderThan);
+  }
+  if (!startAfterHex.empty()) {
+    RequestId startAfter = {};
+    try {
+      auto buffer = ndn::fromHex(startAfterHex);
+      if (buffer->size() != startAfter.size()) {
+        NDN_THROW(std::runtime_error("request IDs are " + std::to_string(startAfter.size()) + " octets long"));
+      }
+      std::memcpy(startAfter.data(), buffer->data(), startAfter.size());
+    }
+    catch (const std::exception& e) {
+      std::cerr << "ERROR: invalid request ID " << startAfterHex << ": " << e.what() << std::endl;
+      return 2;
+    }
+    filter.startAfter = startAfter;
+  }
+
+  CaSqlite storage(Name(caNameString), databasePath);
+  if (wantCount) {
+    std::cout << storage.countRequests(filter) << std::endl;
+    return 0;
+  }
+
+  if (wantSummary) {
+    std::map<Status, size_t> totals;
+    storage.forEachRequestSummary(filter, [&totals] (const RequestSummary& summary) {
+      std::cout << ndn::toHex(summary.requestId) << "  " << summary.requestType
+                << "  " << statusToString(summary.status);
+      if (!summary.challengeType.empty()) {
+        std::cout << "  " << summary.challengeType << "/" << summary.challengeStatus;
+      }
+      if (summary.challengeTimestamp) {
+        std::cout << "  " << time::toIsoString(*summary.challengeTimestamp);
+      }
+      std::cout << "\n";
+      totals[summary.status]++;
+      return true;
+    });
+    for (const auto& [status, total] : totals) {
+      std::cout << statusToString(status) << ": " << total << "\n";
+    }
+    std::cout << std::flush;
+    return 0;
+  }
+
   std::cerr << "The pending requests are :" << std::endl;
-  for (const auto& entry : requestList) {
+  storage.forEachRequest(filter, [] (const RequestState& entry) {
     std::cerr << "***************************************\n"
               << entry
               << "***************************************\n";
-  }
+    return true;
+  });
   return 0;
 }
 
@@ -199,6 +199,15 @@ challengeCb(const Data& reply)
     std::cerr << "Error when decoding challenge step: " << e.what() << std::endl;
     exit(1);
   }
+  if (requesterState->m_status == Status::SUCCESS && requesterState->m_issuedCert) {
+    std::cerr << "\n***************************************\n"
+              << "Step " << nStep++
+              << ": DONE\nCertificate with Name: " << requesterState->m_issuedCert->getName()
+              << " has been installed to your local keychain\n"
+              << "Exit now" << std::endl;
+    face.getIoService().stop();
+    return;
+  }
   if (requesterState->m_status == Status::SUCCESS) {
     std::cerr << "Certificate has already been issued, downloading certificate..." << std::endl;
     face.expressInterest(*requesterState->genCertFetchInterest(),
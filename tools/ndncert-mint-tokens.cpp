@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2022, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "challenge/challenge-token.hpp"
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <boost/program_options/parsers.hpp>
+
+#include <iostream>
+
+namespace ndncert {
+
+static int
+main(int argc, char* argv[])
+{
+  namespace po = boost::program_options;
+  std::string configFilePath = std::string(NDNCERT_SYSCONFDIR) + "/ndncert/challenge-token.conf";
+  std::vector<std::string> identities;
+  int64_t validityHours = 30 * 24;
+  bool wantNewKey = false;
+  po::options_description description(
+    "Usage: ndncert-mint-tokens [-h] [-c FILE] [-v HOURS] [identity...]\n"
+    "       ndncert-mint-tokens [-c FILE] --generate-key\n"
+    "\n"
+    "Mints one enrollment token for the \"token\" challenge per identity, read from the arguments or,\n"
+    "if there are none, from the standard input, one per line. Prints one line per identity:\n"
+    "<identity> <token>\n"
+    "\n"
+    "Options");
+  description.add_options()
+    ("help,h", "produce help message")
+    ("config-file,c", po::value<std::string>(&configFilePath)->default_value(configFilePath),
+     "path to the configuration file of the token challenge, which holds the key")
+    ("validity,v", po::value<int64_t>(&validityHours)->default_value(validityHours),
+     "validity period of the tokens, in hours")
+    ("generate-key", po::bool_switch(&wantNewKey), "generate a new key and write it to the configuration file, "
+                                                   "which invalidates the tokens minted under the previous key")
+    ("identity", po::value<std::vector<std::string>>(&identities), "identity name, e.g., /example/device1");
+  po::positional_options_description p;
+  p.add("identity", -1);
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(description).positional(p).run(), vm);
+    po::notify(vm);
+  }
+  catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+  if (vm.count("help") != 0) {
+    std::cerr << description << std::endl;
+    return 0;
+  }
+
+  try {
+    if (wantNewKey) {
+      ChallengeToken::generateKey(configFilePath);
+      std::cerr << "New key written to " << configFilePath << std::endl;
+      return 0;
+    }
+    if (validityHours <= 0) {
+      std::cerr << "ERROR: the validity period must be positive." << std::endl;
+      return 2;
+    }
+
+    auto key = ChallengeToken::loadKey(configFilePath);
+    auto expiry = time::system_clock::now() + time::hours(validityHours);
+    auto mint = [&] (const std::string& identity) {
+      Name name(identity);
+      std::cout << name << " " << ChallengeToken::mintToken(key, name, expiry) << "\n";
+    };
+    if (identities.empty()) {
+      std::string line;
+      while (std::getline(std::cin, line)) {
+        boost::algorithm::trim(line);
+        if (!line.empty()) {
+          mint(line);
+        }
+      }
+    }
+    else {
+      std::for_each(identities.begin(), identities.end(), mint);
+    }
+    std::cout << std::flush;
+  }
+  catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace ndncert
+
+int
+main(int argc, char* argv[])
+{
+  return ndncert::main(argc, argv);
+}